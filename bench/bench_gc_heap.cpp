@@ -0,0 +1,111 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <optional>
+
+#include <thread>
+
+#include <mjs/gc_heap.h>
+#include <mjs/gc_vector.h>
+#include <mjs/value.h>
+
+using namespace mjs;
+
+namespace {
+
+template<typename F>
+void run(const char* name, uint32_t num_roots, uint32_t iterations, F f) {
+    gc_heap h{1<<20};
+    {
+        const string s{h, "test"};
+        // Long lived roots
+        std::vector<std::optional<string>> roots(num_roots, s);
+        const auto t0 = std::chrono::steady_clock::now();
+        f(s, roots, iterations);
+        const auto t1 = std::chrono::steady_clock::now();
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+        std::wcout << std::setw(20) << std::left << name << std::right << std::setw(10) << num_roots << std::setw(12) << std::fixed << std::setprecision(2) << static_cast<double>(ns) / iterations << " ns/op\n";
+    }
+    h.garbage_collect();
+}
+
+// Copy and destroy a pointer (the most recently attached pointer is the one being detached)
+void temporary_copies(const string& s, std::vector<std::optional<string>>&, uint32_t iterations) {
+    for (uint32_t i = 0; i < iterations; ++i) {
+        string copy{s};
+        (void)copy;
+    }
+}
+
+// Replace the roots in the order they were created (the pointer being detached is the oldest one)
+void fifo_order(const string& s, std::vector<std::optional<string>>& roots, uint32_t iterations) {
+    if (roots.empty()) {
+        return temporary_copies(s, roots, iterations);
+    }
+    for (uint32_t i = 0; i < iterations; ++i) {
+        auto& p = roots[i % roots.size()];
+        p.reset();
+        p.emplace(s);
+    }
+}
+
+// Assignment between pointers of the same heap
+void assignments(const string& s, std::vector<std::optional<string>>&, uint32_t iterations) {
+    string a{s}, b{s};
+    for (uint32_t i = 0; i < iterations; ++i) {
+        a = b;
+        b = a;
+    }
+}
+
+// Full collection of 'num_objects' live strings (held by vectors of 1000 each) using 'num_threads' threads
+void collection(uint32_t num_objects, uint32_t num_threads) {
+    using string_vector = gc_vector<gc_heap_ptr_untracked<gc_string>>;
+    gc_heap h{1<<28};
+    h.gc_threads(num_threads);
+    {
+        auto live = gc_vector<gc_heap_ptr_untracked<string_vector>>::make(h, 16);
+        for (uint32_t i = 0; i < num_objects; i += 1000) {
+            auto v = string_vector::make(h, 1000);
+            for (uint32_t j = 0; j < 1000; ++j) {
+                v->push_back(string{h, "string " + std::to_string(i + j)}.unsafe_raw_get());
+            }
+            live->push_back(v);
+        }
+        h.garbage_collect(); // Size the heap
+        constexpr int num_collections = 5;
+        const auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < num_collections; ++i) {
+            h.garbage_collect();
+        }
+        const auto t1 = std::chrono::steady_clock::now();
+        const auto us = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+        std::wcout << std::setw(20) << std::left << "collection" << std::right << std::setw(10) << num_objects << std::setw(10) << num_threads << std::setw(12) << std::fixed << std::setprecision(2) << us / 1000.0 / num_collections << " ms\n";
+    }
+    h.garbage_collect();
+}
+
+} // unnamed namespace
+
+int main(int argc, char* argv[]) {
+    const uint32_t iterations = argc > 1 ? std::stoi(argv[1]) : 1'000'000;
+    std::wcout << std::setw(20) << std::left << "benchmark" << std::right << std::setw(10) << "roots" << std::setw(19) << "time\n";
+    for (const uint32_t num_roots: {0, 1000, 100000}) {
+        run("temporary_copies", num_roots, iterations, temporary_copies);
+        run("fifo_order", num_roots, iterations, fifo_order);
+        run("assignments", num_roots, iterations, assignments);
+    }
+
+    std::wcout << "\n" << std::setw(20) << std::left << "benchmark" << std::right << std::setw(10) << "objects" << std::setw(10) << "threads" << std::setw(16) << "time\n";
+    std::vector<uint32_t> thread_counts{1, 2, 4};
+    if (const auto n = std::thread::hardware_concurrency(); n > 4) {
+        thread_counts.push_back(n);
+    }
+    for (const uint32_t num_objects: {1U << 14, 1U << 16, 1U << 18, 1U << 20}) {
+        for (const auto num_threads: thread_counts) {
+            collection(num_objects, num_threads);
+        }
+    }
+}
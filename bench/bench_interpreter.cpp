@@ -0,0 +1,118 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+
+#include <mjs/gc_heap.h>
+#include <mjs/parser.h>
+#include <mjs/interpreter.h>
+#include <mjs/platform.h>
+
+using namespace mjs;
+
+namespace {
+
+const struct {
+    const char* name;
+    const char16_t* text;
+} scripts[] = {
+    { "loop", uR"(
+var s = 0;
+for (var i = 0; i < 200000; ++i) {
+    s += i & 7;
+}
+)" },
+    { "locals", uR"(
+function sum(n) { var s = 0; for (var i = 0; i < n; ++i) { s += i & 7; } return s; }
+sum(200000);
+)" },
+    { "calls", uR"(
+function fib(n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); }
+fib(20);
+)" },
+    { "properties", uR"(
+var o = {x: 0, y: 1};
+for (var i = 0; i < 50000; ++i) {
+    o.x = o.x + o.y;
+    o['y'] = i % 3;
+}
+)" },
+    { "arrays", uR"(
+var a = [];
+for (var i = 0; i < 20000; ++i) {
+    a.push(i & 15);
+}
+var s = 0;
+for (var i = 0; i < a.length; ++i) {
+    s += a[i];
+}
+a.slice(1).reverse().join();
+)" },
+    { "closures", uR"(
+var s = 0;
+for (var i = 0; i < 20000; ++i) {
+    var add = function(x) { var y = x + i; return y; };
+    s += add(1);
+}
+)" },
+    { "concat", uR"(
+var s = '';
+for (var i = 0; i < 20000; ++i) {
+    s += 'item ' + i + ';';
+}
+s.length;
+)" },
+    { "text", uR"(
+var words = [];
+for (var i = 0; i < 2000; ++i) {
+    words.push('\u263a word ' + i);
+}
+var s = words.join(' ');
+var n = 0;
+for (var i = 0; i < 10; ++i) {
+    n += s.indexOf('word ' + (i * 200)) + s.split(' ').length;
+}
+var t = s.toUpperCase();
+)" },
+    { "build", uR"(
+var a = [];
+for (var i = 0; i < 5000; ++i) {
+    a.push({id: i, name: 'item "' + i + '"', tags: ['x', i * 0.5]});
+}
+var j = JSON.stringify(a);
+var r = j.replace(/item/g, 'entry');
+var n = a.join().length + r.length;
+)" },
+};
+
+void run(const char* name, const char16_t* text, interpreter_engine engine) {
+    gc_heap h{1<<22};
+    {
+        auto bs = parse(std::make_shared<source_file>(u"bench", text, version::latest));
+        interpreter i{h, version::latest, {}, engine};
+        const auto t0 = std::chrono::steady_clock::now();
+        (void)i.eval(*bs);
+        const auto t1 = std::chrono::steady_clock::now();
+        const auto ms = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() / 1000.0;
+        // Size of the live set (globals, source text and the strings they refer to) once the script has finished
+        h.garbage_collect();
+        const auto live_kb = static_cast<double>(h.used()) * gc_heap::slot_size / 1024;
+        std::wcout << std::setw(20) << std::left << name << std::right << std::setw(10) << engine << std::setw(12) << std::fixed << std::setprecision(2) << ms << " ms" << std::setw(12) << live_kb << " KiB\n";
+        if (engine != interpreter_engine::ast) {
+            std::wcout << "    inline caches: " << i.inline_cache_stats() << "\n";
+        }
+    }
+    h.garbage_collect();
+}
+
+} // unnamed namespace
+
+int main() {
+    platform_init();
+    std::wcout << std::setw(20) << std::left << "benchmark" << std::right << std::setw(10) << "engine" << std::setw(16) << "time" << std::setw(16) << "live heap\n";
+    for (const auto& s: scripts) {
+        run(s.name, s.text, interpreter_engine::ast);
+        run(s.name, s.text, interpreter_engine::bytecode);
+        run(s.name, s.text, interpreter_engine::jit);
+    }
+}
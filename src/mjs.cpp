@@ -21,13 +21,14 @@
 
 using namespace mjs;
 
-constexpr uint32_t deafult_heap_size = 1<<24;
-std::wstring base_dir;
+constexpr uint32_t deafult_heap_size = 1<<28; // Maximum size, the heap starts out small and grows as needed
+std::u16string base_dir;
+interpreter_engine engine = interpreter_engine::ast;
 
-std::shared_ptr<source_file> read_utf8_file(version ver, const std::wstring_view filename) {
+std::shared_ptr<source_file> read_utf8_file(version ver, const std::u16string_view filename) {
     const auto u8fname = unicode::utf16_to_utf8(filename);
 #ifdef _MSC_VER
-    std::ifstream in(std::wstring{filename});
+    std::ifstream in(std::u16string{filename});
 #else
     std::ifstream in(u8fname);
 #endif
@@ -39,18 +40,18 @@ std::shared_ptr<source_file> read_utf8_file(version ver, const std::wstring_view
         );
 }
 
-std::shared_ptr<source_file> make_source(const std::wstring_view s, version ver) {
-    return std::make_shared<source_file>(std::wstring(L"inline code"), std::wstring(s), ver);
+std::shared_ptr<source_file> make_source(const std::u16string_view s, version ver) {
+    return std::make_shared<source_file>(std::u16string(u"inline code"), std::u16string(s), ver);
 }
 
-value load_file(interpreter& i, const std::wstring_view path) {   
+value load_file(interpreter& i, const std::u16string_view path) {   
 #if 0
     std::wcout << "Loading " << path << "\n";
 #endif
     auto& global = *i.global();
     std::unique_ptr<block_statement> bs;
     try {
-        bs = parse(read_utf8_file(global.language_version(), base_dir + std::wstring{path}), global.strict_mode() ? parse_mode::strict : parse_mode::non_strict);
+        bs = parse(read_utf8_file(global.language_version(), base_dir + std::u16string{path}), global.strict_mode() ? parse_mode::strict : parse_mode::non_strict);
     } catch (const std::exception& e) {
         throw native_error_exception{native_error_type::syntax, global.stack_trace(), e.what()};
     }
@@ -74,14 +75,17 @@ int interpret_file(const std::shared_ptr<source_file>& source) {
         , [](const statement& s, const completion& c) {
         std::wcout << s << " ----> " << c << "\n\n";
     }
+#else
+        , {}
 #endif
+        , engine
     };
     add_functions(i);
     return to_int32(i.eval(*parse(source)));
 }
 
-void set_base_dir(const std::wstring_view fname) {
-    const wchar_t* last_slash = fname.data();
+void set_base_dir(const std::u16string_view fname) {
+    const char16_t* last_slash = fname.data();
     for (const auto& ch: fname) {
         if (ch == '/'
 #ifdef _WIN32
@@ -91,11 +95,11 @@ void set_base_dir(const std::wstring_view fname) {
             last_slash = &ch;
         }
     }
-    base_dir = last_slash == fname.data() ? L"." : std::wstring{fname.data(), last_slash};
+    base_dir = last_slash == fname.data() ? u"." : std::u16string{fname.data(), last_slash};
 #ifdef _WIN32
-    std::replace(base_dir.begin(), base_dir.end(), L'\\', L'/');
+    std::replace(base_dir.begin(), base_dir.end(), u'\\', u'/');
 #endif
-    base_dir.push_back(L'/');
+    base_dir.push_back(u'/');
 }
 
 int main(int argc, char* argv[]) {
@@ -103,6 +107,15 @@ int main(int argc, char* argv[]) {
     //base_dir = std::filesystem::current_path();
     try {
         auto ver = version::latest;
+        if (argc > 1 && !std::strcmp(argv[1], "-bytecode")) {
+            engine = interpreter_engine::bytecode;
+            --argc;
+            ++argv;
+        } else if (argc > 1 && !std::strcmp(argv[1], "-jit")) {
+            engine = interpreter_engine::jit;
+            --argc;
+            ++argv;
+        }
         if (argc > 1 && !std::strncmp(argv[1], "-es", 3)) {
             std::istringstream iss{&argv[1][3]};
             int v;
@@ -124,7 +137,7 @@ int main(int argc, char* argv[]) {
         }
 
         gc_heap heap{deafult_heap_size};
-        interpreter i{heap, ver};
+        interpreter i{heap, ver, {}, engine};
         add_functions(i);
         for (;;) {
             std::wcout << "> " << std::flush;
@@ -133,7 +146,7 @@ int main(int argc, char* argv[]) {
                 break;
             }
             try {
-                const value res = i.eval(*parse(make_source(line, ver)));
+                const value res = i.eval(*parse(make_source(to_u16string(line), ver)));
                 debug_print(std::wcout, res, 2);
                 std::wcout << "\n";
             } catch (const std::exception& e) {
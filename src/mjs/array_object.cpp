@@ -12,13 +12,18 @@ namespace {
 uint32_t check_array_length(const global_object& g, const double n) {
     const auto l = to_uint32(n);
     if (g.language_version() >= version::es3 && n != l) {
-        throw native_error_exception(native_error_type::range, g.stack_trace(), L"Invalid array length");
+        throw native_error_exception(native_error_type::range, g.stack_trace(), u"Invalid array length");
     }
     return l;
 }
 
 } // unnamed namespace
 
+//
+// Elements with default attributes are stored in a dense vector (with holes) as long as they fit within max_normal_size
+// and the array doesn't get too sparse. Other elements are stored as normal object properties, an element is never
+// stored in both places.
+//
 class array_object : public native_object {
 public:
     friend gc_type_info_registration<array_object>;
@@ -34,6 +39,13 @@ public:
         return global.heap().make<array_object>(global, ap->class_name(), ap, length);
     }
 
+    value get(const std::u16string_view& name) const override {
+        if (const auto index = element_index(name); has_dense_element(index)) {
+            return dense_element(index);
+        }
+        return native_object::get(name);
+    }
+
     void put(const string& name, const value& val, property_attribute attr) override {
         if (!can_put(name.view()) || do_native_put(name, val)) {
             return;
@@ -47,31 +59,220 @@ public:
             if (index >= length_) {
                 length_ = index + 1;
             }
+            if (attr == property_attribute::none && element_index(name.view()) == index && put_dense_element(index, name.view(), val)) {
+                return;
+            }
         }
 
         object::put(name, val, attr);
     }
 
+    bool delete_property(const std::u16string_view& name) override {
+        if (const auto index = element_index(name); has_dense_element(index)) {
+            elements_.dereference(heap())[index] = value_representation::hole();
+            return true;
+        }
+        return native_object::delete_property(name);
+    }
+
+    bool has_dense_element(uint32_t index) const {
+        if (!elements_) {
+            return false;
+        }
+        auto& es = elements_.dereference(heap());
+        return index < es.length() && !es[index].is_hole();
+    }
+
+    value dense_element(uint32_t index) const {
+        assert(has_dense_element(index));
+        return elements_.dereference(heap())[index].get_value(heap());
+    }
+
+    value get_element(uint32_t index) const override {
+        if (has_dense_element(index)) {
+            return dense_element(index);
+        }
+        return native_object::get(index_string(index));
+    }
+
+    // [[Put]] of the element at 'index' without creating a property name when it's (or can be) stored densely
+    void put_element(uint32_t index, const value& val) override {
+        if (is_extensible()) {
+            if (has_dense_element(index)) {
+                elements_.dereference(heap())[index] = val;
+                return;
+            }
+            if (index < max_normal_size && put_dense_element(index, index_string(index), val)) {
+                return;
+            }
+        }
+        put(string{heap(), index_string(index)}, val, property_attribute::none);
+    }
+
+    // Create (or overwrite) the own data element at 'index' ignoring the prototype chain (used to fill in new arrays)
+    void define_element(uint32_t index, const value& val) {
+        if (has_dense_element(index) || (can_grow_to(index) && !has_sparse_element(index))) {
+            set_dense_element(index, val);
+            return;
+        }
+        redefine_own_property(string{heap(), index_string(index)}, val, property_attribute::none);
+        if (index >= length_) {
+            length_ = index + 1;
+        }
+    }
+
+    bool delete_element(uint32_t index) {
+        if (has_dense_element(index)) {
+            elements_.dereference(heap())[index] = value_representation::hole();
+            return true;
+        }
+        return delete_property(index_string(index));
+    }
+
+protected:
+    bool do_redefine_own_property(const string& name, const value& val, property_attribute attr) override {
+        if (const auto index = element_index(name.view()); has_dense_element(index)) {
+            if (attr == property_attribute::none) {
+                elements_.dereference(heap())[index] = val;
+                return true;
+            }
+            // Elements with non-default attributes are stored as normal properties
+            elements_.dereference(heap())[index] = value_representation::hole();
+        }
+        return native_object::do_redefine_own_property(name, val, attr);
+    }
+
+    void do_define_accessor_property(const string& name, const object_ptr& accessor, property_attribute attr) override {
+        if (const auto index = element_index(name.view()); has_dense_element(index)) {
+            elements_.dereference(heap())[index] = value_representation::hole();
+        }
+        native_object::do_define_accessor_property(name, accessor, attr);
+    }
+
+    property_attribute do_own_property_attributes(const std::u16string_view& name) const override {
+        if (has_dense_element(element_index(name))) {
+            return property_attribute::none;
+        }
+        return native_object::do_own_property_attributes(name);
+    }
+
+    void add_own_property_names(std::vector<string>& names, bool check_enumerable) const override {
+        add_native_property_names(names, check_enumerable);
+        if (elements_) {
+            auto& es = elements_.dereference(heap());
+            for (uint32_t i = 0; i < es.length(); ++i) {
+                if (!es[i].is_hole()) {
+                    names.emplace_back(heap(), index_string(i));
+                }
+            }
+        }
+        object::add_own_property_names(names, check_enumerable);
+    }
+
+    void do_debug_print_extra(std::wostream& os, int indent_incr, int max_nest, int indent) const override {
+        if (elements_) {
+            const auto indent_string = std::u16string(indent, ' ');
+            auto& es = elements_.dereference(heap());
+            for (uint32_t i = 0; i < es.length(); ++i) {
+                if (!es[i].is_hole()) {
+                    os << indent_string << i << ": ";
+                    mjs::debug_print(os, es[i].get_value(heap()), indent_incr, max_nest - 1, indent);
+                    os << "\n";
+                }
+            }
+        }
+        native_object::do_debug_print_extra(os, indent_incr, max_nest, indent);
+    }
+
 private:
     gc_heap_ptr_untracked<global_object> global_;
     uint32_t length_;
+    gc_heap_ptr_untracked<gc_vector<value_representation>> elements_; // Created on demand
+
+    // Returns the index of the element named 'name' or invalid_index_value if it isn't an array index
+    static uint32_t element_index(const std::u16string_view& name) {
+        if (name.empty() || (name[0] == u'0' && name.size() > 1)) {
+            return invalid_index_value;
+        }
+        return index_value_from_string(name);
+    }
+
+    bool has_sparse_element(uint32_t index) const {
+        return shape().size() && is_valid(object::do_own_property_attributes(index_string(index)));
+    }
+
+    // Only grow the dense storage if it doesn't end up mostly holes
+    bool can_grow_to(uint32_t index) const {
+        const uint32_t dense_length = elements_ ? elements_.dereference(heap()).length() : 0;
+        return index < max_normal_size && index <= 2 * dense_length + 8;
+    }
+
+    // Store 'val' at 'index' in the dense storage if the [[Put]] doesn't need to go through the normal property path
+    bool put_dense_element(uint32_t index, const std::u16string_view& name, const value& val) {
+        if (has_dense_element(index)) {
+            elements_.dereference(heap())[index] = val;
+            return true;
+        }
+        if (!is_extensible() || !can_grow_to(index) || has_sparse_element(index)) {
+            return false;
+        }
+        if (auto p = prototype(); p && p->has_property(name)) {
+            // Could be an accessor or read-only
+            return false;
+        }
+        set_dense_element(index, val);
+        return true;
+    }
+
+    void set_dense_element(uint32_t index, const value& val) {
+        assert(index < max_normal_size);
+        if (!elements_) {
+            elements_ = gc_vector<value_representation>::make(heap(), std::max(index + 1, 4U));
+        }
+        auto& es = elements_.dereference(heap());
+        if (const auto old_length = es.length(); index >= old_length) {
+            es.resize(index + 1);
+            for (uint32_t i = old_length; i < index; ++i) {
+                es[i] = value_representation::hole();
+            }
+        }
+        es[index] = val;
+        if (index >= length_) {
+            length_ = index + 1;
+        }
+    }
 
     value get_length() const {
-        return value{static_cast<double>(length_)};
+        return make_number_value(length_);
     }
 
     void put_length(const value& v) {
         // ES3, 15.4.5.1
         const auto old_length = length_;
         length_ = check_array_length(global_.dereference(heap()), to_number(v));
-        for (auto l = length_; l < old_length; ++l) {
-            delete_property(index_string(l));
+        if (length_ >= old_length) {
+            return;
+        }
+        if (elements_) {
+            auto& es = elements_.dereference(heap());
+            if (es.length() > length_) {
+                es.resize(length_);
+            }
+        }
+        // Only the elements stored as normal properties need to be looked at
+        std::vector<string> names;
+        object::add_own_property_names(names, false);
+        for (const auto& n: names) {
+            if (const auto index = index_value_from_string(n.view()); index != invalid_index_value && index >= length_ && index < old_length) {
+                delete_property(n.view());
+            }
         }
     }
 
     void fixup() {
         auto& h = heap();
         global_.fixup(h);
+        elements_.fixup(h);
         native_object::fixup();
     }
 
@@ -82,38 +283,77 @@ private:
 
 namespace {
 
+array_object* as_array(const object_ptr& o) {
+    return o.has_type<array_object>() ? static_cast<array_object*>(o.get()) : nullptr;
+}
+
+// Element access by index. For arrays these avoid creating property names when the element is stored densely.
+
+bool has_element(const object_ptr& o, uint32_t index) {
+    if (auto a = as_array(o); a && a->has_dense_element(index)) {
+        return true;
+    }
+    return o->has_property(index_string(index));
+}
+
+value get_element(const object_ptr& o, uint32_t index) {
+    if (auto a = as_array(o); a && a->has_dense_element(index)) {
+        return a->dense_element(index);
+    }
+    return o->get(index_string(index));
+}
+
+void put_element(const object_ptr& o, uint32_t index, const value& val) {
+    if (auto a = as_array(o)) {
+        a->put_element(index, val);
+    } else {
+        o->put(string{o.heap(), index_string(index)}, val);
+    }
+}
+
+bool delete_element(const object_ptr& o, uint32_t index) {
+    if (auto a = as_array(o)) {
+        return a->delete_element(index);
+    }
+    return o->delete_property(index_string(index));
+}
+
+// Adds an element to the new array 'a'
+void define_element(const object_ptr& a, uint32_t index, const value& val) {
+    assert(is_array(a));
+    static_cast<array_object&>(*a).define_element(index, val);
+}
+
 string array_to_locale_string(const gc_heap_ptr<global_object>& global_, const object_ptr& arr) {
     auto& h = arr.heap();
-    const uint32_t len = to_uint32(arr->get(L"length"));
-    std::wstring s;
+    const uint32_t len = to_uint32(arr->get(u"length"));
+    string_builder s{h};
     gc_heap_ptr<global_object> global = global_; // Keep local copy since due to use of call_function below (XXX)
     for (uint32_t i = 0; i < len; ++i) {
-        if (i) s += L",";
-        auto v = arr->get(index_string(i));
+        if (i) s.append(u',');
+        auto v = get_element(arr, i);
         if (v.type() != value_type::undefined && v.type() != value_type::null) {
             auto o = global->to_object(v);
-            s += to_string(h, call_function(o->get(L"toLocaleString"), value{o}, {})).view();
+            s.append(to_string(h, call_function(o->get(u"toLocaleString"), value{o}, {})));
         }
     }
-    return string{h, s};
+    return s.release();
 }
 
 value array_concat(gc_heap_ptr<global_object> global, const value& this_, const std::vector<value>& args) {
-    auto& h = global.heap();
     auto a = make_array(global, 0);
     uint32_t n = 0;
 
     auto add_value = [&](const value& e) {
-        a->put(string{h, index_string(n++)}, e);
+        define_element(a, n++, e);
     };
 
     auto add_object = [&](const object_ptr& e) {
         if (is_array(e)) {
-            const uint32_t l = to_uint32(e->get(L"length"));
+            const uint32_t l = to_uint32(e->get(u"length"));
             for (uint32_t k = 0; k < l; ++k) {
-                const auto is = index_string(k);
-                if (e->has_property(is)) {
-                    add_value(e->get(is));
+                if (has_element(e, k)) {
+                    add_value(get_element(e, k));
                 }
             }
         } else {
@@ -134,39 +374,37 @@ value array_concat(gc_heap_ptr<global_object> global, const value& this_, const
     return value{a};
 }
 
-string array_join(const object_ptr& o, const std::wstring_view& sep) {
+string array_join(const object_ptr& o, const string& sep) {
     auto& h = o.heap();
-    const uint32_t l = to_uint32(o->get(L"length"));
-    std::wstring s;
+    const uint32_t l = to_uint32(o->get(u"length"));
+    string_builder s{h};
     for (uint32_t i = 0; i < l; ++i) {
-        if (i) s += sep;
-        const auto& oi = o->get(index_string(i));
+        if (i) s.append(sep);
+        const auto& oi = get_element(o, i);
         if (oi.type() != value_type::undefined && oi.type() != value_type::null) {
-            s += to_string(h, oi).view();
+            s.append(to_string(h, oi));
         }
     }
-    return string{h, s};
+    return s.release();
 }
 
 value array_pop(const gc_heap_ptr<global_object>& global, const object_ptr& o) {
-    const uint32_t l = to_uint32(o->get(L"length"));
+    const uint32_t l = to_uint32(o->get(u"length"));
     if (l == 0) {
         o->put(global->common_string("length"), value{0.});
         return value::undefined;
     }
-    const auto idx_str = index_string(l - 1);
-    auto res = o->get(idx_str);
-    o->delete_property(idx_str);
+    auto res = get_element(o, l - 1);
+    delete_element(o, l - 1);
     o->put(global->common_string("length"), value{static_cast<double>(l-1)});
     return res;
 }
 
 value array_push(const gc_heap_ptr<global_object>& global, const object_ptr& o, const std::vector<value>& args) {
     // FIXME: Overflow of n is possible
-    auto& h = global.heap();
-    uint32_t n = to_uint32(o->get(L"length"));
+    uint32_t n = to_uint32(o->get(u"length"));
     for (const auto& a: args) {
-        o->put(string{h, index_string(n++)}, a);
+        put_element(o, n++, a);
     }
     value l{static_cast<double>(n)};
     o->put(global->common_string("length"), l);
@@ -174,22 +412,18 @@ value array_push(const gc_heap_ptr<global_object>& global, const object_ptr& o,
 }
 
 value array_shift(const gc_heap_ptr<global_object>& global, const object_ptr& o) {
-    auto& h = global.heap();
-    const uint32_t l = to_uint32(o->get(L"length"));
+    const uint32_t l = to_uint32(o->get(u"length"));
     if (l == 0) {
         o->put(global->common_string("length"), value{0.});
         return value::undefined;
     }
-    auto last_idx = string{h, index_string(0)};
-    auto res = o->get(last_idx.view());
+    auto res = get_element(o, 0);
     for (uint32_t k = 1; k < l; ++k) {
-        auto this_idx = string{h, index_string(k)};
-        if (o->has_property(this_idx.view())) { // should this be hasOwnProperty?
-            o->put(last_idx, o->get(this_idx.view()));
+        if (has_element(o, k)) { // should this be hasOwnProperty?
+            put_element(o, k - 1, get_element(o, k));
         } else {
-            o->delete_property(last_idx.view());
+            delete_element(o, k - 1);
         }
-        last_idx = this_idx;
     }
     o->put(global->common_string("length"), value{static_cast<double>(l-1)});
     return res;
@@ -197,22 +431,19 @@ value array_shift(const gc_heap_ptr<global_object>& global, const object_ptr& o)
 
 value array_unshift(const gc_heap_ptr<global_object>& global, const object_ptr& o, const std::vector<value>& args) {
     // ES3, 15.4.4.13
-    auto& h = global.heap();
-    const uint32_t l = to_uint32(o->get(L"length"));
+    const uint32_t l = to_uint32(o->get(u"length"));
     uint32_t k = l;
     const uint32_t num_args = static_cast<uint32_t>(args.size());
     for (; k; k--) {
-        const auto last_idx = index_string(k-1);
-        const auto this_idx = index_string(k+num_args-1);
-        if (o->has_property(last_idx)) {
-            o->put(string{h, this_idx}, o->get(last_idx));
+        if (has_element(o, k-1)) {
+            put_element(o, k+num_args-1, get_element(o, k-1));
         } else {
-            o->delete_property(this_idx);
+            delete_element(o, k+num_args-1);
         }
     }
     k = 0;
     for (const auto& a: args) {
-        o->put(string{h, index_string(k++)}, a);
+        put_element(o, k++, a);
     }
     value new_l{static_cast<double>(l + num_args)};
     o->put(global->common_string("length"), new_l);
@@ -230,7 +461,7 @@ uint32_t calc_start_index(const value& v, const uint32_t l) {
 
 value array_slice(const gc_heap_ptr<global_object>& global, const object_ptr& o, const std::vector<value>& args) {
     // ES3, 15.4.4.10
-    const uint32_t l = to_uint32(o->get(L"length"));
+    const uint32_t l = to_uint32(o->get(u"length"));
     const uint32_t start = args.size() > 0 ? calc_start_index(args[0], l) : 0;
     uint32_t end = l;
     if (args.size() > 1) {
@@ -243,11 +474,9 @@ value array_slice(const gc_heap_ptr<global_object>& global, const object_ptr& o,
         end = static_cast<uint32_t>(e);
     }
 
-    // TODO: Could use put_at since we know the length
     auto res = make_array(global, 0);
-    auto& h = global.heap();
     for (uint32_t n = 0; start + n < end; ++n) {
-        res->put(string{h, index_string(n)}, o->get(index_string(start+n)));
+        define_element(res, n, get_element(o, start+n));
     }
 
     return value{res};
@@ -265,15 +494,13 @@ value array_splice(const gc_heap_ptr<global_object>& global, const object_ptr& o
         return value{res};
     }
 
-    const uint32_t l = to_uint32(o->get(L"length")); // Result(3)
+    const uint32_t l = to_uint32(o->get(u"length")); // Result(3)
     const uint32_t start = calc_start_index(args[0], l); // Result(5)
     const uint32_t delete_count = static_cast<uint32_t>(std::min(num_args < 2 ? static_cast<double>(l) : std::max(to_integer(args[1]), 0.0), 0.0+l-start)); // Result(6)
     
-    auto& h = global.heap();
     for (uint32_t k = 0; k < delete_count; ++k) {
-        const auto prop_name = index_string(start + k);
-        if (o->has_property(prop_name)) {
-            res->put(string{h, index_string(k)}, o->get(prop_name));
+        if (has_element(o, start + k)) {
+            define_element(res, k, get_element(o, start + k));
         }
     }
     res->put(global->common_string("length"), value{static_cast<double>(delete_count)});
@@ -283,33 +510,29 @@ value array_splice(const gc_heap_ptr<global_object>& global, const object_ptr& o
     if (item_count < delete_count) {
         // Step 20-30
         for (uint32_t k = start; k < l - delete_count; ++k) {
-            const auto from_name = index_string(k + delete_count);
-            const auto to_name = index_string(k + item_count);
-            if (o->has_property(from_name)) {
-                o->put(string{h, to_name}, o->get(from_name));
+            if (has_element(o, k + delete_count)) {
+                put_element(o, k + item_count, get_element(o, k + delete_count));
             } else {
-                o->delete_property(to_name);
+                delete_element(o, k + item_count);
             }
         }
         for (uint32_t k = l; k-- > l - delete_count + item_count;) {
-            o->delete_property(index_string(k));
+            delete_element(o, k);
         }
     } else if (item_count > delete_count) {
         // Step 31-47
         for (uint32_t k = l - delete_count; k-- > start; ) {
-            const auto from_name = index_string(k + delete_count);
-            const auto to_name = index_string(k + item_count);
-            if (o->has_property(from_name)) {
-                o->put(string{h, to_name}, o->get(from_name));
+            if (has_element(o, k + delete_count)) {
+                put_element(o, k + item_count, get_element(o, k + delete_count));
             } else {
-                o->delete_property(to_name);
+                delete_element(o, k + item_count);
             }
         }
     }
 
     // step 48
     for (uint32_t i = 0; i < item_count; ++i) {
-        o->put(string{h, index_string(start + i)}, args[2+i]);
+        put_element(o, start + i, args[2+i]);
     }
     o->put(global->common_string("length"), value{static_cast<double>(l - delete_count + item_count)});
     return value{res};
@@ -317,7 +540,7 @@ value array_splice(const gc_heap_ptr<global_object>& global, const object_ptr& o
 
 double array_index_of(const gc_heap_ptr<global_object>& global, const value& this_, const std::vector<value>& args) {
     auto o = global->to_object(this_);
-    const auto len = to_uint32(o->get(L"length"));
+    const auto len = to_uint32(o->get(u"length"));
     if (!len) {
         return -1.0;
     }
@@ -334,8 +557,7 @@ double array_index_of(const gc_heap_ptr<global_object>& global, const value& thi
 
     if (len < array_object::max_normal_size) {
         for (; k < len; ++k) {
-            const auto is = index_string(k);
-            if (o->has_property(is) && o->get(is) == search_element) {
+            if (has_element(o, k) && get_element(o, k) == search_element) {
                 return static_cast<double>(k);
             }
         }
@@ -354,7 +576,7 @@ double array_index_of(const gc_heap_ptr<global_object>& global, const value& thi
 
 double array_last_index_of(const gc_heap_ptr<global_object>& global, const value& this_, const std::vector<value>& args) {
     auto o = global->to_object(this_);
-    const auto len = to_uint32(o->get(L"length"));
+    const auto len = to_uint32(o->get(u"length"));
     if (!len) {
         return -1.0;
     }
@@ -367,8 +589,7 @@ double array_last_index_of(const gc_heap_ptr<global_object>& global, const value
     auto k = n >= 0 ? std::min(n, len-1.) : len - std::fabs(n);
     if (len < array_object::max_normal_size) {
         for (; k >= 0; --k) {
-            const auto is = index_string(static_cast<uint32_t>(k));
-            if (o->has_property(is) && o->get(is) == search_element) {
+            if (has_element(o, static_cast<uint32_t>(k)) && get_element(o, static_cast<uint32_t>(k)) == search_element) {
                 return k;
             }
         }
@@ -389,7 +610,7 @@ double array_last_index_of(const gc_heap_ptr<global_object>& global, const value
 template<typename Init, typename Iter>
 void for_each_helper(gc_heap_ptr<global_object> global, const value& this_, const std::vector<value>& args, const Init& init, const Iter& iter) {
     auto o = global->to_object(this_);
-    const auto len = to_uint32(o->get(L"length"));
+    const auto len = to_uint32(o->get(u"length"));
     const auto callback = !args.empty() ? args[0] : value::undefined;
     global->validate_type(callback, global->function_prototype(), "function");
     const auto this_arg = args.size() > 1 ? args[1] : value::undefined;
@@ -397,9 +618,8 @@ void for_each_helper(gc_heap_ptr<global_object> global, const value& this_, cons
     init(len);
     if (len < array_object::max_normal_size) {
         for (uint32_t k = 0; k < len; ++k) {
-            const auto is = index_string(static_cast<uint32_t>(k));
-            if (o->has_property(is)) {
-                auto kval = o->get(is);
+            if (has_element(o, k)) {
+                auto kval = get_element(o, k);
                 auto res = call_function(callback, this_arg, { kval, value{static_cast<double>(k)}, value{o} });
                 if (!iter(k, res)) {
                     break;
@@ -459,7 +679,7 @@ object_ptr array_map(const gc_heap_ptr<global_object>& global, const value& this
     for_each_helper(global, this_, args, [&a, global](uint32_t length) {
         a = make_array(global, length);
     }, [&a](uint32_t k, const value& v) {
-        a->put(string{a.heap(), index_string(k)}, v);
+        define_element(a, k, v);
         return true;
     });
     return a;
@@ -470,7 +690,7 @@ object_ptr array_filter(const gc_heap_ptr<global_object>& global, const value& t
     uint32_t len = 0;
     for_each_helper(global, this_, args, [](uint32_t) {}, [&this_, &a, &len](uint32_t k, const value& v) {
         if (to_boolean(v)) {
-            a->put(string{a.heap(), index_string(len++)}, this_.object_value()->get(index_string(k)));
+            define_element(a, len++, get_element(this_.object_value(), k));
         }
         return true;
     });
@@ -479,7 +699,7 @@ object_ptr array_filter(const gc_heap_ptr<global_object>& global, const value& t
 
 value array_reduce(gc_heap_ptr<global_object> global, const value& this_, const std::vector<value>& args, bool reduce_right) {
     auto o = global->to_object(this_);
-    const auto len = to_uint32(o->get(L"length"));
+    const auto len = to_uint32(o->get(u"length"));
     const auto callback = !args.empty() ? args[0] : value::undefined;
     global->validate_type(callback, global->function_prototype(), "function");
 
@@ -499,19 +719,19 @@ value array_reduce(gc_heap_ptr<global_object> global, const value& this_, const
             if (i == len) {
                 throw native_error_exception{native_error_type::type, global->stack_trace(), "cannot reduce empty array"};
             }
-            const auto is = index_string(k());
+            const auto index = k();
             ++i; // increase i after having called k() for this loop but before breaking (since the value was consumed)
-            if (o->has_property(is)) {
-                accumulator = o->get(is);
+            if (has_element(o, index)) {
+                accumulator = get_element(o, index);
                 break;
             }
         }
     }
 
     for (; i < len; ++i) {
-        const auto is = index_string(k());
-        if (o->has_property(is)) {
-            accumulator = call_function(callback, value::undefined, { accumulator, o->get(is), value{static_cast<double>(k())}, value{o} });
+        const auto index = k();
+        if (has_element(o, index)) {
+            accumulator = call_function(callback, value::undefined, { accumulator, get_element(o, index), value{static_cast<double>(index)}, value{o} });
         }
     }
 
@@ -536,12 +756,12 @@ global_object_create_result make_array_object(const gc_heap_ptr<global_object>&
     if (version < version::es3) {
         put_native_function(global, prototype, "toString", [global = global](const value& this_, const std::vector<value>&) {
             global->validate_object(this_);
-            return value{array_join(this_.object_value(), L",")};
+            return value{array_join(this_.object_value(), global->common_string(","))};
         }, 0);
     } else {
         put_native_function(global, prototype, "toString", [version, global = global](const value& this_, const std::vector<value>&) {
             if (version < version::es5) global->validate_type(this_, global->array_prototype(), "array");
-            return value{array_join(this_.object_value(), L",")};
+            return value{array_join(this_.object_value(), global->common_string(","))};
         }, 0);
         put_native_function(global, prototype, "toLocaleString", [version, global = global](const value& this_, const std::vector<value>&) {
             if (version < version::es5) global->validate_type(this_, global->array_prototype(), "array");
@@ -578,20 +798,17 @@ global_object_create_result make_array_object(const gc_heap_ptr<global_object>&
     put_native_function(global, prototype, "join", [global](const value& this_, const std::vector<value>& args) {
         global->validate_object(this_);
         auto& h = global.heap();
-        return value{array_join(this_.object_value(), !args.empty() ? to_string(h, args.front()).view() : std::wstring_view{L","})};
+        return value{array_join(this_.object_value(), !args.empty() ? to_string(h, args.front()) : global->common_string(","))};
     }, 1);
     put_native_function(global, prototype, "reverse", [global](const value& this_, const std::vector<value>&) {
         global->validate_object(this_);
         const auto& o = this_.object_value();
-        const uint32_t length = to_uint32(o->get(L"length"));
-        auto& h = global.heap();
+        const uint32_t length = to_uint32(o->get(u"length"));
         for (uint32_t k = 0; k != length / 2; ++k) {
-            const auto i1 = index_string(k);
-            const auto i2 = index_string(length - k - 1);
-            auto v1 = o->get(i1);
-            auto v2 = o->get(i2);
-            o->put(string{h, i1}, v2);
-            o->put(string{h, i2}, v1);
+            auto v1 = get_element(o, k);
+            auto v2 = get_element(o, length - k - 1);
+            put_element(o, k, v2);
+            put_element(o, length - k - 1, v1);
         }
         return this_;
     }, 0);
@@ -599,7 +816,7 @@ global_object_create_result make_array_object(const gc_heap_ptr<global_object>&
         global->validate_object(this_);
         const auto& o = *this_.object_value();
         auto& h = o.heap(); // Capture heap reference (which continues to be valid even after GC) since `this` can move when calling a user-defined compare function (since this can cause GC)
-        const uint32_t length = to_uint32(o.get(L"length"));
+        const uint32_t length = to_uint32(o.get(u"length"));
 
         value comparefn = !args.empty() ? args.front() : value::undefined;
 
@@ -619,23 +836,21 @@ global_object_create_result make_array_object(const gc_heap_ptr<global_object>&
             } else {
                 const auto xs = to_string(h, x);
                 const auto ys = to_string(h, y);
-                if (xs.view() < ys.view()) return -1;
-                if (xs.view() > ys.view()) return 1;
-                return 0;
+                const auto r = xs.unsafe_raw_get()->compare(*ys.unsafe_raw_get());
+                return r < 0 ? -1 : r > 0 ? 1 : 0;
             }
         };
 
         std::vector<value> values(length);
         for (uint32_t i = 0; i < length; ++i) {
-            values[i] = o.get(index_string(i));
+            values[i] = get_element(this_.object_value(), i);
         }
         std::stable_sort(values.begin(), values.end(), [&](const value& x, const value& y) {
             return sort_compare(x, y) < 0;
         });
-        // Note: `this` has possibly become invalid here (!)
-        auto& o_after = *this_.object_value(); // Recapture object reference (since it could also have moved)
+        // Note: `o` has possibly become invalid here (!)
         for (uint32_t i = 0; i < length; ++i) {
-            o_after.put(string{h, index_string(i)}, values[i]);
+            put_element(this_.object_value(), i, values[i]);
         }
         return this_;
     }, 1);
@@ -696,9 +911,13 @@ object_ptr make_array(const gc_heap_ptr<global_object>& global, const std::vecto
     if (args.size() == 1 && args[0].type() == value_type::number) {
         return array_object::make(global, check_array_length(*global, args[0].number_value()));
     }
-    auto arr = array_object::make(global, static_cast<uint32_t>(args.size()));
-    for (uint32_t i = 0; i < args.size(); ++i) {
-        arr->put(string{global.heap(), index_string(i)}, args[i], property_attribute::none);
+    return make_array_from_elements(global, args);
+}
+
+object_ptr make_array_from_elements(const gc_heap_ptr<global_object>& global, const std::vector<value>& elements) {
+    auto arr = array_object::make(global, static_cast<uint32_t>(elements.size()));
+    for (uint32_t i = 0; i < elements.size(); ++i) {
+        arr->define_element(i, elements[i]);
     }
     return arr;
 }
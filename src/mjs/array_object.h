@@ -8,6 +8,8 @@ namespace mjs {
 global_object_create_result make_array_object(const gc_heap_ptr<global_object>& global);
 object_ptr make_array(const gc_heap_ptr<global_object>& global, uint32_t length);
 object_ptr make_array(const gc_heap_ptr<global_object>& global, const std::vector<value>& args);
+// Unlike make_array a single number argument is an element rather than the length
+object_ptr make_array_from_elements(const gc_heap_ptr<global_object>& global, const std::vector<value>& elements);
 bool is_array(const object_ptr& o);
 
 } // namespace mjs
@@ -27,7 +27,7 @@ private:
     }
 
     void do_debug_print_extra(std::wostream& os, int, int, int indent) const override {
-        os << std::wstring(indent, ' ') << "[[Value]]: " << (value_?"true":"false") << "\n";
+        os << std::u16string(indent, ' ') << "[[Value]]: " << (value_?"true":"false") << "\n";
     }
 };
 
@@ -57,7 +57,7 @@ global_object_create_result make_boolean_object(const gc_heap_ptr<global_object>
 
     put_native_function(global, prototype, global->common_string("toString"), [get_bool_obj](const value& this_, const std::vector<value>&){
         auto o = get_bool_obj(this_);
-        return value{string{o.heap(), o->boolean_value() ? L"true" : L"false"}};
+        return value{string{o.heap(), o->boolean_value() ? u"true" : u"false"}};
     }, 0);
 
     put_native_function(global, prototype, global->common_string("valueOf"), [get_bool_obj](const value& this_, const std::vector<value>&){
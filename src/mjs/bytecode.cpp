@@ -0,0 +1,916 @@
+#include "bytecode.h"
+#include "parser.h"
+#include <ostream>
+#include <algorithm>
+#include <optional>
+#include <cassert>
+
+namespace mjs {
+
+namespace {
+
+constexpr uint32_t num_operands(opcode op) {
+    switch (op) {
+#define MJS_OPCODE_OPERANDS(name, num_operands) case opcode::name: return num_operands;
+        MJS_OPCODES(MJS_OPCODE_OPERANDS)
+#undef MJS_OPCODE_OPERANDS
+    }
+    return 0;
+}
+
+constexpr bool is_reference_op(token_type t) {
+    return t == token_type::dot || t == token_type::lbracket;
+}
+
+// Gathers what's needed to decide whether the identifiers in a function body can be resolved statically
+class scope_analysis {
+public:
+    struct nested_function {
+        const function_base* f;
+        bool in_catch; // The scope chain of functions created in catch blocks includes the catch scope
+    };
+
+    std::vector<std::u16string> declarations; // Variables and functions in order of first appearance
+    std::vector<nested_function> functions;
+    bool uses_eval = false;
+    bool uses_arguments = false;
+    bool has_with = false;
+
+    static scope_analysis analyze(const block_statement& bs) {
+        scope_analysis a{};
+        a(bs);
+        return a;
+    }
+
+    void operator()(const identifier_expression& e) {
+        if (e.id() == u"eval") {
+            uses_eval = true;
+        } else if (e.id() == u"arguments") {
+            uses_arguments = true;
+        }
+    }
+
+    void operator()(const array_literal_expression& e) {
+        for (const auto& el: e.elements()) {
+            if (el) {
+                accept(*el, *this);
+            }
+        }
+    }
+
+    void operator()(const object_literal_expression& e) {
+        for (const auto& el: e.elements()) {
+            accept(el.value(), *this);
+        }
+    }
+
+    void operator()(const call_expression& e) {
+        accept(e.member(), *this);
+        for (const auto& a: e.arguments()) {
+            accept(*a, *this);
+        }
+    }
+
+    void operator()(const prefix_expression& e) {
+        accept(e.e(), *this);
+    }
+
+    void operator()(const postfix_expression& e) {
+        accept(e.e(), *this);
+    }
+
+    void operator()(const binary_expression& e) {
+        accept(e.lhs(), *this);
+        accept(e.rhs(), *this);
+    }
+
+    void operator()(const conditional_expression& e) {
+        accept(e.cond(), *this);
+        accept(e.lhs(), *this);
+        accept(e.rhs(), *this);
+    }
+
+    void operator()(const function_expression& e) {
+        functions.push_back(nested_function{&e, in_catch_});
+    }
+
+    // this, literals
+    void operator()(const expression&) {}
+
+    void operator()(const block_statement& s) {
+        for (const auto& bs: s.l()) {
+            accept(*bs, *this);
+        }
+    }
+
+    void operator()(const variable_statement& s) {
+        for (const auto& d: s.l()) {
+            declare(d.id());
+            if (d.init()) {
+                accept(*d.init(), *this);
+            }
+        }
+    }
+
+    void operator()(const expression_statement& s) {
+        accept(s.e(), *this);
+    }
+
+    void operator()(const if_statement& s) {
+        accept(s.cond(), *this);
+        accept(s.if_s(), *this);
+        if (auto e = s.else_s()) {
+            accept(*e, *this);
+        }
+    }
+
+    void operator()(const do_statement& s) {
+        accept(s.s(), *this);
+        accept(s.cond(), *this);
+    }
+
+    void operator()(const while_statement& s) {
+        accept(s.cond(), *this);
+        accept(s.s(), *this);
+    }
+
+    void operator()(const for_statement& s) {
+        if (auto is = s.init()) accept(*is, *this);
+        if (auto c = s.cond()) accept(*c, *this);
+        if (auto it = s.iter()) accept(*it, *this);
+        accept(s.s(), *this);
+    }
+
+    void operator()(const for_in_statement& s) {
+        accept(s.init(), *this);
+        accept(s.e(), *this);
+        accept(s.s(), *this);
+    }
+
+    void operator()(const return_statement& s) {
+        if (s.e()) {
+            accept(*s.e(), *this);
+        }
+    }
+
+    void operator()(const with_statement& s) {
+        has_with = true;
+        accept(s.e(), *this);
+        accept(s.s(), *this);
+    }
+
+    void operator()(const labelled_statement& s) {
+        accept(s.s(), *this);
+    }
+
+    void operator()(const switch_statement& s) {
+        accept(s.e(), *this);
+        for (const auto& c: s.cl()) {
+            if (c.e()) {
+                accept(*c.e(), *this);
+            }
+            for (const auto& cs: c.sl()) {
+                accept(*cs, *this);
+            }
+        }
+    }
+
+    void operator()(const throw_statement& s) {
+        accept(s.e(), *this);
+    }
+
+    void operator()(const try_statement& s) {
+        accept(s.block(), *this);
+        if (auto c = s.catch_block()) {
+            const bool old_in_catch = in_catch_;
+            in_catch_ = true;
+            accept(*c, *this);
+            in_catch_ = old_in_catch;
+        }
+        if (auto f = s.finally_block()) {
+            accept(*f, *this);
+        }
+    }
+
+    void operator()(const function_definition& s) {
+        declare(s.id());
+        functions.push_back(nested_function{&s, in_catch_});
+    }
+
+    // debugger, empty, continue, break
+    void operator()(const statement&) {}
+
+private:
+    bool in_catch_ = false;
+
+    void declare(const std::u16string& id) {
+        if (std::find(declarations.begin(), declarations.end(), id) == declarations.end()) {
+            declarations.push_back(id);
+        }
+    }
+};
+
+// Static scope of the code being compiled
+struct function_context {
+    std::shared_ptr<const frame_layout> layout; // nullptr for programs and functions where identifiers can't be resolved
+    const function_context* parent;             // nullptr if the enclosing scope isn't known (or can't be reached statically)
+};
+
+} // unnamed namespace
+
+uint32_t instruction_size(opcode op) {
+    return 1 + num_operands(op) * static_cast<uint32_t>(sizeof(uint32_t));
+}
+
+std::wostream& operator<<(std::wostream& os, opcode op) {
+    switch (op) {
+#define MJS_OPCODE_NAME(name, num_operands) case opcode::name: return os << #name;
+        MJS_OPCODES(MJS_OPCODE_NAME)
+#undef MJS_OPCODE_NAME
+    }
+    return os << "opcode{" << static_cast<int>(op) << "}";
+}
+
+class bytecode_compiler {
+public:
+    static std::shared_ptr<const bytecode_chunk> compile_program(const block_statement& bs, bool statement_hooks) {
+        const function_context context{nullptr, nullptr};
+        bytecode_compiler c{statement_hooks, context};
+        return c.compile_body(bs, scope_analysis::analyze(bs));
+    }
+
+    static std::shared_ptr<const bytecode_chunk> compile_function(const function_base& f, const function_context* parent, bool statement_hooks) {
+        auto analysis = scope_analysis::analyze(f.block());
+        const function_context context{make_layout(f, analysis), parent};
+        bytecode_compiler c{statement_hooks, context};
+        c.chunk_->layout_ = context.layout;
+        return c.compile_body(f.block(), analysis);
+    }
+
+    //
+    // Expressions
+    //
+
+    void operator()(const identifier_expression& e) {
+        if (auto r = resolve(e.id())) {
+            emit(opcode::get_slot, r->depth, r->slot);
+        } else {
+            emit(opcode::lookup, name_index(e.id()));
+        }
+    }
+
+    void operator()(const this_expression&) {
+        if (auto r = resolve(u"this")) {
+            emit(opcode::get_slot, r->depth, r->slot);
+        } else {
+            emit(opcode::lookup, name_index(u"this"));
+        }
+    }
+
+    void operator()(const literal_expression& e) {
+        switch (e.t().type()) {
+        case token_type::null_:           emit(opcode::push_null); break;
+        case token_type::true_:           emit(opcode::push_true); break;
+        case token_type::false_:          emit(opcode::push_false); break;
+        case token_type::numeric_literal: emit(opcode::push_number, number_index(e.t().dvalue())); break;
+        case token_type::string_literal:  emit(opcode::push_string, name_index(e.t().text())); break;
+        default:                          fallback(e);
+        }
+    }
+
+    void operator()(const call_expression& e) {
+        // Leave the (unevaluated) member and this value on the stack, see interpreter::impl::eval_call_member
+        const auto& member = e.member();
+        if (auto name = constant_member_name(member)) {
+            // Leaves undefined (the member isn't needed since the this value is known), the this value and the function on the stack
+            compile_value(static_cast<const binary_expression&>(member).lhs());
+            emit(opcode::get_method, name_index(*name), cache_index());
+        } else if (member.type() == expression_type::binary && is_reference_op(static_cast<const binary_expression&>(member).op())) {
+            const auto& be = static_cast<const binary_expression&>(member);
+            compile_value(be.lhs());
+            compile_expression(be.rhs());
+            emit(opcode::call_member);
+        } else {
+            compile_expression(member);
+            emit(opcode::push_undefined);
+        }
+        if (!constant_member_name(member)) {
+            emit(opcode::get_callee);
+        }
+        for (const auto& a: e.arguments()) {
+            compile_value(*a);
+        }
+        emit(opcode::call, static_cast<uint32_t>(e.arguments().size()), expression_index(e));
+    }
+
+    void operator()(const prefix_expression& e) {
+        if (e.op() == token_type::new_) {
+            uint32_t num_args = 0;
+            if (e.e().type() == expression_type::call) {
+                const auto& ce = static_cast<const call_expression&>(e.e());
+                compile_expression(ce.member());
+                for (const auto& a: ce.arguments()) {
+                    compile_value(*a);
+                }
+                num_args = static_cast<uint32_t>(ce.arguments().size());
+            } else {
+                compile_expression(e.e());
+            }
+            emit(opcode::new_, num_args, expression_index(e.e()));
+            return;
+        }
+        if (e.op() == token_type::plusplus || e.op() == token_type::minusminus) {
+            if (auto r = writable_slot(e.e())) {
+                emit(opcode::prefix_slot, static_cast<uint32_t>(e.op()), r->depth, r->slot);
+                return;
+            }
+            compile_reference(e.e());
+        } else if (e.op() == token_type::delete_) {
+            compile_reference(e.e());
+        } else {
+            compile_expression(e.e());
+        }
+        emit(opcode::prefix, static_cast<uint32_t>(e.op()));
+    }
+
+    void operator()(const postfix_expression& e) {
+        if (auto r = writable_slot(e.e())) {
+            emit(opcode::postfix_slot, static_cast<uint32_t>(e.op()), r->depth, r->slot);
+            return;
+        }
+        compile_reference(e.e());
+        emit(opcode::postfix, static_cast<uint32_t>(e.op()));
+    }
+
+    void operator()(const binary_expression& e) {
+        if (e.op() == token_type::comma) {
+            compile_value(e.lhs());
+            emit(opcode::pop);
+            compile_value(e.rhs());
+        } else if (operator_precedence(e.op()) == assignment_precedence) {
+            if (auto r = writable_slot(e.lhs())) {
+                compile_value(e.rhs());
+                if (e.op() == token_type::equal) {
+                    emit(opcode::set_slot, r->depth, r->slot);
+                } else {
+                    emit(opcode::assign_slot, static_cast<uint32_t>(e.op()), r->depth, r->slot);
+                }
+                return;
+            }
+            if (auto name = constant_member_name(e.lhs()); name && e.op() == token_type::equal) {
+                // Convert to an object before evaluating the right hand side like when creating the reference
+                compile_value(static_cast<const binary_expression&>(e.lhs()).lhs());
+                emit(opcode::to_object);
+                compile_value(e.rhs());
+                emit(opcode::put_member, name_index(*name), cache_index());
+                return;
+            }
+            if (e.op() == token_type::equal && is_element_access(e.lhs())) {
+                const auto& be = static_cast<const binary_expression&>(e.lhs());
+                compile_value(be.lhs());
+                compile_value(be.rhs());
+                emit(opcode::to_property_key);
+                compile_value(e.rhs());
+                emit(opcode::put_element);
+                return;
+            }
+            compile_reference(e.lhs());
+            compile_value(e.rhs());
+            emit(opcode::assign, static_cast<uint32_t>(e.op()));
+        } else if (e.op() == token_type::andand || e.op() == token_type::oror) {
+            compile_value(e.lhs());
+            const auto skip = emit_jump(e.op() == token_type::andand ? opcode::and_jump : opcode::or_jump);
+            compile_value(e.rhs());
+            patch(skip);
+        } else {
+            compile_value(e.lhs());
+            compile_value(e.rhs());
+            emit(opcode::binary, static_cast<uint32_t>(e.op()));
+        }
+    }
+
+    void operator()(const conditional_expression& e) {
+        compile_value(e.cond());
+        const auto to_rhs = emit_jump(opcode::jump_if_false);
+        compile_value(e.lhs());
+        const auto to_end = emit_jump(opcode::jump);
+        patch(to_rhs);
+        compile_value(e.rhs());
+        patch(to_end);
+    }
+
+    // Literals that create objects and function expressions are handled by the AST interpreter
+    void operator()(const expression& e) {
+        fallback(e);
+    }
+
+    //
+    // Statements
+    //
+
+    void operator()(const block_statement& s) {
+        if (s.l().empty()) {
+            emit(opcode::clear_result);
+        }
+        for (const auto& bs: s.l()) {
+            compile_statement(*bs);
+        }
+    }
+
+    void operator()(const variable_statement& s) {
+        for (const auto& d: s.l()) {
+            if (d.init()) {
+                compile_value(*d.init());
+                if (auto r = resolve(d.id())) {
+                    emit(opcode::set_slot, r->depth, r->slot);
+                    emit(opcode::pop);
+                } else {
+                    emit(opcode::put_local, name_index(d.id()));
+                }
+            }
+        }
+        emit(opcode::clear_result);
+    }
+
+    void operator()(const debugger_statement&) {
+        emit(opcode::clear_result);
+    }
+
+    void operator()(const empty_statement&) {
+        emit(opcode::clear_result);
+    }
+
+    void operator()(const expression_statement& s) {
+        compile_value(s.e());
+        emit(opcode::set_result);
+    }
+
+    void operator()(const if_statement& s) {
+        compile_value(s.cond());
+        const auto to_else = emit_jump(opcode::jump_if_false);
+        compile_statement(s.if_s());
+        const auto to_end = emit_jump(opcode::jump);
+        patch(to_else);
+        if (auto e = s.else_s()) {
+            compile_statement(*e);
+        } else {
+            emit(opcode::clear_result);
+        }
+        patch(to_end);
+    }
+
+    void operator()(const do_statement& s) {
+        begin_loop();
+        const auto body_pc = pc();
+        compile_statement(s.s());
+        loops_.back().continue_pc = pc();
+        compile_value(s.cond());
+        emit(opcode::jump_if_true, body_pc);
+        end_loop();
+    }
+
+    void operator()(const while_statement& s) {
+        begin_loop();
+        const auto cond_pc = pc();
+        loops_.back().continue_pc = cond_pc;
+        compile_value(s.cond());
+        const auto to_end = emit_jump(opcode::jump_if_false);
+        compile_statement(s.s());
+        emit(opcode::jump, cond_pc);
+        patch(to_end);
+        // The loop never has a completion value
+        emit(opcode::clear_result);
+        end_loop();
+    }
+
+    void operator()(const for_statement& s) {
+        begin_loop();
+        if (auto is = s.init()) {
+            compile_statement(*is);
+        }
+        emit(opcode::clear_result);
+        const auto cond_pc = pc();
+        std::optional<uint32_t> to_end;
+        if (auto c = s.cond()) {
+            compile_value(*c);
+            to_end = emit_jump(opcode::jump_if_false);
+        }
+        compile_statement(s.s());
+        loops_.back().continue_pc = pc();
+        if (auto it = s.iter()) {
+            compile_value(*it);
+            emit(opcode::pop);
+        }
+        emit(opcode::jump, cond_pc);
+        if (to_end) {
+            patch(*to_end);
+        }
+        end_loop();
+    }
+
+    void operator()(const continue_statement& s) {
+        if (auto l = find_loop(s.id())) {
+            emit(opcode::clear_result);
+            l->continue_patches.push_back(emit_jump(opcode::jump));
+        } else {
+            // Not targeting a compiled loop, let the completion propagate out of the chunk
+            fallback(s);
+        }
+    }
+
+    void operator()(const break_statement& s) {
+        if (auto l = find_loop(s.id())) {
+            emit(opcode::clear_result);
+            l->break_patches.push_back(emit_jump(opcode::jump));
+        } else {
+            fallback(s);
+        }
+    }
+
+    void operator()(const return_statement& s) {
+        if (s.e()) {
+            compile_value(*s.e());
+        } else {
+            emit(opcode::push_undefined);
+        }
+        emit(opcode::return_);
+    }
+
+    void operator()(const labelled_statement& s) {
+        if (std::find(pending_labels_.begin(), pending_labels_.end(), s.id()) != pending_labels_.end()) {
+            // Let the interpreter report the duplicate label
+            fallback(s);
+            pending_labels_.clear();
+            return;
+        }
+        pending_labels_.push_back(s.id());
+        compile_statement(s.s());
+    }
+
+    void operator()(const throw_statement& s) {
+        compile_value(s.e());
+        emit(opcode::throw_);
+    }
+
+    void operator()(const function_definition& s) {
+        emit(opcode::define_function, statement_index(s));
+        emit(opcode::clear_result);
+    }
+
+    // for-in, with, switch and try statements are handled by the AST interpreter
+    void operator()(const statement& s) {
+        fallback(s);
+    }
+
+private:
+    struct loop {
+        std::vector<std::u16string_view> labels;
+        uint32_t index;
+        uint32_t continue_pc = 0;
+        std::vector<uint32_t> break_patches;
+        std::vector<uint32_t> continue_patches;
+    };
+
+    struct slot_reference {
+        uint32_t depth;
+        uint32_t slot;
+        property_attribute attributes;
+    };
+
+    std::unique_ptr<bytecode_chunk> chunk_;
+    bool statement_hooks_;
+    const function_context& context_;
+    std::vector<std::u16string_view> pending_labels_; // Labels for the next statement (that isn't itself a labelled statement)
+    std::vector<std::u16string_view> current_labels_; // Labels for the statement currently being compiled
+    std::vector<loop> loops_;
+
+    explicit bytecode_compiler(bool statement_hooks, const function_context& context) : chunk_(new bytecode_chunk{}), statement_hooks_(statement_hooks), context_(context) {}
+
+    std::shared_ptr<const bytecode_chunk> compile_body(const block_statement& bs, const scope_analysis& analysis) {
+        chunk_->strict_mode_ = bs.strict_mode();
+        chunk_->block_ = &bs;
+        for (const auto& s: bs.l()) {
+            compile_statement(*s);
+        }
+        emit(opcode::end);
+        for (const auto& nf: analysis.functions) {
+            chunk_->functions_.push_back(compile_function(*nf.f, nf.in_catch ? nullptr : &context_, statement_hooks_));
+        }
+        return std::move(chunk_);
+    }
+
+    // Returns nullptr if the identifiers of 'f' can't be resolved statically
+    static std::shared_ptr<const frame_layout> make_layout(const function_base& f, const scope_analysis& analysis) {
+        if (analysis.uses_eval || analysis.has_with) {
+            return nullptr;
+        }
+        if (analysis.uses_arguments && !f.block().strict_mode()) {
+            // The arguments object aliases the parameters
+            return nullptr;
+        }
+        auto is_special = [](const std::u16string& id) { return id == u"arguments" || id == u"eval"; };
+        auto layout = std::make_shared<frame_layout>();
+        for (const auto& p: f.params()) {
+            if (is_special(p) || layout->find(p) != frame_layout::no_slot) {
+                return nullptr;
+            }
+            layout->add(p, property_attribute::dont_delete);
+        }
+        layout->num_params_ = layout->size();
+        layout->this_slot_ = layout->add(u"this", property_attribute::dont_delete | property_attribute::dont_enum | property_attribute::read_only);
+        if (analysis.uses_arguments) {
+            layout->arguments_slot_ = layout->add(u"arguments", property_attribute::dont_delete);
+        }
+        if (!f.id().empty()) {
+            if (layout->find(f.id()) != frame_layout::no_slot || std::find(analysis.declarations.begin(), analysis.declarations.end(), f.id()) != analysis.declarations.end()) {
+                return nullptr;
+            }
+            layout->id_slot_ = layout->add(f.id(), property_attribute::dont_delete | property_attribute::read_only);
+        }
+        for (const auto& d: analysis.declarations) {
+            if (is_special(d)) {
+                return nullptr;
+            }
+            if (layout->find(d) == frame_layout::no_slot) {
+                layout->add(d, property_attribute::dont_delete);
+            }
+        }
+        return layout;
+    }
+
+    std::optional<slot_reference> resolve(const std::u16string& id) const {
+        uint32_t depth = 0;
+        for (auto ctx = &context_; ctx && ctx->layout; ctx = ctx->parent, ++depth) {
+            if (const auto slot = ctx->layout->find(id); slot != frame_layout::no_slot) {
+                return slot_reference{depth, slot, ctx->layout->attributes(slot)};
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::optional<slot_reference> writable_slot(const expression& e) const {
+        if (e.type() != expression_type::identifier) {
+            return std::nullopt;
+        }
+        auto r = resolve(static_cast<const identifier_expression&>(e).id());
+        if (!r || has_attributes(r->attributes, property_attribute::read_only)) {
+            return std::nullopt;
+        }
+        return r;
+    }
+
+    uint32_t pc() const { return chunk_->code_size(); }
+
+    void emit_operand(uint32_t operand) {
+        uint8_t bytes[sizeof(operand)];
+        std::memcpy(bytes, &operand, sizeof(operand));
+        chunk_->code_.insert(chunk_->code_.end(), std::begin(bytes), std::end(bytes));
+    }
+
+    template<typename... Operands>
+    void emit(opcode op, Operands... operands) {
+        assert(num_operands(op) == sizeof...(operands));
+        chunk_->code_.push_back(static_cast<uint8_t>(op));
+        (emit_operand(operands), ...);
+    }
+
+    // Returns the position of the jump target to be patched
+    [[nodiscard]] uint32_t emit_jump(opcode op) {
+        emit(op, UINT32_MAX);
+        return pc() - static_cast<uint32_t>(sizeof(uint32_t));
+    }
+
+    void patch(uint32_t operand_pos, uint32_t target) {
+        assert(bytecode_chunk::read_operand(&chunk_->code_[operand_pos]) == UINT32_MAX);
+        std::memcpy(&chunk_->code_[operand_pos], &target, sizeof(target));
+    }
+
+    void patch(uint32_t operand_pos) {
+        patch(operand_pos, pc());
+    }
+
+    uint32_t name_index(const std::u16string_view name) {
+        auto& names = chunk_->names_;
+        if (auto it = std::find(names.begin(), names.end(), name); it != names.end()) {
+            return static_cast<uint32_t>(it - names.begin());
+        }
+        names.emplace_back(name);
+        return static_cast<uint32_t>(names.size() - 1);
+    }
+
+    uint32_t number_index(double d) {
+        auto& numbers = chunk_->numbers_;
+        // Compare representations to keep e.g. 0 and -0 apart
+        if (auto it = std::find_if(numbers.begin(), numbers.end(), [d](double n) { return !std::memcmp(&n, &d, sizeof(d)); }); it != numbers.end()) {
+            return static_cast<uint32_t>(it - numbers.begin());
+        }
+        numbers.push_back(d);
+        return static_cast<uint32_t>(numbers.size() - 1);
+    }
+
+    uint32_t expression_index(const expression& e) {
+        chunk_->expressions_.push_back(&e);
+        return static_cast<uint32_t>(chunk_->expressions_.size() - 1);
+    }
+
+    uint32_t cache_index() {
+        chunk_->caches_.emplace_back();
+        return static_cast<uint32_t>(chunk_->caches_.size() - 1);
+    }
+
+    // Returns the property name if 'e' is a property accessor with a string literal name (a.b or a['b'])
+    static std::optional<std::u16string_view> constant_member_name(const expression& e) {
+        if (e.type() != expression_type::binary) {
+            return std::nullopt;
+        }
+        const auto& be = static_cast<const binary_expression&>(e);
+        if (!is_reference_op(be.op()) || be.rhs().type() != expression_type::literal) {
+            return std::nullopt;
+        }
+        const auto& t = static_cast<const literal_expression&>(be.rhs()).t();
+        if (t.type() != token_type::string_literal) {
+            return std::nullopt;
+        }
+        return t.text();
+    }
+
+    // Returns true if 'e' is a property accessor with a computed name (a[i])
+    static bool is_element_access(const expression& e) {
+        return e.type() == expression_type::binary && static_cast<const binary_expression&>(e).op() == token_type::lbracket && !constant_member_name(e);
+    }
+
+    uint32_t statement_index(const statement& s) {
+        chunk_->statements_.push_back(&s);
+        return static_cast<uint32_t>(chunk_->statements_.size() - 1);
+    }
+
+    void compile_expression(const expression& e) {
+        accept(e, *this);
+    }
+
+    // Like compile_expression, but identifiers are always looked up by name (for e.g. assignments to read only slots)
+    void compile_reference(const expression& e) {
+        if (e.type() == expression_type::identifier) {
+            emit(opcode::lookup, name_index(static_cast<const identifier_expression&>(e).id()));
+        } else {
+            compile_expression(e);
+        }
+    }
+
+    bool may_be_reference(const expression& e) const {
+        switch (e.type()) {
+        case expression_type::identifier:
+            return !resolve(static_cast<const identifier_expression&>(e).id());
+        case expression_type::this_:
+            return !resolve(u"this");
+        case expression_type::binary:
+            return is_reference_op(static_cast<const binary_expression&>(e).op());
+        default:
+            return false;
+        }
+    }
+
+    // Compile 'e' and convert the result to a value (i.e. not a reference)
+    void compile_value(const expression& e) {
+        if (auto name = constant_member_name(e)) {
+            compile_value(static_cast<const binary_expression&>(e).lhs());
+            emit(opcode::get_member, name_index(*name), cache_index());
+            return;
+        }
+        if (is_element_access(e)) {
+            const auto& be = static_cast<const binary_expression&>(e);
+            compile_value(be.lhs());
+            compile_value(be.rhs());
+            emit(opcode::get_element);
+            return;
+        }
+        compile_expression(e);
+        if (may_be_reference(e)) {
+            emit(opcode::get_value);
+        }
+    }
+
+    static bool is_fallback(const statement& s) {
+        switch (s.type()) {
+        case statement_type::for_in:
+        case statement_type::with:
+        case statement_type::switch_:
+        case statement_type::try_:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    void compile_statement(const statement& s) {
+        if (s.type() != statement_type::labelled) {
+            current_labels_ = std::move(pending_labels_);
+            pending_labels_.clear();
+        }
+        if (is_fallback(s)) {
+            // eval() handles the statement bookkeeping
+            fallback(s);
+            return;
+        }
+        const auto index = statement_index(s);
+        emit(opcode::statement, index);
+        accept(s, *this);
+        if (statement_hooks_) {
+            emit(opcode::statement_done, index);
+        }
+    }
+
+    // Note: loops_.back() is only the current loop while not compiling the body
+    void begin_loop() {
+        const auto index = static_cast<uint32_t>(chunk_->loops_.size());
+        chunk_->loops_.push_back(bytecode_chunk::loop_info{current_labels_, 0, 0});
+        loops_.push_back(loop{current_labels_, index, 0, {}, {}});
+    }
+
+    void end_loop() {
+        auto& l = loops_.back();
+        for (const auto p: l.break_patches) {
+            patch(p);
+        }
+        for (const auto p: l.continue_patches) {
+            patch(p, l.continue_pc);
+        }
+        auto& info = chunk_->loops_[l.index];
+        info.break_pc = pc();
+        info.continue_pc = l.continue_pc;
+        loops_.pop_back();
+    }
+
+    // Find the loop targeted by a break/continue (same rules as completion::in_set)
+    loop* find_loop(const std::u16string_view label) {
+        for (auto it = loops_.rbegin(); it != loops_.rend(); ++it) {
+            if (label.empty() || std::find(it->labels.begin(), it->labels.end(), label) != it->labels.end()) {
+                return &*it;
+            }
+        }
+        return nullptr;
+    }
+
+    void fallback(const expression& e) {
+        emit(opcode::eval_expression, expression_index(e));
+    }
+
+    void fallback(const statement& s) {
+        bytecode_chunk::fallback_info info{&s, s.type() == statement_type::labelled ? pending_labels_ : current_labels_, {}};
+        for (auto it = loops_.rbegin(); it != loops_.rend(); ++it) {
+            info.loops.push_back(it->index);
+        }
+        chunk_->fallbacks_.push_back(std::move(info));
+        emit(opcode::eval_statement, static_cast<uint32_t>(chunk_->fallbacks_.size() - 1));
+    }
+};
+
+std::shared_ptr<const bytecode_chunk> compile(const block_statement& bs, bool statement_hooks) {
+    return bytecode_compiler::compile_program(bs, statement_hooks);
+}
+
+std::shared_ptr<const bytecode_chunk> compile(const function_base& f, bool statement_hooks) {
+    return bytecode_compiler::compile_function(f, nullptr, statement_hooks);
+}
+
+void disassemble(std::wostream& os, const bytecode_chunk& chunk) {
+    const auto code = chunk.code();
+    for (uint32_t pc = 0; pc < chunk.code_size();) {
+        const auto op = static_cast<opcode>(code[pc]);
+        os << pc << "\t" << op;
+        ++pc;
+        for (uint32_t i = 0, prev = 0; i < num_operands(op); prev = bytecode_chunk::read_operand(&code[pc]), ++i, pc += sizeof(uint32_t)) {
+            const auto operand = bytecode_chunk::read_operand(&code[pc]);
+            // The last two operands of the slot instructions are (depth, slot)
+            if (i == num_operands(op) - 1 && prev == 0 && chunk.layout() && op >= opcode::get_slot && op <= opcode::postfix_slot) {
+                os << ", " << operand << " (" << chunk.layout()->name(operand) << ")";
+                continue;
+            }
+            os << (i ? ", " : "\t") << operand;
+            switch (op) {
+            case opcode::push_number: os << " (" << chunk.number(operand) << ")"; break;
+            case opcode::push_string: [[fallthrough]];
+            case opcode::get_member:  [[fallthrough]];
+            case opcode::put_member:  [[fallthrough]];
+            case opcode::get_method:
+                if (i == 0) os << " (" << chunk.name(operand) << ")";
+                break;
+            case opcode::lookup:      [[fallthrough]];
+            case opcode::put_local:   os << " (" << chunk.name(operand) << ")"; break;
+            case opcode::binary:      [[fallthrough]];
+            case opcode::assign:      [[fallthrough]];
+            case opcode::prefix:      [[fallthrough]];
+            case opcode::postfix:     os << " (" << static_cast<token_type>(operand) << ")"; break;
+            case opcode::assign_slot: [[fallthrough]];
+            case opcode::prefix_slot: [[fallthrough]];
+            case opcode::postfix_slot:
+                if (i == 0) os << " (" << static_cast<token_type>(operand) << ")";
+                break;
+            default: break;
+            }
+        }
+        os << "\n";
+    }
+}
+
+} // namespace mjs
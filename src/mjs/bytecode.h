@@ -0,0 +1,222 @@
+#ifndef MJS_BYTECODE_H
+#define MJS_BYTECODE_H
+
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "property_attribute.h"
+
+namespace mjs {
+
+class expression;
+class statement;
+class block_statement;
+class function_base;
+
+namespace jit { struct chunk_state; }
+
+//
+// Bytecode for the stack based virtual machine in interpreter.cpp
+//
+// Each instruction is a one byte opcode followed by its (32-bit, native endian) operands.
+// Values on the stack may be references (like the result of evaluating an expression in the AST interpreter).
+// Constructs without a dedicated instruction are evaluated by handing the AST node back to the interpreter (eval_expression/eval_statement).
+//
+// In functions that don't use eval or with, identifiers naming parameters and variables are resolved at compile
+// time to (depth, slot) coordinates: 'depth' is the number of scopes to walk up and 'slot' indexes the activation
+// record of the function found there (see frame_layout).
+//
+// Property accesses with a constant name (a.b, a['b']) use get_member/put_member/get_method, whose second operand
+// indexes an inline cache in the chunk remembering where the property was found for the last object shape seen.
+// Other property accesses (a[i]) use get_element/put_element, which avoid converting array indices to strings.
+//
+
+//  name            , number of operands
+#define MJS_OPCODES(X)                  \
+    X( push_undefined   , 0 )           \
+    X( push_null        , 0 )           \
+    X( push_true        , 0 )           \
+    X( push_false       , 0 )           \
+    X( push_number      , 1 )           \
+    X( push_string      , 1 )           \
+    X( pop              , 0 )           \
+    X( lookup           , 1 )           \
+    X( get_slot         , 2 )           \
+    X( set_slot         , 2 )           \
+    X( assign_slot      , 3 )           \
+    X( prefix_slot      , 3 )           \
+    X( postfix_slot     , 3 )           \
+    X( get_value        , 0 )           \
+    X( get_member       , 2 )           \
+    X( put_member       , 2 )           \
+    X( get_method       , 2 )           \
+    X( get_element      , 0 )           \
+    X( to_property_key  , 0 )           \
+    X( put_element      , 0 )           \
+    X( to_object        , 0 )           \
+    X( call_member      , 0 )           \
+    X( get_callee       , 0 )           \
+    X( call             , 2 )           \
+    X( new_             , 2 )           \
+    X( binary           , 1 )           \
+    X( assign           , 1 )           \
+    X( prefix           , 1 )           \
+    X( postfix          , 1 )           \
+    X( jump             , 1 )           \
+    X( jump_if_false    , 1 )           \
+    X( jump_if_true     , 1 )           \
+    X( and_jump         , 1 )           \
+    X( or_jump          , 1 )           \
+    X( eval_expression  , 1 )           \
+    X( statement        , 1 )           \
+    X( statement_done   , 1 )           \
+    X( set_result       , 0 )           \
+    X( clear_result     , 0 )           \
+    X( put_local        , 1 )           \
+    X( define_function  , 1 )           \
+    X( eval_statement   , 1 )           \
+    X( return_          , 0 )           \
+    X( throw_           , 0 )           \
+    X( end              , 0 )
+
+enum class opcode : uint8_t {
+#define MJS_OPCODE_ENUM(name, num_operands) name,
+    MJS_OPCODES(MJS_OPCODE_ENUM)
+#undef MJS_OPCODE_ENUM
+};
+
+std::wostream& operator<<(std::wostream& os, opcode op);
+
+// Size in bytes of an instruction (including its operands)
+uint32_t instruction_size(opcode op);
+
+// Layout of the slot-indexed activation record of a function with statically resolved locals
+class frame_layout {
+public:
+    static constexpr uint32_t no_slot = UINT32_MAX;
+
+    uint32_t size() const { return static_cast<uint32_t>(names_.size()); }
+    const std::u16string& name(uint32_t slot) const { return names_[slot]; }
+    property_attribute attributes(uint32_t slot) const { return attributes_[slot]; }
+
+    // Parameters occupy the first slots
+    uint32_t num_params() const { return num_params_; }
+    uint32_t this_slot() const { return this_slot_; }
+    uint32_t arguments_slot() const { return arguments_slot_; } // no_slot if the function doesn't reference 'arguments'
+    uint32_t id_slot() const { return id_slot_; }               // no_slot for anonymous functions
+
+    uint32_t find(std::u16string_view name) const {
+        for (uint32_t i = 0; i < size(); ++i) {
+            if (names_[i] == name) {
+                return i;
+            }
+        }
+        return no_slot;
+    }
+
+private:
+    friend class bytecode_compiler;
+
+    std::vector<std::u16string> names_;
+    std::vector<property_attribute> attributes_;
+    uint32_t num_params_ = 0;
+    uint32_t this_slot_ = no_slot;
+    uint32_t arguments_slot_ = no_slot;
+    uint32_t id_slot_ = no_slot;
+
+    uint32_t add(const std::u16string& name, property_attribute attributes) {
+        names_.push_back(name);
+        attributes_.push_back(attributes);
+        return size() - 1;
+    }
+};
+
+class bytecode_chunk {
+public:
+    // Loop that can be the target of break/continue
+    struct loop_info {
+        std::vector<std::u16string_view> labels;
+        uint32_t break_pc;
+        uint32_t continue_pc;
+    };
+
+    // Statement evaluated by the AST interpreter
+    struct fallback_info {
+        const statement* s;
+        std::vector<std::u16string_view> labels; // Labels that apply to 's'
+        std::vector<uint32_t> loops;           // Enclosing loops (innermost first) that break/continue completions from 's' can target
+    };
+
+    // Monomorphic inline cache for a property access. Only valid for plain objects.
+    struct property_cache {
+        uint64_t shape_id = 0;        // object_shape::id() of the object (0 if the cache is empty)
+        uint64_t holder_shape_id = 0; // 0 if the property is an own property, otherwise the shape id of the prototype holding it
+        uint32_t index = 0;           // Index of the property in the shape of the holder
+    };
+
+    bool strict_mode() const { return strict_mode_; }
+
+    // The compiled statements
+    const block_statement& block() const { return *block_; }
+
+    // nullptr unless locals are resolved to slots
+    const std::shared_ptr<const frame_layout>& layout() const { return layout_; }
+
+    // Nested functions (compiled knowing the layout of the enclosing functions)
+    const std::vector<std::shared_ptr<const bytecode_chunk>>& functions() const { return functions_; }
+
+    const uint8_t* code() const { return code_.data(); }
+    uint32_t code_size() const { return static_cast<uint32_t>(code_.size()); }
+
+    double number(uint32_t index) const { return numbers_[index]; }
+    const std::u16string& name(uint32_t index) const { return names_[index]; }
+    const expression& expr(uint32_t index) const { return *expressions_[index]; }
+    const statement& stmt(uint32_t index) const { return *statements_[index]; }
+    const loop_info& loop(uint32_t index) const { return loops_[index]; }
+    const fallback_info& fallback(uint32_t index) const { return fallbacks_[index]; }
+    property_cache& cache(uint32_t index) const { return caches_[index]; }
+
+    // State of the JIT compiler for this chunk (created on demand, see jit.h)
+    std::shared_ptr<jit::chunk_state>& jit_state() const { return jit_state_; }
+
+    static uint32_t read_operand(const uint8_t* p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+private:
+    friend class bytecode_compiler;
+
+    bool strict_mode_ = false;
+    const block_statement* block_ = nullptr;
+    std::shared_ptr<const frame_layout> layout_;
+    std::vector<std::shared_ptr<const bytecode_chunk>> functions_;
+    std::vector<uint8_t> code_;
+    std::vector<double> numbers_;
+    std::vector<std::u16string> names_;
+    std::vector<const expression*> expressions_;
+    std::vector<const statement*> statements_;
+    std::vector<loop_info> loops_;
+    std::vector<fallback_info> fallbacks_;
+    mutable std::vector<property_cache> caches_; // Updated while running
+    mutable std::shared_ptr<jit::chunk_state> jit_state_;
+};
+
+// Compile a program (or eval code). The AST must outlive the returned chunk.
+// If 'statement_hooks' is set statement_done instructions are emitted after each statement.
+std::shared_ptr<const bytecode_chunk> compile(const block_statement& bs, bool statement_hooks);
+
+// Compile the body of 'f' without knowledge of any enclosing functions
+std::shared_ptr<const bytecode_chunk> compile(const function_base& f, bool statement_hooks);
+
+void disassemble(std::wostream& os, const bytecode_chunk& chunk);
+
+} // namespace mjs
+
+#endif
@@ -1,4 +1,5 @@
 #include "char_conversions.h"
+#include <ostream>
 
 namespace mjs::unicode {
 
@@ -8,10 +9,10 @@ public:
     const char* what() const noexcept override { return "Unicode conversion failed"; }
 };
 
-std::wstring utf8_to_utf16(const std::string_view in) {
-    std::wstring res;
+std::u16string utf8_to_utf16(const std::string_view in) {
+    std::u16string res;
     const auto l = static_cast<unsigned>(in.length());
-    wchar_t buffer[utf16_max_length];
+    char16_t buffer[utf16_max_length];
     for (unsigned i = 0; i < l;) {
         const auto conv = utf8_to_utf32(&in[i], l - i);
         if (conv.length == invalid_length) {
@@ -28,7 +29,7 @@ std::wstring utf8_to_utf16(const std::string_view in) {
     return res;
 }
 
-std::string utf16_to_utf8(const std::wstring_view in) {
+std::string utf16_to_utf8(const std::u16string_view in) {
     std::string res;
     const auto l = static_cast<unsigned>(in.length());
     char buffer[utf8_max_length];
@@ -49,3 +50,23 @@ std::string utf16_to_utf8(const std::wstring_view in) {
 }
 
 } // namespace mjs::unicode
+
+namespace mjs {
+
+std::wstring to_wstring(std::u16string_view s) {
+    return std::wstring(s.begin(), s.end());
+}
+
+std::u16string to_u16string(std::wstring_view s) {
+    std::u16string res(s.length(), u'\0');
+    for (size_t i = 0; i < s.length(); ++i) {
+        res[i] = static_cast<char16_t>(s[i]);
+    }
+    return res;
+}
+
+std::wostream& operator<<(std::wostream& os, std::u16string_view s) {
+    return os << to_wstring(s);
+}
+
+} // namespace mjs
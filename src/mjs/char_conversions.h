@@ -5,6 +5,7 @@
 #include <cassert>
 #include <string>
 #include <string_view>
+#include <iosfwd>
 
 namespace mjs::unicode {
 
@@ -156,9 +157,19 @@ constexpr unsigned utf32_to_utf16(char32_t code_point, CharT* out) {
     return l;
 }
 
-std::wstring utf8_to_utf16(const std::string_view in);
-std::string utf16_to_utf8(const std::wstring_view in);
+std::u16string utf8_to_utf16(const std::string_view in);
+std::string utf16_to_utf8(const std::u16string_view in);
 
 } // namespace mjs::unicode
 
+namespace mjs {
+
+// Text is stored as UTF-16 code units (char16_t), wide strings/streams are only used for diagnostics and console output.
+// These convert one code unit to one wchar_t (and back).
+std::wstring to_wstring(std::u16string_view s);
+std::u16string to_u16string(std::wstring_view s);
+std::wostream& operator<<(std::wostream& os, std::u16string_view s);
+
+} // namespace mjs
+
 #endif
@@ -157,12 +157,12 @@ struct date_helper {
         return date_helper::make_date(date_helper::make_day(year, month, day), date_helper::make_time(hours, minutes, seconds, ms));
     }
 
-    static constexpr const wchar_t* const invalid_date_string = L"Invalid Date";
+    static constexpr const char16_t* const invalid_date_string = u"Invalid Date";
     static constexpr const wchar_t* const time_format = L"%a %b %d %Y %H:%M:%S";
     static constexpr const wchar_t* const iso_format = L"%Y-%m-%dT%H:%M:%S";
 
-    static double parse(const std::wstring_view s) {
-        std::wistringstream wiss{std::wstring{s}};
+    static double parse(const std::u16string_view s) {
+        std::wistringstream wiss{to_wstring(s)};
         std::tm tm;
         if (wiss >> std::get_time(&tm, iso_format)) {
             auto t = time_from_tm(tm);
@@ -229,7 +229,7 @@ struct date_helper {
         if (tv.type() == value_type::number && !std::isfinite(tv.number_value())) {
             return value::null;
         }
-        auto to_iso = o->get(L"toISOString");
+        auto to_iso = o->get(u"toISOString");
         return call_function(to_iso, value{o}, {});
     }
 
@@ -286,7 +286,7 @@ private:
         if (!std::isnan(value_)) {
             std::snprintf(buffer, sizeof(buffer), "%.17g", value_);
         }
-        os << std::wstring(indent, ' ') << "[[Value]]: " << buffer << "\n";
+        os << std::u16string(indent, ' ') << "[[Value]]: " << buffer << "\n";
     }
 };
 
@@ -419,7 +419,7 @@ global_object_create_result make_date_object(const gc_heap_ptr<global_object>& g
         }, 0);
     };
 
-    auto copy_func = [&](const wchar_t* from, const wchar_t* to) {
+    auto copy_func = [&](const char16_t* from, const char16_t* to) {
         prototype->put(string{h, to}, prototype->get(from), prototype->own_property_attributes(from));
     };
 
@@ -434,9 +434,9 @@ global_object_create_result make_date_object(const gc_heap_ptr<global_object>& g
             if (field3 && args.size() > 3) dt.*field3 = to_number(args[3]);
             return date_helper::time_from_date_time(dt);
         });
-        const std::wstring from{name, name+std::strlen(name)};
-        assert(from.compare(0, 3, L"set") == 0);
-        copy_func(from.c_str(), (L"setUTC" + from.substr(3)).c_str());
+        const std::u16string from{name, name+std::strlen(name)};
+        assert(from.compare(0, 3, u"set") == 0);
+        copy_func(from.c_str(), (u"setUTC" + from.substr(3)).c_str());
     };
 
     make_date_mutator("setTime", [](double, double arg, const std::vector<value>&) {
@@ -462,9 +462,9 @@ global_object_create_result make_date_object(const gc_heap_ptr<global_object>& g
         return value{date_helper::to_string(o.heap(), o->date_value())};
     }, 0);
 
-    copy_func(L"toString", L"toLocaleString");
-    copy_func(L"toString", L"toUTCString");
-    copy_func(L"toString", L"toGMTString");
+    copy_func(u"toString", u"toLocaleString");
+    copy_func(u"toString", u"toUTCString");
+    copy_func(u"toString", u"toGMTString");
 
     if (global->language_version() >= version::es3) {
         put_native_function(global, prototype, "toTimeString", [get_data_object](const value& this_, const std::vector<value>&) {
@@ -477,8 +477,8 @@ global_object_create_result make_date_object(const gc_heap_ptr<global_object>& g
             return value{date_helper::to_date_string(o.heap(), o->date_value())};
         }, 0);
 
-        copy_func(L"toTimeString", L"toLocaleTimeString");
-        copy_func(L"toDateString", L"toLocaleDateString");
+        copy_func(u"toTimeString", u"toLocaleTimeString");
+        copy_func(u"toDateString", u"toLocaleDateString");
     }
 
     if (global->language_version() >= version::es5) {
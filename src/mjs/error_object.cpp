@@ -39,13 +39,13 @@ public:
     string to_string() const {
         auto& h = heap();
         std::wostringstream woss;
-        woss << mjs::to_string(h, get_name()).view() << ": " << mjs::to_string(h, get(L"message")).view();
+        woss << mjs::to_string(h, get_name()).view() << ": " << mjs::to_string(h, get(u"message")).view();
         return string{h, woss.str()};
     }
 
     [[noreturn]] void rethrow() const {
         auto& h = heap();
-        throw native_error_exception{type_, stack_trace_.dereference(h).view(), mjs::to_string(h, get(L"message")).view()};
+        throw native_error_exception{type_, stack_trace_.dereference(h).view(), mjs::to_string(h, get(u"message")).view()};
     }
 
 private:
@@ -66,7 +66,7 @@ private:
     }
 
     void put_name(const value& v) {
-        name_ = value_representation{v};
+        name_ = v;
     }
 
     explicit error_object(native_error_type type, const string& class_name, const object_ptr& prototype, const string& stack_trace)
@@ -82,7 +82,7 @@ static_assert(gc_type_info_registration<error_object>::needs_fixup);
 
 namespace {
 
-std::string get_eval_exception_repr(native_error_type type, const std::wstring_view& stack_trace, const std::wstring_view& msg) {
+std::string get_eval_exception_repr(native_error_type type, const std::u16string_view& stack_trace, const std::u16string_view& msg) {
     std::ostringstream oss;
     oss << type_string(type) << ": "<< std::string(msg.begin(), msg.end());
     if (!stack_trace.empty()) {
@@ -121,7 +121,7 @@ global_object_create_result make_error_object(const gc_heap_ptr<global_object>&
         prototype->put(string{global->heap(), "message"}, value{string{global->heap(), ""}}, message_attributes);
 
         if (!error_constructor) {
-            assert(n.view() == L"Error");
+            assert(n.view() == u"Error");
             error_constructor = constructor;
         } else {
             global->put(n, value{constructor}, property_attribute::dont_enum);
@@ -141,15 +141,19 @@ global_object_create_result make_error_object(const gc_heap_ptr<global_object>&
     return { error_constructor, nullptr };
 }
 
-native_error_exception::native_error_exception(native_error_type type, const std::wstring_view& stack_trace, const std::wstring_view& msg)
+native_error_exception::native_error_exception(native_error_type type, const std::u16string_view& stack_trace, const std::u16string_view& msg)
     : eval_exception{get_eval_exception_repr(type, stack_trace, msg)}
     , type_{type}
     , msg_{msg}
     , stack_trace_{stack_trace} {
 }
 
-native_error_exception::native_error_exception(native_error_type type, const std::wstring_view& stack_trace, const std::string_view& msg)
-    : native_error_exception{type, stack_trace, std::wstring{msg.begin(), msg.end()}} {
+native_error_exception::native_error_exception(native_error_type type, const std::u16string_view& stack_trace, const std::string_view& msg)
+    : native_error_exception{type, stack_trace, std::u16string{msg.begin(), msg.end()}} {
+}
+
+native_error_exception::native_error_exception(native_error_type type, const std::u16string_view& stack_trace, const std::wstring_view& msg)
+    : native_error_exception{type, stack_trace, to_u16string(msg)} {
 }
 
 object_ptr native_error_exception::make_error_object(const gc_heap_ptr<global_object>& global) const {
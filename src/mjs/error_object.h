@@ -22,14 +22,15 @@ public:
 
 class native_error_exception : public eval_exception {
 public:
-    explicit native_error_exception(native_error_type type, const std::wstring_view& stack_trace, const std::wstring_view& msg);
-    explicit native_error_exception(native_error_type type, const std::wstring_view& stack_trace, const std::string_view& msg);
+    explicit native_error_exception(native_error_type type, const std::u16string_view& stack_trace, const std::u16string_view& msg);
+    explicit native_error_exception(native_error_type type, const std::u16string_view& stack_trace, const std::string_view& msg);
+    explicit native_error_exception(native_error_type type, const std::u16string_view& stack_trace, const std::wstring_view& msg);
 
     object_ptr make_error_object(const gc_heap_ptr<global_object>& global) const;
 private:
     native_error_type type_;
-    std::wstring msg_;
-    std::wstring stack_trace_;
+    std::u16string msg_;
+    std::u16string stack_trace_;
 };
 
 [[noreturn]] void rethrow_error(const object_ptr& error);
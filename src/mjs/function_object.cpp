@@ -71,7 +71,7 @@ private:
         , bound_this_{value::undefined}
         , bound_args_{nullptr} {
         if (!args.empty()) {
-            bound_this_ = value_representation{args[0]};
+            bound_this_ = args[0];
             if (args.size() > 1) {
                 bound_args_ =  gc_vector<value_representation>::make(heap_, static_cast<uint32_t>(args.size() - 1));
                 auto a = bound_args_.dereference(heap_);
@@ -223,7 +223,7 @@ global_object_create_result make_function_object(const gc_heap_ptr<global_object
                     if (global->language_version() >= version::es5
                     || (p && p.get() == global->array_prototype().get()) 
                         || global->is_arguments_array(a)) {
-                        const uint32_t len = to_uint32(a->get(L"length"));
+                        const uint32_t len = to_uint32(a->get(u"length"));
                         new_args.resize(len);
                         for (uint32_t i = 0; i < len; ++i) {
                             new_args[i] = a->get(index_string(i));
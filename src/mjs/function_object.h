@@ -26,8 +26,8 @@ public:
     }
 
     void put_prototype_with_attributes(const object_ptr& p, property_attribute attributes) {
-        assert(is_valid(object::own_property_attributes(L"prototype")));
-        prototype_prop_ = value_representation{value{p}};
+        assert(is_valid(object::own_property_attributes(u"prototype")));
+        prototype_prop_ = value{p};
         update_property_attributes("prototype", attributes);
     }
 
@@ -56,7 +56,7 @@ private:
     }
 
     void put_prototype(const value& val) {
-        prototype_prop_ = value_representation{val};
+        prototype_prop_ = val;
     }
 
     explicit function_object(const gc_heap_ptr<global_object>& global, const string& class_name, const object_ptr& prototype);
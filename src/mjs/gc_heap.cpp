@@ -1,8 +1,13 @@
 #include "gc_heap.h"
+#include "platform.h"
 #include <algorithm>
 #include <iomanip>
 #include <sstream>
 #include <cstdlib>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 namespace mjs {
 
@@ -17,68 +22,613 @@ const gc_type_info* gc_type_info::types_[gc_type_info::max_types];
 // gc_heap
 //
 
-gc_heap::gc_heap(uint32_t capacity) : alloc_context_(std::malloc(capacity * sizeof(slot)), capacity), owns_storage_(true) {
-    if (!alloc_context_.storage()) {
-        throw std::runtime_error("Could not allocate heap for " + std::to_string(capacity) + " slots");
+static constexpr uint32_t round_up(uint32_t x, uint32_t multiple) {
+    return static_cast<uint32_t>((static_cast<uint64_t>(x) + multiple - 1) / multiple * multiple);
+}
+
+// Each part of the heap (the nursery and the two halves of the old generation) gets its own (commit granularity aligned) range of address space
+static uint32_t nursery_size(uint32_t capacity) {
+    return std::min(gc_heap::nursery_capacity, capacity / 4);
+}
+
+static uint32_t nursery_stride(uint32_t capacity) {
+    return round_up(nursery_size(capacity), gc_heap::commit_granularity);
+}
+
+static uint32_t half_stride(uint32_t capacity) {
+    return round_up(capacity / 2, gc_heap::commit_granularity);
+}
+
+static uint64_t reserved_size(uint32_t capacity) {
+    return (nursery_stride(capacity) + half_stride(capacity) * 2ULL) * gc_heap::slot_size;
+}
+
+// Halves of the old generation at least this large (in bytes) are backed by large pages when possible
+static constexpr uint64_t large_pages_min_bytes = 64 << 20;
+
+static void* reserve_storage(uint32_t capacity) {
+    if (capacity / 4 < 2 || reserved_size(capacity) / gc_heap::slot_size > UINT32_MAX) {
+        throw std::runtime_error("Invalid heap capacity " + std::to_string(capacity));
     }
+    auto p = virtual_memory_reserve(reserved_size(capacity));
+    if (!p) {
+        throw std::runtime_error("Could not reserve heap for " + std::to_string(capacity) + " slots");
+    }
+    if (const uint64_t half_bytes = half_stride(capacity) * static_cast<uint64_t>(gc_heap::slot_size); half_bytes >= large_pages_min_bytes) {
+        // Fewer TLB misses when copying a large live set (the nursery is small and stays in the cache anyway)
+        virtual_memory_use_large_pages(static_cast<char*>(p) + nursery_stride(capacity) * static_cast<uint64_t>(gc_heap::slot_size), half_bytes * 2);
+    }
+    return p;
 }
 
-gc_heap::gc_heap(void* storage, uint32_t capacity) : alloc_context_(storage, capacity), owns_storage_(false) {
+gc_heap::gc_heap(uint32_t capacity)
+    : nursery_(static_cast<slot*>(reserve_storage(capacity)), 0, nursery_size(capacity), 0, nursery_size(capacity))
+    , alloc_context_(nursery_.storage(), nursery_stride(capacity), nursery_stride(capacity) + capacity/2, nursery_stride(capacity), nursery_stride(capacity) + std::min(capacity/2, initial_capacity), true)
+    , idle_context_(nursery_.storage(), nursery_stride(capacity) + half_stride(capacity), nursery_stride(capacity) + half_stride(capacity) + capacity/2, nursery_stride(capacity) + half_stride(capacity), nursery_stride(capacity) + half_stride(capacity) + std::min(capacity/2, initial_capacity), true)
+    , reserved_bytes_(reserved_size(capacity))
+    , owns_storage_(true) {
+}
+
+gc_heap::gc_heap(void* storage, uint32_t capacity)
+    : nursery_(static_cast<slot*>(storage), 0, 0, 0, 0)
+    , alloc_context_(static_cast<slot*>(storage), 0, capacity/2, capacity/2, capacity/2)
+    , idle_context_(static_cast<slot*>(storage), capacity/2, capacity/2*2, capacity/2*2, capacity/2*2)
+    , reserved_bytes_(0)
+    , owns_storage_(false) {
 }
 
 gc_heap::~gc_heap() {
+    if (gc_state_.incremental) {
+        complete_incremental_collection();
+    }
     assert(gc_state_.initial_state());
+    nursery_.run_destructors();
     alloc_context_.run_destructors();
+    idle_context_.run_destructors();
     if (owns_storage_) {
-        std::free(const_cast<slot*>(alloc_context_.storage()));
+        virtual_memory_release(nursery_.storage(), reserved_bytes_);
     }
     assert(pointers_.empty());
+    assert(root_sets_.empty());
+}
+
+gc_heap::allocation_result gc_heap::allocate(size_t num_bytes, bool needs_destroy) {
+    // Small objects start out in the nursery (if there's room)
+    if (num_bytes < nursery_.max_capacity() * slot_size / 4 && nursery_.can_allocate(1 + bytes_to_slots(num_bytes))) {
+        return nursery_.allocate(num_bytes, needs_destroy);
+    }
+    // While an incremental collection is in progress the old generation is the half being copied to
+    auto& context = gc_state_.incremental ? idle_context_ : alloc_context_;
+    auto a = context.allocate(num_bytes, needs_destroy);
+    if (has_nursery()) {
+        // The object might be initialized with pointers to young objects (or objects the incremental collection
+        // hasn't copied yet) without going through the write barrier
+        context.mark_card(a.pos - 1);
+    }
+    return a;
+}
+
+void gc_heap::register_roots() {
+    // TODO: Used to move the roots lower in the pointers_ array (since we know they won't be destroyed this time around). That still might be an optimization.
+    for (auto p: pointers_) {
+        if (!alloc_context_.is_internal(p) && !nursery_.is_internal(p)) {
+            register_fixup(p->pos_);
+        }
+    }
+    for (auto r: root_sets_) {
+        r->fixup(*this);
+    }
 }
 
 void gc_heap::garbage_collect() {
+    if (gc_state_.incremental) {
+        // Objects that died while it was in progress survive the incremental collection, so still do a full one afterwards
+        complete_incremental_collection();
+    }
+    if (idle_context_.used()) {
+        // Not done destroying the objects that didn't survive the last incremental collection
+        idle_context_.run_destructors();
+    }
     assert(gc_state_.initial_state());
 
     // Determine roots and add their positions as pending fixups
-    // TODO: Used to move the roots lower in the pointers_ array (since we know they won't be destroyed this time around). That still might be an optimization.
+    register_roots();
+    if (weak_table_) {
+        weak_table_->fixup(*this);
+    }
+
+    if (!gc_state_.pending_fixups.empty()) {
+        gc_state_.new_context = &idle_context_;
+        process_fixups();
+        std::swap(alloc_context_, idle_context_);
+        idle_context_.run_destructors();
+        if (owns_storage_ && discard_idle_half_) {
+            idle_context_.discard(initial_capacity);
+        }
+        gc_state_.new_context = nullptr;
+    } else {
+        // Nothing survives
+        for (auto p: gc_state_.weak_fixups) {
+            *p = 0;
+        }
+        gc_state_.weak_fixups.clear();
+        alloc_context_.run_destructors();
+    }
+    nursery_.run_destructors();
+
+    if (weak_table_) {
+        weak_table_->sweep();
+    }
+
+    if (owns_storage_) {
+        adjust_capacity();
+    }
+
+    assert(gc_state_.initial_state());
+}
+
+void gc_heap::minor_garbage_collect() {
+    if (gc_state_.incremental) {
+        // Completing the collection also empties the nursery
+        complete_incremental_collection();
+        return;
+    }
+    if (!has_nursery() || !alloc_context_.can_allocate(nursery_.used())) {
+        // Do a full collection if there's no nursery or the old generation might not be able to hold the survivors
+        garbage_collect();
+        return;
+    }
+
+    assert(gc_state_.initial_state());
+    gc_state_.minor = true;
+
+    // The roots are all pointers into the nursery from outside it (including tracked pointers inside old objects)
+    // Pointers in the other half of the old generation belong to dead objects not yet destroyed after an incremental collection
     for (auto p: pointers_) {
-        if (!alloc_context_.is_internal(p)) {
+        if (is_young(p->pos_) && !nursery_.is_internal(p) && !idle_context_.is_internal(p)) {
             register_fixup(p->pos_);
         }
     }
+    for (auto r: root_sets_) {
+        r->fixup(*this); // Pointers to old objects are left alone by gc_move
+    }
 
-    if (!gc_state_.pending_fixups.empty()) {
-        allocation_context new_ac = alloc_context_.other_half();
+    // And old objects that may have been modified to point into the nursery since the last collection
+    alloc_context_.for_each_dirty_allocation([this](uint32_t pos) {
+        const auto a = alloc_context_.storage()[pos].allocation;
+        if (a.active()) {
+            a.type_info().fixup(slot_at(pos + 1));
+        }
+    });
+    if (weak_table_) {
+        weak_table_->fixup(*this);
+    }
+
+    // Survivors are promoted to the old generation
+    gc_state_.new_context = &alloc_context_;
+    process_fixups();
+    gc_state_.new_context = nullptr;
+    nursery_.run_destructors();
+
+    if (weak_table_) {
+        weak_table_->sweep();
+    }
+
+    gc_state_.minor = false;
+    assert(gc_state_.initial_state());
+}
+
+bool gc_heap::incremental_garbage_collect(std::chrono::microseconds budget) {
+    return incremental_step(step_limit{std::chrono::steady_clock::now() + budget});
+}
+
+bool gc_heap::incremental_garbage_collect(uint32_t max_objects) {
+    return incremental_step(step_limit{std::chrono::steady_clock::time_point::max(), max_objects});
+}
+
+bool gc_heap::incremental_step(const step_limit& limit) {
+    if (!has_nursery()) {
+        garbage_collect();
+        return true;
+    }
+
+    if (!gc_state_.incremental) {
+        if (idle_context_.used()) {
+            return sweep(limit);
+        }
+        start_incremental_collection();
+    }
+
+    // Scan the copied objects until there's nothing left to do or the limit is reached
+    const bool copied = !gc_state_.unscanned.empty();
+    for (uint32_t n = 1; !gc_state_.unscanned.empty(); ++n) {
+        scan_next();
+        if (limit.reached(n)) {
+            return false;
+        }
+    }
+    if (copied) {
+        // Completing the collection (rescanning what changed and updating weak pointers) can't be split up, do it in a step of its own
+        return false;
+    }
+
+    complete_incremental_collection();
+    return sweep(limit);
+}
+
+bool gc_heap::sweep(const step_limit& limit) {
+    // Destroy the objects left in the half of the old generation that was collected
+    if (!idle_context_.run_destructors(limit)) {
+        return false;
+    }
+    if (owns_storage_) {
+        if (discard_idle_half_) {
+            idle_context_.discard(initial_capacity, limit.deadline);
+        }
+        idle_context_.decommit_unused();
+    }
+    return true;
+}
+
+void gc_heap::start_incremental_collection() {
+    // Start out with an empty nursery. Objects allocated after this point are either reached by tracing (in the nursery)
+    // or allocated in the new half of the old generation and scanned when the collection completes.
+    minor_garbage_collect();
+
+    assert(gc_state_.initial_state() && !idle_context_.used());
+    gc_state_.incremental = true;
+    gc_state_.new_context = &idle_context_;
+
+    // The roots may be gone by the time of the next step, so copy what they point to right away rather than keeping their addresses around.
+    // The copied objects are then scanned in the following steps.
+    register_roots();
+    gc_state_.level = 0;
+    move_pending();
+}
+
+void gc_heap::complete_incremental_collection() {
+    assert(gc_state_.incremental);
+
+    // The roots could have changed since the collection started, and objects already copied (or allocated in the new
+    // half) may have been modified to point to objects that haven't been. The write barrier marked the cards of the latter.
+    register_roots();
+    idle_context_.for_each_dirty_allocation([this](uint32_t pos) {
+        const auto a = idle_context_.storage()[pos].allocation;
+        if (a.active()) {
+            a.type_info().fixup(slot_at(pos + 1));
+        }
+    });
+    if (weak_table_) {
+        weak_table_->fixup(*this);
+    }
+
+    process_fixups();
+    gc_state_.incremental = false;
+    std::swap(alloc_context_, idle_context_);
+    gc_state_.new_context = nullptr; // The objects left in idle_context_ are destroyed by sweep()
+    nursery_.run_destructors();
+
+    if (weak_table_) {
+        weak_table_->sweep();
+    }
+
+    if (owns_storage_) {
+        adjust_capacity();
+    }
+
+    assert(gc_state_.initial_state());
+}
 
-        gc_state_.new_context = &new_ac;
-        gc_state_.level = 0;
+//
+// gc_heap::parallel_copier
+//
+
+// The type field of allocation headers is updated atomically while copying in parallel
+static std::atomic<uint32_t>& atomic_type(uint32_t& type) {
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free);
+    return reinterpret_cast<std::atomic<uint32_t>&>(type);
+}
+
+// Copies the live objects of a full collection using several threads. Each thread keeps its pending fixups on a private
+// stack, spilling some of them to a deque idle threads can steal from, and allocates in the new half of the heap from
+// its own buffer. An object is claimed by changing the type in its allocation header to gc_busy_type_index (so each one
+// is only copied once) and forwarded by setting it to gc_moved_type_index once the new position has been stored.
+// Objects with destructors may hold tracked pointers, whose construction modifies the heap's pointer set, so they're
+// left to the calling thread (which moves them using gc_move).
+class gc_heap::parallel_copier {
+public:
+    // Heaps with fewer slots in use than this are not worth starting threads for
+    static constexpr uint32_t min_used_slots = 1 << 18;
+
+    explicit parallel_copier(gc_heap& heap, uint32_t num_threads) : heap_(heap), workers_(num_threads) {
+        assert(num_threads > 1 && !heap.gc_state_.minor && !heap.gc_state_.incremental);
+    }
+
+    // Process the pending fixups of the heap (and those registered while doing so)
+    void run() {
+        // Hand out the roots round robin
+        auto& pending = heap_.gc_state_.pending_fixups;
+        for (size_t i = 0; i < pending.size(); ++i) {
+            workers_[i % workers_.size()].shared.push_back(pending[i]);
+        }
+        for (auto& w: workers_) {
+            w.shared_size.store(w.shared.size(), std::memory_order_relaxed);
+        }
+        pending_.store(pending.size(), std::memory_order_relaxed);
+        pending.clear();
+
+        heap_.gc_state_.copier = this;
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < workers_.size(); ++i) {
+            try {
+                threads.emplace_back([this, i] { work(workers_[i]); });
+            } catch (const std::system_error&) {
+                // Make do with the threads already started (the work of the others is stolen)
+                break;
+            }
+        }
+        work(workers_[0]);
+        for (auto& t: threads) {
+            t.join();
+        }
+        heap_.gc_state_.copier = nullptr;
 
-        // Keep going while there are still fixups to be processed (note: the array changes between loop iterations)
-        while (!gc_state_.pending_fixups.empty()) {
-            auto ppos = gc_state_.pending_fixups.back();
-            gc_state_.pending_fixups.pop_back();
-            *ppos = gc_move(*ppos);
+        for (auto& w: workers_) {
+            close_buffer(w);
+            heap_.gc_state_.weak_fixups.insert(heap_.gc_state_.weak_fixups.end(), w.weak_fixups.begin(), w.weak_fixups.end());
+        }
+        if (error_) {
+            std::rethrow_exception(error_);
         }
+    }
 
-        // Handle weak pointers - if they moved update, otherwise invalidate
-        for (auto& p: gc_state_.weak_fixups) {
-            assert(alloc_context_.pos_inside(*p - 1));
-            auto a = alloc_context_.get_at(*p - 1)->allocation;
-            if (a.type == gc_moved_type_index) {
-                *p = alloc_context_.get_at(*p)->new_position;
+    // Called (through register_fixup/register_weak_fixup) by the fixup functions of copied objects
+    void push(uint32_t* p) {
+        auto& w = *current_;
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        w.local.push_back(p);
+        if (w.local.size() >= 2 * batch_size && !w.shared_size.load(std::memory_order_relaxed)) {
+            // Make some of the work available to other threads
+            std::lock_guard<std::mutex> lock{w.mutex};
+            w.shared.insert(w.shared.end(), w.local.end() - batch_size, w.local.end());
+            w.shared_size.store(w.shared.size(), std::memory_order_relaxed);
+            w.local.resize(w.local.size() - batch_size);
+        }
+    }
+
+    void push_weak(uint32_t* p) {
+        current_->weak_fixups.push_back(p);
+    }
+
+    // Allocate directly in the new half of the heap (used by gc_move in the calling thread)
+    allocation_result allocate_shared(size_t num_bytes, bool needs_destroy) {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return heap_.gc_state_.new_context->allocate(num_bytes, needs_destroy);
+    }
+
+private:
+    // Number of slots in the per-thread allocation buffers
+    static constexpr uint32_t buffer_slots = 1 << 12;
+    // Number of pending fixups moved between threads at a time
+    static constexpr size_t batch_size = 64;
+
+    struct worker {
+        std::vector<uint32_t*> local;       // Pending fixups only accessed by the owning thread
+        std::mutex             mutex;       // Protects 'shared'
+        std::deque<uint32_t*>  shared;      // Pending fixups other threads may steal
+        std::atomic<size_t>    shared_size{0};
+        std::vector<uint32_t*> weak_fixups;
+        uint32_t               next = 0;    // Allocation buffer [next, end) in the new half of the heap
+        uint32_t               end = 0;
+    };
+
+    gc_heap&                heap_;
+    std::vector<worker>     workers_;           // workers_[0] belongs to the calling thread
+    std::atomic<size_t>     pending_{0};        // Pending fixups (queued or being processed)
+    std::mutex              serial_mutex_;
+    std::vector<uint32_t*>  serial_;            // Fixups of objects only the calling thread may move
+    std::atomic<size_t>     serial_size_{0};
+    std::mutex              mutex_;             // Protects allocation in the new half of the heap and 'error_'
+    std::exception_ptr      error_;
+    std::atomic<bool>       failed_{false};
+
+    static thread_local worker* current_;
+
+    void work(worker& w) {
+        current_ = &w;
+        const bool calling_thread = &w == &workers_[0];
+        try {
+            while (!failed_.load(std::memory_order_relaxed)) {
+                uint32_t* p;
+                if (calling_thread && (p = pop_serial()) != nullptr) {
+                    *p = heap_.gc_move(*p);
+                } else if ((p = pop(w)) != nullptr) {
+                    if (const auto pos = copy(*p)) {
+                        *p = pos;
+                    } else {
+                        // Still pending, but now for the calling thread
+                        std::lock_guard<std::mutex> lock{serial_mutex_};
+                        serial_.push_back(p);
+                        serial_size_.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+                } else if (!pending_.load(std::memory_order_acquire)) {
+                    break;
+                } else {
+                    std::this_thread::yield();
+                    continue;
+                }
+                // Fixups registered while processing 'p' were counted before it's marked as done
+                pending_.fetch_sub(1, std::memory_order_acq_rel);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock{mutex_};
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+            failed_.store(true, std::memory_order_relaxed);
+        }
+        current_ = nullptr;
+    }
+
+    uint32_t* pop(worker& w) {
+        if (w.local.empty()) {
+            // Take back shared work, otherwise steal some from the other threads
+            const auto n = workers_.size();
+            const auto self = &w - workers_.data();
+            for (size_t i = 0; i < n && w.local.empty(); ++i) {
+                auto& v = workers_[(self + i) % n];
+                if (!v.shared_size.load(std::memory_order_relaxed)) {
+                    continue;
+                }
+                std::lock_guard<std::mutex> lock{v.mutex};
+                const auto count = std::min(v.shared.size(), batch_size);
+                w.local.insert(w.local.end(), v.shared.begin(), v.shared.begin() + count);
+                v.shared.erase(v.shared.begin(), v.shared.begin() + count);
+                v.shared_size.store(v.shared.size(), std::memory_order_relaxed);
+            }
+            if (w.local.empty()) {
+                return nullptr;
+            }
+        }
+        auto p = w.local.back();
+        w.local.pop_back();
+        return p;
+    }
+
+    uint32_t* pop_serial() {
+        if (!serial_size_.load(std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> lock{serial_mutex_};
+        if (serial_.empty()) {
+            return nullptr;
+        }
+        auto p = serial_.back();
+        serial_.pop_back();
+        serial_size_.fetch_sub(1, std::memory_order_relaxed);
+        return p;
+    }
+
+    // Copy the object at 'pos' (unless that has already been done) and return its new position,
+    // or 0 if it must be moved by the calling thread
+    uint32_t copy(uint32_t pos) {
+        auto& type = atomic_type(heap_.slot_at(pos-1)->allocation.type);
+        auto t = type.load(std::memory_order_acquire);
+        for (;;) {
+            if (t == gc_moved_type_index) {
+                return heap_.slot_at(pos)->new_position;
+            } else if (t == gc_busy_type_index) {
+                std::this_thread::yield();
+                t = type.load(std::memory_order_acquire);
             } else {
-                *p = 0;
+                assert(t < gc_type_info::num_types());
+                if (gc_type_info::from_index(t).needs_destroy()) {
+                    return 0;
+                }
+                if (type.compare_exchange_weak(t, gc_busy_type_index, std::memory_order_acquire)) {
+                    break;
+                }
             }
         }
-        gc_state_.weak_fixups.clear();
 
-        std::swap(alloc_context_, new_ac);
-        new_ac.run_destructors();
-        gc_state_.new_context = nullptr;
-    } else {
-        alloc_context_.run_destructors();
+        const auto& type_info = gc_type_info::from_index(t);
+        auto new_obj = allocate(*current_, heap_.slot_at(pos-1)->allocation.size);
+        type_info.move(new_obj.obj, heap_.slot_at(pos));
+        new_obj.hdr().type = t;
+        heap_.slot_at(pos)->new_position = new_obj.pos;
+        type.store(gc_moved_type_index, std::memory_order_release);
+
+        type_info.fixup(new_obj.obj);
+        return new_obj.pos;
     }
 
-    assert(gc_state_.initial_state());
+    allocation_result allocate(worker& w, uint32_t num_slots) {
+        if (num_slots > w.end - w.next) {
+            if (num_slots > buffer_slots / 4) {
+                return allocate_shared((num_slots - 1) * slot_size, false);
+            }
+            close_buffer(w);
+            try {
+                const auto a = allocate_shared((buffer_slots - 1) * slot_size, false);
+                w.next = a.pos - 1;
+                w.end = w.next + buffer_slots;
+            } catch (const std::bad_alloc&) {
+                // The new half may still have room for the object itself
+                return allocate_shared((num_slots - 1) * slot_size, false);
+            }
+        }
+        const auto pos = w.next;
+        w.next += num_slots;
+        auto s = heap_.gc_state_.new_context->storage();
+        s[pos].allocation.size = num_slots;
+        s[pos].allocation.type = uninitialized_type_index;
+        return { pos + 1, &s[pos + 1] };
+    }
+
+    // Cover what's left of the allocation buffer with an inactive allocation (so the allocations can still be walked)
+    void close_buffer(worker& w) {
+        if (w.next < w.end) {
+            auto& a = heap_.gc_state_.new_context->storage()[w.next].allocation;
+            a.size = w.end - w.next;
+            a.type = uninitialized_type_index;
+        }
+        w.next = w.end = 0;
+    }
+};
+
+thread_local gc_heap::parallel_copier::worker* gc_heap::parallel_copier::current_;
+
+void gc_heap::process_fixups() {
+    gc_state_.level = 0;
+
+    if (gc_threads_ > 1 && !gc_state_.minor && !gc_state_.incremental && alloc_context_.used() + nursery_.used() >= parallel_copier::min_used_slots) {
+        parallel_copier{*this, gc_threads_}.run();
+    }
+
+    move_pending();
+    while (!gc_state_.unscanned.empty()) {
+        scan_next();
+    }
+
+    // Handle weak pointers - if they moved update, otherwise invalidate
+    for (auto& p: gc_state_.weak_fixups) {
+        if (gc_state_.minor && !is_young(*p)) {
+            // Old objects are always kept alive by a minor collection
+            continue;
+        }
+        if (gc_state_.incremental && (!*p || gc_state_.new_context->pos_inside(*p))) {
+            // Already updated (or stored after the object was copied). An incremental collection can register the same
+            // weak pointer twice (once when its owner was copied and once more if the owner's card was dirtied), so it
+            // may also already have been cleared.
+            continue;
+        }
+        auto a = slot_at(*p - 1)->allocation;
+        if (a.type == gc_moved_type_index) {
+            *p = slot_at(*p)->new_position;
+        } else {
+            *p = 0;
+        }
+    }
+    gc_state_.weak_fixups.clear();
+}
+
+void gc_heap::adjust_capacity() {
+    // Size the heap based on how much survived the collection. Grow when more than half of the capacity is live
+    // and shrink when less than a quarter is (the gap avoids oscillating between sizes).
+    const auto live = alloc_context_.used();
+    auto cap = alloc_context_.capacity();
+    if (live > cap / 2) {
+        cap = live > UINT32_MAX / 2 ? UINT32_MAX : live * 2;
+    } else if (live < cap / 4) {
+        cap = std::max(live * 2, initial_capacity);
+    }
+    cap = std::min(round_up(cap, commit_granularity), alloc_context_.max_capacity());
+
+    alloc_context_.capacity(cap);
+    idle_context_.capacity(cap);
+    alloc_context_.decommit_unused();
+    idle_context_.decommit_unused();
 }
 
 uint32_t gc_heap::gc_move(const uint32_t pos) {
@@ -88,28 +638,38 @@ uint32_t gc_heap::gc_move(const uint32_t pos) {
         uint32_t& l;
     } al{gc_state_.level};
 
-    assert(alloc_context_.pos_inside(pos-1));
+    if (gc_state_.minor && !is_young(pos)) {
+        // Only objects in the nursery are moved by minor collections
+        return pos;
+    }
+
+    if (gc_state_.incremental && gc_state_.new_context->pos_inside(pos)) {
+        // Already copied (or allocated after the incremental collection started)
+        return pos;
+    }
+
+    assert(pos_inside(pos-1));
 
-    auto& a = alloc_context_.get_at(pos-1)->allocation;
+    auto& a = slot_at(pos-1)->allocation;
     assert(a.type != uninitialized_type_index);
-    assert(a.size > 1 && a.size <= alloc_context_.next_free() - (pos - 1));
+    assert(a.size > 1 && a.size <= (is_young(pos) ? nursery_ : alloc_context_).next_free() - (pos - 1));
 
     if (a.type == gc_moved_type_index) {
-        return alloc_context_.get_at(pos)->new_position;
+        return slot_at(pos)->new_position;
     }
 
     assert(a.type < gc_type_info::num_types());
 
     // Allocate memory block in new_heap of the same size
-    auto new_obj = gc_state_.new_context->allocate((a.size-1)*slot_size);
+    const auto& type_info = a.type_info();
+    auto new_obj = gc_state_.copier ? gc_state_.copier->allocate_shared((a.size-1)*slot_size, type_info.needs_destroy()) : gc_state_.new_context->allocate((a.size-1)*slot_size, type_info.needs_destroy());
     assert(new_obj.hdr().type == uninitialized_type_index && new_obj.hdr().size == a.size);
 
     // Record number of pointers that exist before constructing the new object
     const auto num_pointers_initially = pointers_.size();
 
     // Move the object to its new position
-    const auto& type_info = a.type_info();
-    void* const p = alloc_context_.get_at(pos);
+    void* const p = slot_at(pos);
     type_info.move(new_obj.obj, p);
     new_obj.hdr().type = a.type;
 
@@ -131,28 +691,68 @@ uint32_t gc_heap::gc_move(const uint32_t pos) {
     // There should now be the same amount of pointers (otherwise something went wrong with moving/destroying the object)
     assert(pointers_.size() == num_pointers_initially);
 
-    // Record the object's new position at the old position
-    a.type = gc_moved_type_index;
-    alloc_context_.get_at(pos)->new_position = new_obj.pos;
+    // Record the object's new position at the old position (before marking it as moved, other threads may be looking at it)
+    slot_at(pos)->new_position = new_obj.pos;
+    atomic_type(a.type).store(gc_moved_type_index, std::memory_order_release);
 
     // After changing the allocation header infinite recursion can now be avoided when copying the internal pointers.
 
     // Let the object register its fixup
-    type_info.fixup(new_obj.obj);
+    if (gc_state_.incremental) {
+        // Not until the object is scanned (see scan_next)
+        gc_state_.unscanned.push_back(new_obj.pos);
+    } else {
+        type_info.fixup(new_obj.obj);
+    }
 
     return new_obj.pos;
 }
 
+void gc_heap::shrink(const gc_heap_ptr_untyped& p, size_t num_bytes) {
+    if (gc_state_.incremental) {
+        // Pending fixups may point into the memory that would be freed (or the object may have been copied already), just leave it
+        return;
+    }
+    assert(p.heap_ == this && gc_state_.initial_state());
+    (is_young(p.pos_) ? nursery_ : alloc_context_).shrink(p.pos_ - 1, 1 + bytes_to_slots(num_bytes));
+}
+
+void gc_heap::move_pending() {
+    // Keep going while there are still fixups to be processed (note: the array changes between loop iterations)
+    while (!gc_state_.pending_fixups.empty()) {
+        auto ppos = gc_state_.pending_fixups.back();
+        gc_state_.pending_fixups.pop_back();
+        *ppos = gc_move(*ppos);
+    }
+}
+
+void gc_heap::scan_next() {
+    // Let the object register its fixups now and handle them right away. The program may store anything (a number, null, ...) in
+    // an object between incremental steps, so the addresses of its pointers can't be kept around.
+    const auto pos = gc_state_.unscanned.back();
+    gc_state_.unscanned.pop_back();
+    slot_at(pos - 1)->allocation.type_info().fixup(slot_at(pos));
+    move_pending();
+}
+
 void gc_heap::register_fixup(uint32_t& pos) {
-    gc_state_.pending_fixups.push_back(&pos);
+    if (gc_state_.copier) {
+        gc_state_.copier->push(&pos);
+    } else {
+        gc_state_.pending_fixups.push_back(&pos);
+    }
 }
 
 void gc_heap::register_weak_fixup(uint32_t& pos) {
-    gc_state_.weak_fixups.push_back(&pos);
+    if (gc_state_.copier) {
+        gc_state_.copier->push_weak(&pos);
+    } else {
+        gc_state_.weak_fixups.push_back(&pos);
+    }
 }
 
 void gc_heap::attach(gc_heap_ptr_untyped& p) {
-    assert(p.heap_ == this && alloc_context_.pos_inside(p.pos_));
+    assert(p.heap_ == this && pos_inside(p.pos_));
     pointers_.insert(p);
 }
 
@@ -161,38 +761,125 @@ void gc_heap::detach(gc_heap_ptr_untyped& p) {
     pointers_.erase(p);
 }
 
-gc_heap::allocation_result gc_heap::allocation_context::allocate(size_t num_bytes) {
+gc_heap::allocation_result gc_heap::allocation_context::allocate(size_t num_bytes, bool needs_destroy) {
     if (!num_bytes || num_bytes >= UINT32_MAX) {
         assert(!"Invalid allocation size");
         throw std::bad_alloc{};
     }
 
     const auto num_slots = 1 + bytes_to_slots(num_bytes);
-    if (num_slots > capacity_ || next_free_ > capacity_ - num_slots) {
-        assert(!"Not implemented: Ran out of heap");
+    if (num_slots > end_ - start_ || next_free_ > end_ - num_slots) {
         throw std::bad_alloc{};
     }
+    if (next_free_ + num_slots > committed_) {
+        // Commit at least up to the soft capacity, and then in multiples of the commit granularity
+        const auto new_committed = round_up(std::max(next_free_ + num_slots, limit_), commit_granularity);
+        if (!virtual_memory_commit(&storage_[committed_], (new_committed - committed_) * slot_size)) {
+            throw std::bad_alloc{};
+        }
+        committed_ = new_committed;
+        if (track_cards_) {
+            resize_cards();
+        }
+    }
     const auto pos = next_free_;
     next_free_ += num_slots;
     storage_[pos].allocation.size = num_slots;
     storage_[pos].allocation.type = uninitialized_type_index;
+    if (needs_destroy) {
+        finalizers_.push_back(pos);
+    }
+    if (track_cards_) {
+        // Record the allocation as the first one for the cards that start inside it
+        constexpr uint32_t card_size = 1 << card_shift;
+        for (uint32_t card = (pos - start_ + card_size - 1) >> card_shift; (card << card_shift) < next_free_ - start_; ++card) {
+            card_first_[card] = pos;
+        }
+    }
     return { pos + 1, &storage_[pos + 1] };
 }
 
-void gc_heap::allocation_context::run_destructors() {
-    for (uint32_t pos = start_; pos < next_free_;) {
+template<typename F>
+void gc_heap::allocation_context::for_each_dirty_allocation(F f) {
+    assert(track_cards_);
+    const auto end = next_free_;
+    uint32_t pos = start_;
+    for (uint32_t card = 0, num_cards = static_cast<uint32_t>(card_dirty_.size()); card < num_cards; ++card) {
+        if (!card_dirty_[card]) {
+            continue;
+        }
+        card_dirty_[card] = false;
+        const auto card_start = start_ + (card << card_shift);
+        if (card_start >= end) {
+            continue;
+        }
+        // Start from the allocation covering the start of the card (unless it has already been visited)
+        pos = std::max(pos, card_first_[card]);
+        for (const auto card_end = std::min(end, card_start + (1 << card_shift)); pos < card_end; pos += storage_[pos].allocation.size) {
+            f(pos);
+        }
+    }
+}
+
+void gc_heap::allocation_context::shrink(uint32_t pos, uint32_t num_slots) {
+    auto& a = storage_[pos].allocation;
+    assert(pos_inside(pos) && num_slots > 1 && num_slots <= a.size);
+    if (pos + a.size == next_free_) {
+        next_free_ = pos + num_slots;
+    } else if (num_slots < a.size) {
+        // Leave an inactive allocation covering the rest, so the allocations can still be walked
+        storage_[pos + num_slots].allocation.size = a.size - num_slots;
+        storage_[pos + num_slots].allocation.type = uninitialized_type_index;
+    }
+    a.size = num_slots;
+}
+
+bool gc_heap::allocation_context::run_destructors(const step_limit& limit) {
+    // Only the recorded allocations are visited, the memory of the other dead objects is never touched. Allocations
+    // that have been moved (or never got constructed) are skipped.
+    for (const auto num_finalizers = static_cast<uint32_t>(finalizers_.size()); sweep_index_ < num_finalizers;) {
+        const auto pos = finalizers_[sweep_index_++];
         const auto a = storage_[pos].allocation;
         if (a.active()) {
             a.type_info().destroy(&storage_[pos+1]);
         }
-        pos += a.size;
+        if (limit.reached(sweep_index_)) {
+            return false;
+        }
     }
 
+    finalizers_.clear();
+    sweep_index_ = 0;
     next_free_ = start_;
+    card_dirty_.assign(card_dirty_.size(), false);
+    return true;
 }
 
-gc_heap::allocation_context gc_heap::allocation_context::other_half() {
-    return allocation_context{ storage_, start_ ? capacity_ / 2 : capacity_ * 2, start_ ? 0 : capacity_ };
+void gc_heap::allocation_context::discard(uint32_t keep, std::chrono::steady_clock::time_point deadline) {
+    // Keeping the start avoids page faults when small heaps are collected often
+    assert(!used());
+    const auto from = std::min(round_up(start_ + keep, commit_granularity), committed_);
+    // Discarding many megabytes takes a while, so it's done a piece (1 MB) at a time checking the deadline in between
+    constexpr uint32_t piece = commit_granularity * 16;
+    for (auto to = committed_; to > from;) {
+        const auto start = to - std::min(piece, to - from);
+        virtual_memory_discard(&storage_[start], (to - start) * slot_size);
+        to = start;
+        if (std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+    }
+}
+
+void gc_heap::allocation_context::decommit_unused() {
+    const auto keep = round_up(std::max(next_free_, limit_), commit_granularity);
+    if (committed_ > keep) {
+        virtual_memory_decommit(&storage_[keep], (committed_ - keep) * slot_size);
+        committed_ = keep;
+        if (track_cards_) {
+            resize_cards();
+        }
+    }
 }
 
 } // namespace mjs
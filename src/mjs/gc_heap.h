@@ -10,6 +10,8 @@
 #include <cassert>
 #include <cstddef>
 #include <cstring>
+#include <memory>
+#include <chrono>
 
 namespace mjs {
 
@@ -33,6 +35,11 @@ public:
         }
     }
 
+    // Does destroy() do anything? (i.e. must the object be finalized when it's garbage collected)
+    bool needs_destroy() const {
+        return destroy_ != nullptr;
+    }
+
     // Move the object from 'from' to 'to'
     void move(void* to, void* from) const {
         move_(to, from);
@@ -168,6 +175,27 @@ private:
 template<typename T>
 const gc_type_info_registration<T> gc_type_info_registration<T>::reg;
 
+// Table outside the heap with weak references (gc_heap_weak_ptr_untracked) to objects inside it, see gc_heap::weak_table()
+class gc_weak_table {
+public:
+    virtual ~gc_weak_table() = default;
+
+    // Called during garbage collection to register the weak pointers held (by calling their fixup function)
+    virtual void fixup(gc_heap& h) = 0;
+
+    // Called at the end of garbage collection, when the weak pointers to collected objects have been reset
+    virtual void sweep() = 0;
+};
+
+// Roots outside the heap that aren't tracked pointers (e.g. arrays of value_representation), see gc_heap::add_root_set()
+class gc_root_set {
+public:
+    virtual ~gc_root_set() = default;
+
+    // Called during garbage collection to register the pointers held (by calling their fixup function)
+    virtual void fixup(gc_heap& h) = 0;
+};
+
 class gc_heap {
 public:
     friend gc_heap_ptr_untyped;
@@ -177,16 +205,79 @@ public:
     static constexpr uint32_t slot_size = sizeof(uint64_t);
     static constexpr uint32_t bytes_to_slots(size_t bytes) { return static_cast<uint32_t>((bytes + slot_size - 1) / slot_size); }
 
+    // Granularity (in slots) of memory committed to the heap. Each half of the heap is aligned to this.
+    static constexpr uint32_t commit_granularity = (64 << 10) / slot_size;
+    // The heap starts out with this capacity and won't shrink below it
+    static constexpr uint32_t initial_capacity   = 1 << 16;
+    // Maximum size of the young generation (nursery) in slots
+    static constexpr uint32_t nursery_capacity   = 1 << 16;
+
+    // Create a heap that can grow to at most 'capacity' slots (address space is reserved up front, but only committed as needed)
+    // New objects are allocated in a separate young generation (nursery), that can be collected by minor_garbage_collect()
     explicit gc_heap(uint32_t capacity);
+    // Create a fixed size heap (without a young generation) using 'storage' (which must be able to hold 'capacity' slots)
     explicit gc_heap(void* storage, uint32_t capacity);
     gc_heap(gc_heap&) = delete;
     gc_heap& operator=(gc_heap&) = delete;
     ~gc_heap();
 
-    int use_percentage() const { return alloc_context_.use_percentage(); }
+    int use_percentage() const { return gc_state_.incremental ? static_cast<int>(used() * 100ULL / std::max(capacity(), 1U)) : alloc_context_.use_percentage(); }
+    int nursery_use_percentage() const { return nursery_.use_percentage(); }
+
+    // Number of slots in use in the old generation (including the half objects are copied to during an incremental collection)
+    uint32_t used() const { return alloc_context_.used() + (gc_state_.incremental ? idle_context_.used() : 0); }
+
+    // Current (soft) capacity of the active half of the heap in slots. Adjusted by garbage_collect() to track the live set.
+    uint32_t capacity() const { return alloc_context_.capacity(); }
 
+    // Number of slots the old generation can grow to
+    uint32_t max_capacity() const { return alloc_context_.max_capacity(); }
+
+    // Collect the whole heap
     void garbage_collect();
 
+    // Collect only the young generation, surviving objects are promoted to the old generation
+    // Falls back to a full collection if the heap doesn't have a young generation
+    void minor_garbage_collect();
+
+    // Collect the whole heap incrementally: do (roughly) at most 'budget' worth of work and return, so the program can
+    // run between the steps. Copying the live objects and destroying the dead ones is split into steps, but a single
+    // object is always copied in one go and objects modified after being copied are scanned again by the final step.
+    // Starts a new collection if none is in progress, returns true once it has completed.
+    // Objects that die while the collection is in progress are only reclaimed by the next one.
+    // garbage_collect()/minor_garbage_collect() finish the collection in progress first.
+    // Heaps without a young generation are collected all at once.
+    bool incremental_garbage_collect(std::chrono::microseconds budget);
+
+    // Same, but a step scans (or destroys) at most 'max_objects' objects regardless of the time it takes. Since the steps
+    // don't depend on timing this is useful for testing (see MJS_GC_INCREMENTAL_STRESS_TEST).
+    bool incremental_garbage_collect(uint32_t max_objects);
+
+    // Is an incremental collection in progress? (including destroying the objects that didn't survive it)
+    bool incremental_collection_active() const { return gc_state_.incremental || idle_context_.used(); }
+
+    // Number of threads garbage_collect() uses to copy the live objects (the calling thread included, 1 by default).
+    // Objects with destructors are always moved by the calling thread, and small heaps are collected by it alone.
+    uint32_t gc_threads() const { return gc_threads_; }
+    void gc_threads(uint32_t num_threads) { gc_threads_ = std::max(num_threads, 1U); }
+
+    // Give the memory of the half of the old generation that's only used while collecting back to the system after each
+    // collection (on by default). Halves the memory used by large heaps between collections, at the cost of page faults
+    // when the next one copies the live objects there.
+    bool discard_idle_half() const { return discard_idle_half_; }
+    void discard_idle_half(bool discard) { discard_idle_half_ = discard; }
+
+    // Must be called after writing pointers to heap objects (gc_heap_ptr_untracked/value_representation) to the heap object at 'p'
+    // without going through their constructors/assignment operators taking a tracked pointer/value (e.g. when copying them)
+    void write_barrier(const void* p) {
+        if (has_nursery() && alloc_context_.is_internal(p)) {
+            alloc_context_.mark_card(slot_position(p));
+        } else if (gc_state_.incremental && idle_context_.is_internal(p)) {
+            // Objects already copied by the incremental collection are scanned again before it completes
+            idle_context_.mark_card(slot_position(p));
+        }
+    }
+
     template<typename T, typename... Args>
     gc_heap_ptr<T> allocate_and_construct(size_t num_bytes, Args&&... args);
 
@@ -198,9 +289,32 @@ public:
     template<typename T>
     gc_heap_ptr<T> unsafe_track(const T& val);
 
+    // Shrink the allocation holding the object 'p' points to, so it's 'num_bytes' large (the object must fit)
+    // The memory is reused right away if it was the most recent allocation, otherwise it's reclaimed by the next collection
+    void shrink(const gc_heap_ptr_untyped& p, size_t num_bytes);
+
+    // Weak table owned by the heap (e.g. the atom table, see string.h) or nullptr if none has been installed
+    gc_weak_table* weak_table() const { return weak_table_.get(); }
+    void weak_table(std::unique_ptr<gc_weak_table>&& t) {
+        assert(!weak_table_);
+        weak_table_ = std::move(t);
+    }
+
+    // Register/unregister a root set, it must be removed before it's destroyed
+    void add_root_set(gc_root_set& r) {
+        root_sets_.push_back(&r);
+    }
+    void remove_root_set(gc_root_set& r) {
+        // Usually the most recently added one
+        auto it = std::find(root_sets_.rbegin(), root_sets_.rend(), &r);
+        assert(it != root_sets_.rend());
+        root_sets_.erase(std::next(it).base());
+    }
+
 private:
     static constexpr uint32_t uninitialized_type_index = UINT32_MAX;
     static constexpr uint32_t gc_moved_type_index      = uninitialized_type_index-1;
+    static constexpr uint32_t gc_busy_type_index       = gc_moved_type_index-1; // Being copied by another thread (see parallel_copier in gc_heap.cpp)
 
     struct slot_allocation_header {
         uint32_t size; // size in slots including the allocation header
@@ -241,30 +355,9 @@ private:
 
         gc_heap_ptr_untyped** data() { return set_; }
 
-        void insert(gc_heap_ptr_untyped& p) {
-            // Note: garbage_collect() assumes nodes are added to the back
-            // assert(std::find(begin(), end(), &p) == end()); // Other asserts should catch this
-            if (size_ == capacity_) {
-                const auto new_cap = capacity_ * 2;
-                auto n = alloc(new_cap);
-                std::memcpy(n, set_, size_*sizeof(gc_heap_ptr_untyped*));
-                std::free(set_);
-                set_ = n;
-                capacity_ = new_cap;
-            }
-            set_[size_++] = &p;
-        }
-
-        void erase(const gc_heap_ptr_untyped& p) {
-            // Search from the back since objects tend to be short lived
-            for (uint32_t i = size_; i--;) {
-                if (set_[i] == &p) {
-                    std::swap(set_[i], set_[--size_]);
-                    return;
-                }
-            }
-            assert(!"Pointer not found in set!");
-        }
+        // Both are O(1): each pointer knows its own index in the set
+        void insert(gc_heap_ptr_untyped& p);
+        void erase(gc_heap_ptr_untyped& p);
     private:
         gc_heap_ptr_untyped** set_;
         uint32_t capacity_;
@@ -277,6 +370,17 @@ private:
         }
     };
 
+    // How much an incremental step may do
+    struct step_limit {
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+        uint32_t max_objects = UINT32_MAX;
+
+        // Should the step stop after having handled 'n' objects? (only checks the clock every so often)
+        bool reached(uint32_t n) const {
+            return n >= max_objects || (n % 64 == 0 && std::chrono::steady_clock::now() >= deadline);
+        }
+    };
+
     struct allocation_result {
         uint32_t pos;
         slot* obj;
@@ -285,29 +389,60 @@ private:
     };
 
     class allocation_context {
-    public:    
-        explicit allocation_context(void* s, uint32_t capacity) : allocation_context(static_cast<slot*>(s), capacity/2, 0) {
+    public:
+        // The context owns the slots [start, end) of 'storage', of which [start, committed) are currently accessible.
+        // 'limit' is the soft capacity used when reporting the use percentage, allocation may proceed past it (committing more memory as needed).
+        // If 'track_cards' is set a card table is maintained so objects modified since the last minor collection can be found.
+        explicit allocation_context(slot* storage, uint32_t start, uint32_t end, uint32_t committed, uint32_t limit, bool track_cards = false)
+            : storage_(storage), start_(start), end_(end), committed_(committed), limit_(limit), next_free_(start), track_cards_(track_cards) {
+            assert(start <= end && limit >= start && limit <= end && committed >= start);
+            if (track_cards_) {
+                resize_cards();
+            }
         }
 
+        slot* storage() { return storage_; }
         const slot* storage() const { return storage_; }
         uint32_t next_free() const { return next_free_; }
+        uint32_t used() const { return next_free_ - start_; }
+        uint32_t capacity() const { return limit_ - start_; }
+        uint32_t max_capacity() const { return end_ - start_; }
+
+        bool can_allocate(uint32_t num_slots) const {
+            return num_slots <= end_ - next_free_;
+        }
 
         // Allocate at least 'num_bytes' of storage, returns the offset (in slots) of the allocation (header) inside 'storage_'
         // The object must be constructed one slot beyond the allocation header and the type field of the allocation header updated
-        allocation_result allocate(size_t num_bytes);
+        // If 'needs_destroy' is set the allocation is recorded so run_destructors() can find it.
+        allocation_result allocate(size_t num_bytes, bool needs_destroy);
 
-        void run_destructors();
+        // Destroy the objects that need it and make the context empty. Stops early (returning false) once 'limit' has been reached,
+        // the next call then continues where it left off.
+        bool run_destructors(const step_limit& limit);
+        void run_destructors() { run_destructors(step_limit{}); }
 
-        allocation_context other_half();
+        // Shrink the allocation (header) at 'pos' to 'num_slots', the rest becomes a dead allocation unless it's at the end
+        void shrink(uint32_t pos, uint32_t num_slots);
+
+        // Change the soft capacity (clamped to the valid range)
+        void capacity(uint32_t new_capacity) {
+            limit_ = start_ + std::clamp(new_capacity, 1U, end_ - start_);
+        }
+
+        // Give committed memory beyond what's currently used (and the soft capacity) back to the system
+        void decommit_unused();
+
+        // Give the memory of the (empty) context back to the system except for the first 'keep' slots, it stays committed.
+        // Works from the end towards the start, leaving the rest resident once 'deadline' has passed.
+        void discard(uint32_t keep, std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
 
-#ifndef NDEBUG
         bool pos_inside(uint32_t pos) const {
             return pos >= start_ && pos < next_free_;
         }
-#endif
 
         int use_percentage() const {
-            return static_cast<int>((next_free_ - start_) * 100ULL / (capacity_ - start_));
+            return limit_ == start_ ? 0 : static_cast<int>((next_free_ - start_) * 100ULL / (limit_ - start_));
         }
 
         slot* get_at(uint32_t pos) const {
@@ -316,32 +451,110 @@ private:
         }
 
         bool is_internal(const void* p) const {
-            return reinterpret_cast<uintptr_t>(p) >= reinterpret_cast<uintptr_t>(storage_) && reinterpret_cast<uintptr_t>(p) < reinterpret_cast<uintptr_t>(storage_ + capacity_);
+            return reinterpret_cast<uintptr_t>(p) >= reinterpret_cast<uintptr_t>(storage_ + start_) && reinterpret_cast<uintptr_t>(p) < reinterpret_cast<uintptr_t>(storage_ + end_);
         }
 
+        void mark_card(uint32_t pos) {
+            assert(track_cards_ && pos >= start_ && pos < next_free_);
+            card_dirty_[(pos - start_) >> card_shift] = true;
+        }
+
+        // Call 'f' with the header position of every allocation overlapping a dirty card, and clean the cards
+        template<typename F>
+        void for_each_dirty_allocation(F f);
+
     private:
+        // Each card covers 2^card_shift slots
+        static constexpr uint32_t card_shift = 6;
+
         slot*    storage_;
-        uint32_t capacity_;
         uint32_t start_;
+        uint32_t end_;
+        uint32_t committed_;
+        uint32_t limit_;
         uint32_t next_free_;
-
-        explicit allocation_context(slot* storage, uint32_t capacity, uint32_t start) : storage_(storage), capacity_(capacity), start_(start), next_free_(start) {
-            assert(start < capacity);
+        uint32_t sweep_index_ = 0; // Allocations before this index in finalizers_ have already been handled by run_destructors()
+        bool     track_cards_;
+        std::vector<uint32_t> finalizers_; // Header positions of the allocations with non-trivial destructors
+        std::vector<bool>     card_dirty_;
+        std::vector<uint32_t> card_first_; // Header position of the allocation covering the start of each card
+
+        void resize_cards() {
+            const auto num_cards = (committed_ - start_ + (1 << card_shift) - 1) >> card_shift;
+            card_dirty_.resize(num_cards);
+            card_first_.resize(num_cards);
         }
     };
 
     pointer_set         pointers_;
-    allocation_context  alloc_context_;
+    allocation_context  nursery_;       // Young generation (empty if the heap isn't generational)
+    allocation_context  alloc_context_; // Old generation
+    allocation_context  idle_context_;  // The other half of the old generation, only used during garbage collection
+    size_t              reserved_bytes_;
     bool                owns_storage_;
+    std::unique_ptr<gc_weak_table> weak_table_;
+    std::vector<gc_root_set*> root_sets_;
+    uint32_t            gc_threads_ = 1;
+    bool                discard_idle_half_ = true;
+
+    class parallel_copier;
+
+    bool has_nursery() const { return nursery_.max_capacity() != 0; }
+
+    bool is_young(uint32_t pos) const {
+        return pos - 1 < nursery_.next_free();
+    }
+
+    uint32_t slot_position(const void* p) const {
+        return static_cast<uint32_t>(reinterpret_cast<const slot*>(p) - alloc_context_.storage());
+    }
+
+    bool pos_inside(uint32_t pos) const {
+        return nursery_.pos_inside(pos) || alloc_context_.pos_inside(pos) || (gc_state_.incremental && idle_context_.pos_inside(pos));
+    }
+
+    // Record that 'pos' was stored at 'p'
+    void record_store(const void* p, uint32_t pos) {
+        if (is_young(pos) && alloc_context_.is_internal(p)) {
+            alloc_context_.mark_card(slot_position(p));
+        } else if (gc_state_.incremental && idle_context_.is_internal(p)) {
+            idle_context_.mark_card(slot_position(p));
+        }
+    }
+
+    allocation_result allocate(size_t num_bytes, bool needs_destroy);
 
+    void adjust_capacity();
+
+    // While an incremental collection is in progress objects may already have been copied, so positions
+    // are forwarded to the current copy (all accesses go through here)
     slot* get_at(uint32_t pos) const {
-        return alloc_context_.get_at(pos);
+        if (gc_state_.incremental) {
+            pos = forwarded(pos);
+        }
+        return slot_at(pos);
+    }
+
+    // Access without forwarding (used by the collector itself)
+    slot* slot_at(uint32_t pos) const {
+        assert(pos_inside(pos));
+        return const_cast<slot*>(&alloc_context_.storage()[pos]);
+    }
+
+    uint32_t forwarded(uint32_t pos) const {
+        const auto s = alloc_context_.storage();
+        return s[pos-1].allocation.type == gc_moved_type_index ? s[pos].new_position : pos;
+    }
+
+    // Allocation header of the object at 'pos'
+    const slot_allocation_header& allocation_header(uint32_t pos) const {
+        return get_at(pos)[-1].allocation;
     }
 
 #ifndef NDEBUG
     template<typename T>
     bool type_check(uint32_t pos) const {
-        const auto a = get_at(pos-1)->allocation;
+        const auto a = allocation_header(pos);
         if constexpr (std::is_convertible_v<T*, object*>) {
             // Avoid creating gc_type_info_registration<T>'s for interface types
             return a.type_info().is_convertible_to_object() && dynamic_cast<T*>(reinterpret_cast<object*>(get_at(pos)));
@@ -354,13 +567,17 @@ private:
     // Only valid during GC
     struct gc_state {
 #ifndef NDEBUG
-        bool initial_state() const { return level == 0 && new_context == nullptr && pending_fixups.empty() && weak_fixups.empty(); }
+        bool initial_state() const { return level == 0 && new_context == nullptr && copier == nullptr && !minor && !incremental && pending_fixups.empty() && weak_fixups.empty() && unscanned.empty(); }
 #endif
 
         uint32_t level = 0;                         // recursion depth
+        bool minor = false;                         // only collecting the young generation?
+        bool incremental = false;                   // incremental collection in progress? (new_context is then the half objects are being copied to)
         allocation_context* new_context = nullptr;  // new allocation context (references to it should not be kept)
+        parallel_copier* copier = nullptr;          // set while the live objects are being copied by several threads
         std::vector<uint32_t*> pending_fixups;      // pending fixup addresses
         std::vector<uint32_t*> weak_fixups;         // pending weak fixup addresses
+        std::vector<uint32_t> unscanned;            // positions of copied objects whose fixup hasn't been called yet (incremental collections only)
     } gc_state_;
     
 
@@ -368,6 +585,15 @@ private:
     void detach(gc_heap_ptr_untyped& p);
 
     uint32_t gc_move(uint32_t pos);
+    void process_fixups();
+    void move_pending();
+    void scan_next();
+
+    void register_roots();
+    void start_incremental_collection();
+    void complete_incremental_collection();
+    bool incremental_step(const step_limit& limit);
+    bool sweep(const step_limit& limit);
 
     void register_fixup(uint32_t& pos);
     void register_weak_fixup(uint32_t& pos);
@@ -395,7 +621,10 @@ public:
         }
     }
     gc_heap_ptr_untyped& operator=(const gc_heap_ptr_untyped& p) {
-        if (this != &p) {
+        if (heap_ && heap_ == p.heap_) {
+            // Already tracked by the right heap
+            pos_ = p.pos_;
+        } else if (this != &p) {
             if (heap_) {
                 heap_->detach(*this);
             }
@@ -421,7 +650,7 @@ public:
 
     template<typename T>
     bool has_type() const {
-        return pos_ && heap_->get_at(pos_-1)->allocation.type == gc_type_info_registration<T>::index();
+        return pos_ && heap_->allocation_header(pos_).type == gc_type_info_registration<T>::index();
     }
 
 protected:
@@ -432,8 +661,31 @@ protected:
 private:
     gc_heap* heap_;
     uint32_t pos_;
+    uint32_t index_; // Index into gc_heap::pointers_ (only valid if heap_ is set)
 };
 
+inline void gc_heap::pointer_set::insert(gc_heap_ptr_untyped& p) {
+    // Note: garbage_collect() assumes nodes are added to the back
+    if (size_ == capacity_) {
+        const auto new_cap = capacity_ * 2;
+        auto n = alloc(new_cap);
+        std::memcpy(n, set_, size_*sizeof(gc_heap_ptr_untyped*));
+        std::free(set_);
+        set_ = n;
+        capacity_ = new_cap;
+    }
+    p.index_ = size_;
+    set_[size_++] = &p;
+}
+
+inline void gc_heap::pointer_set::erase(gc_heap_ptr_untyped& p) {
+    assert(p.index_ < size_ && set_[p.index_] == &p && "Pointer not found in set!");
+    // Move the last pointer into the hole
+    auto last = set_[--size_];
+    last->index_ = p.index_;
+    set_[p.index_] = last;
+}
+
 template<typename T>
 class gc_heap_ptr : public gc_heap_ptr_untyped {
 public:
@@ -465,9 +717,20 @@ class gc_heap_ptr_untracked {
 public:
     gc_heap_ptr_untracked() : pos_(0) {}
     gc_heap_ptr_untracked(std::nullptr_t) : pos_(0) {}
-    gc_heap_ptr_untracked(const gc_heap_ptr<T>& p) : pos_(p.pos_) {}
+    gc_heap_ptr_untracked(const gc_heap_ptr<T>& p) : pos_(p.pos_) {
+        if (p.heap_) {
+            p.heap_->record_store(this, pos_);
+        }
+    }
     gc_heap_ptr_untracked(const gc_heap_ptr_untracked&) = default;
     gc_heap_ptr_untracked& operator=(const gc_heap_ptr_untracked&) = default;
+    gc_heap_ptr_untracked& operator=(const gc_heap_ptr<T>& p) {
+        pos_ = p.pos_;
+        if (p.heap_) {
+            p.heap_->record_store(this, pos_);
+        }
+        return *this;
+    }
 
     explicit operator bool() const { return pos_; }
 
@@ -501,7 +764,7 @@ using gc_heap_weak_ptr_untracked = gc_heap_ptr_untracked<T, false>;
 
 template<typename T, typename... Args>
 gc_heap_ptr<T> gc_heap::allocate_and_construct(size_t num_bytes, Args&&... args) {
-    auto a = alloc_context_.allocate(num_bytes);
+    auto a = allocate(num_bytes, gc_type_info_registration<T>::needs_destroy);
     assert(a.hdr().type == uninitialized_type_index);
     gc_type_info_registration<T>::construct(a.obj, std::forward<Args>(args)...);
     a.hdr().type = gc_type_info_registration<T>::index();
@@ -517,7 +780,7 @@ gc_heap_ptr<T> gc_heap::unsafe_create_from_position(uint32_t pos) {
 template<typename T>
 gc_heap_ptr<T> gc_heap::unsafe_track(const T& val) {
     auto pos = reinterpret_cast<const slot*>(&val) - alloc_context_.storage();
-    assert(pos >= 1 && pos < UINT32_MAX && alloc_context_.pos_inside(static_cast<uint32_t>(pos)));
+    assert(pos >= 1 && pos < UINT32_MAX && pos_inside(static_cast<uint32_t>(pos)));
     return unsafe_create_from_position<T>(static_cast<uint32_t>(pos));
 }
 
@@ -123,12 +123,18 @@ private:
         void push_back(const T& e) {
             assert(length() < capacity());
             new (&entries()[length_++]) T(e);
+            if constexpr (has_fixup_t<T>::value) {
+                heap_.write_barrier(&entries()[length_-1]);
+            }
         }
 
         template<typename... Args>
         void emplace_back(Args&&... args) {
             assert(length() < capacity());
             new (&entries()[length_++]) T(std::forward<Args>(args)...);
+            if constexpr (has_fixup_t<T>::value) {
+                heap_.write_barrier(&entries()[length_-1]);
+            }
         }
 
         void erase(uint32_t index) {
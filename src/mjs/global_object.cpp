@@ -30,7 +30,7 @@ inline const value& get_arg(const std::vector<value>& args, int index) {
     return index < static_cast<int>(args.size()) ? args[index] : value::undefined;
 }
 
-double parse_int(std::wstring_view s, int radix, version ver) {
+double parse_int(std::u16string_view s, int radix, version ver) {
     s = ltrim(s, ver);
     int sign = 1;
     if (!s.empty() && (s[0] == '+' || s[0] == '-')) {
@@ -77,21 +77,21 @@ double parse_int(std::wstring_view s, int radix, version ver) {
     return sign * value;
 }
 
-value parse_float(const gc_heap_ptr<global_object>& global, const std::wstring_view s) {
-    std::wistringstream wiss{std::wstring{ltrim(s, global->language_version())}};
+value parse_float(const gc_heap_ptr<global_object>& global, const std::u16string_view s) {
+    std::wistringstream wiss{to_wstring(ltrim(s, global->language_version()))};
     double val;
     return value{wiss >> val ? val : NAN};
 }
 
 namespace {
 
-void put_hex_byte(std::wstring& res, int val) {
+void put_hex_byte(std::u16string& res, int val) {
     constexpr const char* const hexchars = "0123456789ABCDEF";
     res.push_back(hexchars[(val>>4)&0xf]);
     res.push_back(hexchars[val&0xf]);
 }
 
-void put_percent_hex_byte(std::wstring& res, int val) {
+void put_percent_hex_byte(std::u16string& res, int val) {
     res.push_back('%');
     put_hex_byte(res, val);
 }
@@ -106,13 +106,13 @@ public:
 };
 
 [[noreturn]] void throw_uri_error(const gc_heap_ptr<global_object>& global) {
-    throw native_error_exception{native_error_type::uri, global->stack_trace(), L"URI malformed"};
+    throw native_error_exception{native_error_type::uri, global->stack_trace(), u"URI malformed"};
 }
 
 template<typename Pred>
-value encode_uri_helper(const gc_heap_ptr<global_object>& global, const std::wstring_view s, Pred pred) {
+value encode_uri_helper(const gc_heap_ptr<global_object>& global, const std::u16string_view s, Pred pred) {
     try {
-        std::wstring res;
+        std::u16string res;
         uint8_t buffer[unicode::utf8_max_length];
         for (unsigned i = 0, l = static_cast<unsigned>(s.length()); i < l;) {
             if (pred(s[i])) {
@@ -161,8 +161,8 @@ constexpr bool is_uri_reserved(int ch) {
 
 } // unnamed namespace
 
-value escape(const gc_heap_ptr<global_object>& global, const std::wstring_view s) {
-    std::wstring res;
+value escape(const gc_heap_ptr<global_object>& global, const std::u16string_view s) {
+    std::u16string res;
     for (uint16_t ch: s) {
         if (is_alpha_or_digit(ch) || is_in_list(ch, "@*_+-./")) {
             res.push_back(ch);
@@ -178,8 +178,8 @@ value escape(const gc_heap_ptr<global_object>& global, const std::wstring_view s
     return value{string{global.heap(), res}};
 }
 
-value unescape(const gc_heap_ptr<global_object>& global, const std::wstring_view s) {
-    std::wstring res;
+value unescape(const gc_heap_ptr<global_object>& global, const std::u16string_view s) {
+    std::u16string res;
     for (size_t i = 0; i < s.length(); ++i) {
         if (s[i] != '%') {
             res.push_back(s[i]);
@@ -190,26 +190,26 @@ value unescape(const gc_heap_ptr<global_object>& global, const std::wstring_view
             throw std::runtime_error("Invalid string in unescape");
         }
         if (s[i] == 'u') {
-            res.push_back(static_cast<wchar_t>(get_hex_value4(&s[i+1])));
+            res.push_back(static_cast<char16_t>(get_hex_value4(&s[i+1])));
             i += 4;
         } else {
-            res.push_back(static_cast<wchar_t>(get_hex_value2(&s[i])));
+            res.push_back(static_cast<char16_t>(get_hex_value2(&s[i])));
             i += 1;
         }
     }
     return value{string{global.heap(), res}};
 }
 
-value encode_uri(const gc_heap_ptr<global_object>& global, const std::wstring_view s) {
+value encode_uri(const gc_heap_ptr<global_object>& global, const std::u16string_view s) {
     return encode_uri_helper(global, s, [](int ch) { return is_uri_unescaped(ch) || is_uri_reserved(ch) || ch == '#'; } );
 }
 
-value encode_uri_component(const gc_heap_ptr<global_object>& global, const std::wstring_view s) {
+value encode_uri_component(const gc_heap_ptr<global_object>& global, const std::u16string_view s) {
     return encode_uri_helper(global, s, &is_uri_unescaped);
 }
 
-value decode_uri(const gc_heap_ptr<global_object>& global, const std::wstring_view s) {
-    std::wstring res;
+value decode_uri(const gc_heap_ptr<global_object>& global, const std::u16string_view s) {
+    std::u16string res;
     for (size_t i = 0; i < s.length();) {
         if (s[i] != '%') {
             res += s[i];
@@ -247,7 +247,7 @@ value decode_uri(const gc_heap_ptr<global_object>& global, const std::wstring_vi
             woss << "Unsupported: " << s;
             NOT_IMPLEMENTED(woss.str());
         }
-       wchar_t buf16[unicode::utf16_max_length];
+       char16_t buf16[unicode::utf16_max_length];
        const auto len16 = unicode::utf32_to_utf16(conv.code_point, buf16);
        assert(len16 <= sizeof(buf16)/sizeof(*buf16));
        if (len16 == unicode::invalid_length) {
@@ -260,7 +260,7 @@ value decode_uri(const gc_heap_ptr<global_object>& global, const std::wstring_vi
     return value{string{global.heap(), res}};
 }
 
-value decode_uri_component(const gc_heap_ptr<global_object>& global, const std::wstring_view s) {
+value decode_uri_component(const gc_heap_ptr<global_object>& global, const std::u16string_view s) {
     return decode_uri(global, s);
 }
 
@@ -383,7 +383,7 @@ global_object_create_result make_console_object(const gc_heap_ptr<global_object>
 
     using timer_clock = std::chrono::steady_clock;
 
-    auto timers = std::make_shared<std::unordered_map<std::wstring, timer_clock::time_point>>();
+    auto timers = std::make_shared<std::unordered_map<std::u16string, timer_clock::time_point>>();
     put_native_function(global, console, "log", [](const value&, const std::vector<value>& args) {
         for (const auto& a: args) {
             if (a.type() == value_type::string) {
@@ -401,7 +401,7 @@ global_object_create_result make_console_object(const gc_heap_ptr<global_object>
             THROW_RUNTIME_ERROR("Missing argument to console.time()");
         }
         auto label = to_string(h, args.front());
-        (*timers)[std::wstring{label.view()}] = timer_clock::now();
+        (*timers)[std::u16string{label.view()}] = timer_clock::now();
         return value::undefined;
     }, 1);
     put_native_function(global, console, "timeEnd", [timers, &h](const value&, const std::vector<value>& args) {
@@ -410,7 +410,7 @@ global_object_create_result make_console_object(const gc_heap_ptr<global_object>
             THROW_RUNTIME_ERROR("Missing argument to console.timeEnd()");
         }
         auto label = to_string(h, args.front());
-        auto it = timers->find(std::wstring{label.view()});
+        auto it = timers->find(std::u16string{label.view()});
         if (it == timers->end()) {
             std::wostringstream woss;
             woss << "Timer not found: " << label;
@@ -452,15 +452,13 @@ public:
     }
 
     string get(gc_heap& h, const char* name) {
-        const auto hash = calc_hash(name);
-
 #ifdef STRING_CACHE_STATS
         ++lookups_;
 #endif
         auto& es = entries_.dereference(h);
         auto es_data = es.data(); // Size we never go beyond the initial capacity the data pointer can't change in below
 
-        // In cache already?
+        // In cache already? Names are string literals, so first look for an entry created from the same pointer
         for (uint32_t i = 0, l = es.length(); i < l; ++i) {
             // Check if we encounterd a "lost" weak pointer (only happens first time after a garbage collection)
             if (!es[i].s) {
@@ -471,16 +469,19 @@ public:
                 continue;
             }
 
-            if (es_data[i].hash == hash && string_equal(name, es_data[i].s.dereference(h).view())) {
-#ifdef STRING_CACHE_STATS
-                ++hits_;
-                dist_ += i;
-#endif
-                // Move first
-                for (; i; --i) {
-                    std::swap(es_data[i], es_data[i-1]);
-                }
-                return es_data[0].s.track(h);
+            if (es_data[i].name == name) {
+                return hit(h, es_data, i);
+            }
+        }
+
+        // The same string literal may have a different address in another translation unit, so compare the contents
+        // (using the hash stored in the strings to skip most of them)
+        const auto hash = hash_chars(std::string_view{name});
+        for (uint32_t i = 0, l = es.length(); i < l; ++i) {
+            const auto& str = es_data[i].s.dereference(h);
+            if (str.hash() == hash && str.visit([name](auto v) { return string_equal(name, v); })) {
+                es_data[i].name = name;
+                return hit(h, es_data, i);
             }
         }
 
@@ -488,7 +489,7 @@ public:
         string s{h, name};
 
         if (es.length() < es.capacity()) {
-            es.push_back(entry{0, nullptr});
+            es.push_back(entry{nullptr, nullptr});
             assert(es_data == es.data());
         }
 
@@ -496,14 +497,15 @@ public:
             es_data[i] = es_data[i-1];
         }
 
-        es_data[0] = { hash, s.unsafe_raw_get() };
+        es_data[0] = { name, s.unsafe_raw_get() };
+        h.write_barrier(&es_data[0]);
 
         return s;
     }
 
 private:
     struct entry {
-        uint32_t hash;
+        const char* name; // The string s was last looked up using
         gc_heap_weak_ptr_untracked<gc_string> s;
 
         void fixup(gc_heap& h) {
@@ -512,6 +514,18 @@ private:
     };
     gc_heap_ptr_untracked<gc_vector<entry>> entries_;
 
+    string hit(gc_heap& h, entry* es_data, uint32_t i) {
+#ifdef STRING_CACHE_STATS
+        ++hits_;
+        dist_ += i;
+#endif
+        // Move first
+        for (; i; --i) {
+            std::swap(es_data[i], es_data[i-1]);
+        }
+        return es_data[0].s.track(h);
+    }
+
 #ifdef STRING_CACHE_STATS
     gc_heap* hack_string_cache_heap_;
     uint32_t lookups_ = 0;
@@ -519,23 +533,13 @@ private:
     uint64_t dist_    = 0;
 #endif
 
-    static bool string_equal(const char* s, std::wstring_view v) {
+    template<typename CharT>
+    static bool string_equal(const char* s, std::basic_string_view<CharT> v) {
         for (uint32_t i = 0, sz = static_cast<uint32_t>(v.size()); i < sz; ++i, ++s) {
-            if (*s != v[i]) return false;
+            if (!*s || char_code(*s) != char_code(v[i])) return false;
         }
         return !*s;
     }
-
-    static uint32_t calc_hash(const char* s) {
-        // FNV
-        constexpr uint32_t prime = 16777619;
-        constexpr uint32_t offset = 2166136261;
-        uint32_t h = offset;
-        for (; *s; ++s) {
-            h = (h*prime) ^ static_cast<uint8_t>(*s);
-        }
-        return h;
-    }
 };
 
 #ifndef STRING_CACHE_STATS
@@ -664,15 +668,15 @@ private:
                 assert(native_error_types[i] == static_cast<native_error_type>(i));
                 std::wostringstream woss;
                 woss << static_cast<native_error_type>(i);
-                auto eo = get(woss.str());
+                auto eo = get(to_u16string(woss.str()));
                 assert(is_function(eo));
-                auto prototype = eo.object_value()->get(L"prototype");
+                auto prototype = eo.object_value()->get(u"prototype");
                 assert(prototype.type() == value_type::object);
                 error_prototype_[i] = prototype.object_value();
             }
         }
 
-        assert(!get(L"Object").object_value()->can_put(L"prototype"));
+        assert(!get(u"Object").object_value()->can_put(u"prototype"));
 
         auto self = self_ptr();
 
@@ -775,15 +779,15 @@ object_ptr global_object::make_object() {
     return heap().make<object>(op->class_name(), op);
 }
 
-std::wstring index_string(uint32_t index) {
+std::u16string index_string(uint32_t index) {
     assert(index != UINT32_MAX);
-    wchar_t buffer[12], *p = &buffer[sizeof(buffer)/sizeof(*buffer)];
+    char16_t buffer[12], *p = &buffer[sizeof(buffer)/sizeof(*buffer)];
     *--p = '\0';
     do {
         *--p = '0' + index % 10;
         index /= 10;
     } while (index);
-    return std::wstring{p};
+    return std::u16string{p};
 }
 
 object_ptr global_object::validate_object(const value& v) const {
@@ -31,19 +31,19 @@ public:
     static constexpr auto prototype_attributes = property_attribute::dont_enum | property_attribute::dont_delete | property_attribute::read_only;
     static constexpr auto default_attributes = property_attribute::dont_enum;
 
-    // Make a string (to make it possible to use a cache)
+    // Make a string (to make it possible to use a cache). 'str' should be a string literal, the cache remembers the pointer.
     virtual string common_string(const char* str) = 0;
 
     version language_version() const { return version_; }
 
     object_ptr make_object();
 
-    std::wstring stack_trace() const {
+    std::u16string stack_trace() const {
         assert(stack_trace_);
         return stack_trace_();
     }
 
-    void set_stack_trace_function(const std::function<std::wstring()>& f) {
+    void set_stack_trace_function(const std::function<std::u16string()>& f) {
         assert(!stack_trace_);
         stack_trace_ = f;
     }
@@ -68,11 +68,11 @@ protected:
     global_object(global_object&&) = default;
 
 private:
-    std::function<std::wstring()> stack_trace_;
+    std::function<std::u16string()> stack_trace_;
     std::function<bool()>         strict_mode_func_;
 };
 
-extern std::wstring index_string(uint32_t index);
+extern std::u16string index_string(uint32_t index);
 extern bool is_global_object(const object_ptr& o);
 
 struct global_object_create_result {
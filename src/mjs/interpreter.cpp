@@ -7,13 +7,17 @@
 #include "regexp_object.h"
 #include "object_object.h"
 #include "printer.h"
+#include "bytecode.h"
+#include "jit.h"
 
 #include <sstream>
 #include <algorithm>
 #include <cmath>
+#include <unordered_map>
 
 #ifndef NDEBUG
 #include <iostream>
+#include <exception>
 #endif
 
 namespace mjs {
@@ -33,150 +37,141 @@ std::wostream& operator<<(std::wostream& os, const completion& c) {
     return os << c.type << " value type: " << c.result.type();
 }
 
-class hoisting_visitor {
-public:
-    using scan_result = std::tuple<std::vector<std::wstring>, std::vector<const function_definition*>>;
-
-    static scan_result scan(const statement& s) {
-        hoisting_visitor hv{};
-        accept(s, hv);
-        return std::tuple(std::move(hv.ids_), std::move(hv.funcs_));
-    }
-
-    void operator()(const block_statement& s) {
-        for (const auto& bs: s.l()) {
-            accept(*bs, *this);
-        }
-    }
-
-    void operator()(const variable_statement& s) {
-        for (const auto& d: s.l()) {
-            ids_.push_back(d.id());
-        }
-    }
-
-    void operator()(const debugger_statement&) {}
-
-    void operator()(const empty_statement&) {}
-
-    void operator()(const expression_statement&){}
-
-    void operator()(const if_statement& s) {
-        accept(s.if_s(), *this);
-        if (auto e = s.else_s()) {
-            accept(*e, *this);
-        }
+std::wostream& operator<<(std::wostream& os, interpreter_engine e) {
+    switch (e) {
+    case interpreter_engine::ast: return os << "ast";
+    case interpreter_engine::bytecode: return os << "bytecode";
+    case interpreter_engine::jit: return os << "jit";
     }
+    NOT_IMPLEMENTED((int)e);
+}
 
-    void operator()(const do_statement& s) {
-        accept(s.s(), *this);
-    }
+std::wostream& operator<<(std::wostream& os, const inline_cache_statistics& s) {
+    auto print = [&os](const char* name, const inline_cache_statistics::counters& c) {
+        os << name << ": " << c.hits << " hits, " << c.misses << " misses";
+    };
+    print("get", s.get);
+    os << ", ";
+    print("put", s.put);
+    os << ", ";
+    print("call", s.call);
+    return os;
+}
 
-    void operator()(const while_statement& s) {
-        accept(s.s(), *this);
+class activation_object : public object {
+public:
+    // 'callee' is nullptr if the arguments object can't be observed, otherwise it's created when first accessed
+    static auto make(const gc_heap_ptr<global_object>& global, const std::vector<std::u16string>& param_names, const std::vector<value>& args, const object_ptr& callee) {
+        return global.heap().make<activation_object>(global, param_names, args, callee);
     }
 
-    void operator()(const for_statement& s) {
-        if (s.init()) accept(*s.init(), *this);
-        accept(s.s(), *this);
+    // Activation record with the variables in 'layout' stored in slots (the arguments object doesn't alias the parameters)
+    static auto make(const gc_heap_ptr<global_object>& global, const std::shared_ptr<const frame_layout>& layout, const std::vector<value>& args) {
+        return global.heap().make<activation_object>(*global, layout, args);
     }
 
-    void operator()(const for_in_statement& s) {
-        accept(s.init(), *this);
-        accept(s.s(), *this);
-    }
+    // nullptr if the function doesn't have an arguments object (or it hasn't been created yet)
+    object_ptr arguments() const { return arguments_ ? arguments_.track(heap()) : nullptr; }
 
-    void operator()(const continue_statement&) {}
-    void operator()(const break_statement&) {}
-    void operator()(const return_statement&) {}
-    void operator()(const with_statement& s) {
-        accept(s.s(), *this);
+    value_representation& slot(uint32_t index) {
+        auto& ss = slots_.dereference(heap());
+        assert(index < ss.length());
+        return ss[index];
     }
 
-    void operator()(const labelled_statement& s) {
-        accept(s.s(), *this);
+    // Address of the first slot (only valid until the next garbage collection)
+    value_representation* slot_data() {
+        return slots_.dereference(heap()).data();
     }
 
-    void operator()(const switch_statement& s) {
-        for (const auto& c: s.cl()) {
-            for (const auto& cs: c.sl()) {
-                accept(*cs, *this);
+    value get(const std::u16string_view& name) const override {
+        check_arguments(name);
+        if (auto p = find(name)) {
+            auto& h = heap();
+            if (args_) {
+                return args_.dereference(h)[p->index].get_value(h);
             }
+            return arguments_.dereference(h).get(index_string(p->index));
+        }
+        if (const auto s = find_slot(name); s != frame_layout::no_slot) {
+            return slots_.dereference(heap())[s].get_value(heap());
         }
+        return object::get(name);
     }
 
-    void operator()(const try_statement& s) {
-        accept(s.block(), *this);
-        if (auto c = s.catch_block()) {
-            accept(*c, *this);
+    void put(const string& name, const value& val, property_attribute attr) override {
+        check_arguments(name.view());
+        if (auto p = find(name.view())) {
+            auto& h = heap();
+            if (args_) {
+                args_.dereference(h)[p->index] = val;
+            } else {
+                arguments_.dereference(h).put(string{h, index_string(p->index)}, val, attr);
+            }
+            return;
         }
-        if (auto f = s.finally_block()) {
-            accept(*f, *this);
+        if (const auto s = find_slot(name.view()); s != frame_layout::no_slot) {
+            if (!has_attributes(layout_->attributes(s), property_attribute::read_only)) {
+                slot(s) = val;
+            }
+            return;
         }
+        object::put(name, val, attr);
     }
 
-    void operator()(const throw_statement&) {}
-
-    void operator()(const function_definition& f) {
-        assert(!f.id().empty());
-        // For functions it's important that we start out by registering the first encutered definition
-        if (std::find(ids_.begin(), ids_.end(), f.id()) == ids_.end()) {
-            ids_.push_back(f.id());
-            funcs_.push_back(&f);
+    bool delete_property(const std::u16string_view& name) override {
+        check_arguments(name);
+        if (find_slot(name) != frame_layout::no_slot) {
+            return false;
         }
+        return object::delete_property(name);
     }
 
-    void operator()(const statement& s) {
-        std::wostringstream woss;
-        print(woss, s);
-        NOT_IMPLEMENTED(woss.str());
-    }
-
-private:
-    explicit hoisting_visitor() {}
-    std::vector<std::wstring> ids_;
-    std::vector<const function_definition*> funcs_;
-};
-
-class activation_object : public object {
-public:
-    static auto make(const gc_heap_ptr<global_object>& global, const std::vector<std::wstring>& param_names, const std::vector<value>& args) {
-        return global.heap().make<activation_object>(*global, param_names, args);
+protected:
+    bool do_redefine_own_property(const string& name, const value& val, property_attribute attr) override {
+        check_arguments(name.view());
+        if (const auto s = find_slot(name.view()); s != frame_layout::no_slot) {
+            // Only ever used for variable and function declarations, the attributes are fixed by the layout
+            slot(s) = val;
+            return true;
+        }
+        return object::do_redefine_own_property(name, val, attr);
     }
 
-    object_ptr arguments() const { return arguments_.track(heap()); }
-
-    value get(const std::wstring_view& name) const override {
-        if (auto p = find(name)) {
-            auto& h = heap();
-            return arguments_.dereference(h).get(p->index_string.dereference(h).view());
+    property_attribute do_own_property_attributes(const std::u16string_view& name) const override {
+        check_arguments(name);
+        if (const auto s = find_slot(name); s != frame_layout::no_slot) {
+            return layout_->attributes(s);
         }
-        return object::get(name);
+        return object::do_own_property_attributes(name);
     }
 
-    void put(const string& name, const value& val, property_attribute attr) override {
-        if (auto p = find(name.view())) {
-            auto& h = heap();
-            arguments_.dereference(h).put(p->index_string.track(h), val, attr);
-            return;
+    void add_own_property_names(std::vector<string>& names, bool check_enumerable) const override {
+        check_arguments(u"arguments");
+        if (layout_) {
+            for (uint32_t s = 0; s < layout_->size(); ++s) {
+                if (!check_enumerable || !has_attributes(layout_->attributes(s), property_attribute::dont_enum)) {
+                    names.emplace_back(heap(), layout_->name(s));
+                }
+            }
         }
-        object::put(name, val, attr);
+        object::add_own_property_names(names, check_enumerable);
     }
 
 private:
+    // Parameter aliasing an element of the arguments object (or of args_ until it's created)
     struct param {
         gc_heap_ptr_untracked<gc_string> key;
-        gc_heap_ptr_untracked<gc_string> index_string;
+        uint32_t index;
 
-        explicit param(const string& k, const string& is) : key(k.unsafe_raw_get()), index_string(is.unsafe_raw_get()) {}
+        explicit param(const string& k, uint32_t i) : key(k.unsafe_raw_get()), index(i) {}
 
         void fixup(gc_heap& h) {
             key.fixup(h);
-            index_string.fixup(h);
         }
     };
 
-    param* find(const std::wstring_view& s) const {
+    param* find(const std::u16string_view& s) const {
         if (!params_) {
             return nullptr;
         }
@@ -185,50 +180,112 @@ private:
         const auto pdat = ps.data();
         for (uint32_t index = ps.length(); index--;) {
             auto& p = pdat[index];
-            if (p.key.dereference(h).view() == s) {
+            if (p.key.dereference(h).equals(s)) {
                 return &p;
             }
         }
         return nullptr;
     }
 
+    uint32_t find_slot(const std::u16string_view& s) const {
+        return layout_ ? layout_->find(s) : frame_layout::no_slot;
+    }
+
     friend gc_type_info_registration<activation_object>;
     gc_heap_ptr_untracked<object> arguments_;
     gc_heap_ptr_untracked<gc_vector<param>> params_;
+    gc_heap_ptr_untracked<gc_vector<value_representation>> slots_;
+    std::shared_ptr<const frame_layout> layout_;
+    // Used to create the arguments object on demand, args_ holds the arguments until then
+    gc_heap_ptr_untracked<global_object> global_;
+    gc_heap_ptr_untracked<object> callee_;
+    gc_heap_ptr_untracked<gc_vector<value_representation>> args_;
+    bool strict_ = false;
+
+    explicit activation_object(const gc_heap_ptr<global_object>& global, const std::vector<std::u16string>& param_names, const std::vector<value>& args, const object_ptr& callee)
+        : object(global->common_string("Activation"), global->object_prototype()) {
+
+        strict_ = global->language_version() >= version::es5 && global->strict_mode();
+
+        // The arguments object isn't observable if a parameter shadows it
+        const bool has_arguments = callee && std::find(param_names.begin(), param_names.end(), u"arguments") == param_names.end();
+        if (has_arguments) {
+            global_ = global;
+            callee_ = callee;
+            auto as = gc_vector<value_representation>::make(heap(), std::max(static_cast<uint32_t>(args.size()), 1U));
+            args_ = as;
+            for (const auto& a: args) {
+                as->push_back(value_representation{a});
+            }
+        }
 
-    explicit activation_object(global_object& global, const std::vector<std::wstring>& param_names, const std::vector<value>& args)
-        : object(global.common_string("Activation"), global.object_prototype()) {
+        for (uint32_t i = 0; i < param_names.size(); ++i) {
+            if (has_arguments && !strict_ && i < args.size()) {
+                // Handle the (ugly) fact that the arguments array aliases the parameters
+                if (!params_) {
+                    params_ = gc_vector<param>::make(heap(), static_cast<uint32_t>(param_names.size()));
+                }
+                params_.dereference(heap()).emplace_back(string{heap(), param_names[i]}, i);
+                // Add placeholder (the value is never used)
+                object::put(string{heap(), param_names[i]}, value::undefined, property_attribute::dont_delete);
+            } else {
+                object::put(string{heap(), param_names[i]}, i < args.size() ? args[i] : value::undefined, property_attribute::dont_delete);
+            }
+        }
+    }
 
-        if (!param_names.empty()) {
-            params_ = gc_vector<param>::make(heap(), static_cast<uint32_t>(param_names.size()));
+    // Creates the arguments object if 'name' refers to it and it hasn't been created yet
+    void check_arguments(const std::u16string_view& name) const {
+        if (args_ && name == u"arguments") {
+            const_cast<activation_object&>(*this).create_arguments();
         }
+    }
 
-        const auto ver    = global.language_version();
-        const bool strict = ver >= version::es5 && global.strict_mode();
+    void create_arguments() {
+        assert(args_ && !arguments_);
+        auto& h = heap();
+        auto global = global_.track(h);
+        const auto ver = global->language_version();
 
-        // Arguments array
-        auto as = global.make_arguments_array();
+        auto as = global->make_arguments_array();
         arguments_ = as;
-        as->put(global.common_string("length"), value{static_cast<double>(args.size())}, property_attribute::dont_enum);
-        for (uint32_t i = 0; i < args.size(); ++i) {
-            string is{heap(), index_string(i)};
-            as->put(is, args[i], ver >= version::es5 ? property_attribute::none : property_attribute::dont_enum);
-
-            if (i < param_names.size()) {
-                if (!strict) {
-                    // Handle the (ugly) fact that the arguments array aliases the parameters
-                    params_.dereference(heap()).emplace_back(string{heap(), param_names[i]}, is);
-                } else {
-                    object::put(string{heap(), param_names[i]}, args[i], property_attribute::dont_delete);
-                }
-            }
+        const auto nargs = args_.dereference(h).length();
+        as->put(global->common_string("length"), value{static_cast<double>(nargs)}, property_attribute::dont_enum);
+        for (uint32_t i = 0; i < nargs; ++i) {
+            as->put(string{h, index_string(i)}, args_.dereference(h)[i].get_value(h), ver >= version::es5 ? property_attribute::none : property_attribute::dont_enum);
+        }
+        if (!strict_) {
+            as->put(global->common_string("callee"), value{callee_.track(h)}, property_attribute::dont_enum);
+        } else {
+            global->define_thrower_accessor(*as, "callee");
+            global->define_thrower_accessor(*as, "caller");
         }
+        // From now on the parameters alias the elements of the arguments object
+        args_ = gc_heap_ptr_untracked<gc_vector<value_representation>>{};
 
-        object::put(global.common_string("arguments"), value{as}, property_attribute::dont_delete);
+        object::put(global->common_string("arguments"), value{as}, property_attribute::dont_delete);
+    }
+
+    explicit activation_object(global_object& global, const std::shared_ptr<const frame_layout>& layout, const std::vector<value>& args)
+        : object(global.common_string("Activation"), global.object_prototype())
+        , layout_(layout) {
+        assert(layout_);
+
+        auto ss = gc_vector<value_representation>::make(heap(), std::max(layout_->size(), 1U));
+        slots_ = ss;
+        for (uint32_t i = 0; i < layout_->size(); ++i) {
+            ss->emplace_back(i < layout_->num_params() && i < args.size() ? args[i] : value::undefined);
+        }
 
-        // Add placeholders (see note above)
-        for (size_t i = strict ? args.size() : 0; i < param_names.size(); ++i) {
-            object::put(string{heap(), param_names[i]}, value::undefined, property_attribute::dont_delete);
+        if (layout_->arguments_slot() != frame_layout::no_slot) {
+            // Only strict mode functions get here, so the arguments object doesn't alias the parameters
+            auto as = global.make_arguments_array();
+            arguments_ = as;
+            as->put(global.common_string("length"), value{static_cast<double>(args.size())}, property_attribute::dont_enum);
+            for (uint32_t i = 0; i < args.size(); ++i) {
+                as->put(string{heap(), index_string(i)}, args[i], property_attribute::none);
+            }
+            slot(layout_->arguments_slot()) = value{as};
         }
     }
 
@@ -236,10 +293,123 @@ private:
         auto& h = heap();
         arguments_.fixup(h);
         params_.fixup(h);
+        slots_.fixup(h);
+        global_.fixup(h);
+        callee_.fixup(h);
+        args_.fixup(h);
         object::fixup();
     }
 };
 
+// Operand stack of the bytecode virtual machine.
+// Values are stored as value_representations, so pushing and popping them doesn't register tracked pointers with the
+// heap, instead the stack is a root set. References are kept in a separate stack with a placeholder in their place.
+// The storage only grows, so code generated by the JIT compiler can use it as a fixed size array (see jit.h).
+class value_stack : public gc_root_set {
+public:
+    explicit value_stack(gc_heap& h) : heap_(h) {
+        heap_.add_root_set(*this);
+    }
+    ~value_stack() {
+        heap_.remove_root_set(*this);
+    }
+    value_stack(const value_stack&) = delete;
+    value_stack& operator=(const value_stack&) = delete;
+
+    uint32_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    value_representation* data() { return values_.data(); }
+
+    value at(uint32_t index) const {
+        assert(index < size_);
+        const auto r = values_[index];
+        return r.is_reference_placeholder() ? value{references_[r.placeholder_index()]} : r.get_value(heap_);
+    }
+
+    value back() const {
+        return at(size_ - 1);
+    }
+
+    value_representation back_representation() const {
+        assert(size_ && !values_[size_ - 1].is_reference_placeholder());
+        return values_[size_ - 1];
+    }
+
+    void reserve(uint32_t capacity) {
+        if (values_.size() < capacity) {
+            values_.resize(capacity);
+        }
+    }
+
+    void push_back(value_representation r) {
+        if (size_ == values_.size()) {
+            values_.push_back(r);
+        } else {
+            values_[size_] = r;
+        }
+        ++size_;
+    }
+
+    void push_back(const value& v) {
+        if (v.type() == value_type::reference) {
+            references_.push_back(v.reference_value());
+            push_back(value_representation::reference_placeholder(static_cast<uint32_t>(references_.size() - 1)));
+        } else {
+            push_back(value_representation{v});
+        }
+    }
+
+    void pop_back() {
+        assert(size_);
+        if (values_[--size_].is_reference_placeholder()) {
+            assert(values_[size_].placeholder_index() == references_.size() - 1);
+            references_.pop_back();
+        }
+    }
+
+    value pop() {
+        auto v = back();
+        pop_back();
+        return v;
+    }
+
+    void set_back(const value& v) {
+        pop_back();
+        push_back(v);
+    }
+
+    std::vector<value> pop_arguments(uint32_t num_args) {
+        assert(size_ >= num_args);
+        std::vector<value> args;
+        args.reserve(num_args);
+        for (uint32_t i = size_ - num_args; i < size_; ++i) {
+            args.push_back(at(i));
+        }
+        while (num_args--) {
+            pop_back();
+        }
+        return args;
+    }
+
+    // Set the size after the stack has been updated directly by JIT compiled code
+    void set_size(uint32_t size) {
+        assert(size <= values_.size());
+        size_ = size;
+    }
+
+private:
+    gc_heap& heap_;
+    std::vector<value_representation> values_;
+    std::vector<reference> references_;
+    uint32_t size_ = 0;
+
+    void fixup(gc_heap& h) override {
+        for (uint32_t i = 0; i < size_; ++i) {
+            values_[i].fixup(h);
+        }
+    }
+};
+
 constexpr bool is_reference_op(token_type t) {
     return t == token_type::dot || t == token_type::lbracket;
 }
@@ -254,16 +424,17 @@ value get_this_arg(const gc_heap_ptr<global_object>& global, const value& this_a
 
 class interpreter::impl {
 public:
-    explicit impl(gc_heap& h, version ver, const on_statement_executed_type& on_statement_executed)
+    explicit impl(gc_heap& h, version ver, const on_statement_executed_type& on_statement_executed, interpreter_engine engine)
         : heap_(h)
         , global_(global_object::make(h, ver, strict_mode_))
-        , on_statement_executed_(on_statement_executed) {
+        , on_statement_executed_(on_statement_executed)
+        , engine_(engine) {
 
         global_->set_stack_trace_function([this]() {
             return stack_trace();
         });
 
-        assert(!global_->has_property(L"eval"));
+        assert(!global_->has_property(u"eval"));
         put_native_function(global_, global_, "eval", [this](const value&, const std::vector<value>& args) {
             // ES3, 15.1.2.1
             if (args.empty()) {
@@ -274,19 +445,19 @@ public:
             std::unique_ptr<block_statement> bs;
 
             try {
-                bs = parse(std::make_shared<source_file>(L"eval", args.front().string_value().view(), global_->language_version()), strict_mode_ ? parse_mode::strict : parse_mode::non_strict);
+                bs = parse(std::make_shared<source_file>(u"eval", args.front().string_value().view(), global_->language_version()), strict_mode_ ? parse_mode::strict : parse_mode::non_strict);
             } catch (const std::exception&) {
-                throw native_error_exception{native_error_type::syntax, stack_trace(), L"Invalid argument to eval"};
+                throw native_error_exception{native_error_type::syntax, stack_trace(), u"Invalid argument to eval"};
             }
 
             std::unique_ptr<auto_scope> eval_scope;
             if (bs->strict_mode()) {
-                eval_scope.reset(new auto_scope{*this, activation_object::make(global_, {}, {}), active_scope_});
+                eval_scope.reset(new auto_scope{*this, activation_object::make(global_, std::vector<std::u16string>{}, {}, nullptr), active_scope_});
             }
 
             const std::unique_ptr<force_global_scope> fgs{!was_direct_call_to_eval_ ? new force_global_scope{*this} : nullptr};
             hoist(*bs);
-            auto c = eval(*bs);
+            auto c = eval_program(*bs);
             if (!c) {
                 return c.result;
             } else if (c.type == completion_type::throw_) {
@@ -299,10 +470,10 @@ public:
             throw native_error_exception{native_error_type::syntax, stack_trace(), woss.str()};
         }, 1);
 
-        auto func_obj = global_->get(L"Function").object_value();
+        auto func_obj = global_->get(u"Function").object_value();
         assert(func_obj.has_type<function_object>());
         static_cast<function_object&>(*func_obj).put_function([this](const value&, const std::vector<value>& args) {
-            std::wstring body{}, p{};
+            std::u16string body{}, p{};
             if (args.empty()) {
             } else if (args.size() == 1) {
                 body = to_string(heap_, args.front()).view();
@@ -317,9 +488,9 @@ public:
 
             std::unique_ptr<block_statement> bs;
             try {
-                bs = parse(std::make_shared<source_file>(L"Function definition", L"function anonymous(" + p + L") {\n" + body + L"\n}", global_->language_version()), strict_mode_ ? parse_mode::function_constructor_in_strict_context : parse_mode::non_strict);
+                bs = parse(std::make_shared<source_file>(u"Function definition", u"function anonymous(" + p + u") {\n" + body + u"\n}", global_->language_version()), strict_mode_ ? parse_mode::function_constructor_in_strict_context : parse_mode::non_strict);
             } catch (const std::exception&) {
-                throw native_error_exception{native_error_type::syntax, stack_trace(), L"Invalid argument to function constructor"};
+                throw native_error_exception{native_error_type::syntax, stack_trace(), u"Invalid argument to function constructor"};
             }
             if (bs->l().size() != 1 || bs->l().front()->type() != statement_type::function_definition) {
                 NOT_IMPLEMENTED("Invalid function definition: " << bs->extend().source_view());
@@ -342,24 +513,27 @@ public:
         return global_;
     }
 
+    const inline_cache_statistics& inline_cache_stats() const {
+        return inline_cache_stats_;
+    }
+
     void current_extend(const source_extend& e) {
         current_extend_ = e;
     }
 
-    void hoist(const hoisting_visitor::scan_result& sr) {
-        const auto& [ids, funcs] = sr;
-        for (const auto& var_id: ids) {
+    void hoist(const hoisted_declarations& decls) {
+        for (const auto& var_id: decls.ids) {
             if (!active_scope_->has_property(var_id)) {
                 active_scope_->put_local(string{heap_, var_id}, value::undefined);
             }
         }
-        for (const auto f: funcs) {
+        for (const auto f: decls.functions) {
             active_scope_->put_local_function(*this, *f);
         }
     }
 
     void hoist(const statement& s) {
-        hoist(hoisting_visitor::scan(s));
+        hoist(hoisted_declarations::scan(s));
     }
 
     value eval(const expression& e) {
@@ -391,15 +565,89 @@ public:
         }
     }
 
-    completion eval(const statement& s) {
-        if (!gc_cooldown_) {
-            if (heap_.use_percentage() > 90) {
-                heap_.garbage_collect();
-                gc_cooldown_ = 1000; // Arbitrary, but avoid collecting all the time when close to full
+    const gc_policy& garbage_collection_policy() const {
+        return gc_policy_;
+    }
+
+    void garbage_collection_policy(const gc_policy& policy) {
+        gc_policy_ = policy;
+        gc_growth_percentage_ = policy.growth_percentage;
+        gc_step_budget_ = gc_max_step_budget();
+        // Treat what's in use now as if it survived a collection
+        gc_trigger_ = next_gc_trigger(heap_.used());
+    }
+
+    // Old generation use (in slots) at which to collect after 'live' slots survived a collection
+    uint32_t next_gc_trigger(uint32_t live) const {
+        // Close to the maximum size of the heap, collect when half of the remaining space has been used instead
+        const auto growth = std::max(static_cast<uint64_t>(live) * gc_growth_percentage_ / 100, uint64_t{gc_policy_.min_growth});
+        return live + static_cast<uint32_t>(std::min(growth, uint64_t{(heap_.max_capacity() - live) / 2}));
+    }
+
+    std::chrono::microseconds gc_max_step_budget() const {
+        return gc_policy_.pause_budget - gc_policy_.pause_budget / 4;
+    }
+
+    const gc_statistics& garbage_collection_stats() const {
+        return gc_stats_;
+    }
+
+    void maybe_collect_garbage() {
+#ifdef MJS_GC_INCREMENTAL_STRESS_TEST
+        // Always be collecting, in steps small enough that the program runs in between most of the work
+        heap_.incremental_garbage_collect(uint32_t{8});
+        return;
+#endif
+        if (heap_.incremental_collection_active()) {
+            // Keep going with the collection, until it's done objects that don't fit in the nursery are allocated directly in the old generation
+            collect_garbage_step();
+            return;
+        }
+        if (heap_.nursery_use_percentage() > 90) {
+            heap_.minor_garbage_collect();
+        }
+        // Collect based on how much has been allocated in the old generation (by promotion or directly) since the last collection
+        if (heap_.used() >= gc_trigger_) {
+            gc_used_before_ = heap_.used();
+            collect_garbage_step();
+        }
+    }
+
+    void collect_garbage_step() {
+        const auto budget = gc_policy_.pause_budget;
+        const auto start = std::chrono::steady_clock::now();
+        const bool done = budget.count() ? heap_.incremental_garbage_collect(gc_step_budget_) : (heap_.garbage_collect(), true);
+        const auto pause = std::chrono::steady_clock::now() - start;
+        ++gc_stats_.steps;
+        gc_stats_.longest_pause = std::max(gc_stats_.longest_pause, pause);
+
+        // Steps stop a bit after their budget runs out and some of the work can't be split up (starting and completing
+        // the collection). Leave room for it by aiming for 3/4 of the pause budget, less after a step has overrun it.
+        if (budget.count()) {
+            if (pause > budget) {
+                gc_step_budget_ = std::max(gc_step_budget_ - std::chrono::duration_cast<std::chrono::microseconds>(pause - budget), budget / 4);
+            } else {
+                gc_step_budget_ = std::min(gc_step_budget_ + budget / 8, gc_max_step_budget());
             }
-        } else {
-            --gc_cooldown_;
         }
+        if (!done) {
+            return;
+        }
+        ++gc_stats_.collections;
+
+        // Collect less often while most of the heap survives (collections aren't freeing much), and go back towards
+        // the configured growth when most of it is garbage
+        const auto live = heap_.used();
+        if (live > gc_used_before_ / 4 * 3) {
+            gc_growth_percentage_ = std::min(gc_growth_percentage_ * 2, std::max(gc_policy_.max_growth_percentage, gc_policy_.growth_percentage));
+        } else if (live < gc_used_before_ / 4) {
+            gc_growth_percentage_ = std::max(gc_growth_percentage_ / 2, gc_policy_.growth_percentage);
+        }
+        gc_trigger_ = next_gc_trigger(live);
+    }
+
+    completion eval(const statement& s) {
+        maybe_collect_garbage();
 
         completion res{};
 
@@ -420,8 +668,18 @@ public:
         return res;
     }
 
-    value top_level_eval(const statement& s, bool allow_return = true) {
-        auto c = eval(s);
+    // Evaluate a program (or eval code) using the selected engine
+    completion eval_program(const statement& s) {
+        if (engine_ != interpreter_engine::ast && s.type() == statement_type::block) {
+            const auto chunk = compile(static_cast<const block_statement&>(s), static_cast<bool>(on_statement_executed_));
+            register_functions(*chunk);
+            prune_chunk_cache();
+            return run(*chunk);
+        }
+        return eval(s);
+    }
+
+    value top_level_eval(const completion& c, bool allow_return = true) {
         // ES3, 13.2.1 [[Call]]
         if (c.type == completion_type::throw_) {
             assert(c.result.type() == value_type::object);
@@ -443,7 +701,7 @@ public:
     }
 
     value operator()(const this_expression&) {
-        return value{active_scope_->lookup(L"this")};
+        return value{active_scope_->lookup(u"this")};
     }
 
     value operator()(const literal_expression& e) {
@@ -451,24 +709,20 @@ public:
         case token_type::null_:           return value::null;
         case token_type::true_:           return value{true};
         case token_type::false_:          return value{false};
-        case token_type::numeric_literal: return value{e.t().dvalue()};
+        case token_type::numeric_literal: return make_number_value(e.t().dvalue());
         case token_type::string_literal:  return value{string{heap_, e.t().text()}};
         default: NOT_IMPLEMENTED(e);
         }
     }
 
     value operator()(const array_literal_expression& e) {
-        auto a = make_array(global_, 0);
         const auto& es = e.elements();
-        for (unsigned i = 0; i < es.size(); ++i) {
-            if (es[i]) {
-                auto val = get_value(eval(*es[i]));
-                a->put(string{heap_, index_string(i)}, val);
-            } else {
-                a->put(string{heap_, index_string(i)}, value::undefined);
-            }
+        std::vector<value> elements;
+        elements.reserve(es.size());
+        for (const auto& element: es) {
+            elements.push_back(element ? get_value(eval(*element)) : value::undefined);
         }
-        return value{a};
+        return value{make_array_from_elements(global_, elements)};
     }
 
     value operator()(const object_literal_expression& e) {
@@ -520,6 +774,10 @@ public:
         auto [member, this_] = eval_call_member(e.member());
         auto mval = get_value(member);
         auto args = eval_argument_list(e.arguments());
+        return do_call(member, this_, mval, args, e);
+    }
+
+    value do_call(const value& member, value this_, const value& mval, const std::vector<value>& args, const call_expression& e) {
         if (mval.type() != value_type::object) {
             std::wostringstream woss;
             woss << to_string(heap_, mval).view() << " is not a function";
@@ -533,7 +791,7 @@ public:
             if (auto o = ref.base(); o && !o.has_type<activation_object>() && !is_global_object(o)) {
                 this_ = value{o};
             }
-            if (is_es5_or_later && ref.property_name().view() == L"eval") {
+            if (is_es5_or_later && ref.property_name().view() == u"eval") {
                 // Meh, may need extra/better check
                 was_direct_call_to_eval_ = true;
             }
@@ -547,9 +805,11 @@ public:
         if (e.op() == token_type::new_) {
             return handle_new_expression(e.e());
         }
+        return prefix_op(e.op(), eval(e.e()));
+    }
 
-        auto u = eval(e.e());
-        if (e.op() == token_type::delete_) {
+    value prefix_op(const token_type op, value u) {
+        if (op == token_type::delete_) {
             // ES1-5.1, 11.4.1: The delete Pperator
             if (u.type() != value_type::reference) {
                 return value{true};
@@ -569,10 +829,10 @@ public:
                 }
             }
             return value{base->delete_property(prop.view())};
-        } else if (e.op() == token_type::void_) {
+        } else if (op == token_type::void_) {
             (void)get_value(u);
             return value::undefined;
-        } else if (e.op() == token_type::typeof_) {
+        } else if (op == token_type::typeof_) {
             if (u.type() == value_type::reference && !u.reference_value().base()) {
                 return value{string{heap_, "undefined"}};
             }
@@ -587,33 +847,119 @@ public:
             default:
                 NOT_IMPLEMENTED(u.type());
             }
-        } else if (e.op() == token_type::plusplus || e.op() == token_type::minusminus) {
-            auto num = to_number(get_value(u)) + (e.op() == token_type::plusplus ? 1 : -1);
-            put_value(u, value{num});
-            return value{num};
-        } else if (e.op() == token_type::plus) {
-            return value{to_number(get_value(u))};
-        } else if (e.op() == token_type::minus) {
-            return value{-to_number(get_value(u))};
-        } else if (e.op() == token_type::tilde) {
-            return value{static_cast<double>(~to_int32(get_value(u)))};
-        } else if (e.op() == token_type::not_) {
+        } else if (op == token_type::plusplus || op == token_type::minusminus) {
+            auto num = increment(op, to_number_value(get_value(u)));
+            put_value(u, num);
+            return num;
+        } else if (op == token_type::plus) {
+            return to_number_value(get_value(u));
+        } else if (op == token_type::minus) {
+            auto num = to_number_value(get_value(u));
+            if (num.is_int32() && num.int32_value() != 0 && num.int32_value() != INT32_MIN) {
+                return value{-num.int32_value()};
+            }
+            return value{-num.number_value()};
+        } else if (op == token_type::tilde) {
+            return value{~to_int32(get_value(u))};
+        } else if (op == token_type::not_) {
             return value{!to_boolean(get_value(u))};
         }
-        NOT_IMPLEMENTED(e);
+        NOT_IMPLEMENTED(op);
     }
 
     value operator()(const postfix_expression& e) {
-        auto member = eval(e.e());
-        auto orig = to_number(get_value(member));
-        auto num = orig;
-        switch (e.op()) {
-        case token_type::plusplus:   num += 1; break;
-        case token_type::minusminus: num -= 1; break;
-        default: NOT_IMPLEMENTED(e.op());
+        return postfix_op(e.op(), eval(e.e()));
+    }
+
+    value postfix_op(const token_type op, const value& member) {
+        if (op != token_type::plusplus && op != token_type::minusminus) {
+            NOT_IMPLEMENTED(op);
+        }
+        auto orig = to_number_value(get_value(member));
+        put_value(member, increment(op, orig));
+        return orig;
+    }
+
+    // Returns 'v' if it's already a number (keeping an int32 representation), otherwise ToNumber(v)
+    static value to_number_value(const value& v) {
+        return v.type() == value_type::number ? v : value{to_number(v)};
+    }
+
+    // Add (++) or subtract (--) one from the number 'n' staying in the int32 representation unless it overflows
+    static value increment(const token_type op, const value& n) {
+        const int32_t delta = op == token_type::plusplus ? 1 : -1;
+        if (n.is_int32()) {
+            if (const auto res = static_cast<int64_t>(n.int32_value()) + delta; res >= INT32_MIN && res <= INT32_MAX) {
+                return value{static_cast<int32_t>(res)};
+            }
+        }
+        return value{n.number_value() + delta};
+    }
+
+    // Evaluate 'l op r' for two int32 numbers, returns false if the result must be calculated using doubles
+    // (because it overflows, is -0 or isn't an integer)
+    static bool int32_binary_op(const token_type op, const int32_t l, const int32_t r, value& res) {
+        int64_t x;
+        switch (op) {
+        case token_type::plus:      x = static_cast<int64_t>(l) + r; break;
+        case token_type::minus:     x = static_cast<int64_t>(l) - r; break;
+        case token_type::multiply:
+            x = static_cast<int64_t>(l) * r;
+            if (!x && (l < 0 || r < 0)) {
+                return false;
+            }
+            break;
+        case token_type::divide:
+            if (!r || (!l && r < 0) || static_cast<int64_t>(l) % r) {
+                return false;
+            }
+            x = static_cast<int64_t>(l) / r;
+            break;
+        case token_type::mod:
+            if (!r) {
+                return false;
+            }
+            x = static_cast<int64_t>(l) % r;
+            if (!x && l < 0) {
+                return false;
+            }
+            break;
+        case token_type::lshift:          res = value{static_cast<int32_t>(static_cast<uint32_t>(l) << (r & 0x1f))}; return true;
+        case token_type::rshift:          res = value{l >> (r & 0x1f)}; return true;
+        case token_type::rshiftshift:     x = static_cast<uint32_t>(l) >> (r & 0x1f); break;
+        case token_type::and_:            res = value{l & r}; return true;
+        case token_type::xor_:            res = value{l ^ r}; return true;
+        case token_type::or_:             res = value{l | r}; return true;
+        case token_type::lt:              res = value{l < r}; return true;
+        case token_type::ltequal:         res = value{l <= r}; return true;
+        case token_type::gt:              res = value{l > r}; return true;
+        case token_type::gtequal:         res = value{l >= r}; return true;
+        case token_type::equalequal:      [[fallthrough]];
+        case token_type::equalequalequal: res = value{l == r}; return true;
+        case token_type::notequal:        [[fallthrough]];
+        case token_type::notequalequal:   res = value{l != r}; return true;
+        default:                          return false;
+        }
+        if (x < INT32_MIN || x > INT32_MAX) {
+            return false;
         }
-        put_value(member, value{num});
-        return value{orig};
+        res = value{static_cast<int32_t>(x)};
+        return true;
+    }
+
+    // Returns the array index 'v' denotes if it's a number (without converting it to a string), otherwise invalid_index_value
+    static uint32_t number_index_value(const value& v) {
+        if (v.type() != value_type::number) {
+            return invalid_index_value;
+        }
+        if (v.is_int32()) {
+            return v.int32_value() >= 0 ? static_cast<uint32_t>(v.int32_value()) : invalid_index_value;
+        }
+        const double d = v.number_value();
+        if (d >= 0 && d < invalid_index_value && static_cast<uint32_t>(d) == d) {
+            return static_cast<uint32_t>(d); // Note: -0 is also converted to "0"
+        }
+        return invalid_index_value;
     }
 
     // 0=false, 1=true, -1=undefined
@@ -701,6 +1047,11 @@ public:
     }
 
     value do_binary_op(const token_type op, value& l, value& r) {
+        if (l.type() == value_type::number && r.type() == value_type::number && l.is_int32() && r.is_int32()) {
+            if (value res; int32_binary_op(op, l.int32_value(), r.int32_value(), res)) {
+                return res;
+            }
+        }
         if (op == token_type::plus) {
             l = to_primitive(l);
             r = to_primitive(r);
@@ -751,12 +1102,12 @@ public:
         case token_type::multiply:     return value{ln * rn};
         case token_type::divide:       return value{ln / rn};
         case token_type::mod:          return value{std::fmod(ln, rn)};
-        case token_type::lshift:       return value{static_cast<double>(to_int32(ln) << (to_uint32(rn) & 0x1f))};
-        case token_type::rshift:       return value{static_cast<double>(to_int32(ln) >> (to_uint32(rn) & 0x1f))};
-        case token_type::rshiftshift:  return value{static_cast<double>(to_uint32(ln) >> (to_uint32(rn) & 0x1f))};
-        case token_type::and_:         return value{static_cast<double>(to_int32(ln) & to_int32(rn))};
-        case token_type::xor_:         return value{static_cast<double>(to_int32(ln) ^ to_int32(rn))};
-        case token_type::or_:          return value{static_cast<double>(to_int32(ln) | to_int32(rn))};
+        case token_type::lshift:       return value{static_cast<int32_t>(to_uint32(ln) << (to_uint32(rn) & 0x1f))};
+        case token_type::rshift:       return value{to_int32(ln) >> (to_uint32(rn) & 0x1f)};
+        case token_type::rshiftshift:  return make_number_value(to_uint32(ln) >> (to_uint32(rn) & 0x1f));
+        case token_type::and_:         return value{to_int32(ln) & to_int32(rn)};
+        case token_type::xor_:         return value{to_int32(ln) ^ to_int32(rn)};
+        case token_type::or_:          return value{to_int32(ln) | to_int32(rn)};
         default: NOT_IMPLEMENTED(op);
         }
     }
@@ -765,6 +1116,26 @@ public:
         return value{reference{global_->to_object(obj), to_string(heap_, prop)}};
     }
 
+    // Value of obj[prop] without creating a reference (or the property name if 'prop' is an array index)
+    value get_element(const value& obj, const value& prop) {
+        if (obj.type() == value_type::object) {
+            if (const auto index = number_index_value(prop); index != invalid_index_value) {
+                return obj.object_value()->get_element(index);
+            }
+        }
+        return get_value(make_reference(obj, prop));
+    }
+
+    // obj[prop] = val where 'obj' has already been converted to an object and 'prop' to a property key (see to_property_key)
+    void put_element(const value& obj, const value& prop, const value& val) {
+        const auto& o = obj.object_value();
+        if (const auto index = number_index_value(prop); index != invalid_index_value && !strict_mode_) {
+            o->put_element(index, val);
+        } else {
+            put_value(value{reference{o, to_string(heap_, prop)}}, val);
+        }
+    }
+
     value operator()(const binary_expression& e) {
         if (e.op() == token_type::comma) {
             (void)get_value(eval(e.lhs()));;
@@ -772,13 +1143,7 @@ public:
         }
         if (operator_precedence(e.op()) == assignment_precedence) {
             auto l = eval(e.lhs());
-            auto r = get_value(eval(e.rhs()));
-            if (e.op() != token_type::equal) {
-                auto lval = get_value(l);
-                r = do_binary_op(without_assignment(e.op()), lval, r);
-            }
-            put_value(l, r);
-            return r;
+            return assign_op(e.op(), l, get_value(eval(e.rhs())));
         }
 
         auto l = get_value(eval(e.lhs()));
@@ -788,16 +1153,31 @@ public:
         auto r = get_value(eval(e.rhs()));
         if (e.op() == token_type::andand || e.op() == token_type::oror) {
             return r;
-        } else if (is_reference_op(e.op())) {
+        }
+        return binary_op(e.op(), l, r);
+    }
+
+    value assign_op(const token_type op, const value& l, value r) {
+        if (op != token_type::equal) {
+            auto lval = get_value(l);
+            r = do_binary_op(without_assignment(op), lval, r);
+        }
+        put_value(l, r);
+        return r;
+    }
+
+    // Binary operators other than comma, assignment and the logical operators (which need special evaluation order)
+    value binary_op(const token_type op, value l, value r) {
+        if (is_reference_op(op)) {
             return make_reference(l, r);
-        } else if (e.op() == token_type::in_) {
+        } else if (op == token_type::in_) {
             if (r.type() != value_type::object) {
                 std::wostringstream woss;
                 woss << r.type() << " is not an object";
                 throw native_error_exception{native_error_type::type, stack_trace(), woss.str()};
             }
             return value{r.object_value()->has_property(to_string(heap_, l).view())};
-        } else if (e.op() == token_type::instanceof_) {
+        } else if (op == token_type::instanceof_) {
             if (r.type() != value_type::object || r.object_value()->prototype().get() != global_->function_prototype().get()) {
                 std::wostringstream woss;
                 woss << r.type() << " is not an object";
@@ -807,7 +1187,7 @@ public:
             if (l.type() != value_type::object) {
                 return value{false};
             }
-            auto o = r.object_value()->get(L"prototype");
+            auto o = r.object_value()->get(u"prototype");
             if (o.type() != value_type::object) {
                 std::wostringstream woss;
                 woss << "Function has non-object prototype of type " << o.type() << " in instanceof check";
@@ -825,7 +1205,7 @@ public:
             }
 
         }
-        return do_binary_op(e.op(), l, r);
+        return do_binary_op(op, l, r);
     }
 
     value operator()(const conditional_expression& e) {
@@ -1128,6 +1508,649 @@ public:
         NOT_IMPLEMENTED(woss.str());
     }
 
+    //
+    // Bytecode
+    //
+
+    // Remember where the own or prototype data property 'name' of the plain object 'o' is
+    static void update_cache(bytecode_chunk::property_cache& c, const object& o, const std::u16string_view name) {
+        c = bytecode_chunk::property_cache{};
+        const auto& s = o.shape();
+        if (const auto index = s.find(name); index != object_shape::not_found) {
+            if (!has_attributes(s.attributes(index), property_attribute::accessor)) {
+                c = bytecode_chunk::property_cache{s.id(), 0, index};
+            }
+        } else if (const auto p = o.prototype()) {
+            const auto& ps = p->shape();
+            if (const auto pindex = ps.find(name); pindex != object_shape::not_found && !has_attributes(ps.attributes(pindex), property_attribute::accessor)) {
+                c = bytecode_chunk::property_cache{s.id(), ps.id(), pindex};
+            }
+        }
+    }
+
+    value cached_get(const value& v, const std::u16string& name, bytecode_chunk::property_cache& c, inline_cache_statistics::counters& counters) {
+        // Only plain objects are handled since other objects may have properties outside their shape
+        if (v.type() == value_type::object && v.object_value().has_type<object>()) {
+            const auto& o = v.object_value();
+            if (c.shape_id == o->shape().id()) {
+                if (!c.holder_shape_id) {
+                    ++counters.hits;
+                    return o->raw_get(c.index);
+                }
+                // The shape implies the prototype
+                const auto p = o->prototype();
+                if (c.holder_shape_id == p->shape().id()) {
+                    ++counters.hits;
+                    return p->raw_get(c.index);
+                }
+            }
+            ++counters.misses;
+            update_cache(c, *o, name);
+            return o->get(name);
+        }
+        ++counters.misses;
+        return get_value(make_reference(v, value{string{heap_, name}}));
+    }
+
+    void cached_put(const value& v, const std::u16string& name, const value& val, bytecode_chunk::property_cache& c, inline_cache_statistics::counters& counters) {
+        if (v.type() == value_type::object && v.object_value().has_type<object>()) {
+            const auto& o = v.object_value();
+            // Only writable own data properties are cached (see below)
+            if (c.shape_id == o->shape().id()) {
+                ++counters.hits;
+                o->raw_put(c.index, val);
+                return;
+            }
+            ++counters.misses;
+            put_value(make_reference(v, value{string{heap_, name}}), val);
+            update_cache(c, *o, name);
+            if (c.holder_shape_id || (c.shape_id && has_attributes(o->shape().attributes(c.index), property_attribute::read_only))) {
+                c = bytecode_chunk::property_cache{};
+            }
+            return;
+        }
+        ++counters.misses;
+        put_value(make_reference(v, value{string{heap_, name}}), val);
+    }
+
+    // 'name' is the name of the function (if any) the chunk belongs to
+    completion run(const bytecode_chunk& chunk, std::u16string_view name = {}) {
+        strict_mode_scope sms{*this, chunk.strict_mode()};
+        if (global_->language_version() >= version::es3) {
+            try {
+                return execute(chunk, name);
+            } catch (const native_error_exception& e) {
+                return completion{value{e.make_error_object(global_)}, completion_type::throw_};
+            }
+        }
+        return execute(chunk, name);
+    }
+
+    completion execute(const bytecode_chunk& chunk, std::u16string_view name) {
+        // Same conversions as for expressions evaluated by the AST interpreter
+        try {
+            if (engine_ == interpreter_engine::jit && chunk.layout()) {
+                return run_jit(chunk, name);
+            }
+            return dispatch(chunk);
+        } catch (const not_supported_exception& e) {
+            throw native_error_exception{native_error_type::assertion, stack_trace(), e.what()};
+        } catch (const to_primitive_failed_error& e) {
+            throw native_error_exception{native_error_type::type, stack_trace(), e.what()};
+        } catch (const no_internal_value& e) {
+            throw native_error_exception{native_error_type::type, stack_trace(), e.what()};
+        } catch (const not_callable_exception& e) {
+            throw native_error_exception{native_error_type::type, stack_trace(), e.what()};
+        }
+    }
+
+#ifdef __GNUC__
+// Use "labels as values" to get a separate indirect jump for each instruction
+#define MJS_COMPUTED_GOTO
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+
+    // State of the virtual machine while running a chunk
+    struct vm_state {
+        uint32_t pc = 0;
+        explicit vm_state(gc_heap& h) : stack(h) {}
+
+        value_stack stack;
+        value result;
+        const statement* current_statement = nullptr;
+        uint32_t loop_iterations = 0; // Backward jumps taken (see jit_policy)
+    };
+
+    completion dispatch(const bytecode_chunk& chunk, uint32_t* loop_iterations = nullptr) {
+        vm_state state{heap_};
+        state.stack.reserve(16);
+        completion c;
+        interpret<false>(chunk, state, c);
+        if (loop_iterations) {
+            *loop_iterations = state.loop_iterations;
+        }
+        return c;
+    }
+
+    // Run from state.pc until the chunk completes, returning true with the completion stored in 'out'.
+    // With single_step only the instruction at state.pc is executed, false is returned if the chunk didn't complete.
+    template<bool single_step>
+    bool interpret(const bytecode_chunk& chunk, vm_state& state, completion& out) {
+        const uint8_t* const code = chunk.code();
+        uint32_t pc = state.pc;
+        auto& stack = state.stack;
+        auto& result = state.result;
+        auto& current_statement = state.current_statement;
+
+        auto read_operand = [&]() {
+            const auto operand = bytecode_chunk::read_operand(&code[pc]);
+            pc += sizeof(operand);
+            return operand;
+        };
+
+        auto pop = [&stack]() {
+            return stack.pop();
+        };
+
+        auto pop_arguments = [&stack](uint32_t num_args) {
+            return stack.pop_arguments(num_args);
+        };
+
+        auto abrupt_completion = [&](const completion& c) {
+            if (on_statement_executed_ && current_statement) {
+                on_statement_executed_(*current_statement, c);
+            }
+            return c;
+        };
+
+#ifdef MJS_COMPUTED_GOTO
+        static const void* const dispatch_table[] = {
+#define MJS_OPCODE_LABEL(name, num_operands) &&op_##name,
+            MJS_OPCODES(MJS_OPCODE_LABEL)
+#undef MJS_OPCODE_LABEL
+        };
+#define MJS_VM_CASE(name) op_##name
+#define MJS_VM_NEXT() if constexpr (single_step) { state.pc = pc; return false; } else goto *dispatch_table[code[pc++]]
+        goto *dispatch_table[code[pc++]];
+#else
+#define MJS_VM_CASE(name) case opcode::name
+#define MJS_VM_NEXT() if constexpr (single_step) { state.pc = pc; return false; } else goto next
+next:
+        switch (static_cast<opcode>(code[pc++])) {
+#endif
+
+        MJS_VM_CASE(push_undefined): {
+            stack.push_back(value::undefined);
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(push_null): {
+            stack.push_back(value::null);
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(push_true): {
+            stack.push_back(value{true});
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(push_false): {
+            stack.push_back(value{false});
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(push_number): {
+            stack.push_back(make_number_value(chunk.number(read_operand())));
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(push_string): {
+            stack.push_back(value{string{heap_, chunk.name(read_operand())}});
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(pop): {
+            stack.pop_back();
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(lookup): {
+            stack.push_back(value{active_scope_->lookup(chunk.name(read_operand()))});
+        }
+        MJS_VM_NEXT();
+
+        // Note: Slot references must be re-fetched after anything that may cause a garbage collection
+
+        MJS_VM_CASE(get_slot): {
+            const auto depth = read_operand();
+            stack.push_back(active_scope_->activation_at(depth).slot(read_operand()));
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(set_slot): {
+            const auto depth = read_operand();
+            auto& slot = active_scope_->activation_at(depth).slot(read_operand());
+            slot = stack.back_representation();
+            heap_.write_barrier(&slot);
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(assign_slot): {
+            const auto op = static_cast<token_type>(read_operand());
+            const auto depth = read_operand();
+            const auto index = read_operand();
+            auto r = pop();
+            auto l = active_scope_->activation_at(depth).slot(index).get_value(heap_);
+            r = do_binary_op(without_assignment(op), l, r);
+            active_scope_->activation_at(depth).slot(index) = r;
+            stack.push_back(r);
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(prefix_slot): {
+            const auto op = static_cast<token_type>(read_operand());
+            const auto depth = read_operand();
+            const auto index = read_operand();
+            auto num = increment(op, to_number_value(active_scope_->activation_at(depth).slot(index).get_value(heap_)));
+            active_scope_->activation_at(depth).slot(index) = num;
+            stack.push_back(num);
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(postfix_slot): {
+            const auto op = static_cast<token_type>(read_operand());
+            const auto depth = read_operand();
+            const auto index = read_operand();
+            const auto orig = to_number_value(active_scope_->activation_at(depth).slot(index).get_value(heap_));
+            active_scope_->activation_at(depth).slot(index) = increment(op, orig);
+            stack.push_back(orig);
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(get_member): {
+            const auto& name = chunk.name(read_operand());
+            auto& c = chunk.cache(read_operand());
+            stack.set_back(cached_get(stack.back(), name, c, inline_cache_stats_.get));
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(put_member): {
+            const auto& name = chunk.name(read_operand());
+            auto& c = chunk.cache(read_operand());
+            auto val = pop();
+            cached_put(stack.back(), name, val, c, inline_cache_stats_.put);
+            stack.set_back(val);
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(get_method): {
+            // See call_member/get_callee
+            const auto& name = chunk.name(read_operand());
+            auto& c = chunk.cache(read_operand());
+            auto l = stack.back();
+            stack.set_back(value::undefined);
+            stack.push_back(l);
+            stack.push_back(cached_get(l, name, c, inline_cache_stats_.call));
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(to_object): {
+            if (auto v = stack.back(); v.type() != value_type::object) {
+                stack.set_back(value{global_->to_object(v)});
+            }
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(get_element): {
+            auto r = pop();
+            stack.set_back(get_element(stack.back(), r));
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(to_property_key): {
+            // Like creating a reference, but numbers are left for put_element (converting them can't have side effects)
+            auto k = pop();
+            auto o = pop();
+            stack.push_back(o.type() == value_type::object ? o : value{global_->to_object(o)});
+            stack.push_back(k.type() == value_type::number ? k : value{to_string(heap_, k)});
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(put_element): {
+            auto val = pop();
+            auto prop = pop();
+            put_element(stack.back(), prop, val);
+            stack.set_back(val);
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(get_value): {
+            stack.set_back(get_value(stack.back()));
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(call_member): {
+            // See eval_call_member
+            auto r = pop();
+            auto l = pop();
+            auto ref = make_reference(l, r);
+            stack.push_back(ref);
+            stack.push_back(l);
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(get_callee): {
+            assert(stack.size() >= 2);
+            auto mval = get_value(stack.at(stack.size() - 2));
+            stack.push_back(mval);
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(call): {
+            const auto num_args = read_operand();
+            const auto& e = static_cast<const call_expression&>(chunk.expr(read_operand()));
+            auto args = pop_arguments(num_args);
+            auto mval = pop();
+            auto this_ = pop();
+            auto member = pop();
+            stack.push_back(do_call(member, this_, mval, args, e));
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(new_): {
+            const auto num_args = read_operand();
+            const auto& e = chunk.expr(read_operand());
+            auto args = pop_arguments(num_args);
+            auto o = get_value(pop());
+            stack.push_back(construct(o, args, e));
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(binary): {
+            const auto op = static_cast<token_type>(read_operand());
+            auto r = pop();
+            auto l = pop();
+            stack.push_back(binary_op(op, l, r));
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(assign): {
+            const auto op = static_cast<token_type>(read_operand());
+            auto r = pop();
+            auto l = pop();
+            stack.push_back(assign_op(op, l, r));
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(prefix): {
+            const auto op = static_cast<token_type>(read_operand());
+            stack.push_back(prefix_op(op, pop()));
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(postfix): {
+            const auto op = static_cast<token_type>(read_operand());
+            stack.push_back(postfix_op(op, pop()));
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(jump): {
+            const auto target = read_operand();
+            state.loop_iterations += target < pc;
+            pc = target;
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(jump_if_false): {
+            const auto target = read_operand();
+            if (!to_boolean(pop())) {
+                pc = target;
+            }
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(jump_if_true): {
+            const auto target = read_operand();
+            if (to_boolean(pop())) {
+                state.loop_iterations += target < pc;
+                pc = target;
+            }
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(and_jump): {
+            // Short circuit (leaving the value on the stack) if false
+            const auto target = read_operand();
+            if (!to_boolean(stack.back())) {
+                pc = target;
+            } else {
+                stack.pop_back();
+            }
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(or_jump): {
+            const auto target = read_operand();
+            if (to_boolean(stack.back())) {
+                pc = target;
+            } else {
+                stack.pop_back();
+            }
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(eval_expression): {
+            stack.push_back(eval(chunk.expr(read_operand())));
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(statement): {
+            current_statement = &chunk.stmt(read_operand());
+            current_extend(current_statement->extend());
+#ifdef MJS_GC_STRESS_TEST
+            heap_.garbage_collect();
+#endif
+            maybe_collect_garbage();
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(statement_done): {
+            const auto& s = chunk.stmt(read_operand());
+            if (on_statement_executed_) {
+                on_statement_executed_(s, completion{result});
+            }
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(set_result): {
+            result = pop();
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(clear_result): {
+            result = value::undefined;
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(put_local): {
+            const auto& name = chunk.name(read_operand());
+            auto v = pop();
+            active_scope_->put_local(string{heap_, name}, v);
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(define_function): {
+            active_scope_->put_local_function(*this, static_cast<const function_definition&>(chunk.stmt(read_operand())));
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(eval_statement): {
+            const auto& f = chunk.fallback(read_operand());
+            if (!f.labels.empty()) {
+                label_set_ = f.labels;
+                labels_valid_for_ = f.s;
+            }
+            auto c = eval(*f.s);
+            if (!c) {
+                result = c.result;
+            } else if (!c.has_target()) {
+                out = c;
+                return true;
+            } else {
+                // Break/continue targeting a loop in this chunk?
+                auto it = std::find_if(f.loops.begin(), f.loops.end(), [&](uint32_t index) { return c.in_set(chunk.loop(index).labels); });
+                if (it == f.loops.end()) {
+                    out = c;
+                    return true;
+                }
+                const auto& l = chunk.loop(*it);
+                pc = c.type == completion_type::break_ ? l.break_pc : l.continue_pc;
+                result = value::undefined;
+            }
+        }
+        MJS_VM_NEXT();
+
+        MJS_VM_CASE(return_): {
+            out = abrupt_completion(completion{pop(), completion_type::return_});
+            return true;
+        }
+
+        MJS_VM_CASE(throw_): {
+            out = abrupt_completion(completion{pop(), completion_type::throw_});
+            return true;
+        }
+
+        MJS_VM_CASE(end): {
+            assert(stack.empty());
+            out = completion{result};
+            return true;
+        }
+
+#ifndef MJS_COMPUTED_GOTO
+        }
+        NOT_IMPLEMENTED(static_cast<opcode>(code[pc - 1]));
+#endif
+#undef MJS_VM_NEXT
+#undef MJS_VM_CASE
+    }
+
+#ifdef MJS_COMPUTED_GOTO
+#undef MJS_COMPUTED_GOTO
+#pragma GCC diagnostic pop
+#endif
+
+    const jit_policy& jit_compilation_policy() const {
+        return jit_policy_;
+    }
+
+    void jit_compilation_policy(const jit_policy& policy) {
+        jit_policy_ = policy;
+    }
+
+    const jit_statistics& jit_compilation_stats() const {
+        return jit_stats_;
+    }
+
+    struct jit_frame : jit::frame {
+        explicit jit_frame(impl& self, const bytecode_chunk& chunk) : self(self), chunk(chunk), state(self.heap_) {}
+
+        impl& self;
+        const bytecode_chunk& chunk;
+        vm_state state;
+        completion result;
+        std::exception_ptr exception; // Exceptions can't propagate through the generated code
+        bool deoptimized = false;
+    };
+
+    // Run a function body compiling it first if it has been called often enough (see jit.h)
+    completion run_jit(const bytecode_chunk& chunk, std::u16string_view name) {
+        static const jit::helpers helpers{&impl::jit_step, &impl::jit_test, &impl::jit_deopt};
+
+        auto& js = chunk.jit_state();
+        if (!js) {
+            js = std::make_shared<jit::chunk_state>();
+            js->generic.resize(chunk.code_size());
+        }
+        if (js->hotness < jit_policy_.threshold) {
+            uint32_t loop_iterations = 0;
+            auto c = dispatch(chunk, &loop_iterations);
+            // Saturate so the count can't wrap around
+            const uint64_t hotness = uint64_t{js->hotness} + jit_policy_.call_weight + loop_iterations;
+            js->hotness = static_cast<uint32_t>(std::min(hotness, uint64_t{jit_policy_.threshold}));
+            return c;
+        }
+        if (!js->compiled) {
+            if (js->compiles >= jit_policy_.max_compiles) {
+                return dispatch(chunk);
+            }
+            ++js->compiles;
+            js->compiled = jit::code::compile(chunk, helpers, js->generic, name);
+            if (!js->compiled) {
+                js->compiles = jit_policy_.max_compiles;
+                return dispatch(chunk);
+            }
+            ++jit_stats_.compiles;
+        }
+
+        const auto code = js->compiled; // Keep the code alive even if deoptimization invalidates it
+        jit_frame f{*this, chunk};
+        f.state.stack.reserve(code->max_stack());
+        f.stack = f.state.stack.data();
+        code->run(f, jit_slots());
+        if (f.exception) {
+            std::rethrow_exception(f.exception);
+        }
+        if (f.deoptimized) {
+            // Continue in the bytecode interpreter
+            f.state.pc = f.pc;
+            f.state.stack.set_size(f.depth);
+            interpret<false>(chunk, f.state, f.result);
+        }
+        return f.result;
+    }
+
+    value_representation* jit_slots() {
+        return active_scope_->activation_at(0).slot_data();
+    }
+
+    static jit::helper_result jit_step(jit::frame& frame, uint32_t pc, uint32_t depth) {
+        auto& f = static_cast<jit_frame&>(frame);
+        try {
+            f.state.pc = pc;
+            f.state.stack.set_size(depth);
+            if (f.self.interpret<true>(f.chunk, f.state, f.result)) {
+                return jit::helper_result{jit::status::exit, nullptr};
+            }
+            assert(f.state.stack.data() == f.stack);
+            const auto next = f.state.pc == pc + instruction_size(static_cast<opcode>(f.chunk.code()[pc]));
+            f.pc = f.state.pc;
+            return jit::helper_result{next ? jit::status::next : jit::status::jump, f.self.jit_slots()};
+        } catch (...) {
+            f.exception = std::current_exception();
+            return jit::helper_result{jit::status::exit, nullptr};
+        }
+    }
+
+    static jit::helper_result jit_test(jit::frame& frame, uint32_t, uint32_t depth) {
+        auto& f = static_cast<jit_frame&>(frame);
+        f.state.stack.set_size(depth);
+        const bool b = to_boolean(f.state.stack.pop());
+        return jit::helper_result{static_cast<jit::status>(b), f.self.jit_slots()};
+    }
+
+    static jit::helper_result jit_deopt(jit::frame& frame, uint32_t pc, uint32_t depth) {
+        auto& f = static_cast<jit_frame&>(frame);
+        ++f.self.jit_stats_.deoptimizations;
+        auto& js = *f.chunk.jit_state();
+        js.generic[pc] = true;
+        js.compiled = nullptr; // Recompiled on the next call
+        f.pc = pc;
+        f.depth = depth;
+        f.deoptimized = true;
+        return jit::helper_result{jit::status::exit, nullptr};
+    }
+
 private:
     class scope;
     using scope_ptr = gc_heap_ptr<scope>;
@@ -1135,7 +2158,7 @@ private:
     public:
         friend gc_type_info_registration<scope>;
 
-        bool has_property(const std::wstring& id) const {
+        bool has_property(const std::u16string& id) const {
             if (!activation_) {
                 return false;
             }
@@ -1153,7 +2176,7 @@ private:
             }
         }
 
-        reference lookup(const std::wstring& id) const {
+        reference lookup(const std::u16string& id) const {
             return lookup(string{heap_, id});
         }
 
@@ -1207,6 +2230,16 @@ private:
             return prev_ ? &prev_.dereference(heap_) : nullptr;
         }
 
+        // Activation record 'depth' scopes up, only valid for statically resolved slots
+        activation_object& activation_at(uint32_t depth) const {
+            const scope* s = this;
+            for (; depth; --depth) {
+                s = &s->prev_.dereference(heap_);
+            }
+            assert(s->activation_.track(heap_).has_type<activation_object>());
+            return static_cast<activation_object&>(s->activation_.dereference(heap_));
+        }
+
     private:
         using weak_object_ptr = gc_heap_weak_ptr_untracked<object>;
 
@@ -1302,17 +2335,28 @@ private:
     gc_heap_ptr<global_object>     global_;
     on_statement_executed_type     on_statement_executed_;
     std::vector<source_extend>     stack_trace_;
-    int                            gc_cooldown_ = 0;
+    gc_policy                      gc_policy_;
+    uint32_t                       gc_growth_percentage_ = gc_policy_.growth_percentage;
+    uint32_t                       gc_trigger_ = heap_.capacity() / 10 * 9; // Old generation use (in slots) at which to collect (until a policy is set)
+    uint32_t                       gc_used_before_ = 0;
+    std::chrono::microseconds      gc_step_budget_{0}; // Budget for the next incremental step
+    gc_statistics                  gc_stats_;
     label_set                      label_set_;
     const statement*               labels_valid_for_ = nullptr;
     source_extend                  current_extend_;
     bool                           was_direct_call_to_eval_ = false; // To support ES5.1, 15.1.2.1.1 Direct Call to Eval (TODO: Do this smarter...)
+    interpreter_engine             engine_;
+    inline_cache_statistics        inline_cache_stats_;
+    jit_policy                     jit_policy_;
+    jit_statistics                 jit_stats_;
+    std::unordered_map<const block_statement*, std::weak_ptr<const bytecode_chunk>> chunk_cache_;
+    size_t                         chunk_cache_prune_size_ = 64; // See prune_chunk_cache()
 
     static scope_ptr make_scope(const object_ptr& act, const scope_ptr& prev) {
         return act.heap().make<scope>(act, prev);
     }
 
-    std::wstring stack_trace() const {
+    std::u16string stack_trace() const {
         std::wostringstream woss;
         assert(current_extend_.file);
         woss << current_extend_;
@@ -1320,7 +2364,7 @@ private:
             assert(it->file);
             woss << "\n" << *it;
         }
-        return woss.str();
+        return to_u16string(woss.str());
     }
 
     std::vector<value> eval_argument_list(const expression_list& es) {
@@ -1341,7 +2385,10 @@ private:
         } else {
             o = eval(e);
         }
-        o = get_value(o);
+        return construct(get_value(o), args, e);
+    }
+
+    value construct(const value& o, const std::vector<value>& args, const expression& e) {
         try {
             auto_stack_update asu{*this, e.extend()};
             return construct_function(o, value::undefined, args);
@@ -1357,38 +2404,52 @@ private:
         }
     }
 
-    object_ptr create_function(const string& id, const std::shared_ptr<block_statement>& block, const std::vector<std::wstring>& param_names, const std::wstring& body_text, const scope_ptr& prev_scope) {
+    object_ptr create_function(const function_base& f, const scope_ptr& prev_scope) {
         // §15.3.2.1
         auto callee = make_raw_function(global_);
-        auto func = [this, block, param_names, prev_scope, callee, id, hv_result = hoisting_visitor::scan(*block)](const value& this_, const std::vector<value>& args) {
-            strict_mode_scope sms{*this, block->strict_mode()};
-            // Scope
-            auto activation = activation_object::make(global_, param_names, args);
-            activation->put(global_->common_string("this"), block->strict_mode() ? this_ : get_this_arg(global_, this_), property_attribute::dont_delete | property_attribute::dont_enum | property_attribute::read_only);
-            if (!strict_mode_) {
-                activation->arguments()->put(global_->common_string("callee"), value{callee}, property_attribute::dont_enum);
-            } else {
-                global_->define_thrower_accessor(*activation->arguments(), "callee");
-                global_->define_thrower_accessor(*activation->arguments(), "caller");
+        auto func = [this, info = f.shared_info(), prev_scope, callee, chunk = function_chunk(f)](const value& this_, const std::vector<value>& args) {
+            const auto& block = *info->block;
+            strict_mode_scope sms{*this, block.strict_mode()};
+            if (chunk && chunk->layout()) {
+                const auto& layout = *chunk->layout();
+                auto activation = activation_object::make(global_, chunk->layout(), args);
+                activation->slot(layout.this_slot()) = block.strict_mode() ? this_ : get_this_arg(global_, this_);
+                if (layout.id_slot() != frame_layout::no_slot) {
+                    activation->slot(layout.id_slot()) = value{callee};
+                }
+                if (auto as = activation->arguments()) {
+                    assert(strict_mode_);
+                    global_->define_thrower_accessor(*as, "callee");
+                    global_->define_thrower_accessor(*as, "caller");
+                }
+                auto_scope auto_scope_{*this, activation, prev_scope};
+                hoist(info->declarations);
+                return top_level_eval(run(*chunk, info->id));
             }
+            // Scope
+            auto activation = activation_object::make(global_, info->params, args, info->may_use_arguments ? callee : nullptr);
+            activation->put(global_->common_string("this"), block.strict_mode() ? this_ : get_this_arg(global_, this_), property_attribute::dont_delete | property_attribute::dont_enum | property_attribute::read_only);
             auto_scope auto_scope_{*this, activation, prev_scope};
             // Variables
-            hoist(hv_result);
-            if (!id.view().empty()) {
+            hoist(info->declarations);
+            if (!info->id.empty()) {
                 // Add name of function to activation record even if it's not necessary for function_definition
                 // It's needed for function expressions since `a=function x() { x(...); }` is legal, but x isn't added to the containing scope
                 // TODO: Should actually be done a separate scope object (See ES3, 13)
-                assert(!activation->has_property(id.view())); // TODO: Handle this..
-                activation->put(id, value{callee}, property_attribute::dont_delete|property_attribute::read_only);
+                assert(!activation->has_property(info->id)); // TODO: Handle this..
+                activation->put(string{heap_, info->id}, value{callee}, property_attribute::dont_delete|property_attribute::read_only);
             }
-            return top_level_eval(*block);
+            return top_level_eval(chunk ? run(*chunk) : eval(block));
         };
-        callee->put_function(func, nullptr, string{heap_, L"function " + std::wstring{id.view()} + body_text}.unsafe_raw_get(), static_cast<int>(param_names.size()));
+        const auto body_text = f.body_extend().source_view();
+        string_builder text{heap_, static_cast<uint32_t>(9 + f.id().length() + body_text.length())};
+        text.append(u"function ").append(std::u16string_view{f.id()}).append(body_text);
+        callee->put_function(func, nullptr, text.release().unsafe_raw_get(), static_cast<int>(f.params().size()));
 
-        callee->construct_function([global = global_, callee, id](const value& this_, const std::vector<value>& args) {
+        callee->construct_function([global = global_, callee, id = string{heap_, f.id()}](const value& this_, const std::vector<value>& args) {
             assert(this_.type() == value_type::undefined); (void)this_; // [[maybe_unused]] not working with MSVC here?
             assert(!id.view().empty());
-            auto p = callee->get(L"prototype");
+            auto p = callee->get(u"prototype");
             auto o = value{global->heap().make<object>(id, p.type() == value_type::object ? p.object_value() : global->object_prototype())};
             auto r = callee->call(o, args);
             return r.type() == value_type::object ? r : value{o};
@@ -1397,10 +2458,52 @@ private:
         return callee;
     }
 
-    object_ptr create_function(const function_base& f, const scope_ptr& prev_scope) {
-        return create_function(string{heap_, f.id()}, f.block_ptr(), f.params(), std::wstring{f.body_extend().source_view()}, prev_scope);
+    // Returns the (shared) bytecode for a function body or nullptr when using the AST engine
+    std::shared_ptr<const bytecode_chunk> function_chunk(const function_base& f) {
+        if (engine_ == interpreter_engine::ast) {
+            return nullptr;
+        }
+        // The chunk is kept alive by the function objects, which also keep the body alive
+        auto& cached = chunk_cache_[&f.block()];
+        auto chunk = cached.lock();
+        if (!chunk) {
+            // Not reached through an enclosing chunk (e.g. created by the Function constructor), compile without knowing the outer scopes
+            chunk = compile(f, static_cast<bool>(on_statement_executed_));
+            cached = chunk;
+            register_functions(*chunk);
+            prune_chunk_cache();
+        }
+        return chunk;
+    }
+
+    // Make the nested functions of 'chunk' (which were compiled knowing the enclosing scopes) available to function_chunk
+    void register_functions(const bytecode_chunk& chunk) {
+        for (const auto& fc: chunk.functions()) {
+            auto& cached = chunk_cache_[&fc->block()];
+            if (cached.expired()) {
+                cached = fc;
+            }
+            register_functions(*fc);
+        }
+    }
+
+    // Erase the entries of chunks that are gone (e.g. from eval code or functions created by the Function constructor).
+    // Only done once the cache has doubled since the last time, so it stays proportional to the live chunks at an amortized constant cost.
+    void prune_chunk_cache() {
+        if (chunk_cache_.size() < chunk_cache_prune_size_) {
+            return;
+        }
+        for (auto it = chunk_cache_.begin(); it != chunk_cache_.end();) {
+            if (it->second.expired()) {
+                it = chunk_cache_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        chunk_cache_prune_size_ = std::max(chunk_cache_.size() * 2, size_t{64});
     }
 
+
     // ES3, 8.7.1
     value get_value(const value& v) const {
         if (v.type() != value_type::reference) {
@@ -1416,7 +2519,7 @@ private:
         return b->get(r.property_name().view());
     }
 
-    void check_strict_mode_put(const object_ptr& o, const std::wstring_view p) const {
+    void check_strict_mode_put(const object_ptr& o, const std::u16string_view p) const {
         if (!o) {
             std::wostringstream woss;
             woss << cpp_quote(p) << " is not defined";
@@ -1464,7 +2567,7 @@ private:
     }
 };
 
-interpreter::interpreter(gc_heap& h, version ver, const on_statement_executed_type& on_statement_executed) : impl_(new impl{h, ver, on_statement_executed}) {
+interpreter::interpreter(gc_heap& h, version ver, const on_statement_executed_type& on_statement_executed, interpreter_engine engine) : impl_(new impl{h, ver, on_statement_executed, engine}) {
 }
 
 interpreter::~interpreter() = default;
@@ -1473,9 +2576,37 @@ gc_heap_ptr<global_object> interpreter::global() const {
     return impl_->global();
 }
 
+const inline_cache_statistics& interpreter::inline_cache_stats() const {
+    return impl_->inline_cache_stats();
+}
+
+const gc_policy& interpreter::garbage_collection_policy() const {
+    return impl_->garbage_collection_policy();
+}
+
+void interpreter::garbage_collection_policy(const gc_policy& policy) {
+    impl_->garbage_collection_policy(policy);
+}
+
+const gc_statistics& interpreter::garbage_collection_stats() const {
+    return impl_->garbage_collection_stats();
+}
+
+const jit_policy& interpreter::jit_compilation_policy() const {
+    return impl_->jit_compilation_policy();
+}
+
+void interpreter::jit_compilation_policy(const jit_policy& policy) {
+    impl_->jit_compilation_policy(policy);
+}
+
+const jit_statistics& interpreter::jit_compilation_stats() const {
+    return impl_->jit_compilation_stats();
+}
+
 value interpreter::eval(const statement& s) {
     impl_->hoist(s);
-    auto c = impl_->eval(s);
+    auto c = impl_->eval_program(s);
     if (!c) {
         return c.result;
     } else if (c.type == completion_type::throw_) {
@@ -4,6 +4,7 @@
 #include "value.h"
 #include "version.h"
 #include "error_object.h"
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <stdexcept>
@@ -21,17 +22,17 @@ enum class completion_type {
 };
 std::wostream& operator<<(std::wostream& os, const completion_type& t);
 
-using label_set = std::vector<std::wstring_view>;
+using label_set = std::vector<std::u16string_view>;
 struct completion {
     completion_type type;
     value result;
-    std::wstring_view target;
+    std::u16string_view target;
 
    explicit completion(const value& r = value::undefined, completion_type t = completion_type::normal) : type(t), result(r), target() {
         assert(!has_target());
    }
 
-   explicit completion(completion_type t, std::wstring_view target) : type(t), result(value::undefined), target(target) {
+   explicit completion(completion_type t, std::u16string_view target) : type(t), result(value::undefined), target(target) {
        assert(has_target());
    }
 
@@ -46,17 +47,86 @@ struct completion {
 };
 std::wostream& operator<<(std::wostream& os, const completion& c);
 
+// ast: Walk the syntax tree directly
+// bytecode: Compile programs and function bodies to bytecode (see bytecode.h) and run them in a virtual machine
+// jit: Like bytecode, but function bodies are also compiled to machine code (see jit.h) when the JIT compiler is available
+enum class interpreter_engine {
+    ast, bytecode, jit
+};
+std::wostream& operator<<(std::wostream& os, interpreter_engine e);
+
+// Inline cache counters for property accesses with constant names (only used by the bytecode engine)
+// Accesses that can't be cached (e.g. because the object isn't a plain object) count as misses
+struct inline_cache_statistics {
+    struct counters {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+    counters get;  // a.b
+    counters put;  // a.b = c
+    counters call; // a.b()
+};
+std::wostream& operator<<(std::wostream& os, const inline_cache_statistics& s);
+
+// Controls when the interpreter collects garbage (which it does between statements)
+struct gc_policy {
+    // Do a full collection once the old generation has grown by this percentage of what survived the previous one
+    uint32_t growth_percentage = 100;
+    // The percentage is raised (up to this) while most of the heap keeps surviving, to avoid collecting all the time when it's nearly full
+    uint32_t max_growth_percentage = 800;
+    // Minimum growth (in slots) before doing a full collection
+    uint32_t min_growth = 1 << 14;
+    // When non-zero collections are done incrementally, pausing the program for (roughly) at most this long at a time.
+    // Zero means the whole heap is collected in one go.
+    std::chrono::microseconds pause_budget{0};
+};
+
+// Collections started by the gc_policy
+struct gc_statistics {
+    uint64_t collections = 0;                       // Completed collections
+    uint64_t steps = 0;                             // Pauses taken by them (one per collection unless incremental)
+    std::chrono::steady_clock::duration longest_pause{};
+};
+
+// Controls when the jit engine compiles function bodies to machine code (see jit.h)
+// A body is compiled once its hotness, the number of calls times call_weight plus the number of loop iterations run by the
+// bytecode interpreter, reaches the threshold. Since compiled code only starts on function entry the body is compiled at the next call.
+struct jit_policy {
+    // Hotness at which a function body is compiled (zero compiles bodies before their first call)
+    uint32_t threshold = 2000;
+    // Hotness added by each call
+    uint32_t call_weight = 1000;
+    // Number of times a body is compiled before giving up on speculating (and just using the bytecode)
+    uint32_t max_compiles = 8;
+};
+
+// Work done by the jit engine
+struct jit_statistics {
+    uint64_t compiles = 0;          // Function bodies compiled (including recompilations)
+    uint64_t deoptimizations = 0;   // Times compiled code exited to the bytecode interpreter because speculation failed
+};
+
 class interpreter {
 public:
     using on_statement_executed_type = std::function<void (const statement&, const completion& c)>;
 
-    explicit interpreter(gc_heap& h, version ver, const on_statement_executed_type& on_statement_executed = on_statement_executed_type{});
+    explicit interpreter(gc_heap& h, version ver, const on_statement_executed_type& on_statement_executed = on_statement_executed_type{}, interpreter_engine engine = interpreter_engine::ast);
     ~interpreter();
 
     gc_heap_ptr<global_object> global() const;
 
     value eval(const statement& bs);
 
+    const inline_cache_statistics& inline_cache_stats() const;
+
+    const gc_policy& garbage_collection_policy() const;
+    void garbage_collection_policy(const gc_policy& policy);
+    const gc_statistics& garbage_collection_stats() const;
+
+    const jit_policy& jit_compilation_policy() const;
+    void jit_compilation_policy(const jit_policy& policy);
+    const jit_statistics& jit_compilation_stats() const;
+
 private:
     class impl;
     std::unique_ptr<impl> impl_;
@@ -0,0 +1,931 @@
+#include "jit.h"
+#include "bytecode.h"
+
+#ifdef MJS_JIT
+#if !defined(__x86_64__) || !defined(__linux__)
+#error "The JIT compiler is only supported on x86-64 Linux"
+#endif
+
+#include "lexer.h"
+#include "value.h"
+#include "value_representation.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace mjs::jit {
+
+#ifdef MJS_JIT
+
+namespace {
+
+enum reg : uint8_t { rax, rcx, rdx, rbx, rsp, rbp, rsi, rdi, r8, r9, r10, r11, r12, r13, r14, r15 };
+enum xmm : uint8_t { xmm0, xmm1 };
+
+// Condition codes (the low nibble of the jcc/setcc opcodes)
+enum class cond : uint8_t { b = 0x2, ae = 0x3, e = 0x4, ne = 0x5, be = 0x6, a = 0x7, p = 0xA, np = 0xB };
+
+//
+// Minimal x86-64 assembler. Only the instruction forms used by the compiler are supported,
+// memory operands are always [base + disp32].
+//
+class assembler {
+public:
+    using label = uint32_t;
+
+    const std::vector<uint8_t>& code() const { return code_; }
+    uint32_t offset() const { return static_cast<uint32_t>(code_.size()); }
+
+    label new_label() {
+        labels_.push_back(unbound);
+        return static_cast<label>(labels_.size() - 1);
+    }
+
+    void bind(label l) {
+        assert(labels_[l] == unbound);
+        labels_[l] = offset();
+    }
+
+    uint32_t label_offset(label l) const {
+        assert(labels_[l] != unbound);
+        return labels_[l];
+    }
+
+    // Resolve jumps to labels, must be called once all labels are bound
+    void finish() {
+        for (const auto& f: fixups_) {
+            const int32_t rel = static_cast<int32_t>(label_offset(f.l) - (f.pos + 4));
+            std::memcpy(&code_[f.pos], &rel, sizeof(rel));
+        }
+        fixups_.clear();
+    }
+
+    void push(reg r) { rex(false, 0, r); u8(0x50 + (r & 7)); }
+    void pop(reg r) { rex(false, 0, r); u8(0x58 + (r & 7)); }
+    void ret() { u8(0xC3); }
+    void ud2() { u8(0x0F); u8(0x0B); }
+    void int3() { u8(0xCC); }
+
+    void mov(reg dst, reg src) { rex(true, src, dst); u8(0x89); modrm_reg(src, dst); }
+    void mov_imm32(reg dst, uint32_t imm) { rex(false, 0, dst); u8(0xB8 + (dst & 7)); u32(imm); }
+    void mov_imm64(reg dst, uint64_t imm) { rex(true, 0, dst); u8(0xB8 + (dst & 7)); u64(imm); }
+
+    void load64(reg dst, reg base, int32_t disp) { rex(true, dst, base); u8(0x8B); modrm_mem(dst, base, disp); }
+    void load32(reg dst, reg base, int32_t disp) { rex(false, dst, base); u8(0x8B); modrm_mem(dst, base, disp); }
+    void store64(reg base, int32_t disp, reg src) { rex(true, src, base); u8(0x89); modrm_mem(src, base, disp); }
+    void store8(reg base, int32_t disp, reg src) { assert(src < rsp); rex(false, src, base); u8(0x88); modrm_mem(src, base, disp); }
+    void store32_imm(reg base, int32_t disp, uint32_t imm) { rex(false, 0, base); u8(0xC7); modrm_mem(0, base, disp); u32(imm); }
+    void store8_imm(reg base, int32_t disp, uint8_t imm) { rex(false, 0, base); u8(0xC6); modrm_mem(0, base, disp); u8(imm); }
+    void cmp32_imm(reg base, int32_t disp, uint32_t imm) { rex(false, 0, base); u8(0x81); modrm_mem(7, base, disp); u32(imm); }
+    void cmp8_imm(reg base, int32_t disp, uint8_t imm) { rex(false, 0, base); u8(0x80); modrm_mem(7, base, disp); u8(imm); }
+
+    void cmp32_imm(reg r, uint32_t imm) { rex(false, 0, r); u8(0x81); modrm_reg(7, r); u32(imm); }
+    void cmp32(reg l, reg r) { rex(false, r, l); u8(0x39); modrm_reg(r, l); }
+    void cmp64(reg l, reg r) { rex(true, r, l); u8(0x39); modrm_reg(r, l); }
+    void cmp64_imm(reg r, int32_t imm) { rex(true, 0, r); u8(0x81); modrm_reg(7, r); u32(static_cast<uint32_t>(imm)); }
+    void or64(reg dst, reg src) { rex(true, src, dst); u8(0x09); modrm_reg(src, dst); }
+    void xor64(reg dst, reg src) { rex(true, src, dst); u8(0x31); modrm_reg(src, dst); }
+    void and32_imm(reg r, uint32_t imm) { rex(false, 0, r); u8(0x81); modrm_reg(4, r); u32(imm); }
+    void and32(reg dst, reg src) { rex(false, src, dst); u8(0x21); modrm_reg(src, dst); }
+    void or32(reg dst, reg src) { rex(false, src, dst); u8(0x09); modrm_reg(src, dst); }
+    void xor32(reg dst, reg src) { rex(false, src, dst); u8(0x31); modrm_reg(src, dst); }
+    void test32(reg l, reg r) { rex(false, r, l); u8(0x85); modrm_reg(r, l); }
+    void shr64_imm(reg r, uint8_t imm) { rex(true, 0, r); u8(0xC1); modrm_reg(5, r); u8(imm); }
+    void shl32_cl(reg r) { rex(false, 0, r); u8(0xD3); modrm_reg(4, r); }
+    void shr32_cl(reg r) { rex(false, 0, r); u8(0xD3); modrm_reg(5, r); }
+    void sar32_cl(reg r) { rex(false, 0, r); u8(0xD3); modrm_reg(7, r); }
+    void mov32(reg dst, reg src) { rex(false, src, dst); u8(0x89); modrm_reg(src, dst); } // Zero extends
+    void sub_rsp(uint8_t imm) { rex(true, 0, rsp); u8(0x83); modrm_reg(5, rsp); u8(imm); }
+    void add_rsp(uint8_t imm) { rex(true, 0, rsp); u8(0x83); modrm_reg(0, rsp); u8(imm); }
+
+    void setcc(cond c, reg r) { assert(r < rsp); u8(0x0F); u8(0x90 | static_cast<uint8_t>(c)); modrm_reg(0, r); }
+
+    void movsd_load(xmm dst, reg base, int32_t disp) { u8(0xF2); rex(false, dst, base); u8(0x0F); u8(0x10); modrm_mem(dst, base, disp); }
+    void movsd_store(reg base, int32_t disp, xmm src) { u8(0xF2); rex(false, src, base); u8(0x0F); u8(0x11); modrm_mem(src, base, disp); }
+    void movq(xmm dst, reg src) { u8(0x66); rex(true, dst, src); u8(0x0F); u8(0x6E); modrm_reg(dst, src); }
+    void addsd(xmm dst, xmm src) { sse(0xF2, 0x58, dst, src); }
+    void subsd(xmm dst, xmm src) { sse(0xF2, 0x5C, dst, src); }
+    void mulsd(xmm dst, xmm src) { sse(0xF2, 0x59, dst, src); }
+    void divsd(xmm dst, xmm src) { sse(0xF2, 0x5E, dst, src); }
+    void ucomisd(xmm l, xmm r) { sse(0x66, 0x2E, l, r); }
+    void cvttsd2si(reg dst, xmm src) { u8(0xF2); rex(true, dst, src); u8(0x0F); u8(0x2C); modrm_reg(dst, src); }
+    void cvtsi2sd(xmm dst, reg src, bool is64) { u8(0xF2); rex(is64, dst, src); u8(0x0F); u8(0x2A); modrm_reg(dst, src); }
+
+    void call(reg r) { rex(false, 0, r); u8(0xFF); modrm_reg(2, r); }
+    void jmp(label l) { u8(0xE9); rel32(l); }
+    void jcc(cond c, label l) { u8(0x0F); u8(0x80 | static_cast<uint8_t>(c)); rel32(l); }
+
+    // lea dst, [rip + l]
+    void lea(reg dst, label l) { rex(true, dst, 0); u8(0x8D); u8(static_cast<uint8_t>(((dst & 7) << 3) | 5)); rel32(l); }
+
+    // jmp qword [table + index*8]
+    void jmp_table(reg table, reg index) {
+        assert(table < r8 && index < r8 && (table & 7) != rbp);
+        u8(0xFF);
+        u8(0x24);
+        u8(static_cast<uint8_t>(0xC0 | (index << 3) | table));
+    }
+
+private:
+    static constexpr uint32_t unbound = UINT32_MAX;
+
+    struct fixup {
+        uint32_t pos;
+        label l;
+    };
+
+    std::vector<uint8_t> code_;
+    std::vector<uint32_t> labels_;
+    std::vector<fixup> fixups_;
+
+    void u8(uint8_t b) { code_.push_back(b); }
+    void u32(uint32_t v) { for (int i = 0; i < 4; ++i) { u8(static_cast<uint8_t>(v >> (i * 8))); } }
+    void u64(uint64_t v) { u32(static_cast<uint32_t>(v)); u32(static_cast<uint32_t>(v >> 32)); }
+
+    void rel32(label l) {
+        fixups_.push_back(fixup{offset(), l});
+        u32(0);
+    }
+
+    // 'reg_field' is the register in the ModRM reg field (or the opcode extension), 'rm' the register in the r/m field (or the base)
+    void rex(bool w, uint8_t reg_field, uint8_t rm) {
+        const uint8_t r = static_cast<uint8_t>(0x40 | (w ? 8 : 0) | (reg_field & 8 ? 4 : 0) | (rm & 8 ? 1 : 0));
+        if (r != 0x40) {
+            u8(r);
+        }
+    }
+
+    void modrm_reg(uint8_t reg_field, uint8_t rm) {
+        u8(static_cast<uint8_t>(0xC0 | ((reg_field & 7) << 3) | (rm & 7)));
+    }
+
+    void modrm_mem(uint8_t reg_field, reg base, int32_t disp) {
+        u8(static_cast<uint8_t>(0x80 | ((reg_field & 7) << 3) | (base & 7)));
+        if ((base & 7) == rsp) {
+            u8(0x24); // SIB: no index
+        }
+        u32(static_cast<uint32_t>(disp));
+    }
+
+    void sse(uint8_t prefix, uint8_t op, xmm dst, xmm src) {
+        u8(prefix);
+        u8(0x0F);
+        u8(op);
+        modrm_reg(dst, src);
+    }
+};
+
+uint64_t double_bits(double d) {
+    uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(bits));
+    return bits;
+}
+
+bool is_number_op(token_type op) {
+    switch (op) {
+    case token_type::plus:
+    case token_type::minus:
+    case token_type::multiply:
+    case token_type::divide:
+    case token_type::and_:
+    case token_type::or_:
+    case token_type::xor_:
+    case token_type::lshift:
+    case token_type::rshift:
+    case token_type::rshiftshift:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool is_compare_op(token_type op) {
+    switch (op) {
+    case token_type::lt:
+    case token_type::ltequal:
+    case token_type::gt:
+    case token_type::gtequal:
+    case token_type::equalequal:
+    case token_type::notequal:
+    case token_type::equalequalequal:
+    case token_type::notequalequal:
+        return true;
+    default:
+        return false;
+    }
+}
+
+class compiler {
+public:
+    explicit compiler(const bytecode_chunk& chunk, const helpers& h, const std::vector<bool>& generic)
+        : chunk_(chunk), helpers_(h), generic_(generic) {
+    }
+
+    bool compute_stack_depths();
+    void generate();
+
+    const assembler& assembled() const { return a_; }
+    uint32_t max_stack() const { return max_stack_; }
+    uint32_t table_offset() const { return a_.label_offset(table_); }
+
+    // Native offset of each pc (or of a trap for pcs that aren't reachable instruction starts)
+    std::vector<uint32_t> pc_offsets() const {
+        std::vector<uint32_t> offsets(chunk_.code_size());
+        for (uint32_t pc = 0; pc < chunk_.code_size(); ++pc) {
+            offsets[pc] = depths_[pc] >= 0 ? a_.label_offset(pc_labels_[pc]) : a_.label_offset(trap_);
+        }
+        return offsets;
+    }
+
+private:
+    using label = assembler::label;
+
+    struct deopt_info {
+        label l;
+        uint32_t pc;
+        uint32_t depth;
+    };
+
+    // Registers preserved across helper calls (callee-saved in the System V ABI)
+    static constexpr reg frame_reg = rbx;
+    static constexpr reg stack_reg = r12;
+    static constexpr reg slots_reg = r13;
+
+    const uint64_t false_repr_ = value_representation{value{false}}.raw(); // true is false_repr_|1
+    const uint32_t reference_tag_ = static_cast<uint32_t>(value_representation::reference_placeholder(0).raw() >> 32);
+    const uint32_t int32_tag_ = static_cast<uint32_t>(value_representation{value{int32_t{0}}}.raw() >> 32); // The low 32 bits hold the number
+
+    const bytecode_chunk& chunk_;
+    const helpers& helpers_;
+    const std::vector<bool>& generic_;
+    assembler a_;
+    std::vector<int32_t> depths_;   // Stack depth before each instruction (-1 if unreachable / not the start of an instruction)
+    std::vector<label> pc_labels_;
+    std::vector<deopt_info> deopts_;
+    uint32_t max_stack_ = 0;
+    label epilogue_ = 0;
+    label status_ = 0;
+    label trap_ = 0;
+    label table_ = 0;
+
+    uint32_t operand(uint32_t pc, uint32_t index) const {
+        return bytecode_chunk::read_operand(&chunk_.code()[pc + 1 + index * sizeof(uint32_t)]);
+    }
+
+    static uint32_t next_pc(uint32_t pc, opcode op) {
+        return pc + instruction_size(op);
+    }
+
+    // Offset of stack entries/slots (both arrays of value_representation)
+    static int32_t entry_offset(uint32_t index) { return static_cast<int32_t>(index * sizeof(value_representation)); }
+
+    label deopt_label(uint32_t pc, uint32_t depth) {
+        deopts_.push_back(deopt_info{a_.new_label(), pc, depth});
+        return deopts_.back().l;
+    }
+
+    void call_helper(helper h, uint32_t pc, uint32_t depth) {
+        a_.mov(rdi, frame_reg);
+        a_.mov_imm32(rsi, pc);
+        a_.mov_imm32(rdx, depth);
+        a_.mov_imm64(rax, reinterpret_cast<uint64_t>(h));
+        a_.call(rax);
+        a_.mov(slots_reg, rdx);
+    }
+
+    void step(uint32_t pc, uint32_t depth) {
+        call_helper(helpers_.step, pc, depth);
+        a_.test32(rax, rax);
+        a_.jcc(cond::ne, status_);
+    }
+
+    // Jump to 'not_number' unless the value_representation in rax is a number (see is_special in value_representation.cpp)
+    void check_number_repr(label not_number) {
+        a_.mov(rcx, rax);
+        a_.shr64_imm(rcx, 48);
+        a_.and32_imm(rcx, 0x7fff);
+        a_.cmp32_imm(rcx, 0x7ff0);
+        a_.jcc(cond::a, not_number);
+    }
+
+    // Jump to 'l' if xmm0 is NaN (which must be stored in canonical form in slots)
+    void check_nan(label l) {
+        a_.ucomisd(xmm0, xmm0);
+        a_.jcc(cond::p, l);
+    }
+
+    // Jump to 'is_int32' if the value_representation in rax is an int32 number
+    void check_int32_repr(label is_int32) {
+        a_.mov(rcx, rax);
+        a_.shr64_imm(rcx, 32);
+        a_.cmp32_imm(rcx, int32_tag_);
+        a_.jcc(cond::e, is_int32);
+    }
+
+    // Convert the value_representation in rax to a double in 'x' jumping to 'not_number' if it isn't a number
+    void repr_to_number(xmm x, label not_number) {
+        const auto is_int32 = a_.new_label(), done = a_.new_label();
+        check_int32_repr(is_int32);
+        check_number_repr(not_number);
+        a_.movq(x, rax);
+        a_.jmp(done);
+        a_.bind(is_int32);
+        a_.cvtsi2sd(x, rax, false);
+        a_.bind(done);
+    }
+
+    // Load stack entry 'index' into 'x' jumping to 'not_number' if it isn't a number
+    void load_number(xmm x, uint32_t index, label not_number) {
+        a_.load64(rax, stack_reg, entry_offset(index));
+        repr_to_number(x, not_number);
+    }
+
+    // xmm0 = xmm0 op xmm1
+    void number_op(token_type op, label deopt) {
+        switch (op) {
+        case token_type::plus:     a_.addsd(xmm0, xmm1); return;
+        case token_type::minus:    a_.subsd(xmm0, xmm1); return;
+        case token_type::multiply: a_.mulsd(xmm0, xmm1); return;
+        case token_type::divide:   a_.divsd(xmm0, xmm1); return;
+        default: break;
+        }
+        // Truncating to 64-bit gives the same low 32 bits as ToInt32 unless the value is out of range (or NaN/infinite)
+        a_.cvttsd2si(rax, xmm0);
+        a_.cvttsd2si(rcx, xmm1);
+        a_.mov_imm64(rdx, static_cast<uint64_t>(std::numeric_limits<int64_t>::min()));
+        a_.cmp64(rax, rdx);
+        a_.jcc(cond::e, deopt);
+        a_.cmp64(rcx, rdx);
+        a_.jcc(cond::e, deopt);
+        switch (op) {
+        case token_type::and_:        a_.and32(rax, rcx); break;
+        case token_type::or_:         a_.or32(rax, rcx); break;
+        case token_type::xor_:        a_.xor32(rax, rcx); break;
+        case token_type::lshift:      a_.shl32_cl(rax); break;
+        case token_type::rshift:      a_.sar32_cl(rax); break;
+        case token_type::rshiftshift: a_.shr32_cl(rax); break;
+        default: assert(false);
+        }
+        if (op == token_type::rshiftshift) {
+            a_.mov32(rax, rax);
+            a_.cvtsi2sd(xmm0, rax, true);
+        } else {
+            a_.cvtsi2sd(xmm0, rax, false);
+        }
+    }
+
+    // al = xmm0 op xmm1
+    void compare_op(token_type op) {
+        switch (op) {
+        case token_type::lt:      a_.ucomisd(xmm1, xmm0); a_.setcc(cond::a, rax); return;
+        case token_type::ltequal: a_.ucomisd(xmm1, xmm0); a_.setcc(cond::ae, rax); return;
+        case token_type::gt:      a_.ucomisd(xmm0, xmm1); a_.setcc(cond::a, rax); return;
+        case token_type::gtequal: a_.ucomisd(xmm0, xmm1); a_.setcc(cond::ae, rax); return;
+        case token_type::equalequal:
+        case token_type::equalequalequal:
+            a_.ucomisd(xmm0, xmm1);
+            a_.setcc(cond::e, rax);
+            a_.setcc(cond::np, rcx);
+            a_.and32(rax, rcx);
+            return;
+        case token_type::notequal:
+        case token_type::notequalequal:
+            a_.ucomisd(xmm0, xmm1);
+            a_.setcc(cond::ne, rax);
+            a_.setcc(cond::p, rcx);
+            a_.or32(rax, rcx);
+            return;
+        default:
+            assert(false);
+        }
+    }
+
+    void instruction(uint32_t pc, uint32_t depth);
+};
+
+bool compiler::compute_stack_depths() {
+    const auto code = chunk_.code();
+    depths_.assign(chunk_.code_size(), -1);
+    std::vector<uint32_t> work;
+    bool ok = true;
+
+    auto reach = [&](uint32_t pc, int64_t depth) {
+        if (pc >= chunk_.code_size() || depth < 0 || depth > INT32_MAX) {
+            ok = false;
+            return;
+        }
+        if (depths_[pc] < 0) {
+            depths_[pc] = static_cast<int32_t>(depth);
+            max_stack_ = std::max(max_stack_, static_cast<uint32_t>(depth));
+            work.push_back(pc);
+        } else if (depths_[pc] != depth) {
+            ok = false;
+        }
+    };
+
+    reach(0, 0);
+    while (!work.empty() && ok) {
+        const auto pc = work.back();
+        work.pop_back();
+        const auto op = static_cast<opcode>(code[pc]);
+        const int64_t d = depths_[pc];
+        const auto next = next_pc(pc, op);
+        switch (op) {
+        case opcode::push_undefined:
+        case opcode::push_null:
+        case opcode::push_true:
+        case opcode::push_false:
+        case opcode::push_number:
+        case opcode::push_string:
+        case opcode::lookup:
+        case opcode::get_slot:
+        case opcode::prefix_slot:
+        case opcode::postfix_slot:
+        case opcode::get_callee:
+        case opcode::eval_expression:
+            reach(next, d + 1);
+            break;
+        case opcode::get_method:
+            reach(next, d + 2);
+            break;
+        case opcode::pop:
+        case opcode::put_member:
+        case opcode::get_element:
+        case opcode::binary:
+        case opcode::assign:
+        case opcode::set_result:
+        case opcode::put_local:
+            reach(next, d - 1);
+            break;
+        case opcode::put_element:
+            reach(next, d - 2);
+            break;
+        case opcode::call:
+            reach(next, d - operand(pc, 0) - 2);
+            break;
+        case opcode::new_:
+            reach(next, d - operand(pc, 0));
+            break;
+        case opcode::jump:
+            reach(operand(pc, 0), d);
+            break;
+        case opcode::jump_if_false:
+        case opcode::jump_if_true:
+            reach(next, d - 1);
+            reach(operand(pc, 0), d - 1);
+            break;
+        case opcode::and_jump:
+        case opcode::or_jump:
+            reach(next, d - 1);
+            reach(operand(pc, 0), d);
+            break;
+        case opcode::eval_statement:
+            reach(next, d);
+            for (const auto index: chunk_.fallback(operand(pc, 0)).loops) {
+                reach(chunk_.loop(index).break_pc, d);
+                reach(chunk_.loop(index).continue_pc, d);
+            }
+            break;
+        case opcode::return_:
+        case opcode::throw_:
+        case opcode::end:
+            break;
+        default:
+            reach(next, d);
+        }
+    }
+    return ok;
+}
+
+void compiler::instruction(uint32_t pc, uint32_t depth) {
+    const auto op = static_cast<opcode>(chunk_.code()[pc]);
+    const bool speculate = !generic_[pc];
+
+    switch (op) {
+    case opcode::push_undefined:
+    case opcode::push_null:
+    case opcode::push_true:
+    case opcode::push_false:
+    case opcode::push_number: {
+        value v;
+        switch (op) {
+        case opcode::push_null:   v = value::null; break;
+        case opcode::push_true:   v = value{true}; break;
+        case opcode::push_false:  v = value{false}; break;
+        case opcode::push_number: v = make_number_value(chunk_.number(operand(pc, 0))); break;
+        default:                  break;
+        }
+        a_.mov_imm64(rax, value_representation{v}.raw());
+        a_.store64(stack_reg, entry_offset(depth), rax);
+        return;
+    }
+    case opcode::pop: {
+        // Only references (placeholders) need the interpreter
+        const auto done = a_.new_label();
+        a_.load64(rax, stack_reg, entry_offset(depth - 1));
+        a_.shr64_imm(rax, 32);
+        a_.cmp32_imm(rax, reference_tag_);
+        a_.jcc(cond::ne, done);
+        step(pc, depth);
+        a_.bind(done);
+        return;
+    }
+    case opcode::get_slot:
+        if (operand(pc, 0) == 0) {
+            a_.load64(rax, slots_reg, entry_offset(operand(pc, 1)));
+            a_.store64(stack_reg, entry_offset(depth), rax);
+            return;
+        }
+        break;
+    case opcode::set_slot:
+        if (operand(pc, 0) == 0) {
+            // Storing numbers doesn't need a write barrier
+            const auto slow = a_.new_label(), store = a_.new_label(), done = a_.new_label();
+            a_.load64(rax, stack_reg, entry_offset(depth - 1));
+            check_int32_repr(store);
+            check_number_repr(slow);
+            a_.bind(store);
+            a_.store64(slots_reg, entry_offset(operand(pc, 1)), rax);
+            a_.jmp(done);
+            a_.bind(slow);
+            step(pc, depth);
+            a_.bind(done);
+            return;
+        }
+        break;
+    case opcode::assign_slot:
+        if (speculate && operand(pc, 1) == 0 && is_number_op(without_assignment(static_cast<token_type>(operand(pc, 0))))) {
+            const auto deopt = deopt_label(pc, depth);
+            const auto slot = entry_offset(operand(pc, 2));
+            load_number(xmm1, depth - 1, deopt);
+            a_.load64(rax, slots_reg, slot);
+            repr_to_number(xmm0, deopt);
+            number_op(without_assignment(static_cast<token_type>(operand(pc, 0))), deopt);
+            check_nan(deopt);
+            a_.movsd_store(slots_reg, slot, xmm0);
+            a_.movsd_store(stack_reg, entry_offset(depth - 1), xmm0);
+            return;
+        }
+        break;
+    case opcode::prefix_slot:
+    case opcode::postfix_slot:
+        if (speculate && operand(pc, 1) == 0) {
+            const auto deopt = deopt_label(pc, depth);
+            const auto slot = entry_offset(operand(pc, 2));
+            a_.load64(rax, slots_reg, slot);
+            // The entry above the stack top is free, so the original value can be stored before knowing if the result is valid
+            a_.store64(stack_reg, entry_offset(depth), rax);
+            repr_to_number(xmm0, deopt);
+            a_.mov_imm64(rax, double_bits(1.0));
+            a_.movq(xmm1, rax);
+            if (static_cast<token_type>(operand(pc, 0)) == token_type::plusplus) {
+                a_.addsd(xmm0, xmm1);
+            } else {
+                a_.subsd(xmm0, xmm1);
+            }
+            check_nan(deopt);
+            a_.movsd_store(slots_reg, slot, xmm0);
+            if (op == opcode::prefix_slot) {
+                a_.movsd_store(stack_reg, entry_offset(depth), xmm0);
+            }
+            return;
+        }
+        break;
+    case opcode::binary: {
+        const auto bop = static_cast<token_type>(operand(pc, 0));
+        if (speculate && (is_number_op(bop) || is_compare_op(bop))) {
+            const auto deopt = deopt_label(pc, depth);
+            load_number(xmm0, depth - 2, deopt);
+            load_number(xmm1, depth - 1, deopt);
+            if (is_number_op(bop)) {
+                number_op(bop, deopt);
+                check_nan(deopt);
+                a_.movsd_store(stack_reg, entry_offset(depth - 2), xmm0);
+            } else {
+                compare_op(bop);
+                a_.and32_imm(rax, 1);
+                a_.mov_imm64(rcx, false_repr_);
+                a_.or64(rax, rcx);
+                a_.store64(stack_reg, entry_offset(depth - 2), rax);
+            }
+            return;
+        }
+        break;
+    }
+    case opcode::jump:
+        a_.jmp(pc_labels_[operand(pc, 0)]);
+        return;
+    case opcode::jump_if_false:
+    case opcode::jump_if_true: {
+        const auto target = pc_labels_[operand(pc, 0)];
+        const auto slow = a_.new_label(), done = a_.new_label();
+        const auto jump_cond = op == opcode::jump_if_true ? cond::ne : cond::e;
+        // rax is 0 or 1 for booleans
+        a_.load64(rax, stack_reg, entry_offset(depth - 1));
+        a_.mov_imm64(rcx, false_repr_);
+        a_.xor64(rax, rcx);
+        a_.cmp64_imm(rax, 1);
+        a_.jcc(cond::a, slow);
+        a_.test32(rax, rax);
+        a_.jcc(jump_cond, target);
+        a_.jmp(done);
+        a_.bind(slow);
+        call_helper(helpers_.test, pc, depth);
+        a_.test32(rax, rax);
+        a_.jcc(jump_cond, target);
+        a_.bind(done);
+        return;
+    }
+    default:
+        break;
+    }
+    step(pc, depth);
+}
+
+void compiler::generate() {
+    epilogue_ = a_.new_label();
+    status_ = a_.new_label();
+    trap_ = a_.new_label();
+    table_ = a_.new_label();
+    pc_labels_.resize(chunk_.code_size());
+    for (auto& l: pc_labels_) {
+        l = a_.new_label();
+    }
+
+    // entry(frame*, value* stack, value_representation* slots)
+    a_.push(rbp);
+    a_.mov(rbp, rsp);
+    a_.push(rbx);
+    a_.push(r12);
+    a_.push(r13);
+    a_.push(r14);
+    a_.push(r15);
+    a_.sub_rsp(8); // Keep the stack 16-byte aligned
+    a_.mov(frame_reg, rdi);
+    a_.mov(stack_reg, rsi);
+    a_.mov(slots_reg, rdx);
+
+    for (uint32_t pc = 0; pc < chunk_.code_size(); ) {
+        const auto op = static_cast<opcode>(chunk_.code()[pc]);
+        a_.bind(pc_labels_[pc]);
+        if (depths_[pc] < 0) {
+            a_.ud2();
+        } else {
+            instruction(pc, depths_[pc]);
+        }
+        pc = next_pc(pc, op);
+    }
+    a_.ud2(); // Control never falls off the end
+
+    for (const auto& d: deopts_) {
+        a_.bind(d.l);
+        call_helper(helpers_.deopt, d.pc, d.depth);
+        a_.jmp(epilogue_);
+    }
+
+    // Status in eax is either jump or exit
+    a_.bind(status_);
+    a_.cmp32_imm(rax, static_cast<uint32_t>(status::jump));
+    a_.jcc(cond::ne, epilogue_);
+    a_.load32(rax, frame_reg, static_cast<int32_t>(offsetof(frame, pc)));
+    a_.lea(rcx, table_);
+    a_.jmp_table(rcx, rax);
+
+    a_.bind(epilogue_);
+    a_.add_rsp(8);
+    a_.pop(r15);
+    a_.pop(r14);
+    a_.pop(r13);
+    a_.pop(r12);
+    a_.pop(rbx);
+    a_.pop(rbp);
+    a_.ret();
+
+    a_.bind(trap_);
+    a_.ud2();
+
+    // Jump table (filled in when the final address is known)
+    while (a_.offset() % 8) {
+        a_.int3();
+    }
+    a_.bind(table_);
+    a_.finish();
+}
+
+// The perf map (see tools/perf/Documentation/jit-interface.txt in the Linux source) or nullptr if not enabled.
+// Entries can't be removed from the map, so the code_arena doesn't reuse memory while it's enabled.
+FILE* perf_map() {
+    static FILE* map = []() -> FILE* {
+        if (!std::getenv("MJS_PERF_MAP")) {
+            return nullptr;
+        }
+        char filename[64];
+        std::snprintf(filename, sizeof(filename), "/tmp/perf-%d.map", static_cast<int>(getpid()));
+        return std::fopen(filename, "w"); // Don't keep entries from an earlier process with the same pid
+    }();
+    return map;
+}
+
+// Register the code with perf
+void register_perf_map(const void* start, size_t size, std::u16string_view name) {
+    auto map = perf_map();
+    if (!map) {
+        return;
+    }
+    std::string narrow_name;
+    for (const auto ch: name.empty() ? std::u16string_view{u"<anonymous>"} : name) {
+        narrow_name.push_back(ch > 0x20 && ch < 0x7f ? static_cast<char>(ch) : '?');
+    }
+    std::fprintf(map, "%lx %lx js::%s\n", reinterpret_cast<unsigned long>(start), static_cast<unsigned long>(size), narrow_name.c_str());
+    std::fflush(map);
+}
+
+// Executable memory shared by all compiled code.
+// Each block is mapped twice (from a memfd): writable where the code is copied to and executable where it runs, so
+// no page is both and installing code doesn't need any system calls once a block is mapped.
+class code_arena {
+public:
+    static constexpr size_t alignment = 16;
+    static constexpr size_t min_block_size = 1 << 20;
+
+    struct allocation {
+        uint8_t* writable;
+        uint8_t* executable;
+    };
+
+    static code_arena& instance() {
+        // Never destroyed since code can be freed during static destruction
+        static code_arena* arena = new code_arena{};
+        return *arena;
+    }
+
+    // Returns {nullptr, nullptr} if the memory couldn't be mapped
+    allocation allocate(size_t size) {
+        size = (size + alignment - 1) & ~(alignment - 1);
+        std::lock_guard<std::mutex> lock{mutex_};
+        for (int retry = 0; retry < 2; ++retry) {
+            for (auto& b: blocks_) {
+                for (auto it = b.free.begin(); it != b.free.end(); ++it) {
+                    if (it->size < size) {
+                        continue;
+                    }
+                    const auto offset = it->offset;
+                    it->offset += size;
+                    it->size -= size;
+                    if (!it->size) {
+                        b.free.erase(it);
+                    }
+                    return allocation{b.writable + offset, b.executable + offset};
+                }
+            }
+            if (!add_block(size)) {
+                break;
+            }
+        }
+        return allocation{nullptr, nullptr};
+    }
+
+    void free(const void* executable, size_t size) {
+        if (perf_map()) {
+            return;
+        }
+        size = (size + alignment - 1) & ~(alignment - 1);
+        std::lock_guard<std::mutex> lock{mutex_};
+        const auto p = static_cast<const uint8_t*>(executable);
+        auto b = std::find_if(blocks_.begin(), blocks_.end(), [p](const block& b) { return p >= b.executable && p < b.executable + b.size; });
+        assert(b != blocks_.end());
+        range r{static_cast<size_t>(p - b->executable), size};
+        // Keep the free list sorted and coalesced
+        auto next = std::lower_bound(b->free.begin(), b->free.end(), r.offset, [](const range& f, size_t offset) { return f.offset < offset; });
+        if (next != b->free.end() && r.offset + r.size == next->offset) {
+            r.size += next->size;
+            next = b->free.erase(next);
+        }
+        if (next != b->free.begin() && std::prev(next)->offset + std::prev(next)->size == r.offset) {
+            std::prev(next)->size += r.size;
+        } else {
+            b->free.insert(next, r);
+        }
+    }
+
+private:
+    struct range {
+        size_t offset;
+        size_t size;
+    };
+    struct block {
+        uint8_t* writable;
+        uint8_t* executable;
+        size_t size;
+        std::vector<range> free; // Sorted by offset
+    };
+
+    std::mutex mutex_;
+    std::vector<block> blocks_;
+
+    code_arena() = default;
+
+    bool add_block(size_t min_size) {
+        const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const size_t size = (std::max(min_size, min_block_size) + page_size - 1) & ~(page_size - 1);
+        const int fd = memfd_create("mjs-jit", MFD_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        void* writable = MAP_FAILED;
+        void* executable = MAP_FAILED;
+        if (!ftruncate(fd, static_cast<off_t>(size))) {
+            writable = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            executable = mmap(nullptr, size, PROT_READ | PROT_EXEC, MAP_SHARED, fd, 0);
+        }
+        close(fd); // The mappings keep the memory alive
+        if (writable == MAP_FAILED || executable == MAP_FAILED) {
+            if (writable != MAP_FAILED) {
+                munmap(writable, size);
+            }
+            if (executable != MAP_FAILED) {
+                munmap(executable, size);
+            }
+            return false;
+        }
+        blocks_.push_back(block{static_cast<uint8_t*>(writable), static_cast<uint8_t*>(executable), size, {range{0, size}}});
+        return true;
+    }
+};
+
+} // unnamed namespace
+
+std::shared_ptr<code> code::compile(const bytecode_chunk& chunk, const helpers& h, const std::vector<bool>& generic, std::u16string_view name) {
+    assert(chunk.layout() && generic.size() == chunk.code_size());
+
+    compiler c{chunk, h, generic};
+    if (!c.compute_stack_depths()) {
+        return nullptr;
+    }
+    c.generate();
+
+    const auto& machine_code = c.assembled().code();
+    const auto offsets = c.pc_offsets();
+    const size_t code_size = machine_code.size() + offsets.size() * sizeof(uint64_t);
+
+    const auto memory = code_arena::instance().allocate(code_size);
+    if (!memory.executable) {
+        return nullptr;
+    }
+    std::memcpy(memory.writable, machine_code.data(), machine_code.size());
+    for (size_t pc = 0; pc < offsets.size(); ++pc) {
+        const uint64_t address = reinterpret_cast<uint64_t>(memory.executable + offsets[pc]);
+        std::memcpy(memory.writable + c.table_offset() + pc * sizeof(uint64_t), &address, sizeof(address));
+    }
+    register_perf_map(memory.executable, machine_code.size(), name);
+
+    // An instruction pushes at most 2 values
+    return std::shared_ptr<code>{new code{memory.executable, code_size, reinterpret_cast<entry_type>(memory.executable), c.max_stack() + 2}};
+}
+
+code::code(void* memory, size_t memory_size, entry_type entry, uint32_t max_stack) : memory_(memory), memory_size_(memory_size), entry_(entry), max_stack_(max_stack) {
+}
+
+code::~code() {
+    code_arena::instance().free(memory_, memory_size_);
+}
+
+helper_result code::run(frame& f, value_representation* slots) const {
+    return entry_(&f, f.stack, slots);
+}
+
+bool available() {
+    return true;
+}
+
+#else
+
+std::shared_ptr<code> code::compile(const bytecode_chunk&, const helpers&, const std::vector<bool>&, std::u16string_view) {
+    return nullptr;
+}
+
+code::code(void* memory, size_t memory_size, entry_type entry, uint32_t max_stack) : memory_(memory), memory_size_(memory_size), entry_(entry), max_stack_(max_stack) {
+}
+
+code::~code() {
+}
+
+helper_result code::run(frame&, value_representation*) const {
+    return helper_result{status::exit, nullptr};
+}
+
+bool available() {
+    return false;
+}
+
+#endif
+
+} // namespace mjs::jit
@@ -0,0 +1,106 @@
+#ifndef MJS_JIT_H
+#define MJS_JIT_H
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace mjs {
+
+class bytecode_chunk;
+class value_representation;
+
+//
+// Baseline JIT compiler for bytecode chunks (see bytecode.h)
+//
+// Only available on x86-64 Linux when built with MJS_JIT (the enable_jit CMake option), see available().
+//
+// Each instruction is translated to a machine code template. Instructions without a template call back into the
+// interpreter (helpers::step) to do the work. Number arithmetic and comparisons are compiled speculating that the
+// operands are numbers, if a guard fails the code exits (deoptimizes) so the interpreter can resume at the failing instruction.
+//
+// The operand stack is an array of value_representations, the stack depth before each instruction is known when
+// compiling so the generated code addresses stack entries directly. The helpers get the current depth, since that's
+// the part of the stack the garbage collector scans.
+//
+// The code of all chunks is allocated from a shared arena of executable memory.
+//
+// When the MJS_PERF_MAP environment variable is set the code is registered in /tmp/perf-<pid>.map so it can be profiled with perf
+// (the memory of freed code isn't reused then, since the map can't describe more than one function at an address).
+//
+namespace jit {
+
+// Status returned by the helpers and the generated code
+enum class status : uint64_t {
+    next,   // Continue with the next instruction
+    jump,   // Continue at frame::pc
+    exit,   // Leave the generated code
+};
+
+// Returned in rax:rdx
+struct helper_result {
+    jit::status           status;
+    value_representation* slots; // Slots of the activation record (they move when garbage is collected)
+};
+
+// State shared by the generated code and the helpers, the interpreter adds its own state in a derived class
+struct frame {
+    value_representation* stack = nullptr; // Operand stack (code::max_stack() entries)
+    uint32_t pc = 0;                       // Target of status::jump / where to resume after deoptimizing
+    uint32_t depth = 0;                    // Stack depth at pc after deoptimizing
+};
+
+// Called with the pc of the instruction and the stack depth before it
+using helper = helper_result (*)(frame& f, uint32_t pc, uint32_t depth);
+
+struct helpers {
+    helper step;    // Execute the instruction at pc
+    helper test;    // Pop the top of the stack returning it converted to a boolean as the status (0 or 1)
+    helper deopt;   // A guard failed for the instruction at pc, the status must be exit
+};
+
+class code {
+public:
+    ~code();
+
+    code(const code&) = delete;
+    code& operator=(const code&) = delete;
+
+    // Compile 'chunk' (which must have a frame layout), returns nullptr if not possible.
+    // Instructions at the pcs marked in 'generic' don't get speculative fast paths.
+    static std::shared_ptr<code> compile(const bytecode_chunk& chunk, const helpers& h, const std::vector<bool>& generic, std::u16string_view name);
+
+    // Number of values needed for the operand stack
+    uint32_t max_stack() const { return max_stack_; }
+
+    // Run from the start. Returns when a helper returns status::exit.
+    helper_result run(frame& f, value_representation* slots) const;
+
+private:
+    using entry_type = helper_result (*)(frame*, value_representation*, value_representation*);
+
+    void* memory_;
+    size_t memory_size_;
+    entry_type entry_;
+    uint32_t max_stack_;
+
+    explicit code(void* memory, size_t memory_size, entry_type entry, uint32_t max_stack);
+};
+
+// Compilation state of a bytecode_chunk
+struct chunk_state {
+    uint32_t hotness = 0;           // Calls and loop iterations before compiling (counts up to the interpreter's jit_policy::threshold)
+    uint32_t compiles = 0;
+    std::vector<bool> generic;      // Instructions (indexed by pc) where speculation failed
+    std::shared_ptr<code> compiled; // nullptr until compiled and after deoptimizing
+};
+
+// Returns true if the JIT compiler is available
+bool available();
+
+} // namespace jit
+
+} // namespace mjs
+
+#endif
@@ -56,12 +56,12 @@ public:
     explicit json_token(json_token_type type, size_t pos) : type_(type), pos_(pos) {
         assert(type_ != json_token_type::string && type_ != json_token_type::number);
     }
-    explicit json_token(json_token_type type, std::wstring&& text, size_t pos) : type_(type), text_(std::move(text)), pos_(pos) {
+    explicit json_token(json_token_type type, std::u16string&& text, size_t pos) : type_(type), text_(std::move(text)), pos_(pos) {
         assert(type_ == json_token_type::string || type_ == json_token_type::number);
     }
 
     json_token_type type() const { return type_; }
-    const std::wstring& text() const {
+    const std::u16string& text() const {
         assert(type_ == json_token_type::string || type_ == json_token_type::number);
         return text_;
     }
@@ -69,7 +69,7 @@ public:
 
 private:
     json_token_type type_;
-    std::wstring text_;
+    std::u16string text_;
     size_t pos_;
 };
 
@@ -77,7 +77,7 @@ std::wostream& operator<<(std::wostream& os, const json_token& tok) {
     if (tok.type() == json_token_type::string) {
         return os << '"' << cpp_quote(tok.text()) << '"';
     } else if (tok.type() == json_token_type::number) {
-        return os << tok.text();
+        return os << to_wstring(tok.text());
     } else {
         return os << tok.type();
     }
@@ -93,7 +93,7 @@ constexpr bool json_is_digit(char16_t ch) {
 
 class json_lexer {
 public:
-    explicit json_lexer(const gc_heap_ptr<global_object>& global, std::wstring&& text)
+    explicit json_lexer(const gc_heap_ptr<global_object>& global, std::u16string&& text)
         : global_{global}
         , text_{std::move(text)}
         , pos_{0}
@@ -103,7 +103,7 @@ public:
 
     const gc_heap_ptr<global_object>& global() const { return global_; }
 
-    const std::wstring& text() const {
+    const std::u16string& text() const {
         return text_;
     }
 
@@ -143,13 +143,13 @@ public:
             tok_ = json_token{json_token_type::comma, start};
         } else if (ch == ':') {
             tok_ = json_token{json_token_type::colon, start};
-        } else if (ch == 'n' && text_.compare(end, 3, L"ull") == 0) {
+        } else if (ch == 'n' && text_.compare(end, 3, u"ull") == 0) {
             end += 3;
             tok_ = json_token{json_token_type::null, start};
-        } else if (ch == 'f' && text_.compare(end, 4, L"alse") == 0) {
+        } else if (ch == 'f' && text_.compare(end, 4, u"alse") == 0) {
             end += 4;
             tok_ = json_token{json_token_type::false_, start};
-        } else if (ch == 't' && text_.compare(end, 3, L"rue") == 0) {
+        } else if (ch == 't' && text_.compare(end, 3, u"rue") == 0) {
             end += 3;
             tok_ = json_token{json_token_type::true_, start};
         } else if (ch == '-' || json_is_digit(ch)) {
@@ -189,7 +189,7 @@ public:
             }
             tok_ = json_token{json_token_type::number, text_.substr(start, end-start), start};
         } else if (ch == '"') {
-            std::wstring s;
+            std::u16string s;
             for (bool escape = false;;) {
                 if (end == len) {
                     std::wostringstream woss;
@@ -284,7 +284,7 @@ public:
 
 private:
     gc_heap_ptr<global_object> global_;
-    std::wstring               text_;
+    std::u16string               text_;
     size_t                     pos_;
     json_token                 tok_;
 };
@@ -365,14 +365,14 @@ value json_parse_value(json_lexer& lex) {
     lex.throw_unexpected(token);
 }
 
-value json_walk(const gc_heap_ptr<global_object>& global, const value& reviver, const object_ptr& holder, const std::wstring_view name) {
+value json_walk(const gc_heap_ptr<global_object>& global, const value& reviver, const object_ptr& holder, const std::u16string_view name) {
     auto& h = global.heap();
 
     const auto val = holder->get(name);
     if (val.type() == value_type::object) {
         const auto& o = val.object_value();
         if (is_array(o)) {
-            const uint32_t len = to_uint32(o->get(L"length"));
+            const uint32_t len = to_uint32(o->get(u"length"));
             for (uint32_t i = 0; i < len; ++i) {
                 const auto is = index_string(i);
                 auto new_element = json_walk(global, reviver, o, is);
@@ -385,7 +385,7 @@ value json_walk(const gc_heap_ptr<global_object>& global, const value& reviver,
         } else {
             const auto keys = o->own_property_names(true);
             for (const auto& p: keys) {
-                const std::wstring key{p.view()}; // Keep local copy in case p gets moved during the walk
+                const std::u16string key{p.view()}; // Keep local copy in case p gets moved during the walk
                 auto new_element = json_walk(global, reviver, o, key);
                 if (new_element.type() == value_type::undefined) {
                     o->delete_property(p.view());
@@ -401,7 +401,7 @@ value json_walk(const gc_heap_ptr<global_object>& global, const value& reviver,
 } // unnamed namespace
 
 value json_parse(const gc_heap_ptr<global_object>& global, const std::vector<value>& args) {
-    json_lexer lex{global, std::wstring{args.empty() ? L"undefined" : to_string(global.heap(), args.front()).view()}};
+    json_lexer lex{global, std::u16string{args.empty() ? u"undefined" : to_string(global.heap(), args.front()).view()}};
     value val = json_parse_value(lex);
     lex.skip_whitespace();
     if (!lex.eof()) {
@@ -410,7 +410,7 @@ value json_parse(const gc_heap_ptr<global_object>& global, const std::vector<val
     if (args.size() > 1 && args[1].type() == value_type::object && args[1].object_value().has_type<function_object>()) {
         auto holder = global->make_object();
         holder->put(global->common_string(""), val);
-        return json_walk(global, args[1], holder, L"");
+        return json_walk(global, args[1], holder, u"");
     }
     return val;
 }
@@ -421,34 +421,36 @@ value json_parse(const gc_heap_ptr<global_object>& global, const std::vector<val
 
 namespace {
 
-std::wstring json_quote(const std::wstring_view& s) {
-    std::wstring res;
-    res.push_back('"');
-    for (const auto ch: s) {
-        if (ch == '"' || ch == '\\') {
-            res.push_back('\\');
-            res.push_back(ch);
-        } else if (ch < ' ') {
-            res.push_back('\\');
+// Appends 's' quoted to 'b'
+void json_quote(string_builder& b, const string& s) {
+    s.visit([&b](auto v) {
+        b.append(u'"');
+        size_t run = 0; // Start of the current run of characters that don't need escaping
+        for (size_t i = 0; i < v.length(); ++i) {
+            const auto ch = char_code(v[i]);
+            if (ch != '"' && ch != '\\' && ch >= ' ') {
+                continue;
+            }
+            b.append(v.substr(run, i - run));
+            run = i + 1;
+            b.append(u'\\');
             switch (ch) {
-            case  8: res.push_back('b'); break;
-            case  9: res.push_back('t'); break;
-            case 10: res.push_back('n'); break;
-            case 12: res.push_back('f'); break;
-            case 13: res.push_back('r'); break;
+            case '"':  b.append(u'"'); break;
+            case '\\': b.append(u'\\'); break;
+            case  8: b.append(u'b'); break;
+            case  9: b.append(u't'); break;
+            case 10: b.append(u'n'); break;
+            case 12: b.append(u'f'); break;
+            case 13: b.append(u'r'); break;
             default:
-                res.push_back('u');
-                res.push_back('0');
-                res.push_back('0');
-                res.push_back((ch&0x10)?'1':'0');
-                res.push_back("0123456789abcdef"[ch&0xf]);
+                b.append(u"u00");
+                b.append(static_cast<char16_t>((ch&0x10)?'1':'0'));
+                b.append(static_cast<char16_t>("0123456789abcdef"[ch&0xf]));
             }
-        } else {
-            res.push_back(ch);
         }
-    }
-    res.push_back('"');
-    return res;
+        b.append(v.substr(run));
+        b.append(u'"');
+    });
 }
 
 class stringify_state {
@@ -461,13 +463,13 @@ public:
                 replacer_ = o;
             } else if (is_array(o)) {
                 auto& h = heap();
-                const uint32_t len = to_uint32(o->get(L"length"));
+                const uint32_t len = to_uint32(o->get(u"length"));
                 property_names_ = gc_vector<gc_heap_ptr_untracked<gc_string>>::make(h, len);
                 auto insert_item = [&](const string& item) {
                     // Check if the item is already in the list
                     auto n = property_names_->data();
                     for (uint32_t i = 0, l = property_names_->length(); i < l; ++i) {
-                        if (n[i].dereference(h).view() == item.view()) {
+                        if (n[i].dereference(h).equals(*item.unsafe_raw_get())) {
                             return;
                         }
                     }
@@ -481,7 +483,7 @@ public:
                         insert_item(to_string(h, item.number_value()));
                     } else if (item.type() == value_type::object) {
                         auto io = item.object_value();
-                        if (io->class_name().view() == L"String" || io->class_name().view() == L"Number") {
+                        if (io->class_name().view() == u"String" || io->class_name().view() == u"Number") {
                             insert_item(to_string(h, item));
                         }
                     }
@@ -494,15 +496,15 @@ public:
                 // FIXME: As below this is a bad way to determine the type...
                 auto o = space.object_value();
                 const auto class_name = o->class_name();
-                if (class_name.view() == L"Number") {
+                if (class_name.view() == u"Number") {
                     space = value{to_number(space)};
-                } else if (class_name.view() == L"String") {
+                } else if (class_name.view() == u"String") {
                     space = value{to_string(heap(), space)};
                 }
             }
 
             if (space.type() == value_type::number) {
-                gap_ = std::wstring(std::max(0, std::min(10, static_cast<int>(to_integer(space.number_value())))), ' ');
+                gap_ = std::u16string(std::max(0, std::min(10, static_cast<int>(to_integer(space.number_value())))), ' ');
             } else if (space.type() == value_type::string) {
                 auto s = space.string_value().view(); 
                 gap_ = s.substr(0, std::min(size_t{10}, s.length()));
@@ -520,7 +522,7 @@ public:
     string null_str() const { return global_->common_string("null"); }
     string bool_str(bool val) const { return global_->common_string(val ? "true" : "false"); }
 
-    void call_replacer(value& v, const std::wstring_view key, const object_ptr& holder) {
+    void call_replacer(value& v, const std::u16string_view key, const object_ptr& holder) {
         if (!replacer_) {
             return;
         }
@@ -554,25 +556,26 @@ public:
             state_.indent_ = step_back_;
         }
 
-        std::wstring start_gap() const {
-            return state_.gap_.empty() ? L"" : L"\n" + state_.indent_;
+        void start_gap(string_builder& b) const {
+            if (!state_.gap_.empty()) b.append(u'\n').append(std::u16string_view{state_.indent_});
         }
 
-        std::wstring end_gap() const {
-            return state_.gap_.empty() ? L"" : L"\n" + step_back_;
+        void end_gap(string_builder& b) const {
+            if (!state_.gap_.empty()) b.append(u'\n').append(std::u16string_view{step_back_});
         }
 
-        std::wstring sep() const {
-            return state_.gap_.empty() ? L"," : L",\n" + state_.indent_;
+        void sep(string_builder& b) const {
+            b.append(u',');
+            start_gap(b);
         }
 
-        std::wstring spacing() const {
-            return state_.gap_.empty() ? L"" : L" ";
+        void spacing(string_builder& b) const {
+            if (!state_.gap_.empty()) b.append(u' ');
         }
 
     private:
         stringify_state& state_;
-        std::wstring step_back_;
+        std::u16string step_back_;
     };
 
 private:
@@ -580,8 +583,8 @@ private:
     gc_heap_ptr<gc_vector<gc_heap_ptr_untracked<object>>>       stack_ = nullptr;
     object_ptr                                                  replacer_ = nullptr;
     gc_heap_ptr<gc_vector<gc_heap_ptr_untracked<gc_string>>>    property_names_ = nullptr;
-    std::wstring                                                indent_;
-    std::wstring                                                gap_;
+    std::u16string                                                indent_;
+    std::u16string                                                gap_;
 
     void push(const object_ptr& obj) {
         if (!stack_) {
@@ -600,77 +603,70 @@ private:
     }
 };
 
-value json_str(stringify_state& state, const std::wstring_view key, const object_ptr& holder);
+value json_str(stringify_state& state, const std::u16string_view key, const object_ptr& holder);
 
 string json_str_object(stringify_state& state, const object_ptr& o) {
     stringify_state::nest nest{state, o};
     auto k = state.property_list(o);
 
-    std::vector<std::wstring> partial;
+    string_builder res{state.heap()};
+    res.append(u'{');
+    bool first = true;
     for (const auto& p: k) {
         auto str_p = json_str(state, p.view(), o);
         if (str_p.type() != value_type::undefined) {
             assert(str_p.type() == value_type::string);
-            partial.push_back(json_quote(p.view()) + L":" + nest.spacing() + std::wstring{str_p.string_value().view()});
+            if (first) {
+                nest.start_gap(res);
+            } else {
+                nest.sep(res);
+            }
+            json_quote(res, p);
+            res.append(u':');
+            nest.spacing(res);
+            res.append(str_p.string_value());
+            first = false;
         }
     }
 
-    if (partial.empty()) {
+    if (first) {
         return state.global()->common_string("{}");
     }
 
-    std::wstring res;
-    res.push_back('{');
-    res += nest.start_gap();
-    bool first = true;
-    for (const auto& s: partial) {
-        if (!first) {
-            res += nest.sep();
-        }
-        res += s;
-        first = false;
-    }
-    res += nest.end_gap();
-    res.push_back('}');
-    return string{state.heap(), res};
+    nest.end_gap(res);
+    res.append(u'}');
+    return res.release();
 }
 
 string json_str_array(stringify_state& state, const object_ptr& a) {
     stringify_state::nest nest{state, a};
 
-    std::vector<string> partial;
-    const auto len = to_uint32(a->get(L"length"));
+    const auto len = to_uint32(a->get(u"length"));
+    if (!len) {
+        return state.global()->common_string("[]");
+    }
+
+    string_builder res{state.heap()};
+    res.append(u'[');
+    nest.start_gap(res);
     for (uint32_t index = 0; index < len; ++index) {
+        if (index) {
+            nest.sep(res);
+        }
         auto str_p = json_str(state, index_string(index), a);
         if (str_p.type() == value_type::undefined) {
-            partial.push_back(state.null_str());
+            res.append(state.null_str());
         } else {
             assert(str_p.type() == value_type::string);
-            partial.push_back(str_p.string_value());
-        }
-    }
-
-    if (partial.empty()) {
-        return state.global()->common_string("[]");
-    }
-
-    std::wstring res;
-    res.push_back('[');
-    res += nest.start_gap();
-    bool first = true;
-    for (const auto& s: partial) {
-        if (!first) {
-            res += nest.sep();
+            res.append(str_p.string_value());
         }
-        res += s.view();
-        first = false;
     }
-    res += nest.end_gap();
-    res.push_back(']');
-    return string{state.heap(), res};
+    nest.end_gap(res);
+    res.append(u']');
+    return res.release();
 }
 
-value json_str(stringify_state& state, const std::wstring_view key, const object_ptr& holder) {
+value json_str(stringify_state& state, const std::u16string_view key, const object_ptr& holder) {
     // ES5.1, 15.12.3 Str(key, holder)
     // May only return a string or undefined
 
@@ -681,7 +677,7 @@ value json_str(stringify_state& state, const std::wstring_view key, const object
     // 2. If Type(value) is Object, then
     if (v.type() == value_type::object) {        
         auto o = v.object_value();
-        auto to_json_value = o->get(L"toJSON");
+        auto to_json_value = o->get(u"toJSON");
         if (to_json_value.type() == value_type::object) {
             if (auto to_json = to_json_value.object_value(); to_json.has_type<function_object>()) {
                 v = call_function(to_json_value, v, {value{string{h,key}}});
@@ -713,7 +709,11 @@ value json_str(stringify_state& state, const std::wstring_view key, const object
             return value{to_string(h, v.number_value())};
         }
     case value_type::string:
-        return value{string{h, json_quote(v.string_value().view())}};
+    {
+        string_builder res{h, v.string_value().length() + 2};
+        json_quote(res, v.string_value());
+        return value{res.release()};
+    }
     default:
         break;
     }
@@ -738,7 +738,7 @@ value json_stringify(const gc_heap_ptr<global_object>& global, const std::vector
 
     stringify_state s{global, args};
 
-    return json_str(s, L"", wrapper);
+    return json_str(s, u"", wrapper);
 }
 
 global_object_create_result make_json_object(const gc_heap_ptr<global_object>& global) {
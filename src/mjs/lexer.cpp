@@ -14,9 +14,9 @@ const token eof_token{token_type::eof};
 
 namespace {
 
-constexpr const wchar_t unicode_ZWNJ = 0x200c;
-constexpr const wchar_t unicode_ZWJ  = 0x200d;
-constexpr const wchar_t unicode_BOM  = 0xfeff;
+constexpr const char16_t unicode_ZWNJ = 0x200c;
+constexpr const char16_t unicode_ZWJ  = 0x200d;
+constexpr const char16_t unicode_BOM  = 0xfeff;
 
 void cpp_quote_escape(std::wstring& r, char16_t c) {
     switch (c) {
@@ -120,10 +120,10 @@ constexpr bool is_form_control(uint32_t ch) {
     return ch >= 0xAD && classify(ch) == unicode::classification::format;
 }
 
-std::tuple<token_type, int> get_punctuation(std::wstring_view s, version v) {
+std::tuple<token_type, int> get_punctuation(std::u16string_view s, version v) {
     assert(!s.empty());
 
-#define CHECK_PUNCTUATORS(name, str, ver) if (v >= version::ver && s.length() >= sizeof(str)-1 && s.compare(0, sizeof(str)-1, L##str) == 0) return std::pair<token_type, int>{token_type::name, static_cast<int>(sizeof(str)-1)};
+#define CHECK_PUNCTUATORS(name, str, ver) if (v >= version::ver && s.length() >= sizeof(str)-1 && s.compare(0, sizeof(str)-1, u ## str) == 0) return std::pair<token_type, int>{token_type::name, static_cast<int>(sizeof(str)-1)};
     MJS_PUNCTUATORS(CHECK_PUNCTUATORS)
 #undef CHECK_PUNCTUATORS
 
@@ -133,7 +133,7 @@ std::tuple<token_type, int> get_punctuation(std::wstring_view s, version v) {
     throw std::runtime_error(oss.str());
 }
 
-std::pair<token, size_t> skip_comment(const std::wstring_view& text, size_t pos, version v) {
+std::pair<token, size_t> skip_comment(const std::u16string_view& text, size_t pos, version v) {
     assert(pos < text.size());
     assert(text[pos] == '/' || text[pos] == '*');
     const bool is_single_line = text[pos++] == '/';
@@ -164,7 +164,7 @@ unsigned try_get_decimal_value(int ch) {
     return is_digit(ch) ? ch - '0' : UINT_MAX;
 }
 
-std::pair<wchar_t, size_t> get_octal_escape_sequence(const std::wstring_view& text, size_t pos) {
+std::pair<char16_t, size_t> get_octal_escape_sequence(const std::u16string_view& text, size_t pos) {
     auto value = try_get_decimal_value(text[pos]);
     assert(value < 8);
     const size_t max_len = value < 4 ? 3 : 2;
@@ -176,15 +176,15 @@ std::pair<wchar_t, size_t> get_octal_escape_sequence(const std::wstring_view& te
         }
         value = value*8 + this_digit;
     }
-    return { static_cast<wchar_t>(value), len };
+    return { static_cast<char16_t>(value), len };
 }
 
-std::wstring replace_unicode_escape_sequences(const std::wstring& id, version ver) {
-    auto idx = id.find_first_of(L'\\');
-    assert(idx != std::wstring::npos);
-    std::wstring res;
+std::u16string replace_unicode_escape_sequences(const std::u16string& id, version ver) {
+    auto idx = id.find_first_of(u'\\');
+    assert(idx != std::u16string::npos);
+    std::u16string res;
     constexpr const char* const default_error_message = "Illegal unicode escape sequence in identfier";
-    std::wstring::size_type last = 0;
+    std::u16string::size_type last = 0;
     while (idx != std::string::npos) {
         assert(id[idx] == '\\');
         if (idx != last) {
@@ -202,7 +202,7 @@ std::wstring replace_unicode_escape_sequences(const std::wstring& id, version ve
         }
         res += ch;
 
-        idx = id.find_first_of(L'\\', idx + 1);
+        idx = id.find_first_of(u'\\', idx + 1);
     }
 
     res += id.substr(last);
@@ -210,9 +210,9 @@ std::wstring replace_unicode_escape_sequences(const std::wstring& id, version ve
     return res;
 }
 
-std::pair<token, size_t> get_string_literal(const std::wstring_view text_, const size_t token_start, version ver) {
+std::pair<token, size_t> get_string_literal(const std::u16string_view text_, const size_t token_start, version ver) {
     bool escape = false;
-    std::wstring s;
+    std::u16string s;
     const auto ch = text_[token_start];
     assert(ch == '"' || ch == '\'');
     size_t token_end = token_start + 1;
@@ -245,7 +245,7 @@ std::pair<token, size_t> get_string_literal(const std::wstring_view text_, const
                 if (token_end + 2 >= text_.size()) {
                     throw std::runtime_error("Invalid hex escape sequence");
                 }
-                s.push_back(static_cast<wchar_t>(get_hex_value2(&text_[token_end])));
+                s.push_back(static_cast<char16_t>(get_hex_value2(&text_[token_end])));
                 token_end += 1; // Incremented in loop
                 break;
                 // OctalEscapeSequence
@@ -254,7 +254,7 @@ std::pair<token, size_t> get_string_literal(const std::wstring_view text_, const
                 {
                     const auto [och, len] =  get_octal_escape_sequence(text_, token_end);
                     token_end += len-1; // Incremented in loop
-                    s.push_back(static_cast<wchar_t>(och));
+                    s.push_back(static_cast<char16_t>(och));
                     break;
                 }
                 break;
@@ -264,7 +264,7 @@ std::pair<token, size_t> get_string_literal(const std::wstring_view text_, const
                 if (token_end + 4 >= text_.size()) {
                     throw std::runtime_error("Invalid unicode escape sequence");
                 }
-                s.push_back(static_cast<wchar_t>(get_hex_value4(&text_[token_end])));
+                s.push_back(static_cast<char16_t>(get_hex_value4(&text_[token_end])));
                 token_end += 3; // Incremented in loop
                 break;
             default:
@@ -298,7 +298,7 @@ std::pair<token, size_t> get_string_literal(const std::wstring_view text_, const
     return { token{token_type::string_literal, std::move(s)}, token_end };
 }
 
-std::pair<token, size_t> get_identifier(const std::wstring_view text, const size_t token_start, version ver) {
+std::pair<token, size_t> get_identifier(const std::u16string_view text, const size_t token_start, version ver) {
     auto token_end = token_start + 1;
     bool escape_sequence_used = text[token_start] == '\\';
 
@@ -316,13 +316,13 @@ std::pair<token, size_t> get_identifier(const std::wstring_view text, const size
             break;
         }
     }
-    auto id = std::wstring{text.begin() + token_start, text.begin() + token_end};
+    auto id = std::u16string{text.begin() + token_start, text.begin() + token_end};
     token tok{token_type::eof};
     if (escape_sequence_used) {
         id = replace_unicode_escape_sequences(id, ver);
     }
     if (0) {}
-#define X(rw, first_ver, last_ver) else if (ver >= version::first_ver && ver <= version::last_ver && id == L ## #rw) { tok = token{token_type::rw ## _}; }
+#define X(rw, first_ver, last_ver) else if (ver >= version::first_ver && ver <= version::last_ver && id == u ## #rw) { tok = token{token_type::rw ## _}; }
     MJS_KEYWORDS(X)
 #undef X
 else tok = token{token_type::identifier, id};
@@ -334,7 +334,7 @@ else tok = token{token_type::identifier, id};
     return { tok, token_end };
 }
 
-std::pair<token, size_t> get_number_literal(const std::wstring_view text_, const size_t token_start, version) {
+std::pair<token, size_t> get_number_literal(const std::u16string_view text_, const size_t token_start, version) {
     const auto ch = text_[token_start];
     auto token_end = token_start + 1;
     if (ch == '0' && !(token_end < text_.size() && text_[token_end] == '.')) {
@@ -400,7 +400,7 @@ constexpr bool is_whitespace(char16_t ch, version ver) {
         || (ver >= version::es3 && classify(ch) == unicode::classification::whitespace);
 }
 
-std::pair<token, size_t> skip_whitespace(const std::wstring_view text, const size_t token_start, version ver) {
+std::pair<token, size_t> skip_whitespace(const std::u16string_view text, const size_t token_start, version ver) {
     auto token_end = token_start;
     while (token_end < text.size() && is_whitespace(static_cast<char16_t>(text[token_end]), ver)) {
         ++token_end;
@@ -414,7 +414,7 @@ bool is_whitespace_or_line_terminator(char16_t ch, version ver) {
     return is_whitespace(ch, ver) || is_line_terminator(ch, ver);
 }
 
-std::wstring cpp_quote(const std::wstring_view& s) {
+std::wstring cpp_quote(const std::u16string_view& s) {
     std::wstring r;
     for (const auto c: s) {
         if (c < 32 || c > 127 || c == '\"' || c == '\\') {
@@ -527,22 +527,22 @@ unsigned get_hex_value(int ch) {
     throw std::runtime_error("Invalid hex digit: " + std::string(1, (char)ch));
 }
 
-unsigned get_hex_value2(const wchar_t* s) {
+unsigned get_hex_value2(const char16_t* s) {
     return get_hex_value(s[0])<<4 | get_hex_value(s[1]);
 }
 
-unsigned get_hex_value4(const wchar_t* s) {
+unsigned get_hex_value4(const char16_t* s) {
     return get_hex_value(s[0])<<12 | get_hex_value(s[1])<<8 | get_hex_value(s[2])<<4 | get_hex_value(s[3]);
 }
 
-std::wstring strip_format_control_characters(const std::wstring_view& s) {
-    std::wstring res;
+std::u16string strip_format_control_characters(const std::u16string_view& s) {
+    std::u16string res;
     res.reserve(s.size());
     std::copy_if(s.begin(), s.end(), std::back_inserter(res), [](auto ch) { return !is_form_control(ch); });
     return res;
 }
 
-lexer::lexer(const std::wstring_view& text, version ver) : text_(text), version_(ver) {
+lexer::lexer(const std::u16string_view& text, version ver) : text_(text), version_(ver) {
     next_token();
 }
 
@@ -569,7 +569,7 @@ void lexer::next_token() {
         if (ch == '/' && token_end < text_.size() && (text_[token_end] == '/' || text_[token_end] == '*')) {
             std::tie(current_token_, token_end)  = skip_comment(text_, token_end, version_);
         } else {
-            auto [tok, len] = get_punctuation(std::wstring_view{&text_[text_pos_], text_.size() - text_pos_}, version_);
+            auto [tok, len] = get_punctuation(std::u16string_view{&text_[text_pos_], text_.size() - text_pos_}, version_);
             token_end = text_pos_ + len;
             current_token_ = token{tok};
         }
@@ -596,7 +596,7 @@ void lexer::next_token() {
     text_pos_ = token_end;
 }
 
-std::wstring_view lexer::get_regex_literal() {
+std::u16string_view lexer::get_regex_literal() {
     assert(version_ >= version::es3 &&  "Regular expression literals are not support until ES3");
     assert(current_token_.type() == token_type::divide || current_token_.type() == token_type::divideequal);
     const size_t start = text_pos_ - (current_token_.type() == token_type::divide ? 1 : 2);
@@ -637,7 +637,7 @@ std::wstring_view lexer::get_regex_literal() {
         }
     }
 
-    const std::wstring_view regex_lit{&text_[start], text_pos_ - start};
+    const std::u16string_view regex_lit{&text_[start], text_pos_ - start};
 
     next_token();
 
@@ -5,6 +5,7 @@
 #include <cassert>
 #include <string>
 #include "version.h"
+#include "char_conversions.h"
 
 namespace mjs {
 
@@ -158,8 +159,8 @@ extern token_type without_assignment(token_type t);
 const char* op_text(token_type tt);
 
 extern unsigned get_hex_value(int ch);
-unsigned get_hex_value2(const wchar_t* s);
-unsigned get_hex_value4(const wchar_t* s);
+unsigned get_hex_value2(const char16_t* s);
+unsigned get_hex_value4(const char16_t* s);
 
 extern bool is_whitespace_or_line_terminator(char16_t ch, version ver);
 
@@ -168,7 +169,7 @@ public:
     explicit token(token_type type) : type_(type) {
         assert(!has_text());
     }
-    explicit token(token_type type, const std::wstring& text) : type_(type), text_(text) {
+    explicit token(token_type type, const std::u16string& text) : type_(type), text_(text) {
         assert(has_text());
     }
     explicit token(double dval) : type_(token_type::numeric_literal), dvalue_(dval) {
@@ -184,7 +185,7 @@ public:
             destroy();
             type_ = t.type_;
             if (t.has_text()) {
-                new (&text_) std::wstring(t.text_);
+                new (&text_) std::u16string(t.text_);
             } else {
                 ivalue_ = t.ivalue_;
             }
@@ -196,7 +197,7 @@ public:
             destroy();
             type_ = t.type_;
             if (t.has_text()) {
-                new (&text_) std::wstring(std::move(t.text_));
+                new (&text_) std::u16string(std::move(t.text_));
             } else {
                 ivalue_ = t.ivalue_;
             }
@@ -210,7 +211,7 @@ public:
 
     token_type type() const { return type_; }
 
-    const std::wstring& text() const {
+    const std::u16string& text() const {
         assert(has_text());
         return text_;
     }
@@ -235,7 +236,7 @@ private:
     union {
         uint64_t        ivalue_;
         double          dvalue_;
-        std::wstring    text_;
+        std::u16string    text_;
     };
 
     void destroy() {
@@ -249,10 +250,10 @@ extern const token eof_token;
 
 class lexer {
 public:
-    explicit lexer(const std::wstring_view& text, version ver);
+    explicit lexer(const std::u16string_view& text, version ver);
 
     const token& current_token() const { return current_token_; }
-    std::wstring_view text() const { return text_; }
+    std::u16string_view text() const { return text_; }
     uint32_t text_position() const { return static_cast<uint32_t>(text_pos_); }
 
     void next_token();
@@ -263,19 +264,19 @@ public:
     // method. The complete regular expression literal text is returned and
     // the scanner advanced to the next token (i.e. current_token() will 
     // return the first token following the regular expression)
-    std::wstring_view get_regex_literal();
+    std::u16string_view get_regex_literal();
 
 private:
-    std::wstring_view text_;
+    std::u16string_view text_;
     version version_;
     size_t text_pos_ = 0;
     token current_token_ = eof_token;
 };
 
-std::wstring cpp_quote(const std::wstring_view& s);
+std::wstring cpp_quote(const std::u16string_view& s);
 
 // Remove Unicode Format-Control Characters (ES3, 7.1)
-std::wstring strip_format_control_characters(const std::wstring_view& s);
+std::u16string strip_format_control_characters(const std::u16string_view& s);
 
 } // namespace mjs
 
@@ -14,7 +14,7 @@ void native_object::fixup() {
     object::fixup();
 }
 
-bool native_object::delete_property(const std::wstring_view& name) {
+bool native_object::delete_property(const std::u16string_view& name) {
     if (auto it = find(name)) {
         if (has_attributes(it->attributes, property_attribute::dont_delete)) {
             return false;
@@ -35,7 +35,7 @@ native_object::native_object_property* native_object::find(const char* name) con
     return nullptr;
 }
 
-native_object::native_object_property* native_object::find(const std::wstring_view& v) const {
+native_object::native_object_property* native_object::find(const std::u16string_view& v) const {
     const auto len = v.length();
     if (len >= sizeof(native_object_property::name)) {
         return nullptr;
@@ -58,12 +58,16 @@ void native_object::do_add_native_property(const char* name, property_attribute
 }
 
 void native_object::add_own_property_names(std::vector<string>& names, bool check_enumerable) const {
+    add_native_property_names(names, check_enumerable);
+    object::add_own_property_names(names, check_enumerable);
+}
+
+void native_object::add_native_property_names(std::vector<string>& names, bool check_enumerable) const {
     for (const auto& p: native_properties_.dereference(heap())) {
         if (!check_enumerable || !has_attributes(p.attributes, property_attribute::dont_enum)) {
             names.emplace_back(heap(), p.name);
         }
     }
-    object::add_own_property_names(names, check_enumerable);
 }
 
 native_object::native_object_property::native_object_property(const char* name, property_attribute attributes, get_func get, put_func put)
@@ -75,7 +79,7 @@ native_object::native_object_property::native_object_property(const char* name,
 }
 
 void native_object::do_debug_print_extra(std::wostream& os, int indent_incr, int max_nest, int indent) const {
-    const auto indent_string = std::wstring(indent, ' ');
+    const auto indent_string = std::u16string(indent, ' ');
     for (const auto& p: native_properties_.dereference(heap())) {
         os << indent_string << p.name << ": ";
         mjs::debug_print(os, p.get(*this), indent_incr, 1, indent);
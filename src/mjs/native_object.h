@@ -10,7 +10,7 @@ namespace mjs {
 
 class native_object : public object {
 public:
-    value get(const std::wstring_view& name) const override {
+    value get(const std::u16string_view& name) const override {
         if (auto it = find(name)) {
             return it->get(*this);
         }
@@ -23,7 +23,7 @@ public:
         }
     }
 
-    bool delete_property(const std::wstring_view& name) override;
+    bool delete_property(const std::u16string_view& name) override;
 
 private:
     using get_func = value (*)(const native_object&);
@@ -40,7 +40,7 @@ private:
     gc_heap_ptr_untracked<gc_vector<native_object_property>> native_properties_;
 
     native_object_property* find(const char* name) const;
-    native_object_property* find(const std::wstring_view& v) const;
+    native_object_property* find(const std::u16string_view& v) const;
 
     void do_add_native_property(const char* name, property_attribute attributes, get_func get, put_func put);
 
@@ -67,7 +67,10 @@ protected:
 
     void add_own_property_names(std::vector<string>& names, bool check_enumerable) const override;
 
-    property_attribute do_own_property_attributes(const std::wstring_view& name) const override {
+    // Only the native properties (add_own_property_names also adds the normal properties)
+    void add_native_property_names(std::vector<string>& names, bool check_enumerable) const;
+
+    property_attribute do_own_property_attributes(const std::u16string_view& name) const override {
         if (auto it = find(name)) {
             return it->attributes;
         }
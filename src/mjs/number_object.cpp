@@ -34,7 +34,7 @@ private:
     }
 
     void do_debug_print_extra(std::wostream& os, int, int, int indent) const override {
-        os << std::wstring(indent, ' ') << "[[Value]]: " << number_to_string(value_) << "\n";
+        os << std::u16string(indent, ' ') << "[[Value]]: " << number_to_string(value_) << "\n";
     }
 };
 
@@ -96,7 +96,7 @@ global_object_create_result make_number_object(const gc_heap_ptr<global_object>&
         make_number_function("toFixed", 1, [global](double num, const std::vector<value>& args) {
             const auto f = get_int_arg(args);
             if (f < 0 || f > 20) {
-                throw native_error_exception{native_error_type::range, global->stack_trace(), L"fractionDigits out of range in Number.toFixed()"};
+                throw native_error_exception{native_error_type::range, global->stack_trace(), u"fractionDigits out of range in Number.toFixed()"};
             }
             auto& h = global.heap();
             if (std::isnan(num) || std::fabs(num) >= 1e21) {
@@ -107,7 +107,7 @@ global_object_create_result make_number_object(const gc_heap_ptr<global_object>&
         make_number_function("toExponential", 1, [global](double num, const std::vector<value>& args) {
             const auto f = get_int_arg(args);
             if (f < 0 || f > 20) {
-                throw native_error_exception{native_error_type::range, global->stack_trace(), L"fractionDigits out of range in Number.toExponential()"};
+                throw native_error_exception{native_error_type::range, global->stack_trace(), u"fractionDigits out of range in Number.toExponential()"};
             }
             auto& h = global.heap();
             if (!std::isfinite(num)) {
@@ -122,7 +122,7 @@ global_object_create_result make_number_object(const gc_heap_ptr<global_object>&
             }
             const auto p = get_int_arg(args);
             if (p < 1 || p > 21) {
-                throw native_error_exception{native_error_type::range, global->stack_trace(), L"precision out of range in Number.toPrecision()"};
+                throw native_error_exception{native_error_type::range, global->stack_trace(), u"precision out of range in Number.toPrecision()"};
             }
             if (!std::isfinite(num)) {
                 return to_string(h, num);
@@ -3,6 +3,8 @@
 #include <cassert>
 #include <cmath>
 #include <cstring>
+#include <cstdio>
+#include <cstdlib>
 
 namespace mjs {
 
@@ -53,10 +55,15 @@ ecvt_result do_ecvt(double m, int k) {
     return res;
 }
 
-std::wstring to_radix_string_inner(double x, int radix, bool int_part) {
+// The formatted numbers only contain ASCII characters
+std::u16string ascii_to_u16string(const std::string& s) {
+    return std::u16string(s.begin(), s.end());
+}
+
+std::u16string to_radix_string_inner(double x, int radix, bool int_part) {
     assert(std::isfinite(x) && x > 0);
     constexpr const char digits[37] = "0123456789abcdefghijklmnopqrstuvwxyz";
-    std::wstring res;
+    std::u16string res;
     int iter = 1100;
     do {
         if (!--iter) {
@@ -80,36 +87,54 @@ std::wstring to_radix_string_inner(double x, int radix, bool int_part) {
 
     } while (x != 0.0);
 
-    return int_part ? std::wstring(res.crbegin(), res.crend()) : res;
+    return int_part ? std::u16string(res.crbegin(), res.crend()) : res;
 }
 
 } // unnamed namespace
 
-std::wstring do_format_double(double m, int k) {
+// Writes the representation of 'm' using 'k' digits to 'out', returns the number of characters written
+int do_format_double(char* out, double m, int k) {
     auto [k_, n, s] = do_ecvt(m, k); (void)k_;
 
-    std::wostringstream woss;
+    char* p = out;
+    auto put = [&p](const char* chars, int count) {
+        std::memcpy(p, chars, count);
+        p += count;
+    };
+    auto put_zeros = [&p](int count) {
+        std::memset(p, '0', count);
+        p += count;
+    };
+    auto put_exponent = [&p](int e) {
+        p += std::snprintf(p, 6, "e%c%d", e >= 0 ? '+' : '-', std::abs(e));
+    };
     if (k <= n && n <= 21) {
         // 6. If k <= n <= 21, return the string consisting of the k digits of the decimal
         // representation of s (in order, with no leading zeroes), followed by n - k
         // occurences of the character 0
-        woss << s << std::wstring(n-k, '0');
+        put(s, k);
+        put_zeros(n-k);
     } else if (0 < n && n <= 21) {
         // 7. If 0 < n <= 21, return the string consisting of the most significant n digits
         // of the decimal representation of s, followed by a decimal point ., followed
         // by the remaining k - n digits of the decimal representation of s.
-        woss << std::wstring(s, s + n) << '.' << std::wstring(s + n, s + std::strlen(s));
+        put(s, n);
+        put(".", 1);
+        put(s + n, k - n);
     } else if (-6 < n && n <= 0) {
         // 8. If -6 < n <= 0, return the string consisting of the character 0, followed
         // by a decimal point ., followed by -n occurences of the character 0, followed
         // by the k digits of the decimal representation of s.
-        woss << "0." << std::wstring(-n, '0') << s;
+        put("0.", 2);
+        put_zeros(-n);
+        put(s, k);
     } else if (k == 1) {
         // 9.  Otherwise, if k = 1, return the string consisting of the single digit of s,
         // followed by lowercase character e, followed by a plus sign + or minus sign
         // - according to whether n - 1 is positive or negative, followed by the decimal
         // representation of the integer abs(n - 1) (with no leading zeros).
-        woss << s << 'e' << (n-1>=0?'+':'-') << std::abs(n-1);
+        put(s, 1);
+        put_exponent(n-1);
     } else {
         // 10. Return the string consisting of the most significant digit of the decimal
         // representation of s, followed by a decimal point ., followed by the remaining
@@ -117,24 +142,33 @@ std::wstring do_format_double(double m, int k) {
         // e, followed by a plus sign + or minus sign - according to whether n - 1 is positive
         // or negative, followed by the decimal representation of the integer abs(n - 1)
         // (with no leading zeros)
-        woss << s[0] << '.' << s+1 << 'e' << (n-1>=0?'+':'-') << std::abs(n-1);
+        put(s, 1);
+        put(".", 1);
+        put(s + 1, k - 1);
+        put_exponent(n-1);
     }
-    return woss.str();
+    return static_cast<int>(p - out);
 }
 
-std::wstring number_to_string(double m) {
+int number_to_chars(char* buf, double m) {
     // Handle special cases
+    auto special = [buf](const char* s) {
+        const auto len = std::strlen(s);
+        std::memcpy(buf, s, len);
+        return static_cast<int>(len);
+    };
     if (std::isnan(m)) {
-        return L"NaN";
+        return special("NaN");
     }
     if (m == 0) {
-        return L"0";
+        return special("0");
     }
     if (m < 0) {
-        return L"-" + number_to_string(-m);
+        buf[0] = '-';
+        return 1 + number_to_chars(buf + 1, -m);
     }
     if (std::isinf(m)) {
-        return L"Infinity";
+        return special("Infinity");
     }
 
     assert(std::isfinite(m) && m > 0);
@@ -143,11 +177,10 @@ std::wstring number_to_string(double m) {
 
     // Use really slow method to determine shortest representation of m
     for (int k = 1; k <= 17; ++k) {
-        std::ostringstream woss;
-        woss.precision(k);
-        woss << std::defaultfloat << m;
-        if (double t; std::istringstream{woss.str()} >> t && t == m) {
-            return do_format_double(m, k);
+        char temp[32];
+        std::snprintf(temp, sizeof(temp), "%.*g", k, m);
+        if (std::strtod(temp, nullptr) == m) {
+            return do_format_double(buf, m, k);
         }
     }
     // More than 17 digits should never happen
@@ -155,37 +188,42 @@ std::wstring number_to_string(double m) {
     throw std::runtime_error("Internal error");
 }
 
-std::wstring number_to_fixed(double x, int f) {
+std::u16string number_to_string(double m) {
+    char buf[number_to_chars_max];
+    return std::u16string(buf, buf + number_to_chars(buf, m));
+}
+
+std::u16string number_to_fixed(double x, int f) {
     // TODO: Implement actual rules from ES3, 15.7.4.5
     assert(std::isfinite(x) && std::fabs(x) < 1e21 && f >= 0 && f <= 20);
-    std::wstringstream wss;
+    std::ostringstream oss;
     if (x < 0) {
         x = -x;
-        wss << L'-';
+        oss << '-';
     }
-    wss.precision(f);
-    wss.flags(std::ios::fixed);
-    wss << x;
-    return wss.str();
+    oss.precision(f);
+    oss.flags(std::ios::fixed);
+    oss << x;
+    return ascii_to_u16string(oss.str());
 }
 
-std::wstring number_to_exponential(double x, int f) {
+std::u16string number_to_exponential(double x, int f) {
     // TODO: Implement actual rules from ES3, 15.7.4.6
     assert(std::isfinite(x) && f >= 0 && f <= 20);
-    std::wstringstream wss;
+    std::ostringstream oss;
     if (x < 0) {
         x = -x;
-        wss << L'-';
+        oss << '-';
     }
-    wss.precision(f ? f : 18);
-    wss.flags(std::ios::scientific);
-    wss << x;
-    auto s = wss.str();
+    oss.precision(f ? f : 18);
+    oss.flags(std::ios::scientific);
+    oss << x;
+    auto s = ascii_to_u16string(oss.str());
 
     // Remove unnecessary digits (yuck)
     if (f == 0) {
-        auto e_pos = s.find_last_of(L'e');
-        assert(e_pos != std::wstring::npos && e_pos > 0);
+        auto e_pos = s.find_last_of(u'e');
+        assert(e_pos != std::u16string::npos && e_pos > 0);
         for (;;) {
             --e_pos;
             if (s[e_pos] == '.') {
@@ -200,66 +238,66 @@ std::wstring number_to_exponential(double x, int f) {
     }
 
     // Fix up the exponent to match ECMAscript format (yuck)
-    auto e_pos = s.find_last_of(L'e');
-    assert(e_pos != std::wstring::npos && e_pos+2 < s.length() && (s[e_pos+1] == '+' || s[e_pos+1] == '-'));
+    auto e_pos = s.find_last_of(u'e');
+    assert(e_pos != std::u16string::npos && e_pos+2 < s.length() && (s[e_pos+1] == '+' || s[e_pos+1] == '-'));
     e_pos += 2;
 
     // Remove leading zeros in exponent
-    while (e_pos + 1 < s.length() && s[e_pos] == L'0') {
+    while (e_pos + 1 < s.length() && s[e_pos] == u'0') {
         s.erase(e_pos, 1);
     }
 
     return s;
 }
 
-std::wstring number_to_precision(double x, int p) {
+std::u16string number_to_precision(double x, int p) {
     // HACK HACK
     assert(std::isfinite(x) && p >= 1 && p <= 21);
-    std::wstring s = L"";
+    std::u16string s = u"";
     if (x < 0) {
-        s = L"-";
+        s = u"-";
         x = -x;
     }
 
     auto [k, e, digits] = do_ecvt(x, p);
-    std::wstring m = std::wstring{digits, digits+k};
+    std::u16string m = std::u16string{digits, digits+k};
     e--;
     if (e < -6 || e >= p) {
         if (m.size() > 1) {
-            m.insert(m.begin() + 1, L'.');
+            m.insert(m.begin() + 1, u'.');
         }
         if (e == 0) {
-            m += L"e+0";
+            m += u"e+0";
         } else if (e > 0) {
-            m += L"e+" + std::to_wstring(e);
+            m += u"e+" + ascii_to_u16string(std::to_string(e));
         } else {
-            m += L"e-" + std::to_wstring(-e);
+            m += u"e-" + ascii_to_u16string(std::to_string(-e));
         }
     } else if (e == p - 1) {
     } else if (e >= 0) {
-        m.insert(m.begin() + e + 1, L'.');
+        m.insert(m.begin() + e + 1, u'.');
     } else {
-        m = L"0." + std::wstring(-(e+1), L'0') + m;
+        m = u"0." + std::u16string(-(e+1), u'0') + m;
     }
 
     return s + m;
 }
 
-std::wstring number_to_radix_string(double x, int radix) {
+std::u16string number_to_radix_string(double x, int radix) {
     assert(radix >= 2 && radix != 10 && radix <= 36);
     if (!std::isfinite(x)) {
         return number_to_string(x);
     } else if (x == 0.0) {
-        return L"0";
+        return u"0";
     } else if (x < 0) {
-        return L"-" + number_to_radix_string(-x, radix);
+        return u"-" + number_to_radix_string(-x, radix);
     }
     assert(std::isfinite(x) && x > 0);
 
     const double int_part  = std::floor(x);
     const double frac_part = x - int_part;
 
-    auto res = int_part ? to_radix_string_inner(int_part, radix, true) : L"0";
+    auto res = int_part ? to_radix_string_inner(int_part, radix, true) : u"0";
     if (frac_part != 0.0) {
         res += '.';
         res += to_radix_string_inner(frac_part, radix, false);
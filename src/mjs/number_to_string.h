@@ -5,11 +5,16 @@
 
 namespace mjs {
 
-std::wstring number_to_string(double x);
-std::wstring number_to_radix_string(double x, int radix);
-std::wstring number_to_fixed(double x, int f);
-std::wstring number_to_exponential(double x, int f);
-std::wstring number_to_precision(double x, int p);
+std::u16string number_to_string(double x);
+
+// Write the characters of number_to_string(x) (which are ASCII) to 'buf', returns the number of characters written
+constexpr int number_to_chars_max = 32;
+int number_to_chars(char* buf, double x);
+
+std::u16string number_to_radix_string(double x, int radix);
+std::u16string number_to_fixed(double x, int f);
+std::u16string number_to_exponential(double x, int f);
+std::u16string number_to_precision(double x, int p);
 
 } // namespace mjs
 
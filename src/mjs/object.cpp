@@ -10,7 +10,7 @@ object::object(const string& class_name, const object_ptr& prototype)
     : heap_{class_name.heap()} // A class will always have a class_name - grab heap from that
     , class_{class_name.unsafe_raw_get()}
     , prototype_{prototype}
-    , properties_{gc_vector<property>::make(heap_, 4)}
+    , shape_{prototype ? prototype->empty_child_shape() : object_shape::make_empty(heap_)}
     , extensible_{true} {
 }
 
@@ -18,10 +18,37 @@ object::object(const string& class_name, const object_ptr& prototype)
 void object::fixup() {
     class_.fixup(heap_);
     prototype_.fixup(heap_);
-    properties_.fixup(heap_);
+    shape_.fixup(heap_);
+    slots_.fixup(heap_);
+    child_shape_.fixup(heap_);
 }
 
-bool object::has_property(const std::wstring_view& name) const {
+gc_heap_ptr<object_shape> object::empty_child_shape() const {
+    if (!child_shape_) {
+        child_shape_ = object_shape::make_empty(heap_);
+    }
+    return child_shape_.track(heap_);
+}
+
+void object::add_property(const string& name, const value& val, property_attribute attr) {
+    shape_ = object_shape::add(shape_.track(heap_), name, attr);
+    if (!slots_) {
+        slots_ = gc_vector<value_representation>::make(heap_, 4);
+    }
+    slots_.dereference(heap_).emplace_back(val);
+    assert(slots_.dereference(heap_).length() == shape_.dereference(heap_).size());
+}
+
+void object::change_attributes(uint32_t index, property_attribute attr) {
+    shape_ = object_shape::change_attributes(shape_.track(heap_), index, attr);
+}
+
+void object::remove_property(uint32_t index) {
+    shape_ = object_shape::remove(shape_.track(heap_), index);
+    slots_.dereference(heap_).erase(index);
+}
+
+bool object::has_property(const std::u16string_view& name) const {
     if (own_property_attributes(name) != property_attribute::invalid) {
         return true;
     }
@@ -43,80 +70,80 @@ std::vector<string> object::own_property_names(bool check_enumerable) const {
     return names;
 }
 
-void object::define_accessor_property(const string& name, const object_ptr& accessor, property_attribute attr) {
+void object::do_define_accessor_property(const string& name, const object_ptr& accessor, property_attribute attr) {
     assert(is_valid(attr));
-    assert(accessor && !accessor->prototype() && (is_function(accessor->get(L"get")) || is_function(accessor->get(L"set"))));
+    assert(accessor && !accessor->prototype() && (is_function(accessor->get(u"get")) || is_function(accessor->get(u"set"))));
     attr |= property_attribute::accessor;
-    if (accessor->get(L"set").type() != value_type::undefined) {
+    if (accessor->get(u"set").type() != value_type::undefined) {
         attr &= ~property_attribute::read_only;
     } else {
         attr |= property_attribute::read_only;
     }
-    if (auto it = find(name.view()).first) {
-        it->raw_put(value{accessor});
-        it->attributes(attr);
+    if (auto index = find(name); index != object_shape::not_found) {
+        raw_put(index, value{accessor});
+        change_attributes(index, attr);
         return;
     }
     assert(!is_valid(own_property_attributes(name.view())));
-    properties_.dereference(heap()).emplace_back(name, value{accessor}, attr);
+    add_property(name, value{accessor}, attr);
 }
 
-void object::modify_accessor_object(const std::wstring_view name, const value& new_val, bool is_get) {
+void object::modify_accessor_object(const std::u16string_view name, const value& new_val, bool is_get) {
     assert(new_val.type() == value_type::undefined || is_function(new_val));
-    auto it = find(name).first;
-    if (!has_attributes(it->attributes(), property_attribute::accessor)) {
+    const auto index = find(name);
+    if (index == object_shape::not_found || !has_attributes(attributes_at(index), property_attribute::accessor)) {
         throw std::logic_error{"modify_accessor_object called on non-accessor property"};
     }
 
-    auto a = it->raw_get(heap_).object_value();
-    assert(a && a->class_name().view() == L"Accessor" && !a->prototype());
-    auto p = a->find(is_get ? L"get" : L"set").first;
-    assert(p);
-    p->raw_put(new_val);
+    auto a = raw_get(index).object_value();
+    assert(a && a->class_name().view() == u"Accessor" && !a->prototype());
+    const auto p = a->find(is_get ? u"get" : u"set");
+    assert(p != object_shape::not_found);
+    a->raw_put(p, new_val);
 
     // Maintain invariant regarding the read_only attribute
     if (!is_get) {
-        auto attr = it->attributes() & ~property_attribute::read_only;
+        auto attr = attributes_at(index) & ~property_attribute::read_only;
         if (new_val.type() == value_type::undefined) {
             attr |= property_attribute::read_only;
         }
-        it->attributes(attr);
+        change_attributes(index, attr);
     }
 }
 
-object_ptr object::get_accessor_property_object(const std::wstring_view name) {
-    auto it = find(name).first;
-    if (!has_attributes(it->attributes(), property_attribute::accessor)) {
+object_ptr object::get_accessor_property_object(const std::u16string_view name) {
+    const auto index = find(name);
+    if (index == object_shape::not_found || !has_attributes(attributes_at(index), property_attribute::accessor)) {
         throw std::logic_error{"get_accessor_property_fields called on non-accessor property"};
     }
-    return it->raw_get(heap_).object_value();
+    return raw_get(index).object_value();
 }
 
 bool object::do_redefine_own_property(const string& name, const value& val, property_attribute attr) {
-    if (auto it = find(name.view()).first) {
+    if (auto index = find(name); index != object_shape::not_found) {
         assert(!has_attributes(attr, property_attribute::accessor));
-        it->attributes(attr);
-        it->raw_put(val);
+        raw_put(index, val);
+        change_attributes(index, attr);
         return true;
     }
     assert(!is_valid(own_property_attributes(name.view())));
-    properties_.dereference(heap()).emplace_back(name, val, attr);
+    add_property(name, val, attr);
     return true;
 }
 
-property_attribute object::do_own_property_attributes(const std::wstring_view& name) const {
-    if (auto it = find(name).first; it) {
-        return it->attributes();
+property_attribute object::do_own_property_attributes(const std::u16string_view& name) const {
+    if (auto index = find(name); index != object_shape::not_found) {
+        return attributes_at(index);
     }
     return property_attribute::invalid;
 }
 
 void object::add_own_property_names(std::vector<string>& names, bool check_enumerable) const {
-    for (auto& p : properties_.dereference(heap_)) { 
-        if (!check_enumerable || !has_attributes(p.attributes(), property_attribute::dont_enum)) {
-            names.push_back(p.key(heap_));
+    shape_.dereference(heap_).for_each_property([&](const string& key, property_attribute attr) {
+        if (!check_enumerable || !has_attributes(attr, property_attribute::dont_enum)) {
+            names.push_back(key);
         }
-    }
+    });
 }
 
 void object::debug_print(std::wostream& os, int indent_incr, int max_nest, int indent) const {
@@ -124,7 +151,7 @@ void object::debug_print(std::wostream& os, int indent_incr, int max_nest, int i
         os << "[Object " << class_name() << "]";
         return;
     }
-    auto indent_string = std::wstring(indent + indent_incr, ' ');
+    auto indent_string = std::u16string(indent + indent_incr, ' ');
     auto print_prop = [&](const auto& name, const auto& val, bool internal) {
         os << indent_string << name << ": ";
         mjs::debug_print(os, mjs::value{val}, indent_incr, max_nest > 1 && internal ? 1 : max_nest - 1, indent + indent_incr);
@@ -133,15 +160,15 @@ void object::debug_print(std::wostream& os, int indent_incr, int max_nest, int i
     os << "{\n";
     print_prop("[[Class]]", class_name(), true);
     print_prop("[[Prototype]]", prototype_ ? value{prototype_.track(heap())} : value::null, true);
-    for (auto& p: properties_.dereference(heap_)) {
-        const auto key = p.key(heap_).view();
-        print_prop(key, p.get(*this), key == L"constructor");
+    for (uint32_t index = 0, size = shape_.dereference(heap_).size(); index < size; ++index) {
+        const auto key = shape_.dereference(heap_).key(index);
+        print_prop(key.view(), get_at(index, *this), key.view() == u"constructor");
     }
     do_debug_print_extra(os, indent_incr, max_nest, indent+indent_incr);
-    os << std::wstring(indent, ' ') << "}";
+    os << std::u16string(indent, ' ') << "}";
 }
 
-bool object::can_put(const std::wstring_view& name) const {
+bool object::can_put(const std::u16string_view& name) const {
     auto a = own_property_attributes(name);
     if (is_valid(a)) {
         return !has_attributes(a, property_attribute::read_only);
@@ -152,14 +179,14 @@ bool object::can_put(const std::wstring_view& name) const {
     return prototype_.dereference(heap()).can_put(name);
 }
 
-value object::get(const std::wstring_view& name) const {
-    if (auto it = find(name).first) {
-        return it->get(*this);
+value object::get(const std::u16string_view& name) const {
+    if (auto index = find(name); index != object_shape::not_found) {
+        return get_at(index, *this);
     }
     for (auto p = prototype_; p; ) {
         auto& proto = p.dereference(heap());
-        if (auto it = proto.find(name).first) {
-            return it->get(*this);
+        if (auto index = proto.find(name); index != object_shape::not_found) {
+            return proto.get_at(index, *this);
         } else if (is_valid(proto.own_property_attributes(name))) {
             return proto.get(name);
         }
@@ -173,20 +200,20 @@ void object::put(const string& name, const value& val, property_attribute attr)
     //ES5.1, 8.12.5
 
     // See if there is already a property with this name
-    if (auto it = find(name.view()).first; it) {
-        if (has_attributes(it->attributes(), property_attribute::read_only)) {
+    if (auto index = find(name); index != object_shape::not_found) {
+        if (has_attributes(attributes_at(index), property_attribute::read_only)) {
             return;
         }
-        it->put(*this, val);
+        put_at(index, *this, val);
         return;
     }
 
     // Check if there is an accessor property in a prototype
     for (auto p = prototype_; p; ) {
         auto& proto = p.dereference(heap());
-        if (auto it = proto.find(name.view()).first) {
-            if (has_attributes(it->attributes(), property_attribute::accessor)) {
-                it->put(*this, val);
+        if (auto index = proto.find(name); index != object_shape::not_found) {
+            if (has_attributes(proto.attributes_at(index), property_attribute::accessor)) {
+                proto.put_at(index, *this, val);
                 return;
             }
             // Handle as insertion
@@ -197,60 +224,55 @@ void object::put(const string& name, const value& val, property_attribute attr)
 
     // Normal insertion
     if (extensible_) {
-        properties_.dereference(heap()).emplace_back(name, val, attr);
+        add_property(name, val, attr);
     }
 }
 
-bool object::delete_property(const std::wstring_view& name) {
-    auto [it, props] = find(name);
-    if (!it) {
+value object::get_element(uint32_t index) const {
+    return get(index_string(index));
+}
+
+void object::put_element(uint32_t index, const value& val) {
+    put(string{heap(), index_string(index)}, val);
+}
+
+bool object::delete_property(const std::u16string_view& name) {
+    const auto index = find(name);
+    if (index == object_shape::not_found) {
         return true;
 
     }
-    if (has_attributes(it->attributes(), property_attribute::dont_delete)) {
+    if (has_attributes(attributes_at(index), property_attribute::dont_delete)) {
         return false;
     }
-    props->erase(it);
+    remove_property(index);
     return true;
 }
 
-void object::property::fixup(gc_heap& h) {
-    key_.fixup(h);
-    value_.fixup(h);
-}
-
-value object::property::get(const object& self) const {
+value object::get_at(uint32_t index, const object& self) const {
     auto& h = self.heap();
-    auto v = raw_get(h);
-    if (is_accessor()) {
+    auto v = raw_get(index);
+    if (has_attributes(attributes_at(index), property_attribute::accessor)) {
         assert(v.type() == value_type::object);
         auto a = v.object_value();
-        auto g = a->get(L"get");
-        const bool strict = a->get(L"__strict__").boolean_value() && is_primitive_object(self);
+        auto g = a->get(u"get");
+        const bool strict = a->get(u"__strict__").boolean_value() && is_primitive_object(self);
         return g.type() != value_type::undefined ? call_function(g, strict ? self.internal_value() : value{h.unsafe_track(self)}, {}) : g;
     }
     return v;
 }
 
-value object::property::raw_get(gc_heap& heap) const {
-    return value_.get_value(heap);
-}
-
-void object::property::raw_put(const value& val) {
-    value_ = value_representation{val};
-}
-
-void object::property::put(const object& self, const value& val) {
-    assert(!has_attributes(attributes_, property_attribute::read_only));
-    if (is_accessor()) {
+void object::put_at(uint32_t index, const object& self, const value& val) {
+    assert(!has_attributes(attributes_at(index), property_attribute::read_only));
+    if (has_attributes(attributes_at(index), property_attribute::accessor)) {
         auto& h = self.heap();
-        auto a = value_.get_value(h).object_value();
-        auto s = a->get(L"set");
-        const bool strict = a->get(L"__strict__").boolean_value() && is_primitive_object(self);
+        auto a = raw_get(index).object_value();
+        auto s = a->get(u"set");
+        const bool strict = a->get(u"__strict__").boolean_value() && is_primitive_object(self);
         call_function(s, strict ? self.internal_value() : value{h.unsafe_track(self)}, {val});
     } else {
-        assert(val.type() != value_type::object || val.object_value()->class_name().view() != L"Accessor");
-        raw_put(val);
+        assert(val.type() != value_type::object || val.object_value()->class_name().view() != u"Accessor");
+        raw_put(index, val);
     }
 }
 
@@ -260,7 +282,7 @@ value object::internal_value() const {
 
 bool is_primitive_object(const object& o) {
     const auto class_name = o.class_name();
-    return class_name.view() == L"Number" || class_name.view() == L"String" || class_name.view() == L"Boolean";
+    return class_name.view() == u"Number" || class_name.view() == u"String" || class_name.view() == u"Boolean";
 }
 
 } // namespace mjs
@@ -5,6 +5,7 @@
 #include "value_representation.h"
 #include "property_attribute.h"
 #include "gc_vector.h"
+#include "object_shape.h"
 
 namespace mjs {
 
@@ -42,33 +43,39 @@ public:
     string class_name() const { return class_.track(heap_); }
 
     // [[Get]] (PropertyName)
-    virtual value get(const std::wstring_view& name) const;
+    virtual value get(const std::u16string_view& name) const;
 
     bool redefine_own_property(const string& name, const value& val, property_attribute attr) {
         return do_redefine_own_property(name, val, attr);
     }
 
-    void define_accessor_property(const string& name, const object_ptr& accessor, property_attribute attr);
+    void define_accessor_property(const string& name, const object_ptr& accessor, property_attribute attr) {
+        do_define_accessor_property(name, accessor, attr);
+    }
 
     // Note: Do not directly modify the returned object, use modify_accessor_object instead
-    object_ptr get_accessor_property_object(const std::wstring_view name);
+    object_ptr get_accessor_property_object(const std::u16string_view name);
 
-    void modify_accessor_object(const std::wstring_view name, const value& new_val, bool is_get);
+    void modify_accessor_object(const std::u16string_view name, const value& new_val, bool is_get);
 
     // [[Put]] (PropertyName, Value)
     virtual void put(const string& name, const value& val, property_attribute attr = property_attribute::none);
 
+    // [[Get]]/[[Put]] with the array index 'index' as the property name (objects with indexed storage avoid creating the name)
+    virtual value get_element(uint32_t index) const;
+    virtual void put_element(uint32_t index, const value& val);
+
     // [[CanPut]] (PropertyName)
-    bool can_put(const std::wstring_view& name) const;
+    bool can_put(const std::u16string_view& name) const;
 
     // [[HasProperty]] (PropertyName)
-    bool has_property(const std::wstring_view& name) const;
+    bool has_property(const std::u16string_view& name) const;
 
     // [[Delete]] (PropertyName)
-    virtual bool delete_property(const std::wstring_view& name);
+    virtual bool delete_property(const std::u16string_view& name);
 
     // Get attributes of own property, returns invalid if not found
-    property_attribute own_property_attributes(const std::wstring_view& name) const {
+    property_attribute own_property_attributes(const std::u16string_view& name) const {
         return do_own_property_attributes(name);
     }
 
@@ -79,6 +86,18 @@ public:
 
     virtual value internal_value() const;
 
+    // Layout of the own properties, shared with objects that got the same properties in the same order
+    const object_shape& shape() const { return shape_.dereference(heap_); }
+
+    // Direct access to the value of the own property at 'index' in shape(). Doesn't call accessors or check attributes.
+    value raw_get(uint32_t index) const {
+        return slots_.dereference(heap_)[index].get_value(heap_);
+    }
+
+    void raw_put(uint32_t index, const value& val) {
+        slots_.dereference(heap_)[index] = val;
+    }
+
     std::vector<string> enumerable_property_names() const;
     std::vector<string> own_property_names(bool check_enumerable) const;
 
@@ -93,58 +112,43 @@ protected:
     void fixup();
 
     virtual bool do_redefine_own_property(const string& name, const value& val, property_attribute attr);
-    virtual property_attribute do_own_property_attributes(const std::wstring_view& name) const;
+    virtual void do_define_accessor_property(const string& name, const object_ptr& accessor, property_attribute attr);
+    virtual property_attribute do_own_property_attributes(const std::u16string_view& name) const;
     virtual void add_own_property_names(std::vector<string>& names, bool check_enumerable) const;
     virtual void do_debug_print_extra(std::wostream& os, int indent_incr, int max_nest, int indent) const {
         (void)os; (void)indent_incr; (void)max_nest; (void)indent;
     }
 
 private:
-    class property {
-    public:
-        explicit property(const string& key, const mjs::value& v, property_attribute attr)
-            : key_{key.unsafe_raw_get()}
-            , attributes_{attr}
-            , value_{v} {
-        }
-
-        void fixup(gc_heap& h);
-        
-        bool is_accessor() const { return has_attributes(attributes_, property_attribute::accessor); }
-        
-        property_attribute attributes() const { return attributes_; }
-        void attributes(property_attribute a) { attributes_ = a; }
-
-        string key(gc_heap& h) const { return key_.track(h); }
-
-        value get(const object& self) const;
-        value raw_get(gc_heap& heap) const;
-        void put(const object& self, const value& val);
-        void raw_put(const value& val);
-
-        bool key_matches(gc_heap& h, const std::wstring_view k) { return key_.dereference(h).view() == k; }
-
-    private:
-        gc_heap_ptr_untracked<gc_string>    key_;
-        property_attribute                  attributes_;
-        value_representation                value_; // holds object with get/set methods if is_accessor()
-    };
-
-    gc_heap&                                   heap_;
-    gc_heap_ptr_untracked<gc_string>           class_;
-    gc_heap_ptr_untracked<object>              prototype_;
-    gc_heap_ptr_untracked<gc_vector<property>> properties_;
-    bool                                       extensible_;
-
-    std::pair<property*, gc_vector<property>*> find(const std::wstring_view key) const {
-        auto& props = properties_.dereference(heap_);
-        for (auto& p: props) {
-            if (p.key_matches(heap_, key)) {
-                return { &p, &props };
-            }
-        }
-        return {nullptr, &props};
+    gc_heap&                                               heap_;
+    gc_heap_ptr_untracked<gc_string>                       class_;
+    gc_heap_ptr_untracked<object>                          prototype_;
+    gc_heap_ptr_untracked<object_shape>                    shape_;
+    gc_heap_ptr_untracked<gc_vector<value_representation>> slots_;       // Property values in shape_ index order (created on demand)
+    mutable gc_heap_ptr_untracked<object_shape>            child_shape_; // Empty shape of objects with this object as their prototype (created on demand)
+    bool                                                   extensible_;
+
+    // Returns the index of the own property 'key' or object_shape::not_found
+    uint32_t find(const std::u16string_view key) const {
+        return shape_.dereference(heap_).find(key);
     }
+    uint32_t find(const string& key) const {
+        return shape_.dereference(heap_).find(key);
+    }
+
+    property_attribute attributes_at(uint32_t index) const {
+        return shape_.dereference(heap_).attributes(index);
+    }
+
+    // Get/put the value of the property at 'index' using 'self' as the this value for accessors
+    value get_at(uint32_t index, const object& self) const;
+    void put_at(uint32_t index, const object& self, const value& val);
+
+    void add_property(const string& name, const value& val, property_attribute attr);
+    void change_attributes(uint32_t index, property_attribute attr);
+    void remove_property(uint32_t index);
+
+    gc_heap_ptr<object_shape> empty_child_shape() const;
 };
 
 // Returns true if o is a Number, Boolean or String
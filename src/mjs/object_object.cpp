@@ -38,18 +38,18 @@ inline const value& get_arg(const std::vector<value>& args, int index) {
     return index < static_cast<int>(args.size()) ? args[index] : value::undefined;
 }
 
-bool has_own_property(const object_ptr& o, const std::wstring_view p) {
+bool has_own_property(const object_ptr& o, const std::u16string_view p) {
     return is_valid(o->own_property_attributes(p));
 }
 
 // ES5.1, 8.10
 
 bool is_accessor_descriptor(const object_ptr& desc) {
-    return has_own_property(desc, L"get") || has_own_property(desc, L"set");
+    return has_own_property(desc, u"get") || has_own_property(desc, u"set");
 }
 
 bool is_data_descriptor(const object_ptr& desc) {
-    return has_own_property(desc, L"value") || has_own_property(desc, L"writable");
+    return has_own_property(desc, u"value") || has_own_property(desc, u"writable");
 }
 
 bool is_generic_descriptor(const object_ptr& desc) {
@@ -58,9 +58,9 @@ bool is_generic_descriptor(const object_ptr& desc) {
 
 property_attribute attributes_from_descriptor(const object_ptr& desc) {
     auto a = property_attribute::none;
-    if (!to_boolean(desc->get(L"writable"))) a |= property_attribute::read_only;
-    if (!to_boolean(desc->get(L"enumerable"))) a |= property_attribute::dont_enum;
-    if (!to_boolean(desc->get(L"configurable"))) a |= property_attribute::dont_delete;
+    if (!to_boolean(desc->get(u"writable"))) a |= property_attribute::read_only;
+    if (!to_boolean(desc->get(u"enumerable"))) a |= property_attribute::dont_enum;
+    if (!to_boolean(desc->get(u"configurable"))) a |= property_attribute::dont_delete;
     return a;
 }
 
@@ -70,12 +70,12 @@ void define_accessor_property(const gc_heap_ptr<global_object>& global, const ob
 }
 
 void copy_accessor_methods(const object_ptr& dst, const object_ptr& src) {
-    assert(dst && src && src->class_name().view() == L"Accessor");
+    assert(dst && src && src->class_name().view() == u"Accessor");
     const auto& names = src->own_property_names(false);
     assert(names.size() == 3);
     for (const auto& p: names) {
-        assert(p.view() == L"get" || p.view() == L"set" || p.view() == L"__strict__");
-        if (p.view() == L"__strict__")continue;
+        assert(p.view() == u"get" || p.view() == u"set" || p.view() == u"__strict__");
+        if (p.view() == u"__strict__")continue;
         dst->put(p, src->get(p.view()));
     }
 }
@@ -91,7 +91,7 @@ define_own_property_result define_own_property(const gc_heap_ptr<global_object>&
     const auto current_attributes = o->own_property_attributes(p.view());
     const auto new_attributes = attributes_from_descriptor(desc);
 
-    if ((desc->has_property(L"get") || desc->has_property(L"set")) && (desc->has_property(L"value") || desc->has_property(L"writable"))) {
+    if ((desc->has_property(u"get") || desc->has_property(u"set")) && (desc->has_property(u"value") || desc->has_property(u"writable"))) {
         throw native_error_exception{native_error_type::type, global->stack_trace(), "Accessor property descriptor may not have value or writable attributes"};
     }
 
@@ -102,11 +102,11 @@ define_own_property_result define_own_property(const gc_heap_ptr<global_object>&
 
         // property not already present
         if (is_generic_descriptor(desc) || is_data_descriptor(desc)) {
-            o->put(p, desc->get(L"value"), new_attributes);
+            o->put(p, desc->get(u"value"), new_attributes);
             return define_own_property_result::ok;
         } else {
-            auto get = desc->get(L"get");
-            auto set = desc->get(L"set");
+            auto get = desc->get(u"get");
+            auto set = desc->get(u"set");
             assert(get.type() != value_type::undefined || set.type() != value_type::undefined); // Should be handle above
 
             auto check_accessor = [&](const char* name, const value v) {
@@ -124,14 +124,14 @@ define_own_property_result define_own_property(const gc_heap_ptr<global_object>&
     }
 
     // If descriptor is empty or all fields are equal
-    if (!has_own_property(desc, L"writable")
-        && !has_own_property(desc, L"enumerable")
-        && !has_own_property(desc, L"configurable")
-        && !has_own_property(desc, L"value")
-        && !has_own_property(desc, L"get")
-        && !has_own_property(desc, L"set")) {
+    if (!has_own_property(desc, u"writable")
+        && !has_own_property(desc, u"enumerable")
+        && !has_own_property(desc, u"configurable")
+        && !has_own_property(desc, u"value")
+        && !has_own_property(desc, u"get")
+        && !has_own_property(desc, u"set")) {
         return define_own_property_result::ok;
-    } else if (current_attributes == new_attributes && o->get(p.view()) == desc->get(L"value")) {
+    } else if (current_attributes == new_attributes && o->get(p.view()) == desc->get(u"value")) {
         return define_own_property_result::ok;
     }
 
@@ -142,7 +142,7 @@ define_own_property_result define_own_property(const gc_heap_ptr<global_object>&
             // Reject, if the [[Configurable]] field of Desc is true.
             return define_own_property_result::cannot_redefine;
         }
-        if (has_own_property(desc, L"enumerable") && has_attributes(current_attributes, property_attribute::dont_enum) != has_attributes(new_attributes, property_attribute::dont_enum)) {
+        if (has_own_property(desc, u"enumerable") && has_attributes(current_attributes, property_attribute::dont_enum) != has_attributes(new_attributes, property_attribute::dont_enum)) {
             // Reject, if the [[Enumerable]] field of Desc is present and the [[Enumerable]] fields of current and Desc are the Boolean negation of each other.
             return define_own_property_result::cannot_redefine;
         }
@@ -164,7 +164,7 @@ define_own_property_result define_own_property(const gc_heap_ptr<global_object>&
                     // 10.a.i
                     return define_own_property_result::cannot_redefine;
                 }
-                if (has_own_property(desc, L"value") && o->get(p.view()) != desc->get(L"value")) {
+                if (has_own_property(desc, u"value") && o->get(p.view()) != desc->get(u"value")) {
                     // 10.a.ii
                     return define_own_property_result::cannot_redefine;
                 }
@@ -175,7 +175,7 @@ define_own_property_result define_own_property(const gc_heap_ptr<global_object>&
     }
 
     property_attribute a = property_attribute::none;
-    auto apply_flag = [&](const wchar_t* name, property_attribute f) {
+    auto apply_flag = [&](const char16_t* name, property_attribute f) {
         if (desc->has_property(name)) {
             if (!to_boolean(desc->get(name))) {
                 a |= f;
@@ -185,26 +185,26 @@ define_own_property_result define_own_property(const gc_heap_ptr<global_object>&
         }
     };
 
-    apply_flag(L"enumerable", property_attribute::dont_enum);
-    apply_flag(L"configurable", property_attribute::dont_delete);
+    apply_flag(u"enumerable", property_attribute::dont_enum);
+    apply_flag(u"configurable", property_attribute::dont_delete);
     if (is_accessor_descriptor(desc) || (is_generic_descriptor(desc) && has_attributes(current_attributes, property_attribute::accessor))) {
-        auto g = desc->get(L"get");
-        auto s = desc->get(L"set");
+        auto g = desc->get(u"get");
+        auto s = desc->get(u"set");
         if (has_attributes(current_attributes, property_attribute::accessor)) {
             auto temp = o->get_accessor_property_object(p.view());
-            if (!desc->has_property(L"get")) {
-                if (temp->has_property(L"get")) {
-                    g = temp->get(L"get");
+            if (!desc->has_property(u"get")) {
+                if (temp->has_property(u"get")) {
+                    g = temp->get(u"get");
                 }
-            } else if (has_attributes(current_attributes, property_attribute::read_only) && g != temp->get(L"get")) {
+            } else if (has_attributes(current_attributes, property_attribute::read_only) && g != temp->get(u"get")) {
                 return define_own_property_result::cannot_redefine;
             }
 
             if (s.type() == value_type::undefined) {
-                if (temp->has_property(L"set")) {
-                    s = temp->get(L"set");
+                if (temp->has_property(u"set")) {
+                    s = temp->get(u"set");
                 }
-            } else if (has_attributes(current_attributes, property_attribute::read_only) && s != temp->get(L"set")) {
+            } else if (has_attributes(current_attributes, property_attribute::read_only) && s != temp->get(u"set")) {
                 return define_own_property_result::cannot_redefine;
             }
         }
@@ -212,8 +212,8 @@ define_own_property_result define_own_property(const gc_heap_ptr<global_object>&
         define_accessor_property(global, o, p, g, s, a);
         return define_own_property_result::ok;
     } else {
-        apply_flag(L"writable", property_attribute::read_only);
-        if (o->redefine_own_property(p, has_own_property(desc, L"value") ? desc->get(L"value") : o->get(p.view()), a)) {
+        apply_flag(u"writable", property_attribute::read_only);
+        if (o->redefine_own_property(p, has_own_property(desc, u"value") ? desc->get(u"value") : o->get(p.view()), a)) {
             return define_own_property_result::ok;
         } else {
             return define_own_property_result::cannot_redefine;
@@ -285,7 +285,7 @@ global_object_create_result make_object_object(const gc_heap_ptr<global_object>&
     if (global->language_version() >= version::es3) {
         put_native_function(global, prototype, "toLocaleString", [global](const value& this_, const std::vector<value>&) {
             auto o = global->to_object(this_);
-            return call_function(o->get(L"toString"), value{o}, {});
+            return call_function(o->get(u"toString"), value{o}, {});
         }, 0);
         put_native_function(global, prototype, "hasOwnProperty", [global](const value& this_, const std::vector<value>& args) {
             auto o = global->validate_object(this_);
@@ -398,7 +398,7 @@ global_object_create_result make_object_object(const gc_heap_ptr<global_object>&
 
         put_native_function(global, o, "create", [global](const value&, const std::vector<value>& args) {
             if (args.empty() || (args[0].type() != value_type::null && args[0].type() != value_type::object)) {
-                throw native_error_exception{native_error_type::type, global->stack_trace(), L"Invalid object prototype"};
+                throw native_error_exception{native_error_type::type, global->stack_trace(), u"Invalid object prototype"};
             }
             auto o = global->heap().make<object>(global->object_prototype()->class_name(), args[0].type() == value_type::object ? args[0].object_value() : nullptr);
             if (args.size() > 1) {
@@ -0,0 +1,136 @@
+#include "object_shape.h"
+
+namespace mjs {
+
+static_assert(gc_type_info_registration<object_shape>::needs_fixup);
+static_assert(!gc_type_info_registration<object_shape>::needs_destroy);
+
+uint64_t object_shape::next_id_ = 1;
+
+gc_heap_ptr<object_shape> object_shape::make_empty(gc_heap& h) {
+    return h.make<object_shape>(h);
+}
+
+gc_heap_ptr<object_shape> object_shape::add(const gc_heap_ptr<object_shape>& shape, const string& key, property_attribute attr) {
+    assert(is_valid(attr) && shape->find(key.view()) == not_found);
+    auto& h = shape.heap();
+    const auto atom = atom_table::of(h).intern(key);
+    if (shape->dictionary_ || shape->size_ >= max_shared_size) {
+        auto res = shape->dictionary_ ? shape : make_dictionary(shape);
+        res->dictionary_add(atom, attr);
+        return res;
+    }
+    if (!shape->transitions_) {
+        shape->transitions_ = gc_vector<transition>::make(h, 1);
+    } else {
+        auto& ts = shape->transitions_.dereference(h);
+        for (uint32_t i = 0; i < ts.length();) {
+            if (!ts[i]) {
+                // Forget shapes that are no longer used
+                ts.erase(i);
+                continue;
+            }
+            auto& t = ts[i].dereference(h);
+            if (t.attributes_ == attr && &t.key_.dereference(h) == atom.unsafe_raw_get().get()) {
+                return ts[i].track(h);
+            }
+            ++i;
+        }
+    }
+    auto ns = h.make<object_shape>(shape, atom, attr);
+    shape->transitions_.dereference(h).push_back(ns);
+    return ns;
+}
+
+gc_heap_ptr<object_shape> object_shape::remove(const gc_heap_ptr<object_shape>& shape, uint32_t index) {
+    assert(index < shape->size());
+    auto res = shape->dictionary_ ? shape : make_dictionary(shape);
+    res->properties_.dereference(res.heap()).erase(index);
+    --res->size_;
+    res->id_ = next_id_++;
+    // The indices of the following properties changed
+    res->rehash();
+    return res;
+}
+
+gc_heap_ptr<object_shape> object_shape::change_attributes(const gc_heap_ptr<object_shape>& shape, uint32_t index, property_attribute attr) {
+    assert(is_valid(attr));
+    if (shape->attributes(index) == attr) {
+        return shape;
+    }
+    auto res = shape->dictionary_ ? shape : make_dictionary(shape);
+    res->properties_.dereference(res.heap())[index].attributes = attr;
+    res->id_ = next_id_++;
+    return res;
+}
+
+gc_heap_ptr<object_shape> object_shape::make_dictionary(const gc_heap_ptr<object_shape>& shape) {
+    assert(!shape->dictionary_);
+    auto& h = shape.heap();
+    auto props = gc_vector<property>::make(h, std::max(shape->size_, 4U));
+    shape->for_each_property([&](const string& key, property_attribute attr) {
+        props->push_back(property{key.unsafe_raw_get(), attr});
+    });
+    auto res = h.make<object_shape>(h);
+    res->dictionary_ = true;
+    res->size_ = shape->size_;
+    res->properties_ = props;
+    res->rehash();
+    return res;
+}
+
+uint32_t object_shape::dictionary_find(const gc_string& atom) const {
+    auto& buckets = buckets_.dereference(heap_);
+    auto& props = properties_.dereference(heap_);
+    const auto mask = buckets.length() - 1;
+    for (uint32_t i = atom.hash() & mask; buckets[i]; i = (i + 1) & mask) {
+        if (&props[buckets[i] - 1].key.dereference(heap_) == &atom) {
+            return buckets[i] - 1;
+        }
+    }
+    return not_found;
+}
+
+void object_shape::dictionary_add(const string& atom, property_attribute attr) {
+    assert(dictionary_);
+    properties_.dereference(heap_).push_back(property{atom.unsafe_raw_get(), attr});
+    ++size_;
+    id_ = next_id_++;
+    // Keep the table at most half full
+    if (size_ * 2 > buckets_.dereference(heap_).length()) {
+        rehash();
+    } else {
+        insert_bucket(size_ - 1);
+    }
+}
+
+void object_shape::insert_bucket(uint32_t index) {
+    auto& buckets = buckets_.dereference(heap_);
+    const auto mask = buckets.length() - 1;
+    uint32_t i = properties_.dereference(heap_)[index].key.dereference(heap_).hash() & mask;
+    while (buckets[i]) {
+        i = (i + 1) & mask;
+    }
+    buckets[i] = index + 1;
+}
+
+void object_shape::rehash() {
+    uint32_t capacity = 8;
+    while (capacity < size_ * 2) {
+        capacity *= 2;
+    }
+    if (buckets_ && buckets_.dereference(heap_).length() >= capacity) {
+        // Reuse the table (it isn't shrunk after deleting properties)
+        auto& buckets = buckets_.dereference(heap_);
+        std::fill(buckets.begin(), buckets.end(), 0);
+    } else {
+        auto buckets = gc_vector<uint32_t>::make(heap_, capacity);
+        buckets->resize(capacity);
+        buckets_ = buckets;
+    }
+    for (uint32_t i = 0; i < size_; ++i) {
+        insert_bucket(i);
+    }
+}
+
+} // namespace mjs
@@ -0,0 +1,165 @@
+#ifndef MJS_OBJECT_SHAPE_H
+#define MJS_OBJECT_SHAPE_H
+
+#include <vector>
+#include "string.h"
+#include "property_attribute.h"
+#include "gc_vector.h"
+
+namespace mjs {
+
+//
+// Describes the property layout of an object (a "hidden class"): the names and attributes of its own properties and
+// their index in the object's slot array.
+//
+// A shape is immutable and adds one property (with index size()-1) to its parent. Shapes remember (weakly) the shapes
+// that were derived from them, so objects that get the same properties in the same order end up sharing one shape.
+//
+// Deleting a property, changing its attributes or adding more than max_shared_size properties switches the object to
+// a dictionary shape instead: a hash table owned by that object alone, which is changed in place (getting a new id).
+//
+class object_shape {
+public:
+    friend gc_type_info_registration<object_shape>;
+
+    static constexpr uint32_t not_found = UINT32_MAX;
+
+    // Objects with more properties than this get a dictionary shape
+    static constexpr uint32_t max_shared_size = 64;
+
+    static gc_heap_ptr<object_shape> make_empty(gc_heap& h);
+
+    // Identifies the shape for its entire lifetime (never reused, unlike its position in the heap)
+    uint64_t id() const { return id_; }
+
+    // Number of properties described
+    uint32_t size() const { return size_; }
+
+    // Does the shape belong to a single object? (see above)
+    bool is_dictionary() const { return dictionary_; }
+
+    // Returns the index of the property named 'key' or not_found
+    uint32_t find(const std::u16string_view key) const {
+        if (!size_) {
+            return not_found;
+        }
+        const auto atom = atom_table::of(heap_).find(key);
+        return atom ? find(*atom) : not_found;
+    }
+
+    // Returns the index of the property named 'key' or not_found (without widening one-byte strings)
+    uint32_t find(const string& key) const {
+        if (!size_) {
+            return not_found;
+        }
+        const auto atom = atom_table::of(heap_).find(*key.unsafe_raw_get());
+        return atom ? find(*atom) : not_found;
+    }
+
+    // Returns the index of the property with the name 'atom' (see atom_table) or not_found
+    uint32_t find(const gc_string& atom) const {
+        if (dictionary_) {
+            return dictionary_find(atom);
+        }
+        for (const object_shape* s = this; s->size_; s = &s->parent_.dereference(heap_)) {
+            if (&s->key_.dereference(heap_) == &atom) {
+                return s->size_ - 1;
+            }
+        }
+        return not_found;
+    }
+
+    string key(uint32_t index) const { return dictionary_ ? dictionary_at(index).key.track(heap_) : at(index).key_.track(heap_); }
+    property_attribute attributes(uint32_t index) const { return dictionary_ ? dictionary_at(index).attributes : at(index).attributes_; }
+
+    // Calls f(key, attributes) for each property in index order
+    template<typename F>
+    void for_each_property(F f) const {
+        if (dictionary_) {
+            for (const auto& p: properties_.dereference(heap_)) {
+                f(p.key.track(heap_), p.attributes);
+            }
+            return;
+        }
+        std::vector<const object_shape*> path(size_);
+        for (const object_shape* s = this; s->size_; s = &s->parent_.dereference(heap_)) {
+            path[s->size_ - 1] = s;
+        }
+        for (const auto s: path) {
+            f(s->key_.track(heap_), s->attributes_);
+        }
+    }
+
+    // Returns the shape with 'key' added as the last property (a dictionary shape is changed and returned)
+    static gc_heap_ptr<object_shape> add(const gc_heap_ptr<object_shape>& shape, const string& key, property_attribute attr);
+
+    // Returns the dictionary shape with the property at 'index' removed (the properties after it move down one index)
+    static gc_heap_ptr<object_shape> remove(const gc_heap_ptr<object_shape>& shape, uint32_t index);
+
+    // Returns the dictionary shape with the attributes of the property at 'index' changed
+    static gc_heap_ptr<object_shape> change_attributes(const gc_heap_ptr<object_shape>& shape, uint32_t index, property_attribute attr);
+
+private:
+    using transition = gc_heap_weak_ptr_untracked<object_shape>;
+
+    struct property {
+        gc_heap_ptr_untracked<gc_string> key; // Atom
+        property_attribute               attributes;
+
+        void fixup(gc_heap& h) {
+            key.fixup(h);
+        }
+    };
+
+    gc_heap&                                     heap_;
+    uint64_t                                     id_;
+    gc_heap_ptr_untracked<object_shape>          parent_;
+    gc_heap_ptr_untracked<gc_string>             key_; // Atom
+    property_attribute                           attributes_;
+    uint32_t                                     size_;
+    gc_heap_ptr_untracked<gc_vector<transition>> transitions_; // Created on demand
+    bool                                         dictionary_ = false;
+    gc_heap_ptr_untracked<gc_vector<property>>   properties_; // Dictionary shapes: the properties in index order
+    gc_heap_ptr_untracked<gc_vector<uint32_t>>   buckets_;    // Dictionary shapes: hash table (linear probing) of property index + 1 (0 if unused)
+
+    static uint64_t next_id_;
+
+    explicit object_shape(gc_heap& h) : heap_(h), id_(next_id_++), attributes_(property_attribute::none), size_(0) {}
+    explicit object_shape(const gc_heap_ptr<object_shape>& parent, const string& key, property_attribute attr)
+        : heap_(parent.heap()), id_(next_id_++), parent_(parent), key_(key.unsafe_raw_get()), attributes_(attr), size_(parent->size_ + 1) {}
+    object_shape(object_shape&&) = default;
+
+    const object_shape& at(uint32_t index) const {
+        assert(index < size_);
+        const object_shape* s = this;
+        while (s->size_ != index + 1) {
+            s = &s->parent_.dereference(heap_);
+        }
+        return *s;
+    }
+
+    const property& dictionary_at(uint32_t index) const {
+        assert(dictionary_ && index < size_);
+        return properties_.dereference(heap_)[index];
+    }
+
+    // Returns a new dictionary shape with the properties of 'shape'
+    static gc_heap_ptr<object_shape> make_dictionary(const gc_heap_ptr<object_shape>& shape);
+
+    uint32_t dictionary_find(const gc_string& atom) const;
+    void dictionary_add(const string& atom, property_attribute attr);
+    void insert_bucket(uint32_t index);
+    void rehash();
+
+    void fixup() {
+        parent_.fixup(heap_);
+        key_.fixup(heap_);
+        transitions_.fixup(heap_);
+        properties_.fixup(heap_);
+        buckets_.fixup(heap_);
+    }
+};
+
+} // namespace mjs
+
+#endif
@@ -13,7 +13,7 @@
 #define UNHANDLED() unhandled(__FUNCTION__, __LINE__)
 #define EXPECT(tt) expect(tt, __FUNCTION__, __LINE__)
 #define EXPECT_SEMICOLON_ALLOW_INSERTION() expect_semicolon_allow_insertion(__FUNCTION__, __LINE__)
-#define SYNTAX_ERROR_AT(expr, pos) do { std::wostringstream _oss; _oss << expr; syntax_error(__FUNCTION__, __LINE__, pos, _oss.str()); } while (0)
+#define SYNTAX_ERROR_AT(expr, pos) do { std::wostringstream _oss; _oss << expr; syntax_error(__FUNCTION__, __LINE__, pos, to_u16string(_oss.str())); } while (0)
 #define SYNTAX_ERROR(expr) SYNTAX_ERROR_AT(expr, current_extend())
 
 namespace mjs {
@@ -35,14 +35,14 @@ constexpr bool is_reserved(token_type t, version v) {
            throw std::logic_error{"Invalid version"};
 }
 
-std::wstring token_string(token_type t) {
+std::u16string token_string(token_type t) {
     assert(!is_literal(t));
     std::wostringstream woss;
     woss << t;
-    return woss.str();
+    return to_u16string(woss.str());
 }
 
-source_position calc_source_position(const std::wstring_view& t, uint32_t start_pos, uint32_t end_pos, const source_position& start) {
+source_position calc_source_position(const std::u16string_view& t, uint32_t start_pos, uint32_t end_pos, const source_position& start) {
     assert(start_pos <= t.size() && end_pos <= t.size() && start_pos <= end_pos);
     int cr = start.line-1, lf = start.line-1;
     int column = start.column-1;
@@ -58,7 +58,7 @@ source_position calc_source_position(const std::wstring_view& t, uint32_t start_
     return {1 + std::max(cr, lf), 1 + column};
 }
 
-std::pair<source_position, source_position> extend_to_positions(const std::wstring_view& t, uint32_t start_pos, uint32_t end_pos) {
+std::pair<source_position, source_position> extend_to_positions(const std::u16string_view& t, uint32_t start_pos, uint32_t end_pos) {
     auto start = calc_source_position(t, 0, start_pos, {1,1});
     auto end = calc_source_position(t, start_pos, end_pos, start);
     return {start, end};
@@ -125,27 +125,34 @@ bool is_right_to_left(token_type tt) {
     return operator_precedence(tt) >= assignment_precedence; // HACK
 }
 
-function_base::function_base(const source_extend& body_extend, const std::wstring& id, std::vector<std::wstring>&& params, statement_ptr&& block) : body_extend_(body_extend), id_(id), params_(std::move(params)) {
+function_base::function_base(const source_extend& body_extend, const std::u16string& id, std::vector<std::u16string>&& params, statement_ptr&& block, bool may_use_arguments) {
     assert(block && block->type() == statement_type::block);
-    block_.reset(static_cast<block_statement*>(block.release()));
+    auto i = std::make_shared<info>();
+    i->body_extend = body_extend;
+    i->id = id;
+    i->params = std::move(params);
+    i->block.reset(static_cast<block_statement*>(block.release()));
+    i->declarations = hoisted_declarations::scan(*i->block);
+    i->may_use_arguments = may_use_arguments;
+    info_ = std::move(i);
 }
 
 bool function_base::strict_mode() const {
-    return block_->strict_mode();
+    return info_->block->strict_mode();
 }
 
 void function_base::base_print(std::wostream& os) const {
     os << "{";
-    if (!id_.empty()) os << id_ << ", ";
+    if (!id().empty()) os << id() << ", ";
     os << "[";
-    for (size_t i = 0; i < params_.size(); ++i) {
+    for (size_t i = 0; i < params().size(); ++i) {
         if (i) os << ", ";
-        os << params_[i];
+        os << params()[i];
     }
-    os << "], " << *block_ << "}";
+    os << "], " << block() << "}";
 }
 
-std::wstring property_name_string(const expression& e) {
+std::u16string property_name_string(const expression& e) {
     assert(is_valid_property_name_expression(e));
     if (e.type() == expression_type::identifier) {
         return static_cast<const identifier_expression&>(e).id();
@@ -164,7 +171,7 @@ std::wstring property_name_string(const expression& e) {
 
 // See ES5.1, 10.1.1 and 14.1. The directive can only occur as the first statement in a function/global scope/eval
 
-const wchar_t strict_directive[] = L"use strict";
+const char16_t strict_directive[] = u"use strict";
 
 bool is_directive(const expression& e) {
     if (e.type() != expression_type::literal) {
@@ -196,12 +203,12 @@ bool is_strict_mode_directive(const expression& e) {
 
 constexpr bool is_octal_char(char16_t ch) { return ch >= '0' && ch <= '7'; }
 
-bool is_octal_literal(const std::wstring_view s) {
+bool is_octal_literal(const std::u16string_view s) {
     assert(s.length() > 0);
     return s.length() > 1 && s[0] == '0' && is_octal_char(s[1]);
 }
 
-bool has_octal_escape_sequence(const std::wstring_view s) {
+bool has_octal_escape_sequence(const std::u16string_view s) {
     bool quote = false;
     for (const auto& ch: s) {
         if (quote) {
@@ -216,8 +223,8 @@ bool has_octal_escape_sequence(const std::wstring_view s) {
     return false;
 }
 
-bool is_strict_mode_unassignable_identifier(const std::wstring_view name) {
-    return name == L"eval" || name == L"arguments";
+bool is_strict_mode_unassignable_identifier(const std::u16string_view name) {
+    return name == u"eval" || name == u"arguments";
 }
 
 bool is_strict_mode_unassignable_identifier(const expression& e) {
@@ -305,6 +312,7 @@ private:
     lexer lexer_;
     bool strict_mode_;
     bool skip_strict_checks_for_first_function_;
+    bool may_use_arguments_ = false; // For the function currently being parsed (see function_base::may_use_arguments)
     uint32_t token_start_ = 0;
     position_stack_node* expression_pos_ = nullptr;
     position_stack_node* statement_pos_ = nullptr;
@@ -442,7 +450,7 @@ private:
         }
     }
 
-    std::wstring get_identifier_name(const char* func, int line);
+    std::u16string get_identifier_name(const char* func, int line);
     expression_ptr parse_identifier_name(const char* func, int line);
     expression_ptr parse_property_name();
     property_name_and_value parse_property_name_and_value();
@@ -456,6 +464,9 @@ private:
         //  ObjectLiteral
         //  ( Expression )
         if (auto id = accept(token_type::identifier)) {
+            if (id.text() == u"arguments" || id.text() == u"eval") {
+                may_use_arguments_ = true;
+            }
             return make_expression<identifier_expression>(id.text());
         } else if (accept(token_type::this_)) {
             return make_expression<this_expression>();
@@ -529,7 +540,7 @@ private:
             assert(lit.size() >= 3);
             assert(lit[0] == '/');
             const auto lit_end = lit.find_last_of('/');
-            assert(lit_end > 1 && lit_end != std::wstring_view::npos);
+            assert(lit_end > 1 && lit_end != std::u16string_view::npos);
             return make_expression<regexp_literal_expression>(lit.substr(1, lit_end-1), lit.substr(lit_end+1));
         } else if (accept(token_type::lparen)) {
             auto e = parse_expression();
@@ -646,7 +657,7 @@ private:
     auto parse_function() {
         const auto body_start = lexer_.text_position() - 1;
         EXPECT(token_type::lparen);
-        std::vector<std::wstring> params;
+        std::vector<std::u16string> params;
         std::vector<source_extend> param_extends;
         if (!accept(token_type::rparen)) {
             do {
@@ -656,8 +667,12 @@ private:
             EXPECT(token_type::rparen);
         }
         scoped_strict_mode ssm{*this};   // Make sure state is restored afterwards
+        const bool outer_may_use_arguments = may_use_arguments_;
+        may_use_arguments_ = false;
         auto block = parse_block(version_ >= version::es5);
         const auto body_end = block->extend().end;
+        const bool may_use_arguments = may_use_arguments_;
+        may_use_arguments_ = outer_may_use_arguments;
 
         assert(block->type() == statement_type::block);
         if (static_cast<const block_statement&>(*block).strict_mode() && !skip_strict_checks_for_first_function_) {
@@ -673,10 +688,10 @@ private:
         }
         skip_strict_checks_for_first_function_ = false;
 
-        return std::make_tuple(source_extend{source_, body_start, body_end}, std::move(params), std::move(block));
+        return std::make_tuple(source_extend{source_, body_start, body_end}, std::move(params), std::move(block), may_use_arguments);
     }
 
-    void check_function_name(const std::wstring_view id, const source_extend& extend) {
+    void check_function_name(const std::u16string_view id, const source_extend& extend) {
         if (is_strict_mode_unassignable_identifier(id)) {
             SYNTAX_ERROR_AT("\"" << cpp_quote(id) << "\" may not be used as a function name in strict mode", extend);
         }
@@ -698,17 +713,17 @@ private:
             }
             me = make_expression<prefix_expression>(token_type::new_, std::move(e));
         } else if (version_ >= version::es3 && accept(token_type::function_)) {
-            std::wstring id{};
+            std::u16string id{};
             const auto id_extend = current_extend();
             if (auto id_token = accept(token_type::identifier)) {
                 id = id_token.text();
             }
-            auto [extend, params, block] = parse_function();
+            auto [extend, params, block, may_use_arguments] = parse_function();
             assert(block->type() == statement_type::block);
             if (static_cast<const block_statement&>(*block).strict_mode()) {
                 check_function_name(id, id_extend);
             }
-            return make_expression<function_expression>(extend, id, std::move(params), std::move(block));
+            return make_expression<function_expression>(extend, id, std::move(params), std::move(block), may_use_arguments);
         } else {
             me = parse_primary_expression();
         }
@@ -813,14 +828,14 @@ private:
         return l;
     }
 
-    std::wstring get_label() {
+    std::u16string get_label() {
         // no line break before
         if (version_ >= version::es3 && !line_break_skipped_) {
             if (auto t = accept(token_type::identifier)) {
                 return t.text();
             }
         }
-        return L"";
+        return u"";
     }
 
     statement_ptr parse_statement(bool check_for_strict_mode = false) {
@@ -846,12 +861,12 @@ private:
         } else if (accept(token_type::function_)) {
             const auto id_extend = current_extend();
             auto id = EXPECT(token_type::identifier).text();
-            auto [extend, params, block] = parse_function();
+            auto [extend, params, block, may_use_arguments] = parse_function();
             assert(block->type() == statement_type::block);
             if (static_cast<const block_statement&>(*block).strict_mode()) {
                 check_function_name(id, id_extend);
             }
-            return make_statement<function_definition>(extend, id, std::move(params), std::move(block));
+            return make_statement<function_definition>(extend, id, std::move(params), std::move(block), may_use_arguments);
         } else if (accept(token_type::var_)) {
             auto dl = parse_variable_declaration_list();
             EXPECT_SEMICOLON_ALLOW_INSERTION();
@@ -938,6 +953,7 @@ private:
             EXPECT(token_type::lparen);
             auto e = parse_expression();
             EXPECT(token_type::rparen);
+            may_use_arguments_ = true;
             return make_statement<with_statement>(std::move(e), parse_statement());
         } else if (/*version_ >= version::es3 && */accept(token_type::switch_)) {
             EXPECT(token_type::lparen);
@@ -986,7 +1002,7 @@ private:
         } else if (/*version_ >= version::es3 && */accept(token_type::try_)) {
             auto block = parse_block();
             statement_ptr catch_{}, finally_{};
-            std::wstring catch_id;
+            std::u16string catch_id;
             if (accept(token_type::catch_)) {
                 EXPECT(token_type::lparen);
                 if (strict_mode_ && current_token_type() == token_type::identifier) {
@@ -1033,14 +1049,14 @@ private:
         throw std::runtime_error(oss.str());
     }
 
-    [[noreturn]] static void syntax_error(const char* function, int line, const source_extend& extend, const std::wstring_view message) {
+    [[noreturn]] static void syntax_error(const char* function, int line, const source_extend& extend, const std::u16string_view message) {
         std::wostringstream oss;
         oss << "Syntax error in " << function  << " line " << line << " at \"" << cpp_quote(extend.source_view()) << "\": " << message;
-        throw std::runtime_error(unicode::utf16_to_utf8(oss.str()));
+        throw std::runtime_error(unicode::utf16_to_utf8(to_u16string(oss.str())));
     }
 };
 
-std::wstring parser::get_identifier_name(const char* func, int line) {
+std::u16string parser::get_identifier_name(const char* func, int line) {
     if (auto id = accept(token_type::identifier)) {
         return id.text();
     } else if (version_ >= version::es5) {
@@ -1087,17 +1103,17 @@ property_name_and_value parser::parse_property_name_and_value() {
         // get/set i.e. accessor properties
         if (version_ >= version::es5 && current_token_type() != token_type::colon && p->type() == expression_type::identifier) {
             const auto& p_id = static_cast<const identifier_expression&>(*p).id();
-            const bool is_get = p_id == L"get";
-            if (is_get || p_id == L"set") {
+            const bool is_get = p_id == u"get";
+            if (is_get || p_id == u"set") {
                 auto new_p = parse_property_name();
-                const auto id = p_id + L" " + property_name_string(*new_p);
-                auto [extend, params, block] = parse_function();
+                const auto id = p_id + u" " + property_name_string(*new_p);
+                auto [extend, params, block, may_use_arguments] = parse_function();
                 const size_t expected_args = is_get ? 0 : 1;
                 if (expected_args != params.size()) {
                     SYNTAX_ERROR("Wrong number of arguments to " << p_id << " " << params.size() << " expected " << expected_args);
                 }
 
-                auto f = make_expression<function_expression>(extend, id, std::move(params), std::move(block));
+                auto f = make_expression<function_expression>(extend, id, std::move(params), std::move(block), may_use_arguments);
                 return property_name_and_value{is_get ? property_assignment_type::get : property_assignment_type::set, std::move(new_p), std::move(f)};
             }
         }
@@ -1106,6 +1122,113 @@ property_name_and_value parser::parse_property_name_and_value() {
     return property_name_and_value{property_assignment_type::normal, std::move(p), parse_assignment_expression()};
 }
 
+namespace {
+
+class hoisting_visitor {
+public:
+    explicit hoisting_visitor(hoisted_declarations& result) : ids_(result.ids), funcs_(result.functions) {}
+
+    void operator()(const block_statement& s) {
+        for (const auto& bs: s.l()) {
+            accept(*bs, *this);
+        }
+    }
+
+    void operator()(const variable_statement& s) {
+        for (const auto& d: s.l()) {
+            ids_.push_back(d.id());
+        }
+    }
+
+    void operator()(const debugger_statement&) {}
+
+    void operator()(const empty_statement&) {}
+
+    void operator()(const expression_statement&){}
+
+    void operator()(const if_statement& s) {
+        accept(s.if_s(), *this);
+        if (auto e = s.else_s()) {
+            accept(*e, *this);
+        }
+    }
+
+    void operator()(const do_statement& s) {
+        accept(s.s(), *this);
+    }
+
+    void operator()(const while_statement& s) {
+        accept(s.s(), *this);
+    }
+
+    void operator()(const for_statement& s) {
+        if (s.init()) accept(*s.init(), *this);
+        accept(s.s(), *this);
+    }
+
+    void operator()(const for_in_statement& s) {
+        accept(s.init(), *this);
+        accept(s.s(), *this);
+    }
+
+    void operator()(const continue_statement&) {}
+    void operator()(const break_statement&) {}
+    void operator()(const return_statement&) {}
+    void operator()(const with_statement& s) {
+        accept(s.s(), *this);
+    }
+
+    void operator()(const labelled_statement& s) {
+        accept(s.s(), *this);
+    }
+
+    void operator()(const switch_statement& s) {
+        for (const auto& c: s.cl()) {
+            for (const auto& cs: c.sl()) {
+                accept(*cs, *this);
+            }
+        }
+    }
+
+    void operator()(const try_statement& s) {
+        accept(s.block(), *this);
+        if (auto c = s.catch_block()) {
+            accept(*c, *this);
+        }
+        if (auto f = s.finally_block()) {
+            accept(*f, *this);
+        }
+    }
+
+    void operator()(const throw_statement&) {}
+
+    void operator()(const function_definition& f) {
+        assert(!f.id().empty());
+        // For functions it's important that we start out by registering the first encutered definition
+        if (std::find(ids_.begin(), ids_.end(), f.id()) == ids_.end()) {
+            ids_.push_back(f.id());
+            funcs_.push_back(&f);
+        }
+    }
+
+    void operator()(const statement&) {
+        throw std::runtime_error("Unhandled statement type in hoisting_visitor");
+    }
+
+private:
+    std::vector<std::u16string>& ids_;
+    std::vector<const function_definition*>& funcs_;
+};
+
+} // unnamed namespace
+
+hoisted_declarations hoisted_declarations::scan(const statement& s) {
+    hoisted_declarations res;
+    hoisting_visitor hv{res};
+    accept(s, hv);
+    return res;
+}
+
 std::unique_ptr<block_statement> parse(const std::shared_ptr<source_file>& source, parse_mode mode) {
     return parser{source, mode}.parse();
 }
@@ -27,24 +27,24 @@ struct source_position {
     }
 };
 
-std::pair<source_position, source_position> extend_to_positions(const std::wstring_view& t, uint32_t start, uint32_t end);
+std::pair<source_position, source_position> extend_to_positions(const std::u16string_view& t, uint32_t start, uint32_t end);
 
 class source_file {
 public:
-    explicit source_file(const std::wstring_view& filename, const std::wstring_view& text, version ver)
+    explicit source_file(const std::u16string_view& filename, const std::u16string_view& text, version ver)
         : ver_(ver)
         , filename_(filename)
         , text_(ver == version::es3 ? strip_format_control_characters(text) : text) {
     }
 
     version language_version() const { return ver_; }
-    std::wstring_view filename() const { return filename_; }
-    std::wstring_view text() const { return text_; }
+    std::u16string_view filename() const { return filename_; }
+    std::u16string_view text() const { return text_; }
 
 private:
     version ver_;
-    std::wstring filename_;
-    std::wstring text_;
+    std::u16string filename_;
+    std::u16string text_;
 };
 
 struct source_extend {
@@ -52,8 +52,8 @@ struct source_extend {
     uint32_t start;
     uint32_t end;
 
-    std::wstring_view source_view() const {
-        return std::wstring_view(file->text().data() + start, end - start);
+    std::u16string_view source_view() const {
+        return std::u16string_view(file->text().data() + start, end - start);
     }
 
     bool operator==(const source_extend& rhs) const {
@@ -162,14 +162,14 @@ using statement_list = std::vector<statement_ptr>;
 
 class identifier_expression : public expression {
 public:
-    explicit identifier_expression(const source_extend& extend, const std::wstring& id) : expression(extend), id_(id) {}
+    explicit identifier_expression(const source_extend& extend, const std::u16string& id) : expression(extend), id_(id) {}
 
     expression_type type() const override { return expression_type::identifier; }
 
-    const std::wstring& id() const { return id_; }
+    const std::u16string& id() const { return id_; }
 
 private:
-    std::wstring id_;
+    std::u16string id_;
 
     void print(std::wostream& os) const override {
         os << "identifier_expression{" << id_ << "}";
@@ -250,7 +250,7 @@ inline bool is_valid_property_name_expression(const expression& e) {
 }
 #endif
 
-std::wstring property_name_string(const expression& e);
+std::u16string property_name_string(const expression& e);
 
 class property_name_and_value {
 public:
@@ -264,7 +264,7 @@ public:
     }
     property_assignment_type type() const { return type_; }
     const expression& name() const { return *name_; }
-    std::wstring name_str() const { return property_name_string(name()); }
+    std::u16string name_str() const { return property_name_string(name()); }
     const expression& value() const { return *value_; }
 private:
     property_assignment_type type_;
@@ -299,7 +299,7 @@ private:
 
 class regexp_literal_expression : public expression {
 public:
-    explicit regexp_literal_expression(const source_extend& extend, std::wstring_view pattern, std::wstring_view flags) : expression(extend), re_(pattern, flags) {
+    explicit regexp_literal_expression(const source_extend& extend, std::u16string_view pattern, std::u16string_view flags) : expression(extend), re_(pattern, flags) {
     }
 
     expression_type type() const override { return expression_type::regexp_literal; }
@@ -429,30 +429,50 @@ private:
 };
 
 class block_statement;
+class function_definition;
+
+// Variable and function declarations of a program or function body (they're hoisted to the top of its scope)
+struct hoisted_declarations {
+    std::vector<std::u16string> ids;                   // Names of variables and functions in order of appearance (may contain duplicates)
+    std::vector<const function_definition*> functions; // The first definition of each function name
+
+    static hoisted_declarations scan(const statement& s);
+};
+
 class function_base {
 public:
-    const source_extend& body_extend() const { return body_extend_; }
-    const std::wstring& id() const { return id_; }
-    const std::vector<std::wstring>& params() const { return params_; }
-    const block_statement& block() const { return *block_; }
-    const std::shared_ptr<block_statement>& block_ptr() const { return block_; }
+    // What's needed to create and call the function. Computed once when parsing and shared by the function objects
+    // created from the definition (which may outlive the rest of the syntax tree).
+    struct info {
+        source_extend body_extend;
+        std::u16string id;
+        std::vector<std::u16string> params;
+        std::shared_ptr<block_statement> block;
+        hoisted_declarations declarations; // Of the body
+        bool may_use_arguments;            // False if the body can't observe the arguments object (doesn't mention 'arguments' or 'eval' and has no with statements)
+    };
+
+    const source_extend& body_extend() const { return info_->body_extend; }
+    const std::u16string& id() const { return info_->id; }
+    const std::vector<std::u16string>& params() const { return info_->params; }
+    const block_statement& block() const { return *info_->block; }
+    const std::shared_ptr<block_statement>& block_ptr() const { return info_->block; }
     bool strict_mode() const;
+    bool may_use_arguments() const { return info_->may_use_arguments; }
+    const std::shared_ptr<const info>& shared_info() const { return info_; }
 
 protected:
-    explicit function_base(const source_extend& body_extend, const std::wstring& id, std::vector<std::wstring>&& params, statement_ptr&& block);
+    explicit function_base(const source_extend& body_extend, const std::u16string& id, std::vector<std::u16string>&& params, statement_ptr&& block, bool may_use_arguments);
 
     void base_print(std::wostream& os) const;
 
 private:
-    source_extend body_extend_;
-    std::wstring id_;
-    std::vector<std::wstring> params_;
-    std::shared_ptr<block_statement> block_;
+    std::shared_ptr<const info> info_;
 };
 
 class function_expression : public expression, public function_base {
 public:
-    explicit function_expression(const source_extend& extend, const source_extend& body_extend, const std::wstring& id, std::vector<std::wstring>&& params, statement_ptr&& block) : expression(extend), function_base(body_extend, id, std::move(params), std::move(block)) {
+    explicit function_expression(const source_extend& extend, const source_extend& body_extend, const std::u16string& id, std::vector<std::u16string>&& params, statement_ptr&& block, bool may_use_arguments) : expression(extend), function_base(body_extend, id, std::move(params), std::move(block), may_use_arguments) {
     }
 
     expression_type type() const override { return expression_type::function; }
@@ -516,11 +536,11 @@ class declaration {
 public:
     using list = std::vector<declaration>;
 
-    explicit declaration(const std::wstring& id, expression_ptr&& init) : id_(id), init_(std::move(init)) {
+    explicit declaration(const std::u16string& id, expression_ptr&& init) : id_(id), init_(std::move(init)) {
         assert(!id.empty() || init_);
     }
 
-    const std::wstring& id() const { return id_;}
+    const std::u16string& id() const { return id_;}
 
     const expression* init() const { return init_.get(); }
 
@@ -538,7 +558,7 @@ public:
     }
 
 private:
-    std::wstring id_;
+    std::u16string id_;
     expression_ptr init_;
 };
 
@@ -737,11 +757,11 @@ private:
 
 class continue_statement : public statement {
 public:
-    explicit continue_statement(const source_extend& extend, const std::wstring& id) : statement(extend), id_(id) {}
+    explicit continue_statement(const source_extend& extend, const std::u16string& id) : statement(extend), id_(id) {}
     statement_type type() const override { return statement_type::continue_; }
-    const std::wstring& id() const { return id_; }
+    const std::u16string& id() const { return id_; }
 private:
-    std::wstring id_;
+    std::u16string id_;
     void print(std::wostream& os) const override {
         os << "continue_statement{";
         if (!id_.empty()) {
@@ -753,11 +773,11 @@ private:
 
 class break_statement : public statement {
 public:
-    explicit break_statement(const source_extend& extend, const std::wstring& id) : statement(extend), id_(id) {}
+    explicit break_statement(const source_extend& extend, const std::u16string& id) : statement(extend), id_(id) {}
     statement_type type() const override { return statement_type::break_; }
-    const std::wstring& id() const { return id_; }
+    const std::u16string& id() const { return id_; }
 private:
-    std::wstring id_;
+    std::u16string id_;
     void print(std::wostream& os) const override {
         os << "break_statement{";
         if (!id_.empty()) {
@@ -808,18 +828,18 @@ private:
 
 class labelled_statement : public statement {
 public:
-    explicit labelled_statement(const source_extend& extend, const std::wstring& id, statement_ptr&& s) : statement(extend), id_(id), s_(std::move(s)) {
+    explicit labelled_statement(const source_extend& extend, const std::u16string& id, statement_ptr&& s) : statement(extend), id_(id), s_(std::move(s)) {
         assert(!id_.empty());
         assert(s_);
     }
 
     statement_type type() const override { return statement_type::labelled; }
 
-    const std::wstring& id() const { return id_; };
+    const std::u16string& id() const { return id_; };
     const statement& s() const { return *s_; };
 
 private:
-    std::wstring id_;
+    std::u16string id_;
     statement_ptr s_;
 
     void print(std::wostream& os) const override {
@@ -907,7 +927,7 @@ private:
 
 class try_statement : public statement {
 public:
-    explicit try_statement(const source_extend& extend, statement_ptr&& block, statement_ptr&& catch_, const std::wstring& catch_id, statement_ptr&& finally_)
+    explicit try_statement(const source_extend& extend, statement_ptr&& block, statement_ptr&& catch_, const std::u16string& catch_id, statement_ptr&& finally_)
         : statement(extend)
         , block_(std::move(block))
         , catch_(std::move(catch_))
@@ -922,14 +942,14 @@ public:
     statement_type type() const override { return statement_type::try_; }
 
     const block_statement& block() const { return static_cast<const block_statement&>(*block_); }
-    const std::wstring& catch_id() const { return catch_id_; }
+    const std::u16string& catch_id() const { return catch_id_; }
     const block_statement* catch_block() const { return static_cast<const block_statement*>(catch_.get()); }
     const block_statement* finally_block() const { return static_cast<const block_statement*>(finally_.get()); }
 
 private:
     statement_ptr block_;
     statement_ptr catch_;
-    std::wstring catch_id_;
+    std::u16string catch_id_;
     statement_ptr finally_;
 
     void print(std::wostream& os) const override {
@@ -943,7 +963,7 @@ private:
 
 class function_definition : public statement, public function_base {
 public:
-    explicit function_definition(const source_extend& extend, const source_extend& body_extend, const std::wstring& id, std::vector<std::wstring>&& params, statement_ptr&& block) : statement(extend), function_base(body_extend, id, std::move(params), std::move(block)) {
+    explicit function_definition(const source_extend& extend, const source_extend& body_extend, const std::u16string& id, std::vector<std::u16string>&& params, statement_ptr&& block, bool may_use_arguments) : statement(extend), function_base(body_extend, id, std::move(params), std::move(block), may_use_arguments) {
         assert(!this->id().empty());
     }
 
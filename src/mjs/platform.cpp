@@ -4,6 +4,11 @@
 #include <fcntl.h>
 #include <io.h>
 #include <stdio.h>
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
 #endif
 
 #ifdef _MSC_VER
@@ -45,4 +50,66 @@ void platform_init() {
 
 }
 
+#ifdef _WIN32
+
+void* virtual_memory_reserve(size_t bytes) {
+    return VirtualAlloc(nullptr, bytes, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+void virtual_memory_release(void* base, size_t) {
+    VirtualFree(base, 0, MEM_RELEASE);
+}
+
+bool virtual_memory_commit(void* p, size_t bytes) {
+    return VirtualAlloc(p, bytes, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+}
+
+void virtual_memory_decommit(void* p, size_t bytes) {
+    VirtualFree(p, bytes, MEM_DECOMMIT);
+}
+
+void virtual_memory_discard(void* p, size_t bytes) {
+    VirtualAlloc(p, bytes, MEM_RESET, PAGE_READWRITE);
+}
+
+void virtual_memory_use_large_pages(void*, size_t) {
+    // Large pages can't be committed piecemeal (and require special privileges)
+}
+
+#else
+
+void* virtual_memory_reserve(size_t bytes) {
+    void* p = mmap(nullptr, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+void virtual_memory_release(void* base, size_t bytes) {
+    munmap(base, bytes);
+}
+
+bool virtual_memory_commit(void* p, size_t bytes) {
+    return mprotect(p, bytes, PROT_READ | PROT_WRITE) == 0;
+}
+
+void virtual_memory_decommit(void* p, size_t bytes) {
+    // Drop the pages (and their contents) immediately. Unlike replacing the mapping this keeps the advice given
+    // for the range (see virtual_memory_use_large_pages), so it still applies when the memory is committed again.
+    madvise(p, bytes, MADV_DONTNEED);
+    mprotect(p, bytes, PROT_NONE);
+}
+
+void virtual_memory_discard(void* p, size_t bytes) {
+    // The pages are freed right away (MADV_FREE would leave them counted against the process until there's memory pressure)
+    madvise(p, bytes, MADV_DONTNEED);
+}
+
+void virtual_memory_use_large_pages([[maybe_unused]] void* p, [[maybe_unused]] size_t bytes) {
+#ifdef MADV_HUGEPAGE
+    // Only has an effect for the 2MB aligned parts that are committed
+    madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+}
+
+#endif
+
 } // namespace mjs
@@ -1,11 +1,37 @@
 #ifndef MJS_PLATFORM_H
 #define MJS_PLATFORM_H
 
+#include <cstddef>
+
 namespace mjs {
 
 extern void platform_init(void);
 
+//
+// Virtual memory
+//
+// Memory returned by virtual_memory_reserve() is inaccessible until (a page aligned part of it) is committed.
+// Decommitted memory is returned to the operating system, but the address space stays reserved.
+//
+
+// Reserve 'bytes' of address space, returns nullptr on failure
+void* virtual_memory_reserve(size_t bytes);
+
+// Release address space previously reserved with virtual_memory_reserve()
+void virtual_memory_release(void* base, size_t bytes);
+
+// Make [p, p+bytes) accessible, returns false on failure
+bool virtual_memory_commit(void* p, size_t bytes);
+
+// Return the memory in [p, p+bytes) to the system and make it inaccessible
+void virtual_memory_decommit(void* p, size_t bytes);
+
+// Return the memory in committed range [p, p+bytes) to the system, but keep it accessible (the contents are lost)
+void virtual_memory_discard(void* p, size_t bytes);
+
+// Hint that [p, p+bytes) is used densely, so it may be backed by large pages where that's supported
+void virtual_memory_use_large_pages(void* p, size_t bytes);
+
 } // namespace mjs
 
 #endif
-
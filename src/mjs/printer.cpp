@@ -306,7 +306,7 @@ private:
     std::wostream& os_;
 
     void handle_function(const function_base& s) {
-        os_ << (s.id().empty() ? L"" : L" " + s.id()) << "(";
+        os_ << (s.id().empty() ? u"" : u" " + s.id()) << "(";
         for (size_t i = 0; i < s.params().size(); ++i) {
             os_ << (i?", ":"") << s.params()[i];
         }
@@ -1,4 +1,5 @@
 #include "regexp.h"
+#include "char_conversions.h"
 #include <regex>
 #include <sstream>
 #include <cassert>
@@ -23,15 +24,15 @@ regexp_flag regexp_flag_from_char(char ch) {
     }
 }
 
-std::wstring regexp_flags_to_string(regexp_flag flags) {
-    std::wstring res;
+std::u16string regexp_flags_to_string(regexp_flag flags) {
+    std::u16string res;
     if ((flags & regexp_flag::global) != regexp_flag::none)      res.push_back('g');
     if ((flags & regexp_flag::ignore_case) != regexp_flag::none) res.push_back('i');
     if ((flags & regexp_flag::multiline) != regexp_flag::none)   res.push_back('m');
     return res;
 }
 
-regexp_flag regexp_flags_from_string(std::wstring_view s) {
+regexp_flag regexp_flags_from_string(std::u16string_view s) {
     auto f = regexp_flag::none;
     for (const auto ch: s) {
         const regexp_flag here = regexp_flag_from_char(static_cast<char>(ch));
@@ -48,7 +49,7 @@ regexp_flag regexp_flags_from_string(std::wstring_view s) {
 
 namespace {
 
-std::wregex make_regex(const std::wstring_view pattern, regexp_flag flags) {
+std::wregex make_regex(const std::u16string_view pattern, regexp_flag flags) {
     auto options = std::regex_constants::ECMAScript;
     if ((flags & regexp_flag::ignore_case) != regexp_flag::none) options |= std::regex_constants::icase;
     // TODO: Not implemented in MSVC yet
@@ -56,30 +57,51 @@ std::wregex make_regex(const std::wstring_view pattern, regexp_flag flags) {
     return std::wregex{pattern.begin(), pattern.end(), options};
 }
 
+// std::regex doesn't support char16_t, so matching is done on a wchar_t copy of the input
+class wide_input {
+public:
+    explicit wide_input(const std::u16string_view str) : str_{str}, wide_{to_wstring(str)} {}
+
+    const wchar_t* begin() const { return wide_.data(); }
+    const wchar_t* end() const { return wide_.data() + wide_.length(); }
+
+    const char16_t* map(const wchar_t* p) const {
+        return str_.data() + (p - begin());
+    }
+
+private:
+    std::u16string_view str_;
+    std::wstring wide_;
+};
+
 } // unnamed namespace
 
 class regexp::impl {
 public:
     explicit impl(std::wregex&& r) : r_(std::move(r)) {}
 
-    uint32_t search(const std::wstring_view haystack) const {
+    uint32_t search(const std::u16string_view haystack) const {
         std::wcmatch match;
-        const wchar_t* const str_beg = haystack.data();
-        const wchar_t* const str_end = str_beg + haystack.length();
-        if (!std::regex_search(str_beg, str_end, match, r_)) {
+        const wide_input input{haystack};
+        if (!std::regex_search(input.begin(), input.end(), match, r_)) {
             return npos;
         }
-        return static_cast<uint32_t>(match[0].first - str_beg);
+        return static_cast<uint32_t>(match[0].first - input.begin());
     }
 
-    std::vector<regexp_match> exec(const std::wstring_view str) const {
+    std::vector<regexp_match> exec(const std::u16string_view str) const {
         std::wcmatch match;
-        if (!std::regex_search(str.data(), str.data()+str.length(), match, r_)) {
+        const wide_input input{str};
+        if (!std::regex_search(input.begin(), input.end(), match, r_)) {
             return {};
         }
         std::vector<regexp_match> res;
         for (const auto& m: match) {
-            res.push_back(regexp_match{m.first, m.second});
+            if (m.matched) {
+                res.push_back(regexp_match{input.map(m.first), input.map(m.second)});
+            } else {
+                res.push_back(regexp_match{nullptr, nullptr});
+            }
         }
         return res;
     }
@@ -87,7 +109,7 @@ private:
     std::wregex r_;
 };
 
-regexp::regexp(std::wstring_view pattern, regexp_flag flags)
+regexp::regexp(std::u16string_view pattern, regexp_flag flags)
     : impl_{new impl{make_regex(pattern, flags)}}
     , pattern_{pattern}
     , flags_{flags} {
@@ -95,11 +117,11 @@ regexp::regexp(std::wstring_view pattern, regexp_flag flags)
 
 regexp::~regexp() = default;
 
-uint32_t regexp::search(std::wstring_view haystack) const {
+uint32_t regexp::search(std::u16string_view haystack) const {
     return impl_->search(haystack);
 }
 
-std::vector<regexp_match> regexp::exec(std::wstring_view str) const {
+std::vector<regexp_match> regexp::exec(std::u16string_view str) const {
     return impl_->exec(str);
 }
 
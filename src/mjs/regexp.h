@@ -31,41 +31,41 @@ std::wostream& operator<<(std::wostream& os, regexp_flag f);
 // Convert character to regexp_flag, returns regexp_flag::none on conversion error
 regexp_flag regexp_flag_from_char(char ch);
 
-std::wstring regexp_flags_to_string(regexp_flag flags);
+std::u16string regexp_flags_to_string(regexp_flag flags);
 
 // throws a runtime_error on conversion failure
-regexp_flag regexp_flags_from_string(std::wstring_view s);
+regexp_flag regexp_flags_from_string(std::u16string_view s);
 
 struct regexp_match {
-    const wchar_t* first;
-    const wchar_t* second;
+    const char16_t* first;
+    const char16_t* second;
 
-    std::wstring_view str() const {
-        return std::wstring_view{first, static_cast<size_t>(second-first)};
+    std::u16string_view str() const {
+        return std::u16string_view{first, static_cast<size_t>(second-first)};
     }
 };
 
 class regexp {
 public:
-    explicit regexp(std::wstring_view pattern, regexp_flag flags);
-    explicit regexp(std::wstring_view pattern, std::wstring_view flags) : regexp(pattern, regexp_flags_from_string(flags)) {}
+    explicit regexp(std::u16string_view pattern, regexp_flag flags);
+    explicit regexp(std::u16string_view pattern, std::u16string_view flags) : regexp(pattern, regexp_flags_from_string(flags)) {}
     ~regexp();
 
     static constexpr uint32_t npos = 0xffff'ffff;
 
-    std::wstring_view pattern() const { return pattern_; }
+    std::u16string_view pattern() const { return pattern_; }
     regexp_flag flags() const { return flags_; }
 
     // Returns match groups from running the regular expression on the given string, returns an empty vector on no match
-    std::vector<regexp_match> exec(std::wstring_view str) const;
+    std::vector<regexp_match> exec(std::u16string_view str) const;
 
     // Returns index of match, npos if no match was found
-    uint32_t search(std::wstring_view haystack) const;
+    uint32_t search(std::u16string_view haystack) const;
 
 private:
     class impl;
     std::unique_ptr<impl> impl_;
-    const std::wstring pattern_;
+    const std::u16string pattern_;
     const regexp_flag flags_;
 };
 
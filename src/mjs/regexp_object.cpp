@@ -20,14 +20,14 @@ namespace {
 
 const char* empty_string_regexp = "(?:)";
 
-string get_source_string(const gc_heap_ptr<global_object>& global, const std::wstring_view s) {
+string get_source_string(const gc_heap_ptr<global_object>& global, const std::u16string_view s) {
     auto& h = global->heap();
 
     if (s.empty()) {
         return string{h, empty_string_regexp};
     }
 
-    std::wstring res;
+    std::u16string res;
     bool escape = false;
     for (uint32_t i = 0, l = static_cast<uint32_t>(s.length()); i < l; ++i) {
         const auto ch = s[i];
@@ -50,7 +50,7 @@ string get_source_string(const gc_heap_ptr<global_object>& global, const std::ws
 //       but need to be careful about not using too much (non-GC) memory.
 class regexp_object : public native_object {
 public:
-    static gc_heap_ptr<regexp_object> make(const gc_heap_ptr<global_object>& global, const std::wstring_view& pattern, regexp_flag flags) {
+    static gc_heap_ptr<regexp_object> make(const gc_heap_ptr<global_object>& global, const std::u16string_view& pattern, regexp_flag flags) {
         return global->heap().make<regexp_object>(global, global->regexp_prototype(), get_source_string(global, pattern), flags);
     }
 
@@ -86,11 +86,11 @@ public:
             return value::null;
         }
 
-        const wchar_t* const str_beg = str.view().data();
-        const wchar_t* const str_end = str_beg + str.view().length();
-        const wchar_t* const search_start = str_beg + start_index;
+        const char16_t* const str_beg = str.view().data();
+        const char16_t* const str_end = str_beg + str.view().length();
+        const char16_t* const search_start = str_beg + start_index;
 
-        const auto match = regexp{source_.dereference(heap()).view(), flags_}.exec(std::wstring_view{search_start, static_cast<size_t>(str_end - search_start)});
+        const auto match = regexp{source_.dereference(heap()).view(), flags_}.exec(std::u16string_view{search_start, static_cast<size_t>(str_end - search_start)});
         if (match.empty()) {
             return value::null;
         }
@@ -105,7 +105,9 @@ public:
         res->put(string{heap(), "index"}, value{static_cast<double>(match[0].first - str_beg)});
 
         for (uint32_t i = 0; i < static_cast<uint32_t>(match.size()); ++i) {
-            res->put(string{heap(), index_string(i)}, value{string{heap(), match[i].str()}});
+            // Groups share the characters of the input string (unmatched groups are empty)
+            const auto& m = match[i];
+            res->put(string{heap(), index_string(i)}, value{m.first ? str.substr(m.first - str_beg, m.second - m.first) : string{heap(), ""}});
         }
 
         return value{res};
@@ -144,7 +146,7 @@ private:
     }
 
     void put_lastIndex(const value& v) {
-        last_index_ = value_representation{v};
+        last_index_ = v;
     }
 
     explicit regexp_object(const gc_heap_ptr<global_object>& global, const object_ptr& prototype, const string& source, regexp_flag flags)
@@ -215,7 +217,7 @@ global_object_create_result make_regexp_object(const gc_heap_ptr<global_object>&
 
             if (auto r = cast_to_regexp(args[0])) {
                 if (has_flags_argument) {
-                    throw native_error_exception{native_error_type::type, global->stack_trace(), L"Invalid flags argument to RegExp constructor"};
+                    throw native_error_exception{native_error_type::type, global->stack_trace(), u"Invalid flags argument to RegExp constructor"};
                 }
                 pattern = r->source();
                 flags = r->flags();
@@ -280,15 +282,15 @@ gc_heap_ptr<regexp_object> to_regexp_object(const gc_heap_ptr<global_object>& gl
 string do_get_replacement_string(const string& str, const object_ptr& match, const value& replace_value) {
     if (replace_value.type() == value_type::string) {
         const auto rep_str = replace_value.string_value();
-        if (rep_str.view().find_first_of(L'$') == std::wstring_view::npos) {
+        if (rep_str.view().find_first_of(u'$') == std::u16string_view::npos) {
             // Fast and easy
             return rep_str;
         }
 
-        std::wstring res;
+        std::u16string res;
         const auto r = rep_str.view();
         for (uint32_t i = 0, l = static_cast<uint32_t>(r.length()); i < l;) {
-            if (r[i] != L'$') {
+            if (r[i] != u'$') {
                 res += r[i];
                 ++i;
                 continue;
@@ -298,25 +300,25 @@ string do_get_replacement_string(const string& str, const object_ptr& match, con
                 NOT_IMPLEMENTED("$ at end of string");
             }
             if (r[i] == '$') {
-                res += L'$';
+                res += u'$';
                 ++i;
-            } else if (r[i] == L'&') {
+            } else if (r[i] == u'&') {
                 // The matched substring
-                res += match->get(L"0").string_value().view();
+                res += match->get(u"0").string_value().view();
                 ++i;
-            } else if (r[i] == L'`') {
+            } else if (r[i] == u'`') {
                 //The portion of string that precedes the matched substring.
                 ++i;
-                res += str.view().substr(0, to_uint32(match->get(L"index")));
-            } else if (r[i] == L'\'') {
+                res += str.view().substr(0, to_uint32(match->get(u"index")));
+            } else if (r[i] == u'\'') {
                 //The portion of string that follows the matched substring.
                 ++i;
-                res += str.view().substr(to_uint32(match->get(L"index")) + match->get(L"0").string_value().view().length());
+                res += str.view().substr(to_uint32(match->get(u"index")) + match->get(u"0").string_value().view().length());
             } else if (isdigit(r[i])) {
-                uint32_t idx = r[i]-L'0';
+                uint32_t idx = r[i]-u'0';
                 ++i;
                 if (i < l && isdigit(r[i])) {
-                    idx = idx*10+r[i]-L'0';
+                    idx = idx*10+r[i]-u'0';
                     ++i;
                 }
                 if (!idx) {
@@ -337,46 +339,50 @@ string do_get_replacement_string(const string& str, const object_ptr& match, con
     }
 
     std::vector<value> args;
-    args.push_back(match->get(L"0"));
-    const auto m = to_uint32(match->get(L"length"));
+    args.push_back(match->get(u"0"));
+    const auto m = to_uint32(match->get(u"length"));
     for (uint32_t i = 1; i < m; ++i) {
         args.push_back(match->get(index_string(i)));
     }
-    args.push_back(match->get(L"index"));
+    args.push_back(match->get(u"index"));
     args.push_back(value{str});
 
     return to_string(match.heap(), call_function(replace_value, value::undefined, args));
 }
 
+// Appends the characters of 'str' from 'pos' (up to 'len' of them) to 'b'
+void append_substr(string_builder& b, const string& str, uint32_t pos, uint32_t len = UINT32_MAX) {
+    str.visit([&](auto v) { b.append(v.substr(pos, len)); });
+}
+
 string do_replace(const string& str, const value& match_val, const value& replace_value) {
     if (match_val.type() == value_type::null) {
         return str;
     }
     assert(match_val.type() == value_type::object);
     const auto match           = match_val.object_value();
-    const auto s               = std::wstring{str.view()};
-    const auto match_index_val = match->get(L"index");
-    const auto match_str       = match->get(L"0").string_value();
+    const auto match_index_val = match->get(u"index");
+    const auto match_str       = match->get(u"0").string_value();
     const auto match_index     = static_cast<uint32_t>(match_index_val.number_value());
-    const auto match_length    = static_cast<uint32_t>(match_str.view().length());
+    const auto match_length    = match_str.length();
 
     auto& h = match.heap();
 
-    std::wstring res;
-    res = s.substr(0, match_index);
-    res += do_get_replacement_string(str, match, replace_value).view();
-    res += s.substr(match_index + match_length);
-    return string{h, res};
+    const auto replacement = do_get_replacement_string(str, match, replace_value);
+    string_builder res{h, str.length() - match_length + replacement.length()};
+    append_substr(res, str, 0, match_index);
+    res.append(replacement);
+    append_substr(res, str, match_index + match_length);
+    return res.release();
 }
 
 string do_global_replace(const string& str, const gc_heap_ptr<regexp_object>& re, const value& replace_value) {
     auto& h = re.heap();
-    const auto s = std::wstring{str.view()};
 
     uint32_t last_index = 0;
     re->last_index(last_index);
 
-    std::wstring res;
+    string_builder res{h};
     for (uint32_t i=0;; ++i) {
         auto match = re->exec(str);
         if (match.type() == value_type::null) {
@@ -384,10 +390,10 @@ string do_global_replace(const string& str, const gc_heap_ptr<regexp_object>& re
         }
         assert(match.type() == value_type::object);
         const auto& match_object = match.object_value();
-        const auto match_index = static_cast<uint32_t>(match_object->get(L"index").number_value());
+        const auto match_index = static_cast<uint32_t>(match_object->get(u"index").number_value());
 
-        res += str.view().substr(last_index, match_index-last_index);
-        res += do_get_replacement_string(str, match_object, replace_value).view();
+        append_substr(res, str, last_index, match_index-last_index);
+        res.append(do_get_replacement_string(str, match_object, replace_value));
 
         const uint32_t new_last_index = static_cast<uint32_t>(re->last_index());
         if (last_index == re->last_index()) {
@@ -403,11 +409,11 @@ string do_global_replace(const string& str, const gc_heap_ptr<regexp_object>& re
         return str;
     }
 
-    if (last_index < s.length()) {
-        res += s.substr(last_index);
+    if (last_index < str.length()) {
+        append_substr(res, str, last_index);
     }
 
-    return string{h, res};
+    return res.release();
 }
 
 } // unnamed namespace
@@ -430,7 +436,7 @@ value string_match(const gc_heap_ptr<global_object>& global, const string& str,
         }
         assert(match.type() == value_type::object);
         const auto& match_object = match.object_value();
-        res->put(string{h, index_string(i)}, match_object->get(L"0"));
+        res->put(string{h, index_string(i)}, match_object->get(u"0"));
         if (last_index_before == re->last_index()) {
             // Empty match
             re->last_index(static_cast<uint32_t>(last_index_before + 1));
@@ -465,12 +471,12 @@ value string_replace(const gc_heap_ptr<global_object>& global, const string& str
 
     auto search_string = to_string(h, search_value);
     auto idx = str.view().find(search_string.view());
-    if (idx == std::wstring_view::npos) {
+    if (idx == std::u16string_view::npos) {
         return value{str};
     }
     // Fake up a match object
     auto match = make_array(global, 0);
-    match->put(string{h, L"0"}, value{search_string});
+    match->put(string{h, u"0"}, value{search_string});
     match->put(global->common_string("index"), value{static_cast<double>(idx)});
 
     return value{do_replace(str, value{match}, replace_val)};
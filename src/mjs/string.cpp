@@ -1,29 +1,287 @@
 #include "string.h"
+#include "number_to_string.h"
 #include <ostream>
 #include <sstream>
 #include <cstring>
 #include <cmath>
+#include <stdexcept>
 
 namespace mjs {
 
 static_assert(!gc_type_info_registration<gc_string>::needs_destroy);
-static_assert(!gc_type_info_registration<gc_string>::needs_fixup);
+static_assert(gc_type_info_registration<gc_string>::needs_fixup);
+static_assert(sizeof(gc_string) == 8);
+
+gc_heap_ptr<gc_string> gc_string::concat(gc_heap& h, const gc_heap_ptr<gc_string>& l, const gc_heap_ptr<gc_string>& r) {
+    if (!l->length_) {
+        return r;
+    } else if (!r->length_) {
+        return l;
+    }
+    if (static_cast<uint64_t>(l->length_) + r->length_ > UINT32_MAX / sizeof(char16_t)) {
+        throw std::runtime_error("String too long");
+    }
+    const auto length = l->length_ + r->length_;
+    if (length < min_rope_length) {
+        std::u16string s(length, u'\0');
+        l->visit([&](auto v) { copy_chars(s.data(), v); });
+        r->visit([&](auto v) { copy_chars(s.data() + l->length_, v); });
+        return copy_of(h, std::u16string_view{s}, l->one_byte_ && r->one_byte_);
+    }
+    const auto depth = std::max(l->rope_depth(), r->rope_depth()) + 1;
+    auto res = h.allocate_and_construct<gc_string>(sizeof(gc_string) + sizeof(rope), h, l, r, depth);
+    if (depth > max_rope_depth) {
+        res->flatten();
+    }
+    return res;
+}
+
+gc_heap_ptr<gc_string> gc_string::substr(gc_heap& h, const gc_heap_ptr<gc_string>& s, uint32_t pos, uint32_t len) {
+    assert(pos <= s->length_);
+    len = std::min(len, s->length_ - pos);
+    if (len == s->length_) {
+        return s;
+    }
+    if (len < min_slice_length) {
+        return s->visit([&](auto v) { return copy_of(h, v.substr(pos, len), s->one_byte_); });
+    }
+    // Slices always refer to flat/one-byte strings
+    gc_heap_ptr<gc_string> parent;
+    if (s->kind_ == kind::slice) {
+        auto& sd = s->slice_data();
+        parent = sd.parent.track(h);
+        pos += sd.offset;
+        // The parent may have been widened
+        if (parent->kind_ == kind::rope) {
+            parent = parent->flat(h);
+        }
+    } else {
+        // flat() follows ropes (including widened one-byte strings) all the way to the flat string
+        parent = s->flat(h);
+    }
+    return h.allocate_and_construct<gc_string>(sizeof(gc_string) + sizeof(slice), h, parent, pos, len);
+}
+
+gc_string& gc_string::resolve(uint32_t& offset) {
+    for (gc_string* s = this;;) {
+        switch (s->kind_) {
+        case kind::flat:
+        case kind::one_byte:
+            return *s;
+        case kind::rope:
+            if (s->rope_data().right) {
+                s->flatten();
+            }
+            s = &s->rope_data().left.dereference(*s->rope_data().heap);
+            break;
+        case kind::slice:
+            offset += s->slice_data().offset;
+            s = &s->slice_data().parent.dereference(*s->slice_data().heap);
+            break;
+        }
+    }
+}
+
+std::u16string_view gc_string::indirect_view() {
+    uint32_t offset = 0;
+    gc_string* s = &resolve(offset);
+    if (s->kind_ == kind::one_byte) {
+        s = &s->widen();
+    }
+    return std::u16string_view(s->data() + offset, length_);
+}
+
+void gc_string::flatten() {
+    auto& r = rope_data();
+    auto& h = *r.heap;
+    assert(r.right);
+    auto flat = one_byte_ && length_ >= min_one_byte_length ? h.allocate_and_construct<gc_string>(one_byte_size(length_), h, length_) : h.allocate_and_construct<gc_string>(sizeof(gc_string) + length_ * sizeof(char16_t), length_);
+    flat->one_byte_ = one_byte_;
+    auto fill = [&](auto* out) {
+        // Fill in the characters from the back, so left leaning ropes (from appending to a string, the common case)
+        // only ever need one pending node
+        out += length_;
+        std::vector<const gc_string*> pending{this};
+        while (!pending.empty()) {
+            const gc_string* s = pending.back();
+            pending.pop_back();
+            while (s->kind_ == kind::rope) {
+                const auto& sr = s->rope_data();
+                if (sr.right) {
+                    pending.push_back(&sr.left.dereference(h));
+                    s = &sr.right.dereference(h);
+                } else {
+                    s = &sr.left.dereference(h);
+                }
+            }
+            out -= s->length_;
+            s->visit([out](auto v) { copy_chars(out, v); });
+        }
+    };
+    if (flat->kind_ == kind::one_byte) {
+        fill(flat->chars());
+    } else {
+        fill(flat->data());
+    }
+    r.left = flat;
+    r.right = gc_heap_ptr_untracked<gc_string>{};
+    r.depth = 1;
+}
+
+gc_string& gc_string::widen() {
+    auto& h = *one_byte_heap();
+    auto wide = h.allocate_and_construct<gc_string>(sizeof(gc_string) + length_ * sizeof(char16_t), length_);
+    copy_chars(wide->data(), std::string_view(chars(), length_));
+    wide->one_byte_ = true;
+    // Turn this string into a (flattened) rope referring to the wide copy, and let the next collection reclaim the characters
+    kind_ = kind::rope;
+    new (&rope_data()) rope{&h, wide, gc_heap_ptr_untracked<gc_string>{}, 1};
+    h.shrink(h.unsafe_track(*this), sizeof(gc_string) + sizeof(rope));
+    return *wide;
+}
+
+gc_heap_ptr<gc_string> gc_string::flat(gc_heap& h) const {
+    gc_heap_ptr<gc_string> res;
+    switch (kind_) {
+    case kind::flat:
+    case kind::one_byte:
+        return h.unsafe_track(*this);
+    case kind::rope: {
+        // The flattened string may since have been widened (turning it into a rope referring to the wide copy)
+        const gc_string* s = this;
+        while (s->kind_ == kind::rope) {
+            if (s->rope_data().right) {
+                const_cast<gc_string&>(*s).flatten();
+            }
+            s = &s->rope_data().left.dereference(h);
+        }
+        res = h.unsafe_track(*s);
+        break;
+    }
+    case kind::slice:
+        res = visit([&](auto v) { return copy_of(h, v, one_byte_); });
+        break;
+    }
+    // Keep the hash if it has already been computed
+    if (hash_) {
+        res->hash_ = hash_;
+    }
+    return res;
+}
 
 std::ostream& operator<<(std::ostream& os, const string& s) {
-    auto v = s.view();
-    return os << std::string(v.begin(), v.end());
+    return s.visit([&os](auto v) -> std::ostream& { return os << std::string(v.begin(), v.end()); });
 }
 
 std::wostream& operator<<(std::wostream& os, const string& s) {
-    return os << s.view();
+    return s.visit([&os](auto v) -> std::wostream& {
+        std::u16string w(v.length(), u'\0');
+        copy_chars(w.data(), v);
+        return os << w;
+    });
+}
+
+atom_table::atom_table(gc_heap& h) : heap_(h), entries_(64) {
+}
+
+atom_table& atom_table::create(gc_heap& h) {
+    auto t = new atom_table{h};
+    h.weak_table(std::unique_ptr<gc_weak_table>{t});
+    return *t;
+}
+
+string atom_table::intern(const string& s) {
+    const auto hash = s.unsafe_raw_get()->hash();
+    if (auto a = find(*s.unsafe_raw_get(), hash)) {
+        return heap_.unsafe_track(*a);
+    }
+    if ((size_ + 1) * 4 > entries_.size() * 3) {
+        rehash(static_cast<uint32_t>(entries_.size() * 2));
+    }
+    // Atoms are compared by address, so store the flat string rather than a rope
+    const auto atom = s.unsafe_raw_get()->flat(heap_);
+    insert(entry{hash, atom});
+    ++size_;
+    return atom;
+}
+
+const gc_string* atom_table::find(std::u16string_view s) const {
+    const auto hash = hash_chars(s);
+    const auto mask = static_cast<uint32_t>(entries_.size() - 1);
+    for (uint32_t i = hash & mask; entries_[i].s; i = (i + 1) & mask) {
+        if (entries_[i].hash == hash) {
+            const auto& a = entries_[i].s.dereference(heap_);
+            if (a.equals(s)) {
+                return &a;
+            }
+        }
+    }
+    return nullptr;
+}
+
+const gc_string* atom_table::find(const gc_string& s) const {
+    return find(s, s.hash());
+}
+
+const gc_string* atom_table::find(const gc_string& s, uint32_t hash) const {
+    const auto mask = static_cast<uint32_t>(entries_.size() - 1);
+    for (uint32_t i = hash & mask; entries_[i].s; i = (i + 1) & mask) {
+        if (entries_[i].hash == hash) {
+            const auto& a = entries_[i].s.dereference(heap_);
+            if (&a == &s || a.equals(s)) {
+                return &a;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void atom_table::insert(const entry& e) {
+    const auto mask = static_cast<uint32_t>(entries_.size() - 1);
+    uint32_t i = e.hash & mask;
+    while (entries_[i].s) {
+        i = (i + 1) & mask;
+    }
+    entries_[i] = e;
+}
+
+void atom_table::rehash(uint32_t capacity) {
+    auto old = std::move(entries_);
+    entries_ = std::vector<entry>(capacity);
+    size_ = 0;
+    for (const auto& e: old) {
+        if (e.s) {
+            insert(e);
+            ++size_;
+        }
+    }
 }
 
-double to_number(const std::wstring_view& s) {
+void atom_table::fixup(gc_heap& h) {
+    for (auto& e: entries_) {
+        e.s.fixup(h);
+    }
+}
+
+void atom_table::sweep() {
+    // Collected atoms have been reset, rebuild the table to remove them (and shrink it if it has become sparse)
+    uint32_t live = 0;
+    for (const auto& e: entries_) {
+        live += e.s ? 1 : 0;
+    }
+    auto capacity = static_cast<uint32_t>(entries_.size());
+    while (capacity > 64 && live * 4 < capacity) {
+        capacity /= 2;
+    }
+    rehash(capacity);
+}
+
+double to_number(const std::u16string_view& s) {
     // TODO: Implement real algorithm from §9.3.1 ToNumber Applied to the String Type
     if (s.empty()) {
         return 0;
     }
-    std::wistringstream wis{std::wstring{s}};
+    std::wistringstream wis{to_wstring(s)};
     double d;
     return (wis >> d) && !wis.rdbuf()->in_avail() ? d : NAN;
 }
@@ -33,7 +291,56 @@ double to_number(const string& s) {
     return to_number(s.view());
 }
 
-uint32_t index_value_from_string(const std::wstring_view& str) {
+//
+// string_builder
+//
+
+string_builder& string_builder::append_number(double n) {
+    char buf[number_to_chars_max];
+    return append(std::string_view{buf, static_cast<size_t>(number_to_chars(buf, n))});
+}
+
+string string_builder::release() {
+    if (!buffer_) {
+        return string{heap_, std::u16string_view{}};
+    }
+    auto& b = *buffer_;
+    if (one_byte_ && length_ < gc_string::min_one_byte_length) {
+        // Short strings are always flat, copy it (the buffer is left for the garbage collector)
+        string res{gc_string::copy_of(heap_, std::string_view{b.chars(), length_}, true)};
+        buffer_ = nullptr;
+        length_ = capacity_ = 0;
+        return res;
+    }
+    b.length_ = length_;
+    heap_.shrink(buffer_, one_byte_ ? gc_string::one_byte_size(length_) : sizeof(gc_string) + length_ * sizeof(char16_t));
+    string res{buffer_};
+    buffer_ = nullptr;
+    length_ = capacity_ = 0;
+    one_byte_ = true;
+    return res;
+}
+
+void string_builder::grow(uint32_t min_capacity, bool wide) {
+    const auto capacity = std::max({min_capacity, capacity_ + capacity_ / 2, 16U});
+    // The buffer's length is its capacity until it's released (so it's moved as a whole by the garbage collector)
+    auto new_buffer = wide ? heap_.allocate_and_construct<gc_string>(sizeof(gc_string) + capacity * sizeof(char16_t), capacity) : heap_.allocate_and_construct<gc_string>(gc_string::one_byte_size(capacity), heap_, capacity);
+    if (buffer_) {
+        auto& b = *buffer_;
+        if (!one_byte_) {
+            copy_chars(new_buffer->data(), std::u16string_view{b.data(), length_});
+        } else if (wide) {
+            copy_chars(new_buffer->data(), std::string_view{b.chars(), length_});
+        } else {
+            copy_chars(new_buffer->chars(), std::string_view{b.chars(), length_});
+        }
+    }
+    buffer_ = new_buffer;
+    capacity_ = capacity;
+    one_byte_ = !wide;
+}
+
+uint32_t index_value_from_string(const std::u16string_view& str) {
     const auto len = str.length();
     if (len == 0 || len > 10) {
         assert(len); // Shouldn't be passed the empty string
@@ -42,11 +349,11 @@ uint32_t index_value_from_string(const std::wstring_view& str) {
     uint32_t index = 0;
     for (uint32_t i = 0; i < len; ++i) {
         const auto ch = str[i];
-        if (ch < L'0' || ch > L'9') {
+        if (ch < u'0' || ch > u'9') {
             return invalid_index_value;
         }
         const auto last = index;
-        index = index*10 + (ch - L'0');
+        index = index*10 + (ch - u'0');
         if (index < last) {
             // Overflow
             return invalid_index_value;
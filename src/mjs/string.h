@@ -3,72 +3,507 @@
 #include <iosfwd>
 #include <string>
 #include <string_view>
+#include <new>
+#include <type_traits>
 #include "gc_heap.h"
+#include "char_conversions.h"
 
 namespace mjs {
 
-class gc_string {
+// Code unit value of a character (see gc_string::visit())
+constexpr uint32_t char_code(char ch) { return static_cast<unsigned char>(ch); }
+constexpr uint32_t char_code(char16_t ch) { return static_cast<uint32_t>(ch); }
+
+// Compare the characters of strings of (possibly) different widths
+template<typename L, typename R>
+bool equal_chars(std::basic_string_view<L> l, std::basic_string_view<R> r) {
+    if constexpr (std::is_same_v<L, R>) {
+        return l == r;
+    } else {
+        if (l.length() != r.length()) {
+            return false;
+        }
+        for (size_t i = 0, len = l.length(); i < len; ++i) {
+            if (char_code(l[i]) != char_code(r[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+// Compare the characters of strings of (possibly) different widths like std::u16string_view::compare
+template<typename L, typename R>
+int compare_chars(std::basic_string_view<L> l, std::basic_string_view<R> r) {
+    for (size_t i = 0, len = std::min(l.length(), r.length()); i < len; ++i) {
+        if (char_code(l[i]) != char_code(r[i])) {
+            return char_code(l[i]) < char_code(r[i]) ? -1 : 1;
+        }
+    }
+    return l.length() < r.length() ? -1 : l.length() > r.length() ? 1 : 0;
+}
+
+// Like std::u16string_view::find/rfind for strings of (possibly) different widths
+template<typename S, typename P>
+size_t find_chars(std::basic_string_view<S> s, std::basic_string_view<P> p, size_t pos) {
+    if constexpr (std::is_same_v<S, P>) {
+        return s.find(p, pos);
+    } else {
+        for (size_t i = pos; i <= s.length() && p.length() <= s.length() - i; ++i) {
+            if (equal_chars(s.substr(i, p.length()), p)) {
+                return i;
+            }
+        }
+        return std::u16string_view::npos;
+    }
+}
+
+template<typename S, typename P>
+size_t rfind_chars(std::basic_string_view<S> s, std::basic_string_view<P> p, size_t pos) {
+    if constexpr (std::is_same_v<S, P>) {
+        return s.rfind(p, pos);
+    } else {
+        if (p.length() > s.length()) {
+            return std::u16string_view::npos;
+        }
+        for (size_t i = std::min(pos, s.length() - p.length()) + 1; i--;) {
+            if (equal_chars(s.substr(i, p.length()), p)) {
+                return i;
+            }
+        }
+        return std::u16string_view::npos;
+    }
+}
+
+// Hash of the characters, doesn't depend on the width of the characters, is never 0 and fits in 29 bits (see gc_string::hash())
+template<typename CharT>
+uint32_t hash_chars(std::basic_string_view<CharT> s) {
+    // FNV-1a
+    uint32_t h = 2166136261;
+    for (const auto ch: s) {
+        h = (h ^ char_code(ch)) * 16777619;
+    }
+    h = (h ^ (h >> 29)) & ((1U << 29) - 1);
+    return h ? h : 1;
+}
+
+//
+// Strings come in four kinds:
+//  - Flat strings: the characters follow the gc_string
+//  - One-byte strings: like flat strings, but using one byte per character. Used automatically for strings of at least
+//    min_one_byte_length characters when all of them are in the range 0-0xFF (Latin-1), shorter strings are always flat.
+//    Widened (in place) to refer to a flat copy when view() is used, width-generic code should use visit() instead.
+//  - Ropes: the concatenation of two other strings. Ropes are flattened the first time their contents are needed,
+//    which makes building a string by repeated concatenation linear rather than quadratic. The depth of ropes is bounded
+//    by flattening them when created if they get too deep.
+//  - Slices: part of a flat/one-byte string (see substr()), so taking substrings doesn't copy the characters. Short slices
+//    are copied instead, so they don't keep large strings alive.
+//
+// The hash of the string is computed the first time it's needed and then stored in the string.
+//
+class alignas(uint64_t) gc_string {
 public:
     template<typename CharT>
     static gc_heap_ptr<gc_string> make(gc_heap& h, const std::basic_string_view<CharT>& s) {
-        return h.allocate_and_construct<gc_string>(sizeof(gc_string) + s.length() * sizeof(wchar_t), s);
+        // Note: chars are sign extended when widened, so only ASCII characters fit in one byte for them
+        constexpr uint32_t max_one_byte = std::is_same_v<CharT, char> ? 0x7F : 0xFF;
+        const bool one_byte = std::all_of(s.begin(), s.end(), [](CharT ch) { return char_code(ch) <= max_one_byte; });
+        if (one_byte) {
+            return copy_of(h, s, true);
+        }
+        return h.allocate_and_construct<gc_string>(sizeof(gc_string) + s.length() * sizeof(char16_t), s);
+    }
+
+    // Returns the concatenation of 'l' and 'r'
+    static gc_heap_ptr<gc_string> concat(gc_heap& h, const gc_heap_ptr<gc_string>& l, const gc_heap_ptr<gc_string>& r);
+
+    // Returns the 'len' characters of 's' starting at 'pos' (like std::u16string_view::substr 'len' is clamped to the length of the string)
+    static gc_heap_ptr<gc_string> substr(gc_heap& h, const gc_heap_ptr<gc_string>& s, uint32_t pos, uint32_t len);
+
+    uint32_t length() const { return length_; }
+
+    // Note: Flattens ropes and widens one-byte strings (which allocates)
+    std::u16string_view view() const {
+        if (kind_ != kind::flat) {
+            return const_cast<gc_string&>(*this).indirect_view();
+        }
+        return std::u16string_view(const_cast<gc_string&>(*this).data(), length_);
+    }
+
+    // Calls 'f' with the characters of the string as either a std::string_view (one-byte strings, use char_code() to get
+    // the value of the characters) or a std::u16string_view. Flattens ropes, but doesn't widen one-byte strings.
+    template<typename F>
+    decltype(auto) visit(F&& f) const {
+        uint32_t offset = 0;
+        auto& s = kind_ == kind::flat || kind_ == kind::one_byte ? const_cast<gc_string&>(*this) : const_cast<gc_string&>(*this).resolve(offset);
+        if (s.kind_ == kind::one_byte) {
+            return f(std::string_view(s.chars() + offset, length_));
+        }
+        return f(std::u16string_view(s.data() + offset, length_));
+    }
+
+    // Returns the hash of the characters (see hash_chars()), computing it the first time
+    uint32_t hash() const {
+        if (!hash_) {
+            hash_ = visit([](auto v) { return hash_chars(v); });
+        }
+        return hash_;
+    }
+
+    bool equals(const gc_string& other) const {
+        if (hash_ && other.hash_ && hash_ != other.hash_) {
+            return false;
+        }
+        return length_ == other.length_ && visit([&other](auto l) { return other.visit([l](auto r) { return equal_chars(l, r); }); });
+    }
+
+    bool equals(std::u16string_view s) const {
+        return length_ == s.length() && visit([s](auto v) { return equal_chars(v, s); });
     }
 
-    std::wstring_view view() const {
-        return std::wstring_view(const_cast<gc_string&>(*this).data(), length_);
+    int compare(const gc_string& other) const {
+        return visit([&other](auto l) { return other.visit([l](auto r) { return compare_chars(l, r); }); });
     }
 
+    bool is_rope() const { return kind_ == kind::rope; }
+    bool is_slice() const { return kind_ == kind::slice; }
+    bool is_one_byte() const { return kind_ == kind::one_byte; }
+
+    // Returns the flat (or one-byte) string with the contents of this one (flattening it if it's a rope, and copying it if it's a slice)
+    gc_heap_ptr<gc_string> flat(gc_heap& h) const;
+
 private:
     friend gc_type_info_registration<gc_string>;
+    friend class string_builder;
+
+    // Concatenations shorter than this are copied rather than creating a rope
+    static constexpr uint32_t min_rope_length = 13;
+    // Ropes deeper than this are flattened when created
+    static constexpr uint32_t max_rope_depth = 4096;
+    // Substrings shorter than this are copied rather than creating a slice
+    static constexpr uint32_t min_slice_length = 13;
+    // Strings shorter than this are stored flat even if all characters fit in one byte (see one_byte_size())
+    static constexpr uint32_t min_one_byte_length = 16;
 
+    // Unscoped so it can be compared with the kind_ bit-field
+    struct kind { enum : uint32_t { flat, one_byte, rope, slice }; };
+
+    // Stored instead of the characters for ropes (and one-byte strings that have been widened)
+    struct rope {
+        gc_heap* heap;
+        gc_heap_ptr_untracked<gc_string> left;
+        gc_heap_ptr_untracked<gc_string> right; // nullptr once flattened, 'left' is then the flat string
+        uint32_t depth;
+    };
+
+    // Stored instead of the characters for slices
+    struct slice {
+        gc_heap* heap;
+        gc_heap_ptr_untracked<gc_string> parent; // Flat or one-byte when created
+        uint32_t offset;
+    };
+
+    // One-byte strings store the heap (needed to widen them) followed by the characters. They're long enough to be
+    // turned into a rope without any padding.
+    static size_t one_byte_size(uint32_t length) {
+        static_assert(sizeof(gc_heap*) + min_one_byte_length >= sizeof(rope));
+        assert(length >= min_one_byte_length);
+        return sizeof(gc_string) + sizeof(gc_heap*) + length;
+    }
+
+    // Kept to 8 bytes, since many strings are short
     uint32_t length_; // TODO: Get from allocation header
+    uint32_t kind_ : 2;
+    uint32_t one_byte_ : 1;      // All characters fit in one byte (regardless of how they're stored)
+    mutable uint32_t hash_ : 29; // 0 until computed by hash()
+
+    std::byte* payload() {
+        return reinterpret_cast<std::byte*>(this) + sizeof(*this);
+    }
+
+    char16_t* data() {
+        assert(kind_ == kind::flat);
+        return reinterpret_cast<char16_t*>(payload());
+    }
+
+    gc_heap*& one_byte_heap() {
+        assert(kind_ == kind::one_byte);
+        return *reinterpret_cast<gc_heap**>(payload());
+    }
+
+    char* chars() {
+        assert(kind_ == kind::one_byte);
+        return reinterpret_cast<char*>(payload() + sizeof(gc_heap*));
+    }
+
+    rope& rope_data() {
+        assert(kind_ == kind::rope);
+        return *reinterpret_cast<rope*>(payload());
+    }
+
+    const rope& rope_data() const {
+        return const_cast<gc_string&>(*this).rope_data();
+    }
+
+    uint32_t rope_depth() const {
+        return kind_ == kind::rope ? rope_data().depth : 0;
+    }
 
-    wchar_t* data() {
-        return reinterpret_cast<wchar_t*>(reinterpret_cast<std::byte*>(this) + sizeof(*this));
+    slice& slice_data() {
+        assert(kind_ == kind::slice);
+        return *reinterpret_cast<slice*>(payload());
     }
 
-    explicit gc_string(const std::string_view& s) : length_(static_cast<uint32_t>(s.length())) {
+    explicit gc_string(const std::string_view& s) : length_(static_cast<uint32_t>(s.length())), kind_(kind::flat), one_byte_(false), hash_(0) {
         for (uint32_t i = 0; i < length_; ++i) {
             data()[i] = s[i];
         }
     }
 
-    explicit gc_string(const std::wstring_view& s) : length_(static_cast<uint32_t>(s.length())) {
-        std::memcpy(data(), s.data(), s.length() * sizeof(wchar_t));
+    explicit gc_string(const std::u16string_view& s) : length_(static_cast<uint32_t>(s.length())), kind_(kind::flat), one_byte_(false), hash_(0) {
+        std::memcpy(data(), s.data(), s.length() * sizeof(char16_t));
     }
 
-    explicit gc_string(gc_string&& other) noexcept : length_(other.length_) {
-        std::memcpy(data(), other.data(), other.length_ * sizeof(wchar_t));
+    // Flat string with uninitialized contents
+    explicit gc_string(uint32_t length) : length_(length), kind_(kind::flat), one_byte_(false), hash_(0) {
+    }
+
+    // One-byte string with uninitialized contents
+    explicit gc_string(gc_heap& h, uint32_t length) : length_(length), kind_(kind::one_byte), one_byte_(true), hash_(0) {
+        one_byte_heap() = &h;
+    }
+
+    // Rope
+    explicit gc_string(gc_heap& h, const gc_heap_ptr<gc_string>& l, const gc_heap_ptr<gc_string>& r, uint32_t depth) : length_(l->length_ + r->length_), kind_(kind::rope), one_byte_(l->one_byte_ && r->one_byte_), hash_(0) {
+        new (&rope_data()) rope{&h, l, r, depth};
+    }
+
+    // Slice
+    explicit gc_string(gc_heap& h, const gc_heap_ptr<gc_string>& parent, uint32_t offset, uint32_t length) : length_(length), kind_(kind::slice), one_byte_(parent->one_byte_), hash_(0) {
+        assert((parent->kind_ == kind::flat || parent->kind_ == kind::one_byte) && offset + length <= parent->length_);
+        new (&slice_data()) slice{&h, parent, offset};
+    }
+
+    explicit gc_string(gc_string&& other) noexcept : length_(other.length_), kind_(other.kind_), one_byte_(other.one_byte_), hash_(other.hash_) {
+        switch (kind_) {
+        case kind::flat:     std::memcpy(data(), other.data(), other.length_ * sizeof(char16_t)); break;
+        case kind::one_byte: std::memcpy(payload(), other.payload(), sizeof(gc_heap*) + other.length_); break;
+        case kind::rope:     std::memcpy(&rope_data(), &other.rope_data(), sizeof(rope)); break;
+        case kind::slice:    std::memcpy(&slice_data(), &other.slice_data(), sizeof(slice)); break;
+        }
+    }
+
+    // Allocate a flat/one-byte string with the contents of 'v'
+    template<typename CharT>
+    static gc_heap_ptr<gc_string> copy_of(gc_heap& h, std::basic_string_view<CharT> v, bool one_byte);
+
+    // Returns the flat/one-byte string holding the characters of this one, 'offset' is incremented by the offset of them
+    gc_string& resolve(uint32_t& offset);
+
+    std::u16string_view indirect_view();
+    void flatten();
+    gc_string& widen();
+
+    void fixup() {
+        if (kind_ == kind::rope) {
+            auto& r = rope_data();
+            r.left.fixup(*r.heap);
+            r.right.fixup(*r.heap);
+        } else if (kind_ == kind::slice) {
+            auto& s = slice_data();
+            s.parent.fixup(*s.heap);
+        }
     }
 };
 
+// Copy the characters of 'v' to 'out' (which must be able to hold them)
+template<typename To, typename From>
+void copy_chars(To* out, std::basic_string_view<From> v) {
+    if constexpr (std::is_same_v<To, From>) {
+        std::memcpy(out, v.data(), v.length() * sizeof(To));
+    } else {
+        for (const auto ch: v) {
+            *out++ = static_cast<To>(char_code(ch));
+        }
+    }
+}
+
+template<typename CharT>
+gc_heap_ptr<gc_string> gc_string::copy_of(gc_heap& h, std::basic_string_view<CharT> v, bool one_byte) {
+    const auto length = static_cast<uint32_t>(v.length());
+    if (one_byte && length >= min_one_byte_length) {
+        auto res = h.allocate_and_construct<gc_string>(one_byte_size(length), h, length);
+        copy_chars(res->chars(), v);
+        return res;
+    }
+    auto res = h.allocate_and_construct<gc_string>(sizeof(gc_string) + length * sizeof(char16_t), length);
+    copy_chars(res->data(), v);
+    res->one_byte_ = one_byte;
+    return res;
+}
+
 class string : private gc_heap_ptr<gc_string> {
 public:
     string(const gc_heap_ptr<gc_string>& s) : gc_heap_ptr<gc_string>(s) {}
     explicit string(gc_heap& h, const std::string_view& s) : gc_heap_ptr<gc_string>(gc_string::make(h, s)) {}
-    explicit string(gc_heap& h, const std::wstring_view& s) : gc_heap_ptr<gc_string>(gc_string::make(h, s)) {}
+    explicit string(gc_heap& h, const std::u16string_view& s) : gc_heap_ptr<gc_string>(gc_string::make(h, s)) {}
+    explicit string(gc_heap& h, const std::wstring_view& s) : gc_heap_ptr<gc_string>(gc_string::make(h, std::u16string_view{to_u16string(s)})) {}
 
     using gc_heap_ptr<gc_string>::heap;
 
-    std::wstring_view view() const { return get()->view(); }
+    std::u16string_view view() const { return get()->view(); }
+    uint32_t length() const { return get()->length(); }
+    // See gc_string::visit()
+    template<typename F>
+    decltype(auto) visit(F&& f) const { return get()->visit(std::forward<F>(f)); }
+    // Returns a substring (sharing the characters with this string unless it's short), see gc_string::substr()
+    string substr(size_t pos, size_t len = std::u16string_view::npos) const {
+        return string{gc_string::substr(heap(), *this, static_cast<uint32_t>(pos), static_cast<uint32_t>(std::min(len, size_t{UINT32_MAX})))};
+    }
     const gc_heap_ptr<gc_string>& unsafe_raw_get() const { return *this; }
 };
 std::ostream& operator<<(std::ostream& os, const string& s);
 std::wostream& operator<<(std::wostream& os, const string& s);
-inline bool operator==(const string& l, const string& r) { return l.view() == r.view(); }
+inline bool operator==(const string& l, const string& r) { return l.unsafe_raw_get()->equals(*r.unsafe_raw_get()); }
 inline bool operator!=(const string& l, const string& r) { return !(l == r); }
 inline string operator+(const string& l, const string& r) {
-    // TODO: Optimize this
-    return string{l.heap(), std::wstring{l.view()} + std::wstring{r.view()}};
+    return string{gc_string::concat(l.heap(), l.unsafe_raw_get(), r.unsafe_raw_get())};
 }
 
-double to_number(const std::wstring_view& s);
+double to_number(const std::u16string_view& s);
 double to_number(const string& s);
 
+//
+// Builds a string directly in the heap: characters are appended to a flat/one-byte gc_string allocated with spare
+// capacity (reallocated as needed like std::basic_string), and release() shrinks the allocation to fit rather than copying
+// the result. The string stays one-byte until a character that doesn't fit is appended.
+// The builder keeps its buffer alive, so it can be used across garbage collections (e.g. when converting values to strings
+// calls into JavaScript).
+//
+class string_builder {
+public:
+    explicit string_builder(gc_heap& h, uint32_t capacity = 0) : heap_(h) {
+        reserve(capacity);
+    }
+    string_builder(const string_builder&) = delete;
+    string_builder& operator=(const string_builder&) = delete;
+
+    uint32_t length() const { return length_; }
+
+    // Make room for at least 'capacity' characters in total
+    void reserve(uint32_t capacity) {
+        if (capacity > capacity_) {
+            grow(capacity, !one_byte_);
+        }
+    }
+
+    string_builder& append(char16_t ch) {
+        if (length_ == capacity_ || (ch > 0xFF && one_byte_)) {
+            grow(length_ + 1, !one_byte_ || ch > 0xFF);
+        }
+        auto& b = *buffer_;
+        if (one_byte_) {
+            b.chars()[length_++] = static_cast<char>(ch);
+        } else {
+            b.data()[length_++] = ch;
+        }
+        return *this;
+    }
+
+    // Note: chars are Latin-1 (as for one-byte gc_strings)
+    template<typename CharT>
+    string_builder& append(std::basic_string_view<CharT> s) {
+        const auto len = static_cast<uint32_t>(s.length());
+        if (!len) {
+            return *this;
+        }
+        bool one_byte = one_byte_;
+        if constexpr (!std::is_same_v<CharT, char>) {
+            one_byte = one_byte && std::all_of(s.begin(), s.end(), [](CharT ch) { return char_code(ch) <= 0xFF; });
+        }
+        if (len > capacity_ - length_ || one_byte != one_byte_) {
+            grow(length_ + len, !one_byte);
+        }
+        auto& b = *buffer_;
+        if (one_byte_) {
+            copy_chars(b.chars() + length_, s);
+        } else {
+            copy_chars(b.data() + length_, s);
+        }
+        length_ += len;
+        return *this;
+    }
+
+    string_builder& append(const char16_t* s) { return append(std::u16string_view{s}); }
+    string_builder& append(const char* s) { return append(std::string_view{s}); }
+    string_builder& append(const string& s) { return s.visit([this](auto v) -> string_builder& { return append(v); }); }
+    // Appends ToString(n)
+    string_builder& append_number(double n);
+
+    // Returns the string built so far and leaves the builder empty
+    string release();
+
+private:
+    gc_heap& heap_;
+    gc_heap_ptr<gc_string> buffer_;
+    uint32_t length_ = 0;
+    uint32_t capacity_ = 0;
+    bool one_byte_ = true;
+
+    // Reallocate the buffer with room for at least 'min_capacity' characters (using char16_t if 'wide' is set)
+    void grow(uint32_t min_capacity, bool wide);
+};
+
+//
+// Table of interned strings ("atoms") owned by the heap. There is at most one atom with a given content, so atoms can
+// be compared by address. Property names are stored as atoms (see object_shape).
+// The table only holds weak references, atoms that are no longer used are removed when the heap is garbage collected.
+//
+class atom_table : public gc_weak_table {
+public:
+    // Returns the atom table of 'h' (creating it if necessary)
+    static atom_table& of(gc_heap& h) {
+        if (auto t = h.weak_table()) {
+            return static_cast<atom_table&>(*t);
+        }
+        return create(h);
+    }
+
+    // Returns the atom with the same contents as 's' ('s' itself if there isn't one yet)
+    string intern(const string& s);
+
+    // Returns the atom with the contents 's' or nullptr if there is none (so no property can have the name 's')
+    // Only valid until the next garbage collection
+    const gc_string* find(std::u16string_view s) const;
+    const gc_string* find(const gc_string& s) const;
+
+    uint32_t size() const { return size_; }
+
+private:
+    struct entry {
+        uint32_t hash;
+        gc_heap_weak_ptr_untracked<gc_string> s;
+    };
+
+    gc_heap& heap_;
+    std::vector<entry> entries_; // Open addressing (linear probing), the capacity is a power of two
+    uint32_t size_ = 0;
+
+    explicit atom_table(gc_heap& h);
+    static atom_table& create(gc_heap& h);
+
+    const gc_string* find(const gc_string& s, uint32_t hash) const;
+    void insert(const entry& e);
+    void rehash(uint32_t capacity);
+
+    void fixup(gc_heap& h) override;
+    void sweep() override;
+};
+
 constexpr uint32_t invalid_index_value = UINT32_MAX;
 
 // Convert 'str' to an index value. Returns invalid_index_value if the conversion failed.
-uint32_t index_value_from_string(const std::wstring_view& str);
+uint32_t index_value_from_string(const std::u16string_view& str);
 
 } // namespace mjs
 
@@ -21,14 +21,14 @@ inline const value& get_arg(const std::vector<value>& args, int index) {
 
 class string_object : public native_object {
 public:
-    value get(const std::wstring_view& name) const override {
+    value get(const std::u16string_view& name) const override {
         if (const auto s = handle_array_like_access(name); !s.empty()) {
             return value{string{heap(), s}};
         }
         return native_object::get(name);
     }
 
-    bool delete_property(const std::wstring_view& name) override {
+    bool delete_property(const std::u16string_view& name) override {
         if (const auto s = handle_array_like_access(name); !s.empty()) {
             return false;
         }
@@ -48,7 +48,7 @@ private:
     gc_heap_ptr_untracked<gc_string> value_;
     bool is_v5_or_later_;
 
-    std::wstring_view handle_array_like_access(const std::wstring_view property_name) const {
+    std::u16string_view handle_array_like_access(const std::u16string_view property_name) const {
         if (is_v5_or_later_) {
             if (const uint32_t index = index_value_from_string(property_name); index != invalid_index_value) {
                 auto v = view();
@@ -60,12 +60,12 @@ private:
         return {};
     }
 
-    std::wstring_view view() const {
+    std::u16string_view view() const {
         return value_.dereference(heap()).view();
     }
 
     value get_length() const {
-        return value{static_cast<double>(view().length())};
+        return value{static_cast<double>(value_.dereference(heap()).length())};
     }
 
     explicit string_object(const string& class_name, const object_ptr& prototype, const string& val, bool is_v5_or_later)
@@ -88,7 +88,7 @@ private:
         return native_object::do_redefine_own_property(name, val, attr);
     }
 
-    property_attribute do_own_property_attributes(const std::wstring_view& name) const override {
+    property_attribute do_own_property_attributes(const std::u16string_view& name) const override {
         if (const auto s = handle_array_like_access(name); !s.empty()) {
             return property_attribute::read_only | property_attribute::dont_delete;
         }
@@ -107,7 +107,7 @@ private:
     }
 
     void do_debug_print_extra(std::wostream& os, int, int, int indent) const override {
-        os << std::wstring(indent, ' ') << "[[Value]]: \"" << cpp_quote(view()) << "\"\n";
+        os << std::u16string(indent, ' ') << "[[Value]]: \"" << cpp_quote(view()) << "\"\n";
     }
 };
 
@@ -126,7 +126,7 @@ global_object_create_result make_string_object(const gc_heap_ptr<global_object>&
     prototype->put(global->common_string("constructor"), value{c}, global_object::default_attributes);
 
     put_native_function(global, c, string{h, "fromCharCode"}, [&h](const value&, const std::vector<value>& args){
-        std::wstring s;
+        std::u16string s;
         for (const auto& a: args) {
             s.push_back(to_uint16(a));
         }
@@ -155,33 +155,37 @@ global_object_create_result make_string_object(const gc_heap_ptr<global_object>&
 
     make_string_function("charAt", 1, [&h](const string& s, const std::vector<value>& args){
         const int position = to_int32(get_arg(args, 0));
-        if (position < 0 || position >= static_cast<int>(s.view().length())) {
+        if (position < 0 || position >= static_cast<int>(s.length())) {
             return string{h, ""};
         }
-        return string{h, s.view().substr(position, 1)};
+        return s.substr(position, 1);
     });
 
     make_string_function("charCodeAt", 1, [](const string& s, const std::vector<value>& args){
         const int position = to_int32(get_arg(args, 0));
-        if (position < 0 || position >= static_cast<int>(s.view().length())) {
+        if (position < 0 || position >= static_cast<int>(s.length())) {
             return static_cast<double>(NAN);
         }
-        return static_cast<double>(s.view()[position]);
+        return static_cast<double>(s.visit([position](auto v) { return char_code(v[position]); }));
     });
 
     make_string_function("indexOf", 2, [&h](const string& s, const std::vector<value>& args){
         const auto& search_string = to_string(h, get_arg(args, 0));
         const int position = to_int32(get_arg(args, 1));
-        auto index = s.view().find(search_string.view(), position);
-        return index == std::wstring_view::npos ? -1. : static_cast<double>(index);
+        auto index = s.visit([&](auto v) {
+            return search_string.visit([&](auto p) { return find_chars(v, p, position); });
+        });
+        return index == std::u16string_view::npos ? -1. : static_cast<double>(index);
     });
 
     make_string_function("lastIndexOf", 2, [&h](const string& s, const std::vector<value>& args){
         const auto& search_string = to_string(h, get_arg(args, 0));
         double position = to_number(get_arg(args, 1));
         const int ipos = std::isnan(position) ? INT_MAX : to_int32(position);
-        auto index = s.view().rfind(search_string.view(), ipos);
-        return index == std::wstring_view::npos ? -1. : static_cast<double>(index);
+        auto index = s.visit([&](auto v) {
+            return search_string.visit([&](auto p) { return rfind_chars(v, p, ipos); });
+        });
+        return index == std::u16string_view::npos ? -1. : static_cast<double>(index);
     });
 
     make_string_function("split", 1, [global](const string& str, const std::vector<value>& args){
@@ -189,58 +193,61 @@ global_object_create_result make_string_object(const gc_heap_ptr<global_object>&
         auto& h = global->heap();
         auto a = make_array(global, 0);
         if (args.empty()) {
-            a->put(string{h, index_string(0)}, value{string{h, s}});
+            a->put(string{h, index_string(0)}, value{str});
         } else {
             const auto sep = to_string(h, args.front());
             if (sep.view().empty()) {
                 for (uint32_t i = 0; i < s.length(); ++i) {
-                    a->put(string{h, index_string(i)}, value{string{ h, s.substr(i,1) }});
+                    a->put(string{h, index_string(i)}, value{str.substr(i, 1)});
                 }
             } else {
                 size_t pos = 0;
                 uint32_t i = 0;
                 for (; pos < s.length(); ++i) {
                     const auto next_pos = s.find(sep.view(), pos);
-                    if (next_pos == std::wstring_view::npos) {
+                    if (next_pos == std::u16string_view::npos) {
                         break;
                     }
-                    a->put(string{h, index_string(i)}, value{string{ h, s.substr(pos, next_pos-pos) }});
+                    a->put(string{h, index_string(i)}, value{str.substr(pos, next_pos-pos)});
                     pos = next_pos + 1;
                 }
                 if (pos < s.length()) {
-                    a->put(string{h, index_string(i)}, value{string{ h, s.substr(pos) }});
+                    a->put(string{h, index_string(i)}, value{str.substr(pos)});
                 }
             }
         }
         return a;
     });
 
-    make_string_function("substring", 1, [&h](const string& str, const std::vector<value>& args) {
-        const auto s = str.view();
-        int start = std::min(std::max(to_int32(get_arg(args, 0)), 0), static_cast<int>(s.length()));
+    make_string_function("substring", 1, [](const string& str, const std::vector<value>& args) {
+        int start = std::min(std::max(to_int32(get_arg(args, 0)), 0), static_cast<int>(str.length()));
         if (args.size() < 2) {
-            return string{h, s.substr(start)};
+            return str.substr(start);
         }
-        int end = std::min(std::max(to_int32(get_arg(args, 1)), 0), static_cast<int>(s.length()));
+        int end = std::min(std::max(to_int32(get_arg(args, 1)), 0), static_cast<int>(str.length()));
         if (start > end) {
             std::swap(start, end);
         }
-        return string{h, s.substr(start, end-start)};
+        return str.substr(start, end-start);
     });
 
     auto to_lower = [&h](const string& s, const std::vector<value>&){
-        std::wstring res;
-        for (auto c: s.view()) {
-            res.push_back(towlower(c));
-        }
+        std::u16string res;
+        s.visit([&res](auto v) {
+            for (auto c: v) {
+                res.push_back(static_cast<char16_t>(towlower(char_code(c))));
+            }
+        });
         return string{h, res};
     };
 
     auto to_upper = [&h](const string& s, const std::vector<value>&){
-        std::wstring res;
-        for (auto c: s.view()) {
-            res.push_back(towupper(c));
-        }
+        std::u16string res;
+        s.visit([&res](auto v) {
+            for (auto c: v) {
+                res.push_back(static_cast<char16_t>(towupper(char_code(c))));
+            }
+        });
         return string{h, res};
     };
 
@@ -251,25 +258,24 @@ global_object_create_result make_string_object(const gc_heap_ptr<global_object>&
         make_string_function("toLocaleLowerCase", 0, to_lower);
         make_string_function("toLocaleUpperCase", 0, to_upper);
         make_string_function("localeCompare", 1, [&h](const string& s, const std::vector<value>& args){
-            const auto res = s.view().compare(to_string(h, get_arg(args, 0)).view());
+            const auto res = s.unsafe_raw_get()->compare(*to_string(h, get_arg(args, 0)).unsafe_raw_get());
             return value{ static_cast<double>(res < 0 ? 1 : res > 0 ? -1 : 0) };
         });
         make_string_function("concat", 1, [&h](const string& s, const std::vector<value>& args) {
-            std::wstring res{s.view()};
+            std::u16string res{s.view()};
             for (const auto& a: args) {
                 res += to_string(h, a).view();
             }
             return value{string{h, res}};
         });
-        make_string_function("slice", 2, [&h](const string& str, const std::vector<value>& args) {
-            const auto s = str.view();
-            const auto l = static_cast<uint32_t>(s.length());
+        make_string_function("slice", 2, [](const string& str, const std::vector<value>& args) {
+            const auto l = str.length();
             const auto ns = to_integer(get_arg(args, 0));
             const auto& end_arg = get_arg(args, 1);
             const auto ne = end_arg.type() == value_type::undefined ? l : to_integer(end_arg);
             const auto start = static_cast<uint32_t>(ns < 0 ? std::max(l + ns, 0.0) : std::min(ns, 0.0+l));
             const auto end   = static_cast<uint32_t>(ne < 0 ? std::max(l + ne, 0.0) : std::min(ne, 0.0+l));
-            return value{string{h, s.substr(start, start < end ? end - start : 0)}};
+            return value{str.substr(start, start < end ? end - start : 0)};
         });
         make_string_function("match", 1, [global](const string& s, const std::vector<value>& args) {
             return string_match(global, s, get_arg(args, 0));
@@ -291,7 +297,9 @@ global_object_create_result make_string_object(const gc_heap_ptr<global_object>&
             }
             auto& h = global->heap();
             auto s = to_string(h, this_);
-            return value{string{h, trim(s.view(), ver)}};
+            const auto v = s.view();
+            const auto trimmed = trim(v, ver);
+            return value{s.substr(trimmed.data() - v.data(), trimmed.length())};
         }, 0);
 
         put_native_function(global, prototype, string{h, "substr"}, [global, ver = global->language_version()](const value& this_, const std::vector<value>& args) {
@@ -304,7 +312,7 @@ global_object_create_result make_string_object(const gc_heap_ptr<global_object>&
             // 3
             auto length = args.size() < 2 || args[1].type() == value_type::undefined ? +INFINITY : to_integer(args[1]);
             // 4
-            const auto str_len = str.view().length();
+            const auto str_len = str.length();
             // 5
             if (start < 0) start = std::max(str_len + start, 0.);
             // 6
@@ -312,7 +320,7 @@ global_object_create_result make_string_object(const gc_heap_ptr<global_object>&
             // 7
             if (length <= 0) return value{string{h, ""}};
             // 8
-            return value{string{h, str.view().substr(static_cast<size_t>(start), static_cast<size_t>(length))}};
+            return value{str.substr(static_cast<size_t>(start), static_cast<size_t>(length))};
         }, 2);
     }
 
@@ -324,7 +332,7 @@ object_ptr new_string(const gc_heap_ptr<global_object>& global, const string& va
     return global->heap().make<string_object>(proto->class_name(), proto, val, global->language_version() >= version::es5);
 }
 
-std::wstring_view ltrim(std::wstring_view s, version ver) {
+std::u16string_view ltrim(std::u16string_view s, version ver) {
     size_t start_pos = 0;
     while (start_pos < s.length() && is_whitespace_or_line_terminator(s[start_pos], ver)) {
         ++start_pos;
@@ -332,7 +340,7 @@ std::wstring_view ltrim(std::wstring_view s, version ver) {
     return s.substr(start_pos);
 }
 
-std::wstring_view rtrim(std::wstring_view s, version ver) {
+std::u16string_view rtrim(std::u16string_view s, version ver) {
     size_t end_pos = s.length();
     while (end_pos && is_whitespace_or_line_terminator(s[end_pos-1], ver)) {
         --end_pos;
@@ -340,7 +348,7 @@ std::wstring_view rtrim(std::wstring_view s, version ver) {
     return s.substr(0, end_pos);
 }
 
-std::wstring_view trim(std::wstring_view s, version ver) {
+std::u16string_view trim(std::u16string_view s, version ver) {
     return rtrim(ltrim(s, ver), ver);
 }
 
@@ -9,9 +9,9 @@ global_object_create_result make_string_object(const gc_heap_ptr<global_object>&
 
 object_ptr new_string(const gc_heap_ptr<global_object>& global, const string& val);
 
-std::wstring_view ltrim(std::wstring_view s, version ver);
-std::wstring_view rtrim(std::wstring_view s, version ver);
-std::wstring_view trim(std::wstring_view s, version ver);
+std::u16string_view ltrim(std::u16string_view s, version ver);
+std::u16string_view rtrim(std::u16string_view s, version ver);
+std::u16string_view trim(std::u16string_view s, version ver);
 
 } // namespace mjs
 
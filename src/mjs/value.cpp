@@ -44,7 +44,7 @@ value& value::operator=(const value& rhs) {
         case value_type::undefined: break;
         case value_type::null:      break;
         case value_type::boolean:   b_ = rhs.b_; break;
-        case value_type::number:    n_ = rhs.n_; break;
+        case value_type::number:    n_ = rhs.n_; int32_ = rhs.int32_; break;
         case value_type::string:    new (&s_) string{rhs.s_}; break;
         case value_type::object:    new (&o_) object_ptr{rhs.o_}; break;
         case value_type::reference: new (&r_) reference{rhs.r_}; break;
@@ -60,7 +60,7 @@ value& value::operator=(value&& rhs) {
     case value_type::undefined: break;
     case value_type::null:      break;
     case value_type::boolean:   b_ = rhs.b_; break;
-    case value_type::number:    n_ = rhs.n_; break;
+    case value_type::number:    n_ = rhs.n_; int32_ = rhs.int32_; break;
     case value_type::string:    new (&s_) string{std::move(rhs.s_)}; break;
     case value_type::object:    new (&o_) object_ptr{std::move(rhs.o_)}; break;
     case value_type::reference: new (&r_) reference{std::move(rhs.r_)}; break;
@@ -82,6 +82,7 @@ void value::destroy() {
     default: NOT_IMPLEMENTED(type_);
     }
     type_ = value_type::undefined;
+    int32_ = false;
 }
 
 bool operator==(const value& l, const value& r) {
@@ -97,7 +98,7 @@ bool operator==(const value& l, const value& r) {
         const double lv = l.number_value(), rv = r.number_value();
         return lv == rv || (std::isnan(lv) && std::isnan(rv));
     }
-    case value_type::string:    return l.string_value().view() == r.string_value().view();
+    case value_type::string:    return l.string_value() == r.string_value();
     case value_type::object:    return l.object_value().get() == r.object_value().get();
     case value_type::reference: break;
     }
@@ -123,7 +124,7 @@ value to_primitive(const value& v, value_type hint) {
 
     assert(hint == value_type::number || hint == value_type::string);
     for (int i = 0; i < 2; ++i) {
-        const wchar_t* const id = (hint == value_type::string) ^ i ? L"toString" : L"valueOf";
+        const char16_t* const id = (hint == value_type::string) ^ i ? u"toString" : u"valueOf";
         const auto fo = o->get(id);
         if (fo.type() != value_type::object) {
             continue;
@@ -144,7 +145,7 @@ bool to_boolean(const value& v) {
     case value_type::null:      return false;
     case value_type::boolean:   return v.boolean_value();
     case value_type::number:    return v.number_value() != 0 && !std::isnan(v.number_value());
-    case value_type::string:    return !v.string_value().view().empty();
+    case value_type::string:    return v.string_value().length() != 0;
     case value_type::object:    return true;
     case value_type::reference: break;
     }
@@ -187,6 +188,9 @@ int32_t to_int32(double n) {
 }
 
 int32_t to_int32(const value& v) {
+    if (v.type() == value_type::number && v.is_int32()) {
+        return v.int32_value();
+    }
     return to_int32(to_number(v));
 }
 
@@ -202,6 +206,9 @@ uint32_t to_uint32(double n) {
 }
 
 uint32_t to_uint32(const value& v) {
+    if (v.type() == value_type::number && v.is_int32()) {
+        return static_cast<uint32_t>(v.int32_value());
+    }
     return to_uint32(to_number(v));
 }
 
@@ -214,7 +221,8 @@ uint16_t to_uint16(const value& v) {
 }
 
 string to_string(gc_heap& h, double m) {
-    return string{h, number_to_string(m)};
+    char buf[number_to_chars_max];
+    return string{h, std::string_view{buf, static_cast<size_t>(number_to_chars(buf, m))}};
 }
 
 string to_string(gc_heap& h, const value& v) {
@@ -222,7 +230,7 @@ string to_string(gc_heap& h, const value& v) {
     case value_type::undefined: return string{h, "undefined"};
     case value_type::null:      return string{h, "null"};
     case value_type::boolean:   return string{h, v.boolean_value() ? "true" : "false"};
-    case value_type::number:    return to_string(h, v.number_value());
+    case value_type::number:    return v.is_int32() ? string{h, std::to_string(v.int32_value())} : to_string(h, v.number_value());
     case value_type::string:    return v.string_value();
     case value_type::object:    return to_string(h, to_primitive(v, value_type::string));
     case value_type::reference: break;
@@ -254,7 +262,7 @@ void debug_print(std::wostream& os, const value& v, int indent_incr, int max_nes
             case '\r': os << "\\r"; break;
             case '\t': os << "\\t"; break;
             default:
-                os << ch;
+                os << static_cast<wchar_t>(ch);
             }
         }
         os << "'";
@@ -277,10 +285,10 @@ void debug_print(std::wostream& os, const value& v, int indent_incr, int max_nes
     }
 }
 
-std::wstring debug_string(const value& v) {
+std::u16string debug_string(const value& v) {
     std::wostringstream woss;
     debug_print(woss, v, 4, 0);
-    return woss.str();
+    return to_u16string(woss.str());
 }
 
 [[noreturn]] void throw_runtime_error(const std::string_view& s, const char* file, int line) {
@@ -289,6 +297,10 @@ std::wstring debug_string(const value& v) {
     throw std::runtime_error(oss.str());
 }
 
+[[noreturn]] void throw_runtime_error(const std::u16string_view& s, const char* file, int line) {
+    throw_runtime_error(std::string(s.begin(), s.end()), file, line);
+}
+
 [[noreturn]] void throw_runtime_error(const std::wstring_view& s, const char* file, int line) {
     throw_runtime_error(std::string(s.begin(), s.end()), file, line);
 }
@@ -7,6 +7,7 @@
 #include <cassert>
 #include <stdint.h>
 #include <climits>
+#include <cmath>
 #include <vector>
 
 #include "string.h"
@@ -52,6 +53,7 @@ public:
     explicit value() : type_(value_type::undefined) {}
     explicit value(bool b) : type_(value_type::boolean), b_(b) {}
     explicit value(double n) : type_(value_type::number), n_(n) {}
+    explicit value(int32_t n) : type_(value_type::number), int32_(true), n_(n) {}
     explicit value(const string& s) : type_(value_type::string), s_(s) {}
     explicit value(const object_ptr& o) : type_(value_type::object), o_(o) {}
     explicit value(const reference& r) : type_(value_type::reference), r_(r) {}
@@ -66,6 +68,9 @@ public:
     value_type type() const { return type_; }
     bool boolean_value() const { assert(type_ == value_type::boolean); return b_; }
     double number_value() const { assert(type_ == value_type::number); return n_; }
+    // Numbers created from an int32_t keep that representation (number_value() still works), see make_number_value
+    bool is_int32() const { return int32_; }
+    int32_t int32_value() const { assert(int32_); return static_cast<int32_t>(n_); }
     const string& string_value() const { assert(type_ == value_type::string); return s_; }
     const object_ptr& object_value() const { assert(type_ == value_type::object); return o_; }
     const reference& reference_value() const { assert(type_ == value_type::reference); return r_; }
@@ -78,6 +83,7 @@ private:
     void destroy();
 
     value_type type_;
+    bool int32_ = false;
     union {
         bool b_;
         double n_;
@@ -91,6 +97,17 @@ inline bool operator!=(const value& l, const value& r) {
     return !(l == r);
 }
 
+// Returns 'n' using the int32 representation if that's possible without losing information (i.e. it's integral and not -0)
+inline value make_number_value(double n) {
+    if (n >= INT32_MIN && n <= INT32_MAX) {
+        const auto i = static_cast<int32_t>(n);
+        if (i == n && (i || !std::signbit(n))) {
+            return value{i};
+        }
+    }
+    return value{n};
+}
+
 // §9 Type Conversions
 class to_primitive_failed_error : public std::exception {
 public:
@@ -113,9 +130,10 @@ string to_string(gc_heap& h, double n);
 string to_string(gc_heap& h, const value& v);
 
 void debug_print(std::wostream& os, const value& v, int indent_incr, int max_nest = INT_MAX, int indent = 0);
-std::wstring debug_string(const value& v);
+std::u16string debug_string(const value& v);
 
 [[noreturn]] void throw_runtime_error(const std::string_view& s, const char* file, int line);
+[[noreturn]] void throw_runtime_error(const std::u16string_view& s, const char* file, int line);
 [[noreturn]] void throw_runtime_error(const std::wstring_view& s, const char* file, int line);
 
 #define THROW_RUNTIME_ERROR(msg) ::mjs::throw_runtime_error(msg, __FILE__, __LINE__)
@@ -37,6 +37,13 @@ static uint64_t number_repr(double d) {
     return repr;
 }
 
+value_representation value_representation::reference_placeholder(uint32_t index) {
+    static_assert(reference_tag == make_repr(value_type::reference, 0) >> 32);
+    value_representation r;
+    r.repr_ = make_repr(value_type::reference, index);
+    return r;
+}
+
 value_representation::value_representation(double num) : repr_(number_repr(num)) {
 }
 
@@ -45,7 +52,7 @@ value_representation::value_representation(const value& v) {
     case value_type::undefined: [[fallthrough]];
     case value_type::null:      repr_ = make_repr(v.type(), 0); return;
     case value_type::boolean:   repr_ = make_repr(v.type(), v.boolean_value()); return;
-    case value_type::number:    repr_ = number_repr(v.number_value()); return;
+    case value_type::number:    repr_ = v.is_int32() ? make_repr(v.type(), static_cast<uint32_t>(v.int32_value())) : number_repr(v.number_value()); return;
     case value_type::string:    repr_ = make_repr(v.type(), v.string_value().unsafe_raw_get().pos_); return;
     case value_type::object:    repr_ = make_repr(v.type(), v.object_value().pos_); return;
     case value_type::reference: break; // Not legal here
@@ -56,6 +63,19 @@ value_representation::value_representation(const value& v) {
     THROW_RUNTIME_ERROR(woss.str());
 }
 
+value_representation& value_representation::operator=(const value& v) {
+    repr_ = value_representation{v}.repr_;
+    // Let the heap know in case a pointer to a young object was stored in an old one
+    if (v.type() == value_type::string) {
+        const auto& p = v.string_value().unsafe_raw_get();
+        p.heap_->record_store(this, p.pos_);
+    } else if (v.type() == value_type::object) {
+        const auto& p = v.object_value();
+        p.heap_->record_store(this, p.pos_);
+    }
+    return *this;
+}
+
 value value_representation::get_value(gc_heap& heap) const {
     if (!is_special(repr_)) {
         double d;
@@ -69,7 +89,7 @@ value value_representation::get_value(gc_heap& heap) const {
     case value_type::undefined: assert(!payload); return value::undefined;
     case value_type::null:      assert(!payload); return value::null;
     case value_type::boolean:   assert(payload == 0 || payload == 1); return value{!!payload};
-    case value_type::number:    /*should be handled above*/ break;
+    case value_type::number:    return value{static_cast<int32_t>(payload)}; // Other numbers are handled above
     case value_type::string:    return value{string{heap.unsafe_create_from_position<gc_string>(payload)}};
     case value_type::object:    return value{heap.unsafe_create_from_position<object>(payload)};
     default:                    break;
@@ -80,7 +100,7 @@ value value_representation::get_value(gc_heap& heap) const {
 }
 
 void value_representation::fixup(gc_heap& old_heap) {
-    if (!is_special(repr_)) {
+    if (!is_special(repr_) || is_hole()) {
         return;
     }
     const auto type = type_from_repr(repr_);
@@ -88,7 +108,8 @@ void value_representation::fixup(gc_heap& old_heap) {
     case value_type::undefined: [[fallthrough]];
     case value_type::null:      [[fallthrough]];
     case value_type::boolean:   [[fallthrough]];
-    case value_type::number:
+    case value_type::number:    [[fallthrough]];
+    case value_type::reference: // Placeholder
         return;
     case value_type::string:    [[fallthrough]];
     case value_type::object:
@@ -8,14 +8,42 @@ namespace mjs {
 class value;
 class gc_heap;
 
+//
+// NaN-boxed value (64-bits). Numbers are stored as is (with NaNs canonicalized), other values are encoded in the
+// payload of NaNs with a type tag: undefined, null, booleans, int32 numbers (see value::is_int32) and pointers
+// (heap positions) to strings and objects.
+//
+// The representation is trivially copyable, so pointers held in it must be found by the garbage collector some other way:
+// either it's stored inside a heap object (whose fixup function calls fixup()) or in a gc_root_set.
+//
 class value_representation {
 public:
     value_representation() = default;
     explicit value_representation(double num);
     explicit value_representation(const value& v);
+    value_representation& operator=(const value& v);
     value get_value(gc_heap& heap) const;
     void fixup(gc_heap& old_heap);
+
+    // Marks a missing element in dense storage (see array_object), never a valid value
+    static value_representation hole() {
+        value_representation r;
+        r.repr_ = hole_repr;
+        return r;
+    }
+    bool is_hole() const { return repr_ == hole_repr; }
+
+    // Stands in for a reference (which doesn't fit in 64-bits), 'index' identifies it to the owner (see value_stack in interpreter.cpp)
+    static value_representation reference_placeholder(uint32_t index);
+    bool is_reference_placeholder() const { return (repr_ >> 32) == reference_tag; }
+    uint32_t placeholder_index() const { return static_cast<uint32_t>(repr_); }
+
+    // Raw bits (used by the JIT compiler)
+    uint64_t raw() const { return repr_; }
+
 private:
+    static constexpr uint64_t hole_repr = 0x7fffULL << 48; // A NaN with a type tag no value uses
+    static constexpr uint32_t reference_tag = 0x7ff70000; // High 32 bits of reference placeholders
     uint64_t repr_;
 };
 
@@ -4,15 +4,21 @@
 #include <mjs/printer.h>
 #include <mjs/platform.h>
 #include <sstream>
+#include <cstring>
 
 using namespace mjs;
 
 version tested_version_ = version::latest;
+interpreter_engine tested_engine_ = interpreter_engine::ast;
 
 mjs::version tested_version() {
     return tested_version_;
 }
 
+mjs::interpreter_engine tested_engine() {
+    return tested_engine_;
+}
+
 static const char* run_test_func;
 static const char* run_test_file;
 static int run_test_line;
@@ -22,13 +28,13 @@ void run_test_debug_pos(const char* func, const char* file, int line) {
     run_test_line = line;
 }
 
-void run_test(const std::wstring_view& text, const value& expected) {
+void run_test(const std::u16string_view& text, const value& expected) {
     assert(run_test_func && run_test_file && run_test_line);
 
     // Use local heap, even if expected lives in another heap
     constexpr uint32_t num_slots = 1<<21;
-#ifndef MJS_GC_STRESS_TEST
-    // Re-use storage unless we're stress testing
+#if !defined(MJS_GC_STRESS_TEST) && !defined(MJS_GC_INCREMENTAL_STRESS_TEST)
+    // Re-use storage unless we're stress testing (heaps using fixed storage are never collected incrementally)
     static uint64_t storage[num_slots];
     gc_heap h{storage, num_slots};
 #else
@@ -38,7 +44,7 @@ void run_test(const std::wstring_view& text, const value& expected) {
     {
         decltype(parse(nullptr)) bs;
         try {
-            bs = parse(std::make_shared<source_file>(L"test", text, tested_version()));
+            bs = parse(std::make_shared<source_file>(u"test", text, tested_version()));
         } catch (const std::exception& e) {
             std::wcout << "Parse failed for \"" << text << "\": " << e.what() <<  "\n";
             throw;
@@ -73,7 +79,7 @@ void run_test(const std::wstring_view& text, const value& expected) {
         };
         value res;
         try {
-            interpreter i{h, tested_version()};
+            interpreter i{h, tested_version(), {}, tested_engine()};
             res = i.eval(*bs);
         } catch (const std::exception& e) {
             pb();
@@ -95,10 +101,10 @@ void run_test(const std::wstring_view& text, const value& expected) {
     }
 }
 
-std::string expect_eval_exception(const std::wstring_view& text) {
+std::string expect_eval_exception(const std::u16string_view& text) {
     decltype(parse(nullptr)) bs;
     try {
-        bs = parse(std::make_shared<source_file>(L"test", text, tested_version()));
+        bs = parse(std::make_shared<source_file>(u"test", text, tested_version()));
     } catch (const std::exception& e) {
         std::wcout << "Parse failed for \"" << text << "\": " << e.what() <<  "\n";
         throw;
@@ -106,7 +112,7 @@ std::string expect_eval_exception(const std::wstring_view& text) {
 
     try {
         gc_heap h{1<<20}; // Use local heap, even if expected lives in another heap
-        interpreter i{h, tested_version()};
+        interpreter i{h, tested_version(), {}, tested_engine()};
         (void) i.eval(*bs);
     } catch (const eval_exception& e) {
         return e.what();
@@ -135,8 +141,16 @@ bool operator==(const token& l, const token& r) {
 
 }  // namespace mjs
 
-int main() {
+int main(int argc, char* argv[]) {
     platform_init();
+    if (argc > 1 && !std::strcmp(argv[1], "bytecode")) {
+        tested_engine_ = interpreter_engine::bytecode;
+    } else if (argc > 1 && !std::strcmp(argv[1], "jit")) {
+        tested_engine_ = interpreter_engine::jit;
+    } else if (argc > 1) {
+        std::wcerr << "Usage: " << argv[0] << " [bytecode|jit]\n";
+        return 1;
+    }
     try {
         // Start by testing latest version
         tested_version_ = version::latest;
@@ -152,6 +166,7 @@ int main() {
     } catch (const std::exception& e) {
         std::wcerr << e.what() << "\n";
         std::wcerr << "Tested version: " << tested_version() << "\n";
+        std::wcerr << "Tested engine: " << tested_engine() << "\n";
         return 1;
     }
     return 0;
@@ -27,16 +27,28 @@ std::basic_ostream<CharT>& operator<<(std::basic_ostream<CharT>& os, const mjs::
     return os;
 }
 
+namespace mjs { enum class interpreter_engine; }
+
 extern mjs::version tested_version();
+extern mjs::interpreter_engine tested_engine();
 
 extern void run_test_debug_pos(const char* func, const char* file, int line);
-extern void run_test(const std::wstring_view& text, const mjs::value& expected);
+extern void run_test(const std::u16string_view& text, const mjs::value& expected);
 #define RUN_TEST run_test_debug_pos(__func__, __FILE__, __LINE__); run_test// yuck...
 
-extern std::string expect_eval_exception(const std::wstring_view& text);
+extern std::string expect_eval_exception(const std::u16string_view& text);
 
 namespace mjs {
 
+// Print UTF-16 text (rather than a pointer/number) when a test fails
+inline std::wostream& operator<<(std::wostream& os, const char16_t* s) {
+    return os << std::u16string_view{s};
+}
+
+inline std::wostream& operator<<(std::wostream& os, char16_t ch) {
+    return os << static_cast<wchar_t>(ch);
+}
+
 class token;
 bool operator==(const token& l, const token& r);
 
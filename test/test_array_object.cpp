@@ -9,33 +9,33 @@ void test_main() {
     gc_heap h{8192};
 
     // Array
-    RUN_TEST(L"Array.length", value{1.0});
-    RUN_TEST(L"Array.prototype.length", value{0.0});
-    RUN_TEST(L"new Array().length", value{0.0});
-    RUN_TEST(L"new Array(60).length", value{60.0});
-    RUN_TEST(L"new Array(1,2,3,4).length", value{4.0});
-    RUN_TEST(L"new Array(1,2,3,4)[3]", value{4.0});
-    RUN_TEST(L"new Array(1,2,3,4)[4]", value::undefined);
-    RUN_TEST(L"a=new Array(); a[5]=42; a.length", value{6.0});
-    RUN_TEST(L"a=new Array(); a[5]=42; a[3]=2; a.length", value{6.0});
-    RUN_TEST(L"a=new Array(1,2,3,4); a.length=2; a.length", value{2.0});
-    RUN_TEST(L"a=new Array(1,2,3,4); a.length=2; a[3]", value::undefined);
-    RUN_TEST(L"''+Array()", value{string{h, ""}});
-    RUN_TEST(L"a=Array();a[0]=1;''+a", value{string{h, "1"}});
-    RUN_TEST(L"''+Array(1,2,3,4)", value{string{h, "1,2,3,4"}});
-    RUN_TEST(L"Array(1,2,3,4).join()", value{string{h, "1,2,3,4"}});
-    RUN_TEST(L"Array(1,2,3,4).join('')", value{string{h, "1234"}});
-    RUN_TEST(L"Array(4).join()", value{string{h, ",,,"}});
-    RUN_TEST(L"Array(1,2,3,4).reverse()+''", value{string{h, "4,3,2,1"}});
-    RUN_TEST(L"''+Array('March', 'Jan', 'Feb', 'Dec').sort()", value{string{h, "Dec,Feb,Jan,March"}});
-    RUN_TEST(L"''+Array(1,30,4,21).sort()", value{string{h, "1,21,30,4"}});
-    RUN_TEST(L"function c(x,y) { return x-y; }; ''+Array(1,30,4,21).sort(c)", value{string{h, "1,4,21,30"}});
-    RUN_TEST(L"new Array(1).toString()", value{string{h, ""}});
-    RUN_TEST(L"new Array(1,2).toString()", value{string{h, "1,2"}});
-    RUN_TEST(L"+new Array(1)", value{0.});
-    RUN_TEST(L"+new Array(1,2)", value{NAN});
+    RUN_TEST(u"Array.length", value{1.0});
+    RUN_TEST(u"Array.prototype.length", value{0.0});
+    RUN_TEST(u"new Array().length", value{0.0});
+    RUN_TEST(u"new Array(60).length", value{60.0});
+    RUN_TEST(u"new Array(1,2,3,4).length", value{4.0});
+    RUN_TEST(u"new Array(1,2,3,4)[3]", value{4.0});
+    RUN_TEST(u"new Array(1,2,3,4)[4]", value::undefined);
+    RUN_TEST(u"a=new Array(); a[5]=42; a.length", value{6.0});
+    RUN_TEST(u"a=new Array(); a[5]=42; a[3]=2; a.length", value{6.0});
+    RUN_TEST(u"a=new Array(1,2,3,4); a.length=2; a.length", value{2.0});
+    RUN_TEST(u"a=new Array(1,2,3,4); a.length=2; a[3]", value::undefined);
+    RUN_TEST(u"''+Array()", value{string{h, ""}});
+    RUN_TEST(u"a=Array();a[0]=1;''+a", value{string{h, "1"}});
+    RUN_TEST(u"''+Array(1,2,3,4)", value{string{h, "1,2,3,4"}});
+    RUN_TEST(u"Array(1,2,3,4).join()", value{string{h, "1,2,3,4"}});
+    RUN_TEST(u"Array(1,2,3,4).join('')", value{string{h, "1234"}});
+    RUN_TEST(u"Array(4).join()", value{string{h, ",,,"}});
+    RUN_TEST(u"Array(1,2,3,4).reverse()+''", value{string{h, "4,3,2,1"}});
+    RUN_TEST(u"''+Array('March', 'Jan', 'Feb', 'Dec').sort()", value{string{h, "Dec,Feb,Jan,March"}});
+    RUN_TEST(u"''+Array(1,30,4,21).sort()", value{string{h, "1,21,30,4"}});
+    RUN_TEST(u"function c(x,y) { return x-y; }; ''+Array(1,30,4,21).sort(c)", value{string{h, "1,4,21,30"}});
+    RUN_TEST(u"new Array(1).toString()", value{string{h, ""}});
+    RUN_TEST(u"new Array(1,2).toString()", value{string{h, "1,2"}});
+    RUN_TEST(u"+new Array(1)", value{0.});
+    RUN_TEST(u"+new Array(1,2)", value{NAN});
     // Make sure we handle "large" arrays
-    RUN_TEST(L"a=new Array(500);for (var i=0; i<a.length; ++i) a[i] = i; sum=0; for (var i=0; i<a.length; ++i) sum += a[i]; sum", value{499*500/2.});
+    RUN_TEST(u"a=new Array(500);for (var i=0; i<a.length; ++i) a[i] = i; sum=0; for (var i=0; i<a.length; ++i) sum += a[i]; sum", value{499*500/2.});
 
     RUN_TEST_SPEC(R"(
 var a = new Array();
@@ -45,9 +45,9 @@ a[2] = 42;
 a.length; //$number 3
 a[7] = 100;
 a.length; //$number 8
-var s = ''; for (var k in a) s += k + ','; s //$string 'false,2,7,'
+var s = ''; for (var k in a) s += k + ','; s //$string '2,7,false,'
 a.length=4;
-s = ''; for (var k in a) s += k + ','; s //$string 'false,2,'
+s = ''; for (var k in a) s += k + ','; s //$string '2,false,'
 delete a[2];
 a.length; //$number 4
 s = ''; for (var k in a) s += k + ','; s //$string 'false,'
@@ -503,6 +503,23 @@ try {
     e.toString(); //$string 'RangeError: Invalid array length'
 }
 
+)");
+
+    // Elements moving between the dense and sparse storage
+    RUN_TEST_SPEC(R"(
+a = [1,2,3]; delete a[1]; a.length; //$number 3
+'' + (1 in a) + (2 in a); //$string 'falsetrue'
+a[1] = 2; a.join(); //$string '1,2,3'
+delete a[0]; a.join(); //$string ',2,3'
+a[100000] = 'x'; a.length; //$number 100001
+a.length = 2; a.join(); //$string ',2'
+a[1000] = 'y'; a.length = 3; a[2] = 3; a.join(); //$string ',2,3'
+a['01'] = 'z'; a[1]; //$number 2
+b = []; for (i = 0; i < 100; ++i) b.push(i); b.slice(97).join(); //$string '97,98,99'
+b.splice(1, 97).length; //$number 97
+b.join(); //$string '0,98,99'
+Array.prototype[3] = 'p'; c = []; c[5] = 1; c.join(); //$string ',,,p,,1'
+delete Array.prototype[3];
 )");
 
     if (tested_version() >= version::es5) {
@@ -516,6 +533,11 @@ a[2]; //$number 3
 x;//$number 12
 a[1]=10;
 x;//$number 22
+Object.defineProperty(Array.prototype, '1', {set: function(v) { x=v; }, configurable: true});
+b=[]; b[0]=1; b[1]=2; b[0]; //$number 1
+x;//$number 2
+delete Array.prototype[1];
+Object.defineProperty(b, '0', {writable: false}); b[0]=3; b[0]; //$number 1
 )");
     }
 }
@@ -34,7 +34,7 @@ void test_main() {
     constexpr int num_tests = sizeof(tests)/sizeof(*tests);
     gc_heap h{1<<20};
     int unexpected = 0;
-    const auto helper_code = unicode::utf8_to_utf16(helper_functions) + L";";
+    const auto helper_code = unicode::utf8_to_utf16(helper_functions) + u";";
     for (int i = 0; i < num_tests; ++i) {
         const auto& t = tests[i];
         const bool expect_failure = std::find(std::begin(expected_failures), std::end(expected_failures), i) != std::end(expected_failures);
@@ -50,18 +50,18 @@ void test_main() {
 
             t0 = std::chrono::high_resolution_clock::now();
 
-            auto code = unicode::utf8_to_utf16(t.prelude) +  helper_code + L"(function(){" + unicode::utf8_to_utf16(t.code) + L"})()";
+            auto code = unicode::utf8_to_utf16(t.prelude) +  helper_code + u"(function(){" + unicode::utf8_to_utf16(t.code) + u"})()";
             auto bs = parse(std::make_unique<source_file>(unicode::utf8_to_utf16(t.id), code, version::es5));
 
             t1 = std::chrono::high_resolution_clock::now();
 
             // Could be optimized to reuse interpreter but take to restore global object
-            interpreter interpreter_{h, version::es5};
+            interpreter interpreter_{h, version::es5, {}, tested_engine()};
             auto res = interpreter_.eval(*bs);
             if (res.type() != value_type::boolean || !res.boolean_value()) {
                 std::wostringstream woss;
                 woss << "Unexpected result: " << to_string(h, res).view();
-                throw std::runtime_error(unicode::utf16_to_utf8(woss.str()));
+                throw std::runtime_error(unicode::utf16_to_utf8(to_u16string(woss.str())));
             }
             if (expect_failure) {
                 std::wcerr << "Test " << std::setw(4) << i << " passed: " << std::setw(20) << std::left << t.id << std::right << " " <<  t.description << " -- EXPECTED FAILURE\n";
@@ -7,7 +7,7 @@ void test_main() {
     gc_heap h{256};
     // In ES3 prototype only has attributes DontDelete, in ES1 it's DontEnum
     const string expected_keys{h, tested_version() != version::es3 ? "" : "prototype,"};
-    RUN_TEST(L"s=''; function a(){}; for(k in a) { s+=k+','; }; s", value{expected_keys});
+    RUN_TEST(u"s=''; function a(){}; for(k in a) { s+=k+','; }; s", value{expected_keys});
     // length and are arguments should be DontDelete|DontEnum|ReadOnly
     RUN_TEST_SPEC(R"(
 function a(x,y,z){};
@@ -39,25 +39,25 @@ a.arguments; //$null
 
 
     // ES5.1, 15.3.5.2 "In Edition 5, the prototype property of Function instances is not enumerable. In Edition 3, this property was enumerable"
-    RUN_TEST(L"function a(){}; s=''; for(k in a)s+=k+','; s", value{string{h, tested_version() != version::es3 ? "" : "prototype,"}});
+    RUN_TEST(u"function a(){}; s=''; for(k in a)s+=k+','; s", value{string{h, tested_version() != version::es3 ? "" : "prototype,"}});
 
     if (tested_version() < version::es5) {
-        RUN_TEST(L"Function.prototype.bind", value::undefined);
+        RUN_TEST(u"Function.prototype.bind", value::undefined);
     }
 
     if (tested_version() < version::es3) {
         // In ES1 prototype should be DontEnum only
-        RUN_TEST(L"function a(){}; (delete a.prototype)", value{true});
+        RUN_TEST(u"function a(){}; (delete a.prototype)", value{true});
         // Shouldn't have call/apply
-        RUN_TEST(L"fp = Function.prototype; fp['call'] || fp['apply']", value::undefined);
+        RUN_TEST(u"fp = Function.prototype; fp['call'] || fp['apply']", value::undefined);
         return;
     }
 
     // In ES3 prototype is DontDelete
-    RUN_TEST(L"function a(){}; (delete a.prototype)", value{false});
+    RUN_TEST(u"function a(){}; (delete a.prototype)", value{false});
 
     // The function identifier is DontDelete, ReadOnly
-    RUN_TEST(L"function f(){ f=42; return f==42||delete f;}; f()", value{false});
+    RUN_TEST(u"function f(){ f=42; return f==42||delete f;}; f()", value{false});
 
     RUN_TEST_SPEC(R"(
 Function.prototype.apply.length; //$number 2
@@ -131,7 +131,7 @@ f.prototype = undefined;
 try { fi instanceof f; } catch (e) { e.toString(); } //$string 'TypeError: Function has non-object prototype of type undefined in instanceof check'
 )");
 
-    const wchar_t* const apply_normal_object = L"try { Number.prototype.toString.apply(42, {'length':1,0:16}); } catch (e) { e.toString(); }";
+    const char16_t* const apply_normal_object = u"try { Number.prototype.toString.apply(42, {'length':1,0:16}); } catch (e) { e.toString(); }";
     if (tested_version() < version::es5) {
         // In ES3 the second argument to Function.prototype.apply must be an Arguments object or an Array.
         RUN_TEST(apply_normal_object, value{string{h, "TypeError: Object is not an (arguments) array"}});
@@ -0,0 +1,407 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <cstdio>
+#include <fstream>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <mjs/gc_heap.h>
+#include <mjs/gc_vector.h>
+#include <mjs/platform.h>
+#include <mjs/value.h>
+#include <mjs/value_representation.h>
+#include "test.h"
+
+using namespace mjs;
+
+void test_heap_growth() {
+    gc_heap h{1<<24};
+    const auto initial_capacity = h.capacity();
+    REQUIRE_EQ(initial_capacity, gc_heap::initial_capacity);
+
+    const std::u16string text(100, u'\x263A'); // Not Latin-1, so stored using char16_t
+    std::vector<string> live;
+    {
+        // Allocate well beyond the initial capacity without collecting
+        while (live.size() * 100 * sizeof(char16_t) < initial_capacity * 4 * gc_heap::slot_size) {
+            live.emplace_back(h, text);
+        }
+        REQUIRE(h.use_percentage() > 100);
+        REQUIRE_EQ(h.capacity(), initial_capacity);
+
+        // Everything survives, so the heap should grow
+        h.garbage_collect();
+        REQUIRE(h.capacity() > initial_capacity);
+        REQUIRE(h.use_percentage() <= 50);
+        for (const auto& s: live) {
+            REQUIRE(s.view() == text);
+        }
+    }
+
+    // Shrink back once the live set is gone
+    live.clear();
+    h.garbage_collect();
+    REQUIRE_EQ(h.use_percentage(), 0);
+    REQUIRE_EQ(h.capacity(), initial_capacity);
+}
+
+#ifdef __linux__
+// Number of pages (in the range of addresses 'ps' point into) that are in memory
+size_t resident_pages(const std::vector<const void*>& ps) {
+    const auto page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const auto first = reinterpret_cast<uintptr_t>(*std::min_element(ps.begin(), ps.end())) & ~(page_size - 1);
+    const auto last = reinterpret_cast<uintptr_t>(*std::max_element(ps.begin(), ps.end())) & ~(page_size - 1);
+    std::vector<unsigned char> vec((last - first) / page_size + 1);
+    REQUIRE_EQ(mincore(reinterpret_cast<void*>(first), last + page_size - first, vec.data()), 0);
+    return std::count_if(vec.begin(), vec.end(), [](unsigned char v) { return v & 1; });
+}
+
+// VmFlags line of the mapping containing 'p' (see proc(5))
+std::string mapping_flags(const void* p) {
+    std::ifstream in{"/proc/self/smaps"};
+    bool found = false;
+    for (std::string line; std::getline(in, line);) {
+        unsigned long start, end;
+        if (std::sscanf(line.c_str(), "%lx-%lx ", &start, &end) == 2) {
+            found = reinterpret_cast<uintptr_t>(p) >= start && reinterpret_cast<uintptr_t>(p) < end;
+        } else if (found && line.rfind("VmFlags:", 0) == 0) {
+            return line + " ";
+        }
+    }
+    return "";
+}
+#endif
+
+void test_decommit_keeps_advice() {
+#ifdef __linux__
+    // Memory that's decommitted and committed again should still be backed by large pages where possible
+    constexpr size_t size = 4 << 20;
+    auto p = static_cast<char*>(virtual_memory_reserve(size));
+    REQUIRE(p);
+    virtual_memory_use_large_pages(p, size);
+    REQUIRE(virtual_memory_commit(p, size));
+    p[0] = 1;
+    const bool advised = mapping_flags(p).find(" hg ") != std::string::npos; // Not if the kernel lacks support
+    virtual_memory_decommit(p, size);
+    REQUIRE(virtual_memory_commit(p, size));
+    REQUIRE_EQ(p[0], 0);
+    if (advised) {
+        REQUIRE(mapping_flags(p).find(" hg ") != std::string::npos);
+    }
+    virtual_memory_release(p, size);
+#endif
+}
+
+void test_discard_idle_half() {
+    gc_heap h{1<<24};
+    REQUIRE(h.discard_idle_half());
+    const std::u16string text(100, u'\x263A');
+    std::vector<string> live;
+    while (live.size() * 100 * sizeof(char16_t) < gc_heap::initial_capacity * 4 * gc_heap::slot_size) {
+        live.emplace_back(h, text);
+    }
+    h.garbage_collect(); // Promote them out of the nursery
+    // The objects are copied to memory given back by the previous collection (or kept if it's turned off)
+    for (const bool discard: {true, false}) {
+        h.discard_idle_half(discard);
+        for (int i = 0; i < 3; ++i) {
+            live.emplace_back(h, u"new");
+#ifdef __linux__
+            // Where the objects were before the collection is the idle half afterwards. Only its start (initial_capacity
+            // slots, rounded up to 64 KB) is kept in memory when discarding.
+            std::vector<const void*> before;
+            for (size_t j = 0; j < live.size() - 1; ++j) { // The newest one is still in the nursery
+                before.push_back(live[j].unsafe_raw_get().get());
+            }
+            const auto keep_end = static_cast<const char*>(*std::min_element(before.begin(), before.end())) + gc_heap::initial_capacity * gc_heap::slot_size + (64 << 10);
+            before.erase(std::remove_if(before.begin(), before.end(), [keep_end](const void* p) { return p < keep_end; }), before.end());
+            REQUIRE(before.size() > live.size() / 2);
+#endif
+            h.garbage_collect();
+#ifdef __linux__
+            const auto resident = resident_pages(before);
+            if (discard) {
+                REQUIRE_EQ(resident, size_t{0});
+            } else {
+                REQUIRE(resident * sysconf(_SC_PAGESIZE) >= gc_heap::initial_capacity * 2 * gc_heap::slot_size);
+            }
+#endif
+            for (size_t j = 0; j < live.size(); ++j) {
+                REQUIRE(live[j].view() == (live[j].view().size() == 3 ? u"new" : text));
+            }
+        }
+    }
+}
+
+void test_fixed_heap() {
+    constexpr uint32_t num_slots = 1<<10;
+    static uint64_t storage[num_slots];
+    gc_heap h{storage, num_slots};
+    REQUIRE_EQ(h.capacity(), num_slots/2);
+    {
+        std::vector<string> live;
+        bool out_of_memory = false;
+        try {
+            for (;;) {
+                live.emplace_back(h, "test");
+            }
+        } catch (const std::bad_alloc&) {
+            out_of_memory = true;
+        }
+        REQUIRE(out_of_memory);
+        h.garbage_collect();
+        REQUIRE_EQ(h.capacity(), num_slots/2);
+    }
+    h.garbage_collect();
+    REQUIRE_EQ(h.use_percentage(), 0);
+}
+
+void test_minor_gc() {
+    gc_heap h{1<<20};
+    {
+        // New objects start out in the nursery and are promoted when they survive a minor collection
+        const std::u16string text(10000, u'x');
+        string young{h, text};
+        REQUIRE(h.nursery_use_percentage() > 0);
+        REQUIRE_EQ(h.use_percentage(), 0);
+        h.minor_garbage_collect();
+        REQUIRE_EQ(h.nursery_use_percentage(), 0);
+        REQUIRE(h.use_percentage() > 0);
+        REQUIRE(young.unsafe_raw_get()->equals(text)); // Note: view() would widen the string
+
+        // Garbage in the nursery doesn't make it to the old generation
+        const auto old_use = h.use_percentage();
+        for (int i = 0; i < 5; ++i) {
+            string{h, text};
+        }
+        h.minor_garbage_collect();
+        REQUIRE_EQ(h.use_percentage(), old_use);
+    }
+
+    {
+        // Pointers from old to young objects must keep them alive
+        using vec_type = gc_vector<gc_heap_ptr_untracked<gc_string>>;
+        auto v = vec_type::make(h, 4);
+        auto weak = gc_vector<gc_heap_weak_ptr_untracked<gc_string>>::make(h, 4);
+        h.minor_garbage_collect();
+        v->push_back(string{h, "pushed"}.unsafe_raw_get());
+        v->push_back(nullptr);
+        (*v)[1] = string{h, "assigned"}.unsafe_raw_get();
+        string strong{h, "strong"};
+        weak->push_back(strong.unsafe_raw_get());
+        weak->push_back(string{h, "weak"}.unsafe_raw_get());
+        h.minor_garbage_collect();
+        REQUIRE_EQ(h.nursery_use_percentage(), 0);
+        REQUIRE((*v)[0].dereference(h).view() == u"pushed");
+        REQUIRE((*v)[1].dereference(h).view() == u"assigned");
+        REQUIRE((*weak)[0].dereference(h).view() == u"strong");
+        REQUIRE(!(*weak)[1]);
+
+        // Growing the vector copies the old table
+        for (int i = 0; i < 10; ++i) {
+            v->push_back(string{h, std::to_string(i)}.unsafe_raw_get());
+        }
+        h.minor_garbage_collect();
+        h.garbage_collect();
+        REQUIRE((*v)[0].dereference(h).view() == u"pushed");
+        REQUIRE((*v)[11].dereference(h).view() == u"9");
+        REQUIRE((*weak)[0].dereference(h).view() == u"strong");
+    }
+
+    h.garbage_collect();
+    REQUIRE_EQ(h.use_percentage(), 0);
+    REQUIRE_EQ(h.nursery_use_percentage(), 0);
+}
+
+void test_root_set() {
+    // Values stored outside the heap in a root set are kept alive and updated when objects move
+    struct test_root_set : gc_root_set {
+        std::vector<value_representation> values;
+        void fixup(gc_heap& h) override {
+            for (auto& v: values) {
+                v.fixup(h);
+            }
+        }
+    };
+
+    gc_heap h{1<<20};
+    {
+        test_root_set roots;
+        h.add_root_set(roots);
+        roots.values.push_back(value_representation{value{string{h, "nursery"}}});
+        roots.values.push_back(value_representation{value{42.0}});
+        h.minor_garbage_collect();
+        roots.values.push_back(value_representation{value{string{h, "old"}}});
+        h.garbage_collect();
+        h.minor_garbage_collect();
+        REQUIRE(roots.values[0].get_value(h).string_value().view() == u"nursery");
+        REQUIRE_EQ(roots.values[1].get_value(h), value{42.0});
+        REQUIRE(roots.values[2].get_value(h).string_value().view() == u"old");
+        h.remove_root_set(roots);
+    }
+
+    h.garbage_collect();
+    REQUIRE_EQ(h.use_percentage(), 0);
+    REQUIRE_EQ(h.nursery_use_percentage(), 0);
+}
+
+void test_incremental_gc() {
+    using vec_type = gc_vector<gc_heap_ptr_untracked<gc_string>>;
+    gc_heap h{1<<20};
+    {
+        auto v = vec_type::make(h, 4);
+        auto weak = gc_vector<gc_heap_weak_ptr_untracked<gc_string>>::make(h, 4);
+        std::vector<string> garbage;
+        for (int i = 0; i < 1000; ++i) {
+            v->push_back(string{h, std::to_string(i)}.unsafe_raw_get());
+            garbage.emplace_back(h, "garbage");
+        }
+        string strong{h, "strong"};
+        weak->push_back(strong.unsafe_raw_get());
+        weak->push_back(string{h, "weak"}.unsafe_raw_get());
+        h.minor_garbage_collect();
+        garbage.clear();
+        const auto old_use = h.use_percentage();
+
+        // The program keeps running (and modifying the heap) between the steps
+        int steps = 0;
+        while (!h.incremental_garbage_collect(std::chrono::microseconds{0})) {
+            REQUIRE(h.incremental_collection_active());
+            (*v)[steps] = string{h, "step" + std::to_string(steps)}.unsafe_raw_get();
+            v->push_back(string{h, "pushed" + std::to_string(steps)}.unsafe_raw_get());
+            weak->push_back(string{h, "weak"}.unsafe_raw_get());
+            ++steps;
+        }
+        REQUIRE(steps > 1);
+        REQUIRE(!h.incremental_collection_active());
+        REQUIRE_EQ(h.nursery_use_percentage(), 0);
+        REQUIRE(h.use_percentage() < old_use);
+
+        REQUIRE_EQ(v->length(), 1000U + steps);
+        for (int i = 0; i < steps; ++i) {
+            REQUIRE((*v)[i].dereference(h).view() == u"step" + to_u16string(std::to_wstring(i)));
+            REQUIRE((*v)[1000 + i].dereference(h).view() == u"pushed" + to_u16string(std::to_wstring(i)));
+        }
+        REQUIRE((*v)[999].dereference(h).view() == u"999");
+        REQUIRE((*weak)[0].dereference(h).view() == u"strong");
+        REQUIRE(!(*weak)[1]);
+
+        // A full collection finishes the one in progress
+        REQUIRE(!h.incremental_garbage_collect(std::chrono::microseconds{0}));
+        h.garbage_collect();
+        REQUIRE(!h.incremental_collection_active());
+        REQUIRE((*v)[0].dereference(h).view() == u"step0");
+    }
+
+    h.garbage_collect();
+    REQUIRE_EQ(h.use_percentage(), 0);
+    REQUIRE_EQ(h.nursery_use_percentage(), 0);
+}
+
+// Counts the live instances, so it can be checked that each one is destroyed exactly once
+class counted {
+public:
+    static int live;
+    explicit counted(int value) : value_(value) { ++live; }
+    counted(counted&& other) : value_(other.value_) { ++live; }
+    ~counted() { --live; }
+    int value() const { return value_; }
+private:
+    int value_;
+};
+int counted::live;
+
+void test_finalizers() {
+    {
+        gc_heap h{1<<20};
+        std::vector<gc_heap_ptr<counted>> kept;
+        for (int i = 0; i < 1000; ++i) {
+            auto p = h.make<counted>(i);
+            string{h, "garbage"}; // Doesn't need to be destroyed
+            if (i % 10 == 0) {
+                kept.push_back(p);
+            }
+        }
+        REQUIRE_EQ(counted::live, 1000);
+
+        // Moving an object destroys it at its old position, the dead objects are destroyed by the collection
+        h.minor_garbage_collect();
+        REQUIRE_EQ(counted::live, 100);
+        h.garbage_collect();
+        REQUIRE_EQ(counted::live, 100);
+
+        kept.resize(50);
+        while (!h.incremental_garbage_collect(std::chrono::microseconds{0})) {
+            h.make<counted>(-1);
+        }
+        h.garbage_collect();
+        REQUIRE_EQ(counted::live, 50);
+        for (int i = 0; i < 50; ++i) {
+            REQUIRE_EQ(kept[i]->value(), i * 10);
+        }
+
+        // The remaining objects are destroyed along with the heap
+        for (int i = 0; i < 10; ++i) {
+            h.make<counted>(i);
+        }
+        kept.clear();
+    }
+    REQUIRE_EQ(counted::live, 0);
+}
+
+void test_parallel_gc() {
+    gc_heap h{1<<24};
+    h.gc_threads(4);
+    REQUIRE_EQ(h.gc_threads(), 4U);
+    auto text = [](int i) { return std::u16string(100, static_cast<char16_t>(u'a' + i % 26)) + to_u16string(std::to_wstring(i)); };
+    {
+        // Enough live data for the collection to be done in parallel, mixing objects the helper threads copy (strings
+        // and vectors) with ones they must leave to the calling thread (objects with destructors)
+        auto strings = gc_vector<gc_heap_ptr_untracked<gc_string>>::make(h, 16);
+        auto counters = gc_vector<gc_heap_ptr_untracked<counted>>::make(h, 16);
+        auto weak = gc_vector<gc_heap_weak_ptr_untracked<gc_string>>::make(h, 16);
+        for (int i = 0; i < 30000; ++i) {
+            strings->push_back(string{h, text(i)}.unsafe_raw_get());
+            string{h, "garbage"};
+            if (i % 100 == 0) {
+                counters->push_back(h.make<counted>(i));
+                h.make<counted>(-1);
+                weak->push_back((*strings)[i].track(h));
+                weak->push_back(string{h, "weak"}.unsafe_raw_get());
+            }
+        }
+        REQUIRE_EQ(counted::live, 600);
+
+        for (int gc = 0; gc < 2; ++gc) {
+            h.garbage_collect();
+            REQUIRE_EQ(counted::live, 300);
+            for (int i = 0; i < 30000; ++i) {
+                REQUIRE((*strings)[i].dereference(h).view() == text(i));
+            }
+            for (int i = 0; i < 300; ++i) {
+                REQUIRE_EQ((*counters)[i].dereference(h).value(), i * 100);
+                REQUIRE_EQ(&(*weak)[i * 2].dereference(h), &(*strings)[i * 100].dereference(h));
+                REQUIRE(!(*weak)[i * 2 + 1]);
+            }
+        }
+    }
+    h.garbage_collect();
+    REQUIRE_EQ(counted::live, 0);
+    REQUIRE_EQ(h.use_percentage(), 0);
+}
+
+void test_main() {
+    test_heap_growth();
+    test_discard_idle_half();
+    test_decommit_keeps_advice();
+    test_fixed_heap();
+    test_minor_gc();
+    test_root_set();
+    test_incremental_gc();
+    test_finalizers();
+    test_parallel_gc();
+}
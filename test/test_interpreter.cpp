@@ -4,6 +4,7 @@
 #include <sstream>
 
 #include <mjs/interpreter.h>
+#include <mjs/jit.h>
 #include <mjs/parser.h>
 #include <mjs/printer.h>
 #include <mjs/object.h>
@@ -17,84 +18,84 @@ using namespace mjs;
 void eval_tests() {
     gc_heap h{1<<20};
 
-    RUN_TEST(L"undefined", value::undefined);
-    RUN_TEST(L"null", value::null);
-    RUN_TEST(L"false", value{false});
-    RUN_TEST(L"true", value{true});
-    RUN_TEST(L"123", value{123.});
-    RUN_TEST(L"0123", value{83.});
-    RUN_TEST(L"0x123", value{291.});
-    RUN_TEST(L"'te\"st'", value{string{h, "te\"st"}});
-    RUN_TEST(L"\"te'st\"", value{string{h, "te'st"}});
-    RUN_TEST(L"/*42*/60", value{60.0});
-    RUN_TEST(L"x=12//\n+34;x", value{46.0});
-    RUN_TEST(L"-7.5 % 2", value{-1.5});
-    RUN_TEST(L"1+2*3", value{7.});
-    RUN_TEST(L"''+(0.1+0.2)", value{string{h, "0.30000000000000004"}});
-    RUN_TEST(L"x = 42; 'test ' + 2 * (6 - 4 + 1) + ' ' + x", value{string{h, "test 6 42"}});
-    RUN_TEST(L"y=1/2; z='string'; y+z", value{string{h, "0.5string"}});
-    RUN_TEST(L"var x=2; x++;", value{2.0});
-    RUN_TEST(L"var x=2; x++; x", value{3.0});
-    RUN_TEST(L"var x=2; x--;", value{2.0});
-    RUN_TEST(L"var x=2; x--; x", value{1.0});
-    RUN_TEST(L"var x = 42; delete x; x", value{42.}); // Variables aren't deleted
-    RUN_TEST(L"delete Object.prototype;", value{false});
-    RUN_TEST(L"delete !global", value{true});
-    RUN_TEST(L"this==global", value{true});
+    RUN_TEST(u"undefined", value::undefined);
+    RUN_TEST(u"null", value::null);
+    RUN_TEST(u"false", value{false});
+    RUN_TEST(u"true", value{true});
+    RUN_TEST(u"123", value{123.});
+    RUN_TEST(u"0123", value{83.});
+    RUN_TEST(u"0x123", value{291.});
+    RUN_TEST(u"'te\"st'", value{string{h, "te\"st"}});
+    RUN_TEST(u"\"te'st\"", value{string{h, "te'st"}});
+    RUN_TEST(u"/*42*/60", value{60.0});
+    RUN_TEST(u"x=12//\n+34;x", value{46.0});
+    RUN_TEST(u"-7.5 % 2", value{-1.5});
+    RUN_TEST(u"1+2*3", value{7.});
+    RUN_TEST(u"''+(0.1+0.2)", value{string{h, "0.30000000000000004"}});
+    RUN_TEST(u"x = 42; 'test ' + 2 * (6 - 4 + 1) + ' ' + x", value{string{h, "test 6 42"}});
+    RUN_TEST(u"y=1/2; z='string'; y+z", value{string{h, "0.5string"}});
+    RUN_TEST(u"var x=2; x++;", value{2.0});
+    RUN_TEST(u"var x=2; x++; x", value{3.0});
+    RUN_TEST(u"var x=2; x--;", value{2.0});
+    RUN_TEST(u"var x=2; x--; x", value{1.0});
+    RUN_TEST(u"var x = 42; delete x; x", value{42.}); // Variables aren't deleted
+    RUN_TEST(u"delete Object.prototype;", value{false});
+    RUN_TEST(u"delete !global", value{true});
+    RUN_TEST(u"this==global", value{true});
     if (tested_version() >= version::es5) {
-        RUN_TEST(L"'use strict';var ge;try{delete Object.prototype;} catch(e) {ge=e;}; ge.toString()", value{string{h, "TypeError: may not delete non-configurable property \"prototype\" in strict mode"}});
+        RUN_TEST(u"'use strict';var ge;try{delete Object.prototype;} catch(e) {ge=e;}; ge.toString()", value{string{h, "TypeError: may not delete non-configurable property \"prototype\" in strict mode"}});
     }
-    RUN_TEST(L"var i=42; var x=i; x;", value{42.0});
-    RUN_TEST(L"void(2+2)", value::undefined);
-    RUN_TEST(L"typeof(2)", value{string{h, "number"}});
-    RUN_TEST(L"x=4.5; ++x", value{5.5});
-    RUN_TEST(L"x=4.5; --x", value{3.5});
-    RUN_TEST(L"x=42; +x;", value{42.0});
-    RUN_TEST(L"x=42; -x;", value{-42.0});
-    RUN_TEST(L"x=42; !x;", value{false});
-    RUN_TEST(L"x=42; ~x;", value{(double)~42});
-    RUN_TEST(L"1<<2", value{4.0});
-    RUN_TEST(L"-5>>2", value{-2.0});
-    RUN_TEST(L"-5>>>2", value{1073741822.0});
-    RUN_TEST(L"1 < 2", value{true});
-    RUN_TEST(L"1 > 2", value{false});
-    RUN_TEST(L"1 <= 2", value{true});
-    RUN_TEST(L"1 >= 2", value{false});
-    RUN_TEST(L"1 == 2", value{false});
-    RUN_TEST(L"1 != 2", value{true});
-    RUN_TEST(L"1 == '1'", value{true});
-    RUN_TEST(L"NaN == NaN", value{false});
+    RUN_TEST(u"var i=42; var x=i; x;", value{42.0});
+    RUN_TEST(u"void(2+2)", value::undefined);
+    RUN_TEST(u"typeof(2)", value{string{h, "number"}});
+    RUN_TEST(u"x=4.5; ++x", value{5.5});
+    RUN_TEST(u"x=4.5; --x", value{3.5});
+    RUN_TEST(u"x=42; +x;", value{42.0});
+    RUN_TEST(u"x=42; -x;", value{-42.0});
+    RUN_TEST(u"x=42; !x;", value{false});
+    RUN_TEST(u"x=42; ~x;", value{(double)~42});
+    RUN_TEST(u"1<<2", value{4.0});
+    RUN_TEST(u"-5>>2", value{-2.0});
+    RUN_TEST(u"-5>>>2", value{1073741822.0});
+    RUN_TEST(u"1 < 2", value{true});
+    RUN_TEST(u"1 > 2", value{false});
+    RUN_TEST(u"1 <= 2", value{true});
+    RUN_TEST(u"1 >= 2", value{false});
+    RUN_TEST(u"1 == 2", value{false});
+    RUN_TEST(u"1 != 2", value{true});
+    RUN_TEST(u"1 == '1'", value{true});
+    RUN_TEST(u"NaN == NaN", value{false});
     if (tested_version() >= version::es3) {
-        RUN_TEST(L"1 === '1'", value{false});
-        RUN_TEST(L"1 !== '1'", value{true});
-        RUN_TEST(L"undefined === undefined", value{true});
-        RUN_TEST(L"undefined === null", value{false});
-        RUN_TEST(L"undefined !== null", value{true});
-        RUN_TEST(L"null === null", value{true});
-        RUN_TEST(L"NaN !== NaN", value{true});
-        RUN_TEST(L"NaN === NaN", value{false});
-        RUN_TEST(L"+0 === -0", value{true});
-        RUN_TEST(L"-0 === +0", value{true});
-        RUN_TEST(L"true === false", value{false});
-        RUN_TEST(L"true === true", value{true});
-        RUN_TEST(L"'1234' === '1234'", value{true});
-        RUN_TEST(L"'1234' === '1234 '", value{false});
-        RUN_TEST(L"Object === Object", value{true});
-        RUN_TEST(L"Object !== Object", value{false});
-        RUN_TEST(L"Object === Function", value{false});
-        RUN_TEST(L"Object !== Function", value{true});
-        RUN_TEST(L"a={};1 in a", value{false});
-        RUN_TEST(L"a={1:1};1 in a", value{true});
-        RUN_TEST(L"a={'x':1};'x' in a", value{true});
-        RUN_TEST(L"a={1000:1};1e3 in a", value{true});
+        RUN_TEST(u"1 === '1'", value{false});
+        RUN_TEST(u"1 !== '1'", value{true});
+        RUN_TEST(u"undefined === undefined", value{true});
+        RUN_TEST(u"undefined === null", value{false});
+        RUN_TEST(u"undefined !== null", value{true});
+        RUN_TEST(u"null === null", value{true});
+        RUN_TEST(u"NaN !== NaN", value{true});
+        RUN_TEST(u"NaN === NaN", value{false});
+        RUN_TEST(u"+0 === -0", value{true});
+        RUN_TEST(u"-0 === +0", value{true});
+        RUN_TEST(u"true === false", value{false});
+        RUN_TEST(u"true === true", value{true});
+        RUN_TEST(u"'1234' === '1234'", value{true});
+        RUN_TEST(u"'1234' === '1234 '", value{false});
+        RUN_TEST(u"Object === Object", value{true});
+        RUN_TEST(u"Object !== Object", value{false});
+        RUN_TEST(u"Object === Function", value{false});
+        RUN_TEST(u"Object !== Function", value{true});
+        RUN_TEST(u"a={};1 in a", value{false});
+        RUN_TEST(u"a={1:1};1 in a", value{true});
+        RUN_TEST(u"a={'x':1};'x' in a", value{true});
+        RUN_TEST(u"a={1000:1};1e3 in a", value{true});
         // These tests of `instanceof` don't really belong here as they rely on global object, but eh
-        RUN_TEST(L"o={};o instanceof Object", value{true});
-        RUN_TEST(L"o={};o instanceof Array", value{false});
-        RUN_TEST(L"4 instanceof Number", value{false});
-        RUN_TEST(L"'' instanceof String", value{false});
-        RUN_TEST(L"new String() instanceof String", value{true});
+        RUN_TEST(u"o={};o instanceof Object", value{true});
+        RUN_TEST(u"o={};o instanceof Array", value{false});
+        RUN_TEST(u"4 instanceof Number", value{false});
+        RUN_TEST(u"'' instanceof String", value{false});
+        RUN_TEST(u"new String() instanceof String", value{true});
 
-        RUN_TEST(L"function o(){};function p(){};p.prototype=new o();i=new p(); i instanceof o && i instanceof p;", value{true});
+        RUN_TEST(u"function o(){};function p(){};p.prototype=new o();i=new p(); i instanceof o && i instanceof p;", value{true});
     }
 
     // Check access to properties in the prototype
@@ -109,24 +110,24 @@ ci[1]; //$string 'b'
 ci[2]; //$undefined
 )");
 
-    RUN_TEST(L"255 & 128", value{128.0});
-    RUN_TEST(L"255 ^ 128", value{127.0});
-    RUN_TEST(L"64 | 128", value{192.0});
-    RUN_TEST(L"42 || 13", value{42.0});
-    RUN_TEST(L"42 && 13", value{13.0});
-    RUN_TEST(L"1 ? 2 : 3", value{2.0});
-    RUN_TEST(L"0 ? 2 : 1+2", value{3.0});
-    RUN_TEST(L"x=2.5; x+=4; x", value{6.5});
-    RUN_TEST(L"function f(x,y) { return x*x+y; } f(2, 3)", value{7.0});
-    RUN_TEST(L"function f(){ i = 42; }; f(); i", value{42.0});
-    RUN_TEST(L"i = 1; function f(){ var i = 42; }; f(); i", value{1.0});
-    RUN_TEST(L"x=42; function f(x) { return x; } f()", value::undefined);
-    RUN_TEST(L"function f(){if(1){function a(){return 42;} return a(); }}; f()", value{42.});
-    RUN_TEST(L"{if(1) function a(){return 42;}} a(42);", value{42.});
-    RUN_TEST(L"function a(){return 1;}; a()", value{1.});
+    RUN_TEST(u"255 & 128", value{128.0});
+    RUN_TEST(u"255 ^ 128", value{127.0});
+    RUN_TEST(u"64 | 128", value{192.0});
+    RUN_TEST(u"42 || 13", value{42.0});
+    RUN_TEST(u"42 && 13", value{13.0});
+    RUN_TEST(u"1 ? 2 : 3", value{2.0});
+    RUN_TEST(u"0 ? 2 : 1+2", value{3.0});
+    RUN_TEST(u"x=2.5; x+=4; x", value{6.5});
+    RUN_TEST(u"function f(x,y) { return x*x+y; } f(2, 3)", value{7.0});
+    RUN_TEST(u"function f(){ i = 42; }; f(); i", value{42.0});
+    RUN_TEST(u"i = 1; function f(){ var i = 42; }; f(); i", value{1.0});
+    RUN_TEST(u"x=42; function f(x) { return x; } f()", value::undefined);
+    RUN_TEST(u"function f(){if(1){function a(){return 42;} return a(); }}; f()", value{42.});
+    RUN_TEST(u"{if(1) function a(){return 42;}} a(42);", value{42.});
+    RUN_TEST(u"function a(){return 1;}; a()", value{1.});
 
     // functions are defined at the start of scope
-    RUN_TEST(L"a=f.length; function f(x,y) {} a", value{2.0});
+    RUN_TEST(u"a=f.length; function f(x,y) {} a", value{2.0});
     RUN_TEST_SPEC(R"(
 function g() { return ''+this.x; }
 f.prototype.toString = g;
@@ -137,17 +138,17 @@ function f(x)  {this.x=x; }
 )");
     //TODO: Test more advanced cases
 
-    RUN_TEST(L";", value::undefined);
-    RUN_TEST(L"if (1) 2;", value{2.0});
-    RUN_TEST(L"if (0) 2;", value::undefined);
-    RUN_TEST(L"if (0) 2; else ;", value::undefined);
-    RUN_TEST(L"if (0) 2; else 3;", value{3.0});
-    RUN_TEST(L"1,2", value{2.0});
-    RUN_TEST(L"x=5; while(x-3) { x = x - 1; } x", value{3.0});
-    RUN_TEST(L"x=2; y=0; while(1) { if(x) {x = x - 1; y = y + 2; continue; y = y + 1000; } else break; y = y + 1;} y", value{4.0});
-    RUN_TEST(L"var x = 0; for(var i = 10, dec = 1; i; i = i - dec) x = x + i; x", value{55.0});
-    RUN_TEST(L"var x=0; for (i=2; i; i=i-1) x=x+i; x+i", value{3.0});
-    RUN_TEST(L"for (var i=0;!i;) { i=1 }", value{1.});
+    RUN_TEST(u";", value::undefined);
+    RUN_TEST(u"if (1) 2;", value{2.0});
+    RUN_TEST(u"if (0) 2;", value::undefined);
+    RUN_TEST(u"if (0) 2; else ;", value::undefined);
+    RUN_TEST(u"if (0) 2; else 3;", value{3.0});
+    RUN_TEST(u"1,2", value{2.0});
+    RUN_TEST(u"x=5; while(x-3) { x = x - 1; } x", value{3.0});
+    RUN_TEST(u"x=2; y=0; while(1) { if(x) {x = x - 1; y = y + 2; continue; y = y + 1000; } else break; y = y + 1;} y", value{4.0});
+    RUN_TEST(u"var x = 0; for(var i = 10, dec = 1; i; i = i - dec) x = x + i; x", value{55.0});
+    RUN_TEST(u"var x=0; for (i=2; i; i=i-1) x=x+i; x+i", value{3.0});
+    RUN_TEST(u"for (var i=0;!i;) { i=1 }", value{1.});
 
     // Check break in nested for loop
     RUN_TEST_SPEC(R"(
@@ -195,8 +196,8 @@ y; //$ number 11
 
     // for..in  on undefined/null is a NO-op in ES5+ (12.6.4)
     if (tested_version() < version::es5) {
-        expect_eval_exception(L"for(k in undefined){}");
-        expect_eval_exception(L"for(k in null){}");
+        expect_eval_exception(u"for(k in undefined){}");
+        expect_eval_exception(u"for(k in null){}");
     } else {
         RUN_TEST_SPEC(R"(
 s= ''; for (k in undefined) { s+=k; }; s; //$string ''
@@ -243,23 +244,23 @@ with(42) {
 )");
 
 
-    RUN_TEST(L"function sum() {  var s = 0; for (var i = 0; i < arguments.length; ++i) s += arguments[i]; return s; } sum(1,2,3)", value{6.0});
+    RUN_TEST(u"function sum() {  var s = 0; for (var i = 0; i < arguments.length; ++i) s += arguments[i]; return s; } sum(1,2,3)", value{6.0});
 
     // In ES5 the [[Class]] of the arguments array changed from Object to Arguments and the indexed properties are enumerable
-    RUN_TEST(L" function f() { var a=''; for (k in arguments) {a+=k+',';} arguments.s=Object.prototype.toString; return a+arguments.s(); }; f(23,45);", value{string{h, tested_version() >= version::es5 ? L"0,1,[object Arguments]" : L"[object Object]"}});
+    RUN_TEST(u" function f() { var a=''; for (k in arguments) {a+=k+',';} arguments.s=Object.prototype.toString; return a+arguments.s(); }; f(23,45);", value{string{h, tested_version() >= version::es5 ? u"0,1,[object Arguments]" : u"[object Object]"}});
 
     // ES3, 15.1: The [[Prototype]] and [[Class]] properties of the global object are implementation-dependent
-    RUN_TEST(L"global.toString()", value{string{h, "[object Global]"}});
+    RUN_TEST(u"global.toString()", value{string{h, "[object Global]"}});
 
     // Object
-    RUN_TEST(L"''+Object(null)", value{string{h, "[object Object]"}});
-    RUN_TEST(L"o=Object(null); o.x=42; o.y=60; o.x+o['y']", value{102.0});
-    RUN_TEST(L"a=Object(null);b=Object(null);a.x=b;a.x.y=42;a['x']['y']", value{42.0});
-    RUN_TEST(L"'' + new Object", value{string{h, "[object Object]"}});
-    RUN_TEST(L"'' + new Object()", value{string{h, "[object Object]"}});
-    RUN_TEST(L"'' + new Object(null)", value{string{h, "[object Object]"}});
-    RUN_TEST(L"'' + new Object(undefined)", value{string{h, "[object Object]"}});
-    RUN_TEST(L"o = new Object;o.x=42; new Object(o).x", value{42.0});
+    RUN_TEST(u"''+Object(null)", value{string{h, "[object Object]"}});
+    RUN_TEST(u"o=Object(null); o.x=42; o.y=60; o.x+o['y']", value{102.0});
+    RUN_TEST(u"a=Object(null);b=Object(null);a.x=b;a.x.y=42;a['x']['y']", value{42.0});
+    RUN_TEST(u"'' + new Object", value{string{h, "[object Object]"}});
+    RUN_TEST(u"'' + new Object()", value{string{h, "[object Object]"}});
+    RUN_TEST(u"'' + new Object(null)", value{string{h, "[object Object]"}});
+    RUN_TEST(u"'' + new Object(undefined)", value{string{h, "[object Object]"}});
+    RUN_TEST(u"o = new Object;o.x=42; new Object(o).x", value{42.0});
 
     // Function. Note: toString() rendering isn't specified (exactly)
     RUN_TEST_SPEC(R"(
@@ -375,29 +376,29 @@ count(make(3)); //$number 15
 count(make(4)); //$number 31
 )");
 
-    RUN_TEST(L"function  f ( x   ,\ny )  { return x + y;  }; f.toString()", value{string{h, "function f( x   ,\ny )  { return x + y;  }"}});
-    RUN_TEST(L"a=parseInt;a.toString()", value{string{h, "function parseInt() { [native code] }"}});
+    RUN_TEST(u"function  f ( x   ,\ny )  { return x + y;  }; f.toString()", value{string{h, "function f( x   ,\ny )  { return x + y;  }"}});
+    RUN_TEST(u"a=parseInt;a.toString()", value{string{h, "function parseInt() { [native code] }"}});
 
     // wat
-    RUN_TEST(L"!!('')", value{false});
-    RUN_TEST(L"\"\" == false", value{true});
-    RUN_TEST(L"null == false", value{false});
-    RUN_TEST(L"+true", value{1.0});
-    RUN_TEST(L"true + true", value{2.0});
-    RUN_TEST(L"!!('0' && Object(null))", value{true});
-
-    RUN_TEST(L"function X() { this.val = 42; }; new X().val", value{42.0});
-    RUN_TEST(L"function A() { this.n=1; }; function B() { this.n=2;} function g() { return this.n; } A.prototype.foo = g; new A().foo()", value{1.});
-    RUN_TEST(L"function A() { this.n=1; }; function B() { this.n=2;} function g() { return this.n; } A.prototype.foo = g; new B().foo", value::undefined);
-    RUN_TEST(L"function f() { this.a = 1; this.b = 2; } var o = new f(); f.prototype.b = 3; f.prototype.c = 4; '' + new Array(o.a,o.b,o.c,o.d)", value{string{h, "1,2,4,"}});
-    RUN_TEST(L"var o = new Object(); o.a = 2; function m(){return this.a+1; }; o.m = m; o.m()", value{3.});
-
-    RUN_TEST(L"function s(){} s.prototype.foo = 'bar'; var si = new s(); si.prop = 'some value'; si.prop", value{string{h, "some value"}});
-    RUN_TEST(L"function s(){} s.prototype.foo = 'bar'; var si = new s(); si.prop = 'some value'; si.foo", value{string{h, "bar"}});
-    RUN_TEST(L"function s(){} s.prototype.foo = 'bar'; var si = new s(); si.prop = 'some value'; s.prop", value::undefined);
-    RUN_TEST(L"function s(){} s.prototype.foo = 'bar'; var si = new s(); si.prop = 'some value'; s.foo", value::undefined);
-    RUN_TEST(L"function s(){} s.prototype.foo = 'bar'; var si = new s(); si.prop = 'some value'; s.prototype.prop", value::undefined);
-    RUN_TEST(L"function s(){} s.prototype.foo = 'bar'; var si = new s(); si.prop = 'some value'; s.prototype.foo", value{string{h, "bar"}});
+    RUN_TEST(u"!!('')", value{false});
+    RUN_TEST(u"\"\" == false", value{true});
+    RUN_TEST(u"null == false", value{false});
+    RUN_TEST(u"+true", value{1.0});
+    RUN_TEST(u"true + true", value{2.0});
+    RUN_TEST(u"!!('0' && Object(null))", value{true});
+
+    RUN_TEST(u"function X() { this.val = 42; }; new X().val", value{42.0});
+    RUN_TEST(u"function A() { this.n=1; }; function B() { this.n=2;} function g() { return this.n; } A.prototype.foo = g; new A().foo()", value{1.});
+    RUN_TEST(u"function A() { this.n=1; }; function B() { this.n=2;} function g() { return this.n; } A.prototype.foo = g; new B().foo", value::undefined);
+    RUN_TEST(u"function f() { this.a = 1; this.b = 2; } var o = new f(); f.prototype.b = 3; f.prototype.c = 4; '' + new Array(o.a,o.b,o.c,o.d)", value{string{h, "1,2,4,"}});
+    RUN_TEST(u"var o = new Object(); o.a = 2; function m(){return this.a+1; }; o.m = m; o.m()", value{3.});
+
+    RUN_TEST(u"function s(){} s.prototype.foo = 'bar'; var si = new s(); si.prop = 'some value'; si.prop", value{string{h, "some value"}});
+    RUN_TEST(u"function s(){} s.prototype.foo = 'bar'; var si = new s(); si.prop = 'some value'; si.foo", value{string{h, "bar"}});
+    RUN_TEST(u"function s(){} s.prototype.foo = 'bar'; var si = new s(); si.prop = 'some value'; s.prop", value::undefined);
+    RUN_TEST(u"function s(){} s.prototype.foo = 'bar'; var si = new s(); si.prop = 'some value'; s.foo", value::undefined);
+    RUN_TEST(u"function s(){} s.prototype.foo = 'bar'; var si = new s(); si.prop = 'some value'; s.prototype.prop", value::undefined);
+    RUN_TEST(u"function s(){} s.prototype.foo = 'bar'; var si = new s(); si.prop = 'some value'; s.prototype.foo", value{string{h, "bar"}});
 
     // Test arguments alias
     RUN_TEST_SPEC(R"(
@@ -418,7 +419,7 @@ evil(12, 34);
 )");
 
     if (tested_version() >= version::es5) {
-        RUN_TEST(L"debugger", value::undefined);
+        RUN_TEST(u"debugger", value::undefined);
 
         // No argument aliasing in strict mode
         RUN_TEST_SPEC(R"(
@@ -503,8 +504,8 @@ global['x']; //$undefined
     }
 
     // ES5.1, 10.4.2 the global context is used for indirect calls to eval
-    RUN_TEST(L"var s=1; function t() { var s=2; return eval('s'); }; t();", value{2.});
-    RUN_TEST(L"var s=1; function t() { var s=2; return (0,eval)('s'); }; t();", value{tested_version() >= version::es5 ? 1. : 2.});
+    RUN_TEST(u"var s=1; function t() { var s=2; return eval('s'); }; t();", value{2.});
+    RUN_TEST(u"var s=1; function t() { var s=2; return (0,eval)('s'); }; t();", value{tested_version() >= version::es5 ? 1. : 2.});
 
     // parseInt
     RUN_TEST_SPEC(R"(
@@ -521,7 +522,7 @@ parseInt(' 123', 1); //$ number NaN
 parseInt(' x', 1); //$ number NaN
 )");
     // Octal numbers (when radix == 0) are mandatory in ES1, implemention-defined in ES3 and disallowed in ES5+
-    RUN_TEST(L"parseInt(' \\t\\r 0123')", value{tested_version() >= version::es5 ? 123. : 83.});
+    RUN_TEST(u"parseInt(' \\t\\r 0123')", value{tested_version() >= version::es5 ? 123. : 83.});
 
     // parseFloat
     RUN_TEST_SPEC(R"(
@@ -568,9 +569,9 @@ Number.MAX_VALUE;//$number 1.7976931348623157e+308
 )");
 
     // undefined, NaN and Infinity are immutable in ES5+
-    RUN_TEST(L"undefined=42;undefined", tested_version() >= version::es5 ? value::undefined : value{42.});
-    RUN_TEST(L"NaN=42;NaN", tested_version() >= version::es5 ? value{NAN} : value{42.});
-    RUN_TEST(L"Infinity=42;Infinity", tested_version() >= version::es5 ? value{INFINITY} : value{42.});
+    RUN_TEST(u"undefined=42;undefined", tested_version() >= version::es5 ? value::undefined : value{42.});
+    RUN_TEST(u"NaN=42;NaN", tested_version() >= version::es5 ? value{NAN} : value{42.});
+    RUN_TEST(u"Infinity=42;Infinity", tested_version() >= version::es5 ? value{INFINITY} : value{42.});
 
     // ES3, 15.1.3, URI Handling Functions
 
@@ -580,7 +581,7 @@ delete undefined; //$boolean true
 delete NaN;       //$boolean true
 delete Infinity;  //$boolean true
 )");
-        RUN_TEST(L"global.decodeURI || global.decodeURIComponent || global.encodeURI || global.encodeURIComponent", value::undefined);
+        RUN_TEST(u"global.decodeURI || global.decodeURIComponent || global.encodeURI || global.encodeURIComponent", value::undefined);
         return;
     }
 
@@ -697,15 +698,15 @@ Math.tan(0);            //$ number 0
 }
 
 void test_long_object_chain() {
-    RUN_TEST(LR"(
+    RUN_TEST(uR"(
 var l = null;
 for (var i = 0; i < )"
 #ifdef MJS_GC_STRESS_TEST
-    L"100" // Long enough when stress testing
+    u"100" // Long enough when stress testing
 #else
-    L"10000"
+    u"10000"
 #endif
-LR"(; ++i) {
+uR"(; ++i) {
     n = new Object();
     n.prev = l;
     l = n;
@@ -714,27 +715,298 @@ null
 )", value::null);
 }
 
+void test_local_variables() {
+    // Locals that the bytecode compiler resolves to (depth, slot) coordinates (function expressions require ES3)
+    if (tested_version() < version::es3) {
+        return;
+    }
+    RUN_TEST_SPEC(R"(
+function counter() { var n = 0; return function() { return ++n; }; }
+var c1 = counter(), c2 = counter();
+c1(); c1(); c2(); //$number 1
+c1(); //$number 3
+function outer(a) { function mid() { function inner() { a += 10; return a--; } return inner(); } return mid() + a; }
+outer(1); //$number 21
+function f(x) { x *= x + 1; var y = x, z; z = y++; return [x, y, z].toString(); }
+f(3); //$string '12,13,12'
+function g() { var o = {valueOf: function() { v = 'x'; return 5; }}, v = o; v++; return v; }
+g(); //$number 6
+var h = function fact(n) { fact = 42; return n <= 1 ? 1 : n * fact(n - 1); }; h(5); //$number 120
+function d(p) { var q = 1; return delete p || delete q; } d(2); //$boolean false
+function e(k) { var s = ''; for (var x in this) {}; switch (k) { case 1: s = 'one'; break; default: s = 'other'; } return s; }
+e(1) + e(2); //$string 'oneother'
+function t() { return this; } t() === this; //$boolean true
+)");
+
+    if (tested_version() >= version::es5) {
+        RUN_TEST_SPEC(R"(
+function f(a) { 'use strict'; a = 2; return arguments[0] + arguments.length * 10; }
+f(1, 2); //$number 21
+function g() { 'use strict'; return this; } g(); //$undefined
+(function h() { 'use strict'; try { h = 1; } catch (e) { return e.toString(); } })(); //$string 'TypeError: Cannot assign to read only property h in strict mode'
+)");
+    }
+}
+
+void test_inline_caches() {
+    if (tested_engine() == interpreter_engine::ast || tested_version() < version::es3) {
+        return;
+    }
+    gc_heap h{1<<20};
+    {
+        auto bs = parse(std::make_shared<source_file>(u"test", uR"(
+function P(x) { this.x = x; }
+P.prototype.get = function() { return this.x; };
+var s = 0;
+for (var i = 0; i < 10; ++i) {
+    var p = new P(i);
+    p.x = p.x + 1;
+    s += p.get();
+    s += p['x'];
+}
+s;
+)", tested_version()));
+        interpreter i{h, tested_version(), {}, tested_engine()};
+        REQUIRE_EQ(i.eval(*bs), value{110.0});
+        const auto& stats = i.inline_cache_stats();
+        // p.x, p['x'] and this.x hit after the first iteration (p has the same shape every time), P.prototype is not a plain object
+        REQUIRE_EQ(stats.get.hits, 27U);
+        REQUIRE_EQ(stats.get.misses, 4U);
+        // p.x = ... hits after the first iteration, this.x = x adds the property and misses every time
+        REQUIRE_EQ(stats.put.hits, 9U);
+        REQUIRE_EQ(stats.put.misses, 12U);
+        // p.get() is found in the prototype
+        REQUIRE_EQ(stats.call.hits, 9U);
+        REQUIRE_EQ(stats.call.misses, 1U);
+    }
+    h.garbage_collect();
+    REQUIRE(!h.use_percentage());
+}
+
 #define EX_EQUAL(expected, actual) do { const auto _e = (expected); const auto _a = (actual); if (_e != _a) { std::ostringstream _woss; _woss << "Expected\n\"" << _e << "\" got\n\"" << _a << "\"\n"; THROW_RUNTIME_ERROR(_woss.str()); } } while (0)
 
+void test_jit_speculation() {
+    // Functions called repeatedly with operands of changing types (the jit engine compiles them after a few calls speculating that they're numbers)
+    RUN_TEST_SPEC(R"(
+function arith(a, b) { var r = a + b; r = r * 2 - a / 4; return r; }
+arith(4, 2) + arith(-1, 0.5); //$number 10.25
+arith(4, 2) + arith(-1, 0.5); //$number 10.25
+arith('x', 1); //$number NaN
+arith(4, '2'); //$number 83
+arith(4, 2); //$number 11
+function bits(a, b) { return (a & b) + ',' + (a | b) + ',' + (a ^ b) + ',' + (a << b) + ',' + (a >> b) + ',' + (a >>> b); }
+bits(12, 2); //$string '0,14,14,48,3,3'
+bits(-12, 33); //$string '32,-11,-43,-24,-6,2147483642'
+bits(1e30, 1); //$string '0,1,1,0,0,0'
+bits(NaN, 4294967297); //$string '0,1,1,0,0,0'
+function cmp(a, b) { return (a < b) + ',' + (a <= b) + ',' + (a > b) + ',' + (a >= b) + ',' + (a == b) + ',' + (a != b); }
+cmp(1, 2); //$string 'true,true,false,false,false,true'
+cmp(NaN, NaN); //$string 'false,false,false,false,false,true'
+cmp(0, -0); //$string 'false,true,false,true,true,false'
+cmp(null, 0); //$string 'false,true,false,true,false,true'
+function count(n, step) { var s = 0, i; for (i = 0; i < n; i++) { s += step; s -= 1; } return s; }
+count(100, 1.5); //$number 50
+count(3, 'a'); //$number NaN
+count(4, 3); //$number 8
+function inc(x) { var y = x; var z = y++; ++y; y--; return z + ':' + y; }
+inc(1); //$string '1:2'
+inc('2'); //$string '2:3'
+inc(NaN); //$string 'NaN:NaN'
+function cond(x) { if (x) return 'yes'; else return 'no'; }
+cond(1) + cond(0) + cond('') + cond(cond) + cond(true) + cond(NaN); //$string 'yesnonoyesyesno'
+)");
+}
+
+void test_jit_policy() {
+    // Returns the number of function bodies compiled by the jit engine when running 'text' with 'policy'
+    auto compiles = [](const jit_policy& policy, const char16_t* text) {
+        gc_heap h{1<<20};
+        jit_statistics stats;
+        {
+            auto bs = parse(std::make_shared<source_file>(u"test", text, tested_version()));
+            interpreter i{h, tested_version(), {}, interpreter_engine::jit};
+            i.jit_compilation_policy(policy);
+            i.eval(*bs);
+            stats = i.jit_compilation_stats();
+        }
+        h.garbage_collect();
+        REQUIRE(!h.use_percentage());
+        return stats.compiles;
+    };
+
+    const auto calls = uR"(function f(x) { return x + 1; } for (var i = 0; i < 5; ++i) f(i);)";
+    if (!jit::available()) {
+        REQUIRE_EQ(compiles(jit_policy{}, calls), uint64_t{0});
+        return;
+    }
+    jit_policy policy;
+    REQUIRE_EQ(compiles(policy, calls), uint64_t{1});
+    policy.threshold = 10 * policy.call_weight;
+    REQUIRE_EQ(compiles(policy, calls), uint64_t{0});
+    policy.threshold = 0;
+    REQUIRE_EQ(compiles(policy, calls), uint64_t{1});
+    policy.max_compiles = 0;
+    REQUIRE_EQ(compiles(policy, calls), uint64_t{0});
+
+    // Loop iterations make a body hot, so it's compiled for its second call
+    policy = jit_policy{};
+    REQUIRE_EQ(compiles(policy, uR"(function g(n) { var s = 0; for (var i = 0; i < n; ++i) s += i; return s; } g(5000); g(1);)"), uint64_t{1});
+    REQUIRE_EQ(compiles(policy, uR"(function g(n) { var s = 0; for (var i = 0; i < n; ++i) s += i; return s; } g(1); g(1);)"), uint64_t{0});
+}
+
+void test_int32_numbers() {
+    // Integers are kept in an int32 representation unless the result overflows, is fractional or -0
+    RUN_TEST_SPEC(R"(
+var x = 2147483647; x + 1; //$number 2147483648
+x++; x; //$number 2147483648
+var m = 1 << 31; m; //$number -2147483648
+m - 1; //$number -2147483649
+--m; //$number -2147483649
+m = 1 << 31; m / -1; //$number 2147483648
+-m; //$number 2147483648
+1 / (m % -1) == -Infinity; //$boolean true
+65536 * 65536; //$number 4294967296
+1 / (0 * -1) == -Infinity; //$boolean true
+1 / (-4 % 2) == -Infinity; //$boolean true
+1 / (0 / -5) == -Infinity; //$boolean true
+1 / -(0) == -Infinity; //$boolean true
+-7 % 3; //$number -1
+7 / 2; //$number 3.5
+-12 / 4; //$number -3
+~5; //$number -6
+-1 >>> 0; //$number 4294967295
+-8 >> 1; //$number -4
+(1 << 30) * 4 + ''; //$string '4294967296'
+var s = 0; for (var i = 0; i < 100000; i += 7) { s = (s + i * i) | 0; } s; //$number -1397675037
+)");
+
+    // Property accesses using numbers as keys don't go through strings (when the object has indexed storage)
+    if (tested_version() < version::es3) {
+        return;
+    }
+    RUN_TEST_SPEC(R"(
+var a = [1, 2, 3], i = 1; a[i] + a[i + 1]; //$number 5
+a[1.0] = 5; a[0.5] = 'h'; a[-0] = 'z'; a[-1] = 'n'; a['2'] = 7; [a.join(), a[0.5], a[-1], a['1'], a.length].toString(); //$string 'z,5,7,h,n,5,3'
+a[4294967295] = 1; a.length; //$number 3
+a[4294967294] = 1; a.length; //$number 4294967295
+a[4294967294]; //$number 1
+var o = {}; o[3] = 'x'; o['3'] + o[3.0]; //$string 'xx'
+var log = '', k = {toString: function() { log += 'k'; return 'p'; }}; o[k] = (log += 'v', 1); log + o.p; //$string 'kv1'
+var b = []; for (i = 0; i < 10; ++i) b[i] = i * i; b[9] + b.length; //$number 91
+function P() {} P.prototype[2] = 'proto'; var p = new P(); p[2]; //$string 'proto'
+)");
+}
+
+void test_lazy_arguments() {
+    // The arguments object is only created when the function can observe it (and then only when first accessed)
+    RUN_TEST_SPEC(R"(
+function f(a, b) { return a + b; }
+f(1, 2); //$number 3
+function g(a) { a = 2; var r = arguments[0]; arguments[0] = 3; return r + ',' + a + ',' + arguments.length; }
+g(1, 5); //$string '2,3,2'
+function h(a) { return eval('arguments[0] + a'); }
+h(20); //$number 40
+function w(a) { var o = new Object(); with (o) { return arguments.length; } }
+w(1, 2, 3); //$number 3
+function p(arguments) { return arguments; }
+p(42); //$number 42
+function v() { var arguments; return typeof arguments + arguments.length; }
+v(1); //$string 'object1'
+function c(n) { return n ? arguments.callee(n - 1) + n : 0; }
+c(4); //$number 10
+function u(a) { function inner() { return arguments.length; } a = 7; return inner(1, 2) + a; }
+u(1); //$number 9
+)");
+}
+
+void test_incremental_gc() {
+#if !defined(MJS_GC_STRESS_TEST) && !defined(MJS_GC_INCREMENTAL_STRESS_TEST) // The stress tests don't collect according to the policy
+    // With a pause budget the heap can be collected in steps between statements
+    gc_heap h{1<<18};
+    {
+        auto bs = parse(std::make_shared<source_file>(u"test", uR"(
+var l = new Array();
+for (var i = 0; i < 20000; ++i) {
+    var o = new Object();
+    o.s = 'x' + i;
+    l[i % 500] = o;
+}
+var s = 0;
+for (var i = 0; i < 500; ++i) {
+    s += l[i].s.length;
+}
+s;
+)", tested_version()));
+        int steps = 0;
+        interpreter i{h, tested_version(), [&](const statement&, const completion&) { steps += h.incremental_collection_active(); }, tested_engine()};
+        // Collect often, and incrementally in (very) short steps
+        gc_policy policy;
+        policy.growth_percentage = 10;
+        policy.min_growth = 1024;
+        policy.pause_budget = std::chrono::microseconds{1};
+        i.garbage_collection_policy(policy);
+        REQUIRE_EQ(i.eval(*bs), value{3000.0});
+        REQUIRE(steps > 0);
+    }
+    h.garbage_collect();
+    REQUIRE(!h.use_percentage());
+
+    // Even the first collection is done in steps
+    auto bs = parse(std::make_shared<source_file>(u"test", uR"(
+var l = new Array(150001).join('x').split('');
+for (var i = 0; i < 20000; ++i) {
+    var o = new Object();
+    o.s = 'x' + i;
+}
+l.length;
+)", tested_version()));
+    auto first_collection = [&bs](std::chrono::microseconds budget) {
+        gc_heap h2{1<<23};
+        gc_statistics first;
+        {
+            const interpreter* ip = nullptr;
+            interpreter i{h2, tested_version(), [&](const statement&, const completion&) {
+                if (!first.collections && ip->garbage_collection_stats().collections) {
+                    first = ip->garbage_collection_stats();
+                }
+            }, tested_engine()};
+            ip = &i;
+            gc_policy policy;
+            policy.growth_percentage = 10;
+            policy.min_growth = 1024;
+            policy.pause_budget = budget;
+            i.garbage_collection_policy(policy);
+            REQUIRE_EQ(i.eval(*bs), value{150000.0});
+        }
+        h2.garbage_collect();
+        REQUIRE(!h2.use_percentage());
+        REQUIRE_EQ(first.collections, uint64_t{1});
+        return first;
+    };
+    REQUIRE_EQ(first_collection(std::chrono::microseconds{0}).steps, uint64_t{1});
+    REQUIRE(first_collection(std::chrono::microseconds{1}).steps > 1);
+#endif
+}
+
 void test_eval_exception() {
-    EX_EQUAL("ReferenceError: not_callable is not defined\ntest:1:2-1:18", expect_eval_exception(LR"( not_callable(); )"));
-    EX_EQUAL("TypeError: 42 is not a function\ntest:2:16-2:21\ntest:3:19-3:22\ntest:4:17-4:20\ntest:5:40-5:43", expect_eval_exception(LR"( x = 42;
+    EX_EQUAL("ReferenceError: not_callable is not defined\ntest:1:2-1:18", expect_eval_exception(uR"( not_callable(); )"));
+    EX_EQUAL("TypeError: 42 is not a function\ntest:2:16-2:21\ntest:3:19-3:22\ntest:4:17-4:20\ntest:5:40-5:43", expect_eval_exception(uR"( x = 42;
 function a() { x(); }
    function b() { a(); }
  function c() { b(); }
                                        c();
 )"));
 
-    EX_EQUAL("ReferenceError: bar is not defined\ntest:2:17-2:52\ntest:2:32-2:39\ntest:2:32-2:39\ntest:3:1-3:5", expect_eval_exception(LR"(
+    EX_EQUAL("ReferenceError: bar is not defined\ntest:2:17-2:52\ntest:2:32-2:39\ntest:2:32-2:39\ntest:3:1-3:5", expect_eval_exception(uR"(
 function f(i) { return i > 2 ? f(i-1) : new bar(); }
 f(4);
 )"));
 
-    EX_EQUAL("TypeError: Function is not constructable\ntest:1:1-1:18", expect_eval_exception(L"new parseInt(42);"));
+    EX_EQUAL("TypeError: Function is not constructable\ntest:1:1-1:18", expect_eval_exception(u"new parseInt(42);"));
 
-    EX_EQUAL("SyntaxError: Illegal return statement\neval:1:1-1:11\ntest:1:1-1:19", expect_eval_exception(L"eval('return 42;');"));
-    EX_EQUAL("SyntaxError: Illegal break statement\neval:1:1-1:7\ntest:1:1-1:15", expect_eval_exception(L"eval('break;');"));
-    EX_EQUAL("SyntaxError: Illegal continue statement\neval:1:1-1:10\ntest:1:1-1:18", expect_eval_exception(L"eval('continue;');"));
+    EX_EQUAL("SyntaxError: Illegal return statement\neval:1:1-1:11\ntest:1:1-1:19", expect_eval_exception(u"eval('return 42;');"));
+    EX_EQUAL("SyntaxError: Illegal break statement\neval:1:1-1:7\ntest:1:1-1:15", expect_eval_exception(u"eval('break;');"));
+    EX_EQUAL("SyntaxError: Illegal continue statement\neval:1:1-1:10\ntest:1:1-1:18", expect_eval_exception(u"eval('continue;');"));
 }
 
 void test_es3_statements() {
@@ -743,15 +1015,15 @@ void test_es3_statements() {
     //
     // do..while
     //
-    RUN_TEST(L"s=''; i=1;do{s+=i;}while(++i<3); s", value{string{h,"12"}});
-    RUN_TEST(L"s=''; i=1;do{s+=i;break;}while(++i<3); s", value{string{h,"1"}});
-    RUN_TEST(L"s=''; i=1;do{if(i==1)continue;s+=i;}while(++i<3); s", value{string{h,"2"}});
+    RUN_TEST(u"s=''; i=1;do{s+=i;}while(++i<3); s", value{string{h,"12"}});
+    RUN_TEST(u"s=''; i=1;do{s+=i;break;}while(++i<3); s", value{string{h,"1"}});
+    RUN_TEST(u"s=''; i=1;do{if(i==1)continue;s+=i;}while(++i<3); s", value{string{h,"2"}});
 
     //
     // switch
     //
-    RUN_TEST(L"switch(1){}", value::undefined);
-    RUN_TEST(L"switch(1){case 0:x=42;break;case 1:x=12;break;} x", value{12.});
+    RUN_TEST(u"switch(1){}", value::undefined);
+    RUN_TEST(u"switch(1){case 0:x=42;break;case 1:x=12;break;} x", value{12.});
 
     RUN_TEST_SPEC(R"(
 s='';
@@ -807,11 +1079,11 @@ f(7); s //$ string 'c1c2c3c4c5c6defs4s5'
     //
     // Laballed statements / break+continue to identifer
     //
-    RUN_TEST(L"x:42", value{42.});
+    RUN_TEST(u"x:42", value{42.});
 
-    expect_eval_exception(L"a:a:2;"); // duplicate label
-    expect_eval_exception(L"a:2;while(1){break a;}"); // invalid label reference
-    expect_eval_exception(L"function f(){break a;} a:f();"); // invalid label reference
+    expect_eval_exception(u"a:a:2;"); // duplicate label
+    expect_eval_exception(u"a:2;while(1){break a;}"); // invalid label reference
+    expect_eval_exception(u"function f(){break a;} a:f();"); // invalid label reference
 
     RUN_TEST_SPEC(R"(
 s='';
@@ -849,8 +1121,8 @@ s; //$string '0-00-10-20-31-01-11-21-32-02-12-22-3'
     // Function expressions
     //
 
-    RUN_TEST(L"a=function(){return 42;}; a();", value{42.0});
-    RUN_TEST(L"a=function x(i){return i?i*x(i-1):1;}; a(4);", value{24.});
+    RUN_TEST(u"a=function(){return 42;}; a();", value{42.0});
+    RUN_TEST(u"a=function x(i){return i?i*x(i-1):1;}; a(4);", value{24.});
 
 
     RUN_TEST_SPEC(R"(
@@ -951,13 +1223,13 @@ y;//$string 'blah'
 )");
 
     // ES5.1 12.4 (See Annex D) - `this` should be undefined in the function?
-    RUN_TEST(L"x=13; g=0; try { throw function() { this.x=42; }; } catch (f) { f(); g=x; } g", value{42.});
-    RUN_TEST(L"(function() { try { throw function() { return !('a' in this); }; } catch(e) { var a = true; return e(); } })()", value{true});
+    RUN_TEST(u"x=13; g=0; try { throw function() { this.x=42; }; } catch (f) { f(); g=x; } g", value{42.});
+    RUN_TEST(u"(function() { try { throw function() { return !('a' in this); }; } catch(e) { var a = true; return e(); } })()", value{true});
 }
 
 void test_error_object() {
     if (tested_version() == version::es1) {
-        expect_eval_exception(L"new Error();");
+        expect_eval_exception(u"new Error();");
         return;
     }
 
@@ -1097,18 +1369,18 @@ void test_boolean_object() {
     // Boolean
     //
     // ES3, 15.6.4
-    RUN_TEST(L"Boolean()", value{false});
-    RUN_TEST(L"Boolean(true)", value{true});
-    RUN_TEST(L"Boolean(42)", value{true});
-    RUN_TEST(L"Boolean(0)", value{false});
-    RUN_TEST(L"Boolean('')", value{false});
-    RUN_TEST(L"Boolean('x')", value{true});
-    RUN_TEST(L"new Boolean('x').valueOf()", value{true});
-    RUN_TEST(L"0 + new Boolean()", value{0.});
-    RUN_TEST(L"0 + new Boolean(1)", value{1.});
-    RUN_TEST(L"'' + new Boolean(0)", value{string{h, "false"}});
-    RUN_TEST(L"'' + new Boolean(1)", value{string{h, "true"}});
-    RUN_TEST(L"Object(true).toString()", value{string{h, "true"}});
+    RUN_TEST(u"Boolean()", value{false});
+    RUN_TEST(u"Boolean(true)", value{true});
+    RUN_TEST(u"Boolean(42)", value{true});
+    RUN_TEST(u"Boolean(0)", value{false});
+    RUN_TEST(u"Boolean('')", value{false});
+    RUN_TEST(u"Boolean('x')", value{true});
+    RUN_TEST(u"new Boolean('x').valueOf()", value{true});
+    RUN_TEST(u"0 + new Boolean()", value{0.});
+    RUN_TEST(u"0 + new Boolean(1)", value{1.});
+    RUN_TEST(u"'' + new Boolean(0)", value{string{h, "false"}});
+    RUN_TEST(u"'' + new Boolean(1)", value{string{h, "true"}});
+    RUN_TEST(u"Object(true).toString()", value{string{h, "true"}});
 
     if (tested_version() < version::es3) {
         return;
@@ -1125,15 +1397,15 @@ void test_number_object() {
     gc_heap h{8192};
 
     // Number
-    RUN_TEST(L"Number()", value{0.});
-    RUN_TEST(L"Number(42.42)", value{42.42});
-    RUN_TEST(L"Number.MIN_VALUE", value{5e-324});
-    RUN_TEST(L"Number('1.2')", value{1.2});
-    RUN_TEST(L"Number('1,2')", value{NAN});
-    RUN_TEST(L"new Number(42.42).toString()", value{string{h, "42.42"}});
-    RUN_TEST(L"''+new Number(60)", value{string{h, "60"}});
-    RUN_TEST(L"new Number(123).valueOf()", value{123.0});
-    RUN_TEST(L"Object(42).toString(10)", value{string{h, "42"}});
+    RUN_TEST(u"Number()", value{0.});
+    RUN_TEST(u"Number(42.42)", value{42.42});
+    RUN_TEST(u"Number.MIN_VALUE", value{5e-324});
+    RUN_TEST(u"Number('1.2')", value{1.2});
+    RUN_TEST(u"Number('1,2')", value{NAN});
+    RUN_TEST(u"new Number(42.42).toString()", value{string{h, "42.42"}});
+    RUN_TEST(u"''+new Number(60)", value{string{h, "60"}});
+    RUN_TEST(u"new Number(123).valueOf()", value{123.0});
+    RUN_TEST(u"Object(42).toString(10)", value{string{h, "42"}});
     RUN_TEST_SPEC(R"(
 (NaN).toString(2);                  //$string 'NaN'
 (-Infinity).toString(2);            //$string '-Infinity'
@@ -1277,7 +1549,7 @@ try {
 )");
     } else {
         try {
-            RUN_TEST(L"console.assert(0)", value::undefined);
+            RUN_TEST(u"console.assert(0)", value::undefined);
             REQUIRE(!"Should have thrown");
         } catch (const std::exception&) {
         }
@@ -1295,6 +1567,13 @@ void test_main() {
     test_math_functions();
     test_error_object();
     test_long_object_chain();
+    test_local_variables();
+    test_inline_caches();
+    test_jit_speculation();
+    test_jit_policy();
+    test_int32_numbers();
+    test_lazy_arguments();
+    test_incremental_gc();
     test_eval_exception();
     test_console();
 }
\ No newline at end of file
@@ -5,7 +5,7 @@ using namespace mjs;
 
 void test_main() {
     if (tested_version() < version::es5) {
-        RUN_TEST(L"global['JSON']", value::undefined);
+        RUN_TEST(u"global['JSON']", value::undefined);
         return;
     }
 
@@ -30,6 +30,7 @@ JSON.stringify(-Infinity);      //$string 'null'
 JSON.stringify('');             //$string '""'
 JSON.stringify('abc');          //$string '"abc"'
 JSON.stringify('xb"\u1234\u001F"\b\f\n\r\t');  //$string '"xb\\"\u1234\\u001f\\"\\b\\f\\n\\r\\t"'
+JSON.stringify('caf\u00e9\u0001\u00ff');  //$string '"caf\u00e9\\u0001\u00ff"'
 JSON.stringify(new Date(686452434213)); //$string '"1991-10-03T01:13:54.213Z"'
 
 function J(x) { this.x = x; }
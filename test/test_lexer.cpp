@@ -7,7 +7,7 @@
 
 using namespace mjs;
 
-std::vector<token> lex(const std::wstring_view& s) {
+std::vector<token> lex(const std::u16string_view& s) {
     try {
         lexer l{s, tested_version()};
         std::vector<token> ts;
@@ -22,7 +22,7 @@ std::vector<token> lex(const std::wstring_view& s) {
     }
 }
 
-std::string check_lex_fails(const std::wstring_view& s) {
+std::string check_lex_fails(const std::u16string_view& s) {
     try {
         lexer l{s, tested_version()};
         std::vector<token> ts;
@@ -40,74 +40,74 @@ std::string check_lex_fails(const std::wstring_view& s) {
 #define TOKENS(...) std::vector<token>({__VA_ARGS__});
 
 #define SIMPLE_TEST(text, ...) REQUIRE_EQ(lex(text), TOKENS(__VA_ARGS__))
-#define STR(text) token{token_type::string_literal, L ## text}
-#define ID(text) token{token_type::identifier, L ## text}
+#define STR(text) token{token_type::string_literal, u ## text}
+#define ID(text) token{token_type::identifier, u ## text}
 #define T(t) token{token_type::t}
 #define WS T(whitespace)
 #define NL T(line_terminator)
 
 void basic_tests() {
     // Whitespace
-    SIMPLE_TEST(L"\x09\x0b\x0c\x20 ab", WS, ID("ab"));
+    SIMPLE_TEST(u"\x09\x0b\x0c\x20 ab", WS, ID("ab"));
     if (tested_version() > version::es1) {
         // <NBSP> + <USP> are considered whitespace in ES3+
-        SIMPLE_TEST(L"\xA0\x1680\x2000", WS);
+        SIMPLE_TEST(u"\xA0\x1680\x2000", WS);
     }
     // Line terminators
-    SIMPLE_TEST(L"\012x\015", NL, ID("x"), NL);
+    SIMPLE_TEST(u"\012x\015", NL, ID("x"), NL);
     if (tested_version() > version::es1) {
         // In ES3+ \u2028 and \u2029 are considered line terminators
-        SIMPLE_TEST(L"\x2028\x2029", NL);
-        SIMPLE_TEST(L"x//\x2029", ID("x"), WS, NL);
+        SIMPLE_TEST(u"\x2028\x2029", NL);
+        SIMPLE_TEST(u"x//\x2029", ID("x"), WS, NL);
     }
     // Comments
-    SIMPLE_TEST(L"/*hello world!*/", WS);
-    SIMPLE_TEST(L"/*hello\nworld!*/", NL);
-    SIMPLE_TEST(L"x//test", ID("x"), WS);
-    SIMPLE_TEST(L"x//test\n", ID("x"), WS, NL);
+    SIMPLE_TEST(u"/*hello world!*/", WS);
+    SIMPLE_TEST(u"/*hello\nworld!*/", NL);
+    SIMPLE_TEST(u"x//test", ID("x"), WS);
+    SIMPLE_TEST(u"x//test\n", ID("x"), WS, NL);
     // Reserver word
-    SIMPLE_TEST(LR"(for)", T(for_));
+    SIMPLE_TEST(uR"(for)", T(for_));
     // Identifier
-    SIMPLE_TEST(LR"(test)", ID("test"));
-    SIMPLE_TEST(L"a b cd", ID("a"), WS, ID("b"), WS, ID("cd"));
-    SIMPLE_TEST(L"$ _ $foo2_", ID("$"), WS, ID("_"), WS, ID("$foo2_"));
-    SIMPLE_TEST(L"1a", token{1.}, ID("a"));
+    SIMPLE_TEST(uR"(test)", ID("test"));
+    SIMPLE_TEST(u"a b cd", ID("a"), WS, ID("b"), WS, ID("cd"));
+    SIMPLE_TEST(u"$ _ $foo2_", ID("$"), WS, ID("_"), WS, ID("$foo2_"));
+    SIMPLE_TEST(u"1a", token{1.}, ID("a"));
     // Punctuator
-    SIMPLE_TEST(LR"(<<>>>=)", T(lshift), T(rshiftshiftequal));
+    SIMPLE_TEST(uR"(<<>>>=)", T(lshift), T(rshiftshiftequal));
     if (tested_version() == version::es1) {
-        SIMPLE_TEST(LR"(= = ===)", T(equal), WS, T(equal), WS, T(equalequal), T(equal));
-        SIMPLE_TEST(LR"(!==)", T(notequal), T(equal));
+        SIMPLE_TEST(uR"(= = ===)", T(equal), WS, T(equal), WS, T(equalequal), T(equal));
+        SIMPLE_TEST(uR"(!==)", T(notequal), T(equal));
     } else {
         // ===/ !== are new in ES3
-        SIMPLE_TEST(LR"(= = ===)", T(equal), WS, T(equal), WS, T(equalequalequal));
-        SIMPLE_TEST(LR"(!==)", T(notequalequal));
+        SIMPLE_TEST(uR"(= = ===)", T(equal), WS, T(equal), WS, T(equalequalequal));
+        SIMPLE_TEST(uR"(!==)", T(notequalequal));
     }
     // Literal
     //  - null literal
-    SIMPLE_TEST(LR"(null)", T(null_));
+    SIMPLE_TEST(uR"(null)", T(null_));
     //  - boolean literals
-    SIMPLE_TEST(LR"(true)", T(true_));
-    SIMPLE_TEST(LR"(false)", T(false_));
+    SIMPLE_TEST(uR"(true)", T(true_));
+    SIMPLE_TEST(uR"(false)", T(false_));
     //  - numeric literal
-    SIMPLE_TEST(LR"(60)", token{60.});
-    SIMPLE_TEST(LR"(123.123)", token{123.123});
-    SIMPLE_TEST(LR"(1E+309)", token{INFINITY});
-    SIMPLE_TEST(LR"(1E-323)", token{1e-323});
-    SIMPLE_TEST(LR"(1E-324)", token{0});
-    SIMPLE_TEST(LR"(42.25)", token{42.25});
-    SIMPLE_TEST(LR"(1.11e2)", token{111});
-    SIMPLE_TEST(LR"(0x100)", token{256});
-    SIMPLE_TEST(LR"(0123)", token{83});
+    SIMPLE_TEST(uR"(60)", token{60.});
+    SIMPLE_TEST(uR"(123.123)", token{123.123});
+    SIMPLE_TEST(uR"(1E+309)", token{INFINITY});
+    SIMPLE_TEST(uR"(1E-323)", token{1e-323});
+    SIMPLE_TEST(uR"(1E-324)", token{0});
+    SIMPLE_TEST(uR"(42.25)", token{42.25});
+    SIMPLE_TEST(uR"(1.11e2)", token{111});
+    SIMPLE_TEST(uR"(0x100)", token{256});
+    SIMPLE_TEST(uR"(0123)", token{83});
     //  - string literal
-    SIMPLE_TEST(LR"('test "" str')", STR("test \"\" str"));
-    SIMPLE_TEST(LR"("blahblah''")", STR("blahblah''"));
+    SIMPLE_TEST(uR"('test "" str')", STR("test \"\" str"));
+    SIMPLE_TEST(uR"("blahblah''")", STR("blahblah''"));
     //      SingleEscapeCharacter
-    SIMPLE_TEST(LR"('\'\"\\\b\f\n\r\t')", STR("\'\"\\\b\f\n\r\t"));
+    SIMPLE_TEST(uR"('\'\"\\\b\f\n\r\t')", STR("\'\"\\\b\f\n\r\t"));
 
-    check_lex_fails(L"'\n'"); // an unescaped line terminator cannot appear in a string literal in any version
+    check_lex_fails(u"'\n'"); // an unescaped line terminator cannot appear in a string literal in any version
 
     // Line continutations aren't supported until ES5
-    const auto line_continuation = L"'Test\\\nblah!'";
+    const auto line_continuation = u"'Test\\\nblah!'";
     if (tested_version() < version::es5) {
         check_lex_fails(line_continuation);
     } else {
@@ -115,35 +115,35 @@ void basic_tests() {
     }
 
     // Vertical tab (<VT>) supported from es3 on
-    const auto vert_tab_str = LR"('\v')";
+    const auto vert_tab_str = uR"('\v')";
     if (tested_version() == version::es1) {
         check_lex_fails(vert_tab_str);
     } else {
         SIMPLE_TEST(vert_tab_str, STR("\x0B"));
     }
     //      HexEscapeSequence
-    SIMPLE_TEST(LR"('\xAB\x0A')", STR("\xAB\n"));
+    SIMPLE_TEST(uR"('\xAB\x0A')", STR("\xAB\n"));
     //      OctalEscapeSequence
-    SIMPLE_TEST(LR"('\7\77\123\400')", STR("\x07\x3f\x53\x20\x30"));
+    SIMPLE_TEST(uR"('\7\77\123\400')", STR("\x07\x3f\x53\x20\x30"));
     //      UnicodeEscapeSequence
-    SIMPLE_TEST(LR"('\u1234')", STR("\x1234"));
+    SIMPLE_TEST(uR"('\u1234')", STR("\x1234"));
 
     // A combined example
-    SIMPLE_TEST(LR"(if (1) foo['x']=bar();)", T(if_), WS, T(lparen), token{1.}, T(rparen), WS, ID("foo"), T(lbracket), STR("x"), T(rbracket), T(equal), ID("bar"), T(lparen), T(rparen), T(semicolon));
+    SIMPLE_TEST(uR"(if (1) foo['x']=bar();)", T(if_), WS, T(lparen), token{1.}, T(rparen), WS, ID("foo"), T(lbracket), STR("x"), T(rbracket), T(equal), ID("bar"), T(lparen), T(rparen), T(semicolon));
 }
 
-std::wstring get_one_regexp_literal(std::wstring_view text) {
+std::u16string get_one_regexp_literal(std::u16string_view text) {
     lexer l{text, tested_version()};
     const auto regex_lit = l.get_regex_literal();
     REQUIRE(!l.current_token()); // Must be at end
-    return std::wstring{regex_lit};
+    return std::u16string{regex_lit};
 }
 
-void test_get_regex_literal(std::wstring_view text) {
+void test_get_regex_literal(std::u16string_view text) {
     REQUIRE_EQ(text, get_one_regexp_literal(text));
 }
 
-void test_get_regex_literal_fails(std::wstring_view text) {
+void test_get_regex_literal_fails(std::u16string_view text) {
     try {
         lexer l{text, tested_version()};
         l.get_regex_literal();
@@ -158,17 +158,17 @@ void test_get_regex_literal_fails(std::wstring_view text) {
 }
 
 void test_regexp_literals() {
-    test_get_regex_literal(LR"(/(?:)/)");
-    test_get_regex_literal(LR"(/=X/)");
-    test_get_regex_literal(LR"(/[123]xx/g)");
-    test_get_regex_literal(LR"(/a/test)");
-    test_get_regex_literal(LR"(/\||1212/)");
-    test_get_regex_literal(LR"(/abc\//)");
-    test_get_regex_literal(LR"(/[\/\[]]/)");
-    test_get_regex_literal_fails(LR"(/abc)");
-    test_get_regex_literal_fails(LR"(/abc\/)");
-    test_get_regex_literal_fails(L"/a\nbc/");
-    const wchar_t* const unsescaped_slash_in_character_class = L"/[/]/";
+    test_get_regex_literal(uR"(/(?:)/)");
+    test_get_regex_literal(uR"(/=X/)");
+    test_get_regex_literal(uR"(/[123]xx/g)");
+    test_get_regex_literal(uR"(/a/test)");
+    test_get_regex_literal(uR"(/\||1212/)");
+    test_get_regex_literal(uR"(/abc\//)");
+    test_get_regex_literal(uR"(/[\/\[]]/)");
+    test_get_regex_literal_fails(uR"(/abc)");
+    test_get_regex_literal_fails(uR"(/abc\/)");
+    test_get_regex_literal_fails(u"/a\nbc/");
+    const char16_t* const unsescaped_slash_in_character_class = u"/[/]/";
     // In ES5 '/' can be unescaped in a character class
     if (tested_version() < version::es5) {
         test_get_regex_literal_fails(unsescaped_slash_in_character_class);
@@ -180,13 +180,13 @@ void test_regexp_literals() {
 template<size_t size>
 void check_keywords(const char* const (&list)[size]) {
     for (auto s: list) {
-        const auto tt = std::wstring(s, s+std::strlen(s));
+        const auto tt = std::u16string(s, s+std::strlen(s));
         const auto ts = lex(tt);
         REQUIRE_EQ(ts.size(), 1U);
         REQUIRE(!ts[0].has_text());
         std::wostringstream woss;
         woss << ts[0];
-        REQUIRE_EQ(woss.str(), L"token{" + tt + L"}");
+        REQUIRE_EQ(to_u16string(woss.str()), u"token{" + tt + u"}");
     }
 }
 
@@ -205,33 +205,33 @@ void check_keywords() {
 }
 
 void test_unicode_escape_sequence_in_identifier() {
-    check_lex_fails(LR"(\u0069\u0066)"); // Must not spell 'if' like this
-    check_lex_fails(LR"(\u0069\u0000)");
-    check_lex_fails(LR"(\u0069\u00)");
-    check_lex_fails(LR"(\u0069\u0)");
-    check_lex_fails(LR"(\u0069\u)");
-    check_lex_fails(LR"(\u0069\)");
-    check_lex_fails(LR"(\u0069\x66)");
+    check_lex_fails(uR"(\u0069\u0066)"); // Must not spell 'if' like this
+    check_lex_fails(uR"(\u0069\u0000)");
+    check_lex_fails(uR"(\u0069\u00)");
+    check_lex_fails(uR"(\u0069\u0)");
+    check_lex_fails(uR"(\u0069\u)");
+    check_lex_fails(uR"(\u0069\)");
+    check_lex_fails(uR"(\u0069\x66)");
 
-    const auto uid = LR"(\u0073X\u0031d)";
+    const auto uid = uR"(\u0073X\u0031d)";
     if (tested_version() == version::es1) {
         check_lex_fails(uid);
     } else {
-        SIMPLE_TEST(LR"(\u0069)", ID("i"));
+        SIMPLE_TEST(uR"(\u0069)", ID("i"));
         SIMPLE_TEST(uid, ID("sX1d"));
-        SIMPLE_TEST(L"\\u1234\x7533", ID("\x1234\x7533"));
+        SIMPLE_TEST(u"\\u1234\x7533", ID("\x1234\x7533"));
     }
 }
 
 void test_format_control_characters() {
-    REQUIRE_EQ(strip_format_control_characters(L"te\xADst\x600zz"), L"testzz");
-    check_lex_fails(L"1\xAD"); // Soft-hypen
-    check_lex_fails(L"a\x600");
-    check_lex_fails(L"\x200c");
-    const wchar_t * const in_id = L"a\x200c\x200dz";
-    const wchar_t * const bom_is_ws = L"\xFEFF  \xFEFF" L"abc\t\xFEFF";
-    const wchar_t * const cf_in_lit = L"'\x600\x200c\xFEFF hello'";
-    const wchar_t * const cf_in_relit = L"/\x600\x200c\xFEFF/";
+    REQUIRE_EQ(strip_format_control_characters(u"te\xADst\x600zz"), u"testzz");
+    check_lex_fails(u"1\xAD"); // Soft-hypen
+    check_lex_fails(u"a\x600");
+    check_lex_fails(u"\x200c");
+    const char16_t * const in_id = u"a\x200c\x200dz";
+    const char16_t * const bom_is_ws = u"\xFEFF  \xFEFF" u"abc\t\xFEFF";
+    const char16_t * const cf_in_lit = u"'\x600\x200c\xFEFF hello'";
+    const char16_t * const cf_in_relit = u"/\x600\x200c\xFEFF/";
 
     // It's only in ES3 that we can't have format control characters in string literals
     if (tested_version() != version::es3) {
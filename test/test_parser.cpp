@@ -24,12 +24,12 @@ using namespace mjs;
 
 struct parse_failure {};
 
-auto make_source(const std::wstring_view& text) {
-    return std::make_shared<source_file>(L"test", text, tested_version());
+auto make_source(const std::u16string_view& text) {
+    return std::make_shared<source_file>(u"test", text, tested_version());
 }
 
 auto make_source(const char* text) {
-    return make_source(std::wstring(text, text+std::strlen(text)));
+    return make_source(std::u16string(text, text+std::strlen(text)));
 }
 
 template<typename T>
@@ -49,7 +49,7 @@ auto parse_one_statement(const CharT* text) {
     }
 }
 
-std::exception_ptr test_parse_fails(const std::wstring_view text) {
+std::exception_ptr test_parse_fails(const std::u16string_view text) {
     try {
         auto res = parse_text(text);
         std::wcout << "Parsed:\n" << *res << "\n";
@@ -63,7 +63,7 @@ std::exception_ptr test_parse_fails(const std::wstring_view text) {
 }
 
 auto test_parse_fails(const char* text) {
-    return test_parse_fails(std::wstring{text, text+std::strlen(text)});
+    return test_parse_fails(std::u16string{text, text+std::strlen(text)});
 }
 
 template<typename CharT>
@@ -80,14 +80,14 @@ std::unique_ptr<expression_statement> parse_expression(const CharT* text) {
 
 void test_semicolon_insertion() {
     test_parse_fails(R"({ 1 2 } 3)");
-    RUN_TEST(LR"({ 1
+    RUN_TEST(uR"({ 1
 2 } 3)", value{3.});
-    RUN_TEST(LR"({ 1
+    RUN_TEST(uR"({ 1
 ;2 ;} 3;)", value{3.}); // Valid
     test_parse_fails(R"(for (a; b
 ))");
 
-    RUN_TEST(LR"(function f(a, b) { return
+    RUN_TEST(uR"(function f(a, b) { return
         a+b;}
         f(1,2))", value::undefined);
 
@@ -117,19 +117,19 @@ x++; x //$ number 2
     {
         auto cont_s = parse_one_statement("continue");
         REQUIRE_EQ(cont_s->type(), statement_type::continue_);
-        REQUIRE_EQ(static_cast<const continue_statement&>(*cont_s).id(), L"");
+        REQUIRE_EQ(static_cast<const continue_statement&>(*cont_s).id(), u"");
     }
     {
         auto break_s = parse_one_statement("break");
         REQUIRE_EQ(break_s->type(), statement_type::break_);
-        REQUIRE_EQ(static_cast<const break_statement&>(*break_s).id(), L"");
+        REQUIRE_EQ(static_cast<const break_statement&>(*break_s).id(), u"");
     }
 
     {
         auto es = parse_text("continue\nid");
         REQUIRE_EQ(es->l().size(), 2U);
         REQUIRE_EQ(es->l()[0]->type(), statement_type::continue_);
-        REQUIRE_EQ(static_cast<const continue_statement&>(*es->l()[0]).id(), L"");
+        REQUIRE_EQ(static_cast<const continue_statement&>(*es->l()[0]).id(), u"");
         REQUIRE_EQ(es->l()[1]->type(), statement_type::expression);
         
     }
@@ -137,7 +137,7 @@ x++; x //$ number 2
         auto es = parse_text("break\nid");
         REQUIRE_EQ(es->l().size(), 2U);
         REQUIRE_EQ(es->l()[0]->type(), statement_type::break_);
-        REQUIRE_EQ(static_cast<const break_statement&>(*es->l()[0]).id(), L"");
+        REQUIRE_EQ(static_cast<const break_statement&>(*es->l()[0]).id(), u"");
         REQUIRE_EQ(es->l()[1]->type(), statement_type::expression);
     }
 
@@ -148,12 +148,12 @@ x++; x //$ number 2
         {
             auto cont_s = parse_one_statement("continue id");
             REQUIRE_EQ(cont_s->type(), statement_type::continue_);
-            REQUIRE_EQ(static_cast<const continue_statement&>(*cont_s).id(), L"id");
+            REQUIRE_EQ(static_cast<const continue_statement&>(*cont_s).id(), u"id");
         }
         {
             auto break_s = parse_one_statement("break id");
             REQUIRE_EQ(break_s->type(), statement_type::break_);
-            REQUIRE_EQ(static_cast<const break_statement&>(*break_s).id(), L"id");
+            REQUIRE_EQ(static_cast<const break_statement&>(*break_s).id(), u"id");
         }
         // TODO: Check no-line-break between throw and expression (like return)
     }
@@ -166,7 +166,7 @@ void test_fails_with_es3_constructors() {
     test_parse_fails("[1,2]");
     test_parse_fails("({a:42})");
     test_parse_fails("({1:2})");
-    RUN_TEST(L"{1,2,3}", value{3.}); // Not an object literal!
+    RUN_TEST(u"{1,2,3}", value{3.}); // Not an object literal!
     test_parse_fails("a in x");
     test_parse_fails("a instanceof x");
     test_parse_fails("switch (x){}");
@@ -288,14 +288,14 @@ void test_object_literal() {
         REQUIRE_EQ(e->elements().size(), 2U);
         const auto& es = e->elements();
         REQUIRE_EQ(es[0].type(), property_assignment_type::normal);
-        REQUIRE_EQ(CHECK_EXPR_TYPE(es[0].name(), identifier).id(), L"get");
+        REQUIRE_EQ(CHECK_EXPR_TYPE(es[0].name(), identifier).id(), u"get");
         REQUIRE_EQ(CHECK_EXPR_TYPE(es[0].value(), literal).t(), token{1.0});
         REQUIRE_EQ(es[1].type(), property_assignment_type::normal);
-        REQUIRE_EQ(CHECK_EXPR_TYPE(es[1].name(), identifier).id(), L"set");
+        REQUIRE_EQ(CHECK_EXPR_TYPE(es[1].name(), identifier).id(), u"set");
         REQUIRE_EQ(CHECK_EXPR_TYPE(es[1].value(), literal).t(), token{2.0});
     }
 
-    RUN_TEST(L"{1,2,3}", value{3.}); // Not an object literal!
+    RUN_TEST(u"{1,2,3}", value{3.}); // Not an object literal!
 
     test_parse_fails("{,})");
 
@@ -319,19 +319,19 @@ void test_object_literal() {
         REQUIRE_EQ(CHECK_EXPR_TYPE(elem.name(), literal).t(), token{33.0});
         REQUIRE_EQ(CHECK_EXPR_TYPE(elem.value(), literal).t(), token{66.0});
 
-        RUN_TEST(L"({if:2}).if", value{2.0}); // Reserved words can be used as property names
-        RUN_TEST(L"global.for", value::undefined);
+        RUN_TEST(u"({if:2}).if", value{2.0}); // Reserved words can be used as property names
+        RUN_TEST(u"global.for", value::undefined);
 
         {
             const auto& [_, ge] = parse_object_literal(get_lit); (void)_;
             const auto& ges = ge->elements();
             REQUIRE_EQ(ges.size(), 1U);
             REQUIRE_EQ(ges[0].type(), property_assignment_type::get);
-            REQUIRE_EQ(CHECK_EXPR_TYPE(ges[0].name(), identifier).id(), L"x");
+            REQUIRE_EQ(CHECK_EXPR_TYPE(ges[0].name(), identifier).id(), u"x");
             auto f = CHECK_EXPR_TYPE(ges[0].value(), function);
-            REQUIRE_EQ(f.id(), L"get x");
+            REQUIRE_EQ(f.id(), u"get x");
             REQUIRE_EQ(f.params().size(), 0U);
-            REQUIRE_EQ(f.body_extend().source_view(), L"( \n )\t{}");
+            REQUIRE_EQ(f.body_extend().source_view(), u"( \n )\t{}");
         }
 
 
@@ -340,13 +340,13 @@ void test_object_literal() {
             const auto& ses = se->elements();
             REQUIRE_EQ(ses.size(), 1U);
             REQUIRE_EQ(ses[0].type(), property_assignment_type::set);
-            REQUIRE_EQ(CHECK_EXPR_TYPE(ses[0].name(), identifier).id(), L"x");
+            REQUIRE_EQ(CHECK_EXPR_TYPE(ses[0].name(), identifier).id(), u"x");
             CHECK_EXPR_TYPE(ses[0].value(), function);
             auto f = CHECK_EXPR_TYPE(ses[0].value(), function);
-            REQUIRE_EQ(f.id(), L"set x");
+            REQUIRE_EQ(f.id(), u"set x");
             REQUIRE_EQ(f.params().size(), 1U);
-            REQUIRE_EQ(f.params()[0], L"x");
-            REQUIRE_EQ(f.body_extend().source_view(), L"(  x )  {}");
+            REQUIRE_EQ(f.params()[0], u"x");
+            REQUIRE_EQ(f.body_extend().source_view(), u"(  x )  {}");
         }
 
         // SyntaxError on wrong paramter count
@@ -372,15 +372,15 @@ void test_object_literal() {
             REQUIRE_EQ(oes.size(), 3U);
 
             REQUIRE_EQ(oes[0].type(), property_assignment_type::get);
-            REQUIRE_EQ(CHECK_EXPR_TYPE(oes[0].name(), identifier).id(), L"if");
+            REQUIRE_EQ(CHECK_EXPR_TYPE(oes[0].name(), identifier).id(), u"if");
             CHECK_EXPR_TYPE(oes[0].value(), function);
 
             REQUIRE_EQ(oes[1].type(), property_assignment_type::set);
-            REQUIRE_EQ(CHECK_EXPR_TYPE(oes[1].name(), identifier).id(), L"if");
+            REQUIRE_EQ(CHECK_EXPR_TYPE(oes[1].name(), identifier).id(), u"if");
             CHECK_EXPR_TYPE(oes[1].value(), function);
 
             REQUIRE_EQ(oes[2].type(), property_assignment_type::normal);
-            REQUIRE_EQ(CHECK_EXPR_TYPE(oes[2].name(), identifier).id(), L"x");
+            REQUIRE_EQ(CHECK_EXPR_TYPE(oes[2].name(), identifier).id(), u"x");
             REQUIRE_EQ(CHECK_EXPR_TYPE(oes[2].value(), literal).t(), token{42.});
         }
 
@@ -391,11 +391,11 @@ void test_object_literal() {
 
             REQUIRE_EQ(oes[0].type(), property_assignment_type::get);
             REQUIRE_EQ(CHECK_EXPR_TYPE(oes[0].name(), literal).t(), token{1e3});
-            REQUIRE_EQ(oes[0].name_str(), L"1000");
+            REQUIRE_EQ(oes[0].name_str(), u"1000");
             CHECK_EXPR_TYPE(oes[0].value(), function);
 
             REQUIRE_EQ(oes[1].type(), property_assignment_type::set);
-            REQUIRE_EQ(CHECK_EXPR_TYPE(oes[1].name(), literal).t(), STR(L"test x\x1234"));
+            REQUIRE_EQ(CHECK_EXPR_TYPE(oes[1].name(), literal).t(), STR(u"test x\x1234"));
             CHECK_EXPR_TYPE(oes[1].value(), function);
         }
     }
@@ -422,10 +422,10 @@ void test_labelled_statements() {
     auto s = parse_one_statement("x:y:;");
     REQUIRE_EQ(s->type(), statement_type::labelled);
     const auto& lsx = static_cast<const labelled_statement&>(*s);
-    REQUIRE_EQ(lsx.id(), L"x");
+    REQUIRE_EQ(lsx.id(), u"x");
     REQUIRE_EQ(lsx.s().type(), statement_type::labelled);
     const auto& lsy = static_cast<const labelled_statement&>(lsx.s());
-    REQUIRE_EQ(lsy.id(), L"y");
+    REQUIRE_EQ(lsy.id(), u"y");
     REQUIRE_EQ(lsy.s().type(), statement_type::empty);
 }
 
@@ -438,10 +438,10 @@ void test_regexp_literal() {
         const auto& be = static_cast<const binary_expression&>(es.e());
         REQUIRE_EQ(be.op(), token_type::equal);
         REQUIRE_EQ(be.lhs().type(), expression_type::identifier);
-        REQUIRE_EQ(static_cast<const identifier_expression&>(be.lhs()).id(), L"a");
+        REQUIRE_EQ(static_cast<const identifier_expression&>(be.lhs()).id(), u"a");
         REQUIRE_EQ(be.rhs().type(), expression_type::regexp_literal);
         const auto& rle = static_cast<const regexp_literal_expression&>(be.rhs());
-        REQUIRE_EQ(rle.re().pattern(), LR"(a*b\/)");
+        REQUIRE_EQ(rle.re().pattern(), uR"(a*b\/)");
         REQUIRE_EQ(rle.re().flags(), regexp_flag::global);
     }
 
@@ -449,18 +449,18 @@ void test_regexp_literal() {
         auto es = parse_expression("/abc/gim");
         REQUIRE_EQ(es->e().type(), expression_type::regexp_literal);
         const auto& re = static_cast<const regexp_literal_expression&>(es->e()).re();
-        REQUIRE_EQ(re.pattern(), L"abc");
+        REQUIRE_EQ(re.pattern(), u"abc");
         REQUIRE_EQ(re.flags(), regexp_flag::global | regexp_flag::ignore_case | regexp_flag::multiline);
     }
 
     // TODO: Error may be deferred in ES3, could support that
-    test_parse_fails(L"/re/x");
-    test_parse_fails(L"/(/");
-    test_parse_fails(L"function f() { /re/x; }");
+    test_parse_fails(u"/re/x");
+    test_parse_fails(u"/(/");
+    test_parse_fails(u"function f() { /re/x; }");
 }
 
 void test_form_control_characters() {
-    const wchar_t* const text = L"t\x200cq12\xADst\xFEFFww;";
+    const char16_t* const text = u"t\x200cq12\xADst\xFEFFww;";
     if (tested_version() != version::es3) {
         test_parse_fails(text);
     } else {
@@ -468,13 +468,13 @@ void test_form_control_characters() {
         REQUIRE_EQ(s->type(), statement_type::expression);
         const auto& e = static_cast<const expression_statement&>(*s).e();
         REQUIRE_EQ(e.type(), expression_type::identifier);
-        REQUIRE_EQ(static_cast<const identifier_expression&>(e).id(), L"tq12stww");
+        REQUIRE_EQ(static_cast<const identifier_expression&>(e).id(), u"tq12stww");
     }
 
     // Format control characters were stripped in ES3
     {
-        const wchar_t* const lit = L"'\xFEFF\x200c\xADtest!!'";
-        const wchar_t* const expected_lit = tested_version() == version::es3 ? L"test!!" : L"\xFEFF\x200c\xADtest!!";
+        const char16_t* const lit = u"'\xFEFF\x200c\xADtest!!'";
+        const char16_t* const expected_lit = tested_version() == version::es3 ? u"test!!" : u"\xFEFF\x200c\xADtest!!";
         auto s = parse_one_statement(lit);
         REQUIRE_EQ(s->type(), statement_type::expression);
         const auto& e = static_cast<const expression_statement&>(*s).e();
@@ -486,20 +486,20 @@ void test_form_control_characters() {
 
     if (tested_version() >= version::es5) {
         // Cf in expression regular expression literals
-        auto s = parse_one_statement(L"\xFEFF/\xFEFF\x200c\xADtest/gi");
+        auto s = parse_one_statement(u"\xFEFF/\xFEFF\x200c\xADtest/gi");
         REQUIRE_EQ(s->type(), statement_type::expression);
         const auto& e = static_cast<const expression_statement&>(*s).e();
         REQUIRE_EQ(e.type(), expression_type::regexp_literal);
         const auto& re = static_cast<const regexp_literal_expression&>(e);
-        REQUIRE_EQ(re.re().pattern(), L"\xFEFF\x200c\xADtest");
+        REQUIRE_EQ(re.re().pattern(), u"\xFEFF\x200c\xADtest");
         REQUIRE_EQ(re.re().flags(), regexp_flag::global | regexp_flag::ignore_case);
 
         // Zero-width (non)-joiner in identifier
-        auto s2 = parse_one_statement(L"test\\u200c\x200dxyz");
+        auto s2 = parse_one_statement(u"test\\u200c\x200dxyz");
         REQUIRE_EQ(s2->type(), statement_type::expression);
         const auto& e2 = static_cast<const expression_statement&>(*s2).e();
         REQUIRE_EQ(e2.type(), expression_type::identifier);
-        REQUIRE_EQ(static_cast<const identifier_expression&>(e2).id(), L"test\x200c\x200dxyz");
+        REQUIRE_EQ(static_cast<const identifier_expression&>(e2).id(), u"test\x200c\x200dxyz");
     }
 
 }
@@ -678,11 +678,25 @@ void test_strict_mode() {
         REQUIRE_EQ(bs->l().size(), 1U);
         REQUIRE_EQ(bs->l()[0]->type(), statement_type::function_definition);
         const auto& f = static_cast<const function_definition&>(*bs->l()[0]);
-        REQUIRE_EQ(f.id(), L"f");
+        REQUIRE_EQ(f.id(), u"f");
         REQUIRE_EQ(f.params().size(), 0U);
         return f.block().strict_mode();
     };
 
+    auto may_use_arguments = [](const char* text) {
+        auto bs = parse_text(text);
+        REQUIRE_EQ(bs->l().size(), 1U);
+        REQUIRE_EQ(bs->l()[0]->type(), statement_type::function_definition);
+        return static_cast<const function_definition&>(*bs->l()[0]).may_use_arguments();
+    };
+    REQUIRE(!may_use_arguments("function f(a){return a+1;}"));
+    REQUIRE(!may_use_arguments("function f(){return x.arguments;}"));
+    REQUIRE(!may_use_arguments("function f(){function g(){return arguments;}}"));
+    REQUIRE(may_use_arguments("function f(){return arguments.length;}"));
+    REQUIRE(may_use_arguments("function f(){function g(){}return arguments;}"));
+    REQUIRE(may_use_arguments("function f(){return eval('1');}"));
+    REQUIRE(may_use_arguments("function f(o){with(o){}}"));
+
     REQUIRE_EQ(is_strict_function("'use strict'"), v >= version::es5);
     REQUIRE_EQ(is_strict_function("1;'use strict'"), false);
     REQUIRE_EQ(is_strict_function("'\\x75se strict'"), false);
@@ -736,8 +750,8 @@ void test_strict_mode() {
         REQUIRE_EQ(le.t().type(), token_type::numeric_literal);
         REQUIRE_EQ(le.t().dvalue(), 83);
     }
-    RUN_TEST(L"'use strict'; 0", value{0.});
-    RUN_TEST(L"'use strict'; 0.5", value{0.5});
+    RUN_TEST(u"'use strict'; 0", value{0.});
+    RUN_TEST(u"'use strict'; 0.5", value{0.5});
     if (v >= version::es5) {
         auto ep = test_parse_fails("'use strict';0123");
         try {
@@ -759,11 +773,11 @@ void test_strict_mode() {
     //
     // OctalEscapeSequences are not allowed
     //
-    const wchar_t* const octal_escape_sequences = L"'\\164es\\164\\130'";
+    const char16_t* const octal_escape_sequences = u"'\\164es\\164\\130'";
     RUN_TEST(octal_escape_sequences, value{string{h, "testX"}});
-    RUN_TEST(L"'use strict';'\\x34\\\\0'", value{string{h, "\x34\\0"}});
+    RUN_TEST(u"'use strict';'\\x34\\\\0'", value{string{h, "\x34\\0"}});
     if (v >= version::es5) {
-        auto ep = test_parse_fails(std::wstring(L"'use strict';")+octal_escape_sequences);
+        auto ep = test_parse_fails(std::u16string(u"'use strict';")+octal_escape_sequences);
         try {
             std::rethrow_exception(ep);
         } catch (const std::exception& e) {
@@ -772,7 +786,7 @@ void test_strict_mode() {
         }
 
         // Also check when the escape sequence occurs in an earlier string literal (a possible directive)
-        auto ep2 = test_parse_fails(octal_escape_sequences+std::wstring(L";'use strict'"));
+        auto ep2 = test_parse_fails(octal_escape_sequences+std::u16string(u";'use strict'"));
         try {
             std::rethrow_exception(ep2);
         } catch (const std::exception& e) {
@@ -784,10 +798,10 @@ void test_strict_mode() {
     //
     // Parameter names may not be repeated
     //
-    const wchar_t* const repeated_args = L"function f(a,a) { return a+a; }; f(1,2)";
+    const char16_t* const repeated_args = u"function f(a,a) { return a+a; }; f(1,2)";
     RUN_TEST(repeated_args, value{4.});
     if (v >= version::es5) {
-        auto ep = test_parse_fails(std::wstring(L"'use strict';")+repeated_args);
+        auto ep = test_parse_fails(std::u16string(u"'use strict';")+repeated_args);
         try {
             std::rethrow_exception(ep);
         } catch (const std::exception& e) {
@@ -800,13 +814,13 @@ void test_strict_mode() {
     // It is a SyntaxError if strict mode code contains an ObjectLiteral with more
     // than one definition of any data property (only until ES2015?)
     //
-    const wchar_t* const repeated_data_properties = L"({1e3:1,'1000':2}[1000])";
+    const char16_t* const repeated_data_properties = u"({1e3:1,'1000':2}[1000])";
     if (v >= version::es3) {
         RUN_TEST(repeated_data_properties, value{2.});
     }
     if (v >= version::es5) {
-        RUN_TEST(L"({get x(){return 42;}, set x(a){}}).x", value{42.});
-        auto ep = test_parse_fails(std::wstring(L"'use strict';")+repeated_data_properties);
+        RUN_TEST(u"({get x(){return 42;}, set x(a){}}).x", value{42.});
+        auto ep = test_parse_fails(std::u16string(u"'use strict';")+repeated_data_properties);
         try {
             std::rethrow_exception(ep);
         } catch (const std::exception& e) {
@@ -820,14 +834,14 @@ void test_strict_mode() {
     // Identifier in a PropertySetParameterList of a PropertyAssignment that is contained in
     // strict code or if its FunctionBody is strict code
     //
-    const wchar_t* const eval_prop = L"'use strict';({eval:42}.eval)";
-    const wchar_t* const args_prop = L"'use strict';({arguments:60}.arguments)";
+    const char16_t* const eval_prop = u"'use strict';({eval:42}.eval)";
+    const char16_t* const args_prop = u"'use strict';({arguments:60}.arguments)";
     if (v >= version::es3) {
         RUN_TEST(eval_prop, value{42.});
         RUN_TEST(args_prop, value{60.});
     }
     if (v >= version::es5) {
-        RUN_TEST(L"'use strict';({get eval(){return 12;}}).eval + ({get arguments(){return 34;}}).arguments", value{46.});
+        RUN_TEST(u"'use strict';({get eval(){return 12;}}).eval + ({get arguments(){return 34;}}).arguments", value{46.});
 
         auto ep1 = test_parse_fails("'use strict';({set x(eval){}});");
         try {
@@ -855,27 +869,27 @@ void test_strict_mode() {
     // operator (11.13) or of a PostfixExpression (11.3) or as the UnaryExpression operated upon by
     // a Prefix Increment (11.4.4) or a Prefix Decrement (11.4.5) operator.
     //
-    const wchar_t* const var_syntax_error_tests[] = {
-        L"var a,arguments;",
-        L"var eval,x;",
-        L"for (var q,eval;;) {};",
-        L"o = Object.create(null); for (var arguments in o) {};",
-        L"function eval(){};",
-        L"function arguments(){};",
-        L"function x(a,eval){};",
-        L"function x(arguments){};",
-        L"eval=1;",
-        L"arguments<<=2;",
-        L"++eval;",
-        L"--arguments;",
-        L"eval--",
-        L"arguments++",
+    const char16_t* const var_syntax_error_tests[] = {
+        u"var a,arguments;",
+        u"var eval,x;",
+        u"for (var q,eval;;) {};",
+        u"o = Object.create(null); for (var arguments in o) {};",
+        u"function eval(){};",
+        u"function arguments(){};",
+        u"function x(a,eval){};",
+        u"function x(arguments){};",
+        u"eval=1;",
+        u"arguments<<=2;",
+        u"++eval;",
+        u"--arguments;",
+        u"eval--",
+        u"arguments++",
     };
 
     for (const auto t: var_syntax_error_tests) {
         (void)parse_text(t);
         if (v >= version::es5) {
-            auto ep = test_parse_fails(std::wstring(L"'use strict';")+t);
+            auto ep = test_parse_fails(std::u16string(u"'use strict';")+t);
             try {
                 std::rethrow_exception(ep);
             } catch (const std::exception& e) {
@@ -886,9 +900,9 @@ void test_strict_mode() {
     }
 
     if (v >= version::es5) {
-        const wchar_t* const function_expr = L"(function eval(){})";
+        const char16_t* const function_expr = u"(function eval(){})";
         (void)parse_text(function_expr);
-        auto ep1 = test_parse_fails(std::wstring(L"'use strict';")+function_expr);
+        auto ep1 = test_parse_fails(std::u16string(u"'use strict';")+function_expr);
         try {
             std::rethrow_exception(ep1);
         } catch (const std::exception& e) {
@@ -897,7 +911,7 @@ void test_strict_mode() {
         }
 
         // Check that argument names are check after we know if it's a strict mode function
-        auto ep2 = test_parse_fails(L"function x(eval){'use strict';}");
+        auto ep2 = test_parse_fails(u"function x(eval){'use strict';}");
         try {
             std::rethrow_exception(ep2);
         } catch (const std::exception& e) {
@@ -906,7 +920,7 @@ void test_strict_mode() {
         }
 
         // Also check that function names are verified after body is parsed
-        auto ep3 = test_parse_fails(L"function y() { function arguments(){'use strict';} }");
+        auto ep3 = test_parse_fails(u"function y() { function arguments(){'use strict';} }");
         try {
             std::rethrow_exception(ep3);
         } catch (const std::exception& e) {
@@ -914,7 +928,7 @@ void test_strict_mode() {
             REQUIRE(std::string(e.what()).find(R"(at "arguments")") != std::string::npos);
         }
 
-        auto ep4 = test_parse_fails(L"(function eval\n(){'use strict';});");
+        auto ep4 = test_parse_fails(u"(function eval\n(){'use strict';});");
         try {
             std::rethrow_exception(ep4);
         } catch (const std::exception& e) {
@@ -928,15 +942,15 @@ void test_strict_mode() {
     // the Catch production is eval or arguments (12.14.1)
     //
     if (v >= version::es3) {
-        const wchar_t* const try_catch_syntax_error[] = {
-            L"try {} catch (eval) {}",
-            L"try {} catch (arguments) {}",
+        const char16_t* const try_catch_syntax_error[] = {
+            u"try {} catch (eval) {}",
+            u"try {} catch (arguments) {}",
         };
 
         for (const auto t: try_catch_syntax_error) {
             (void)parse_text(t);
             if (v >= version::es5) {
-                auto ep = test_parse_fails(std::wstring(L"'use strict';")+t);
+                auto ep = test_parse_fails(std::u16string(u"'use strict';")+t);
                 try {
                     std::rethrow_exception(ep);
                 } catch (const std::exception& e) {
@@ -959,16 +973,16 @@ void test_strict_mode() {
 
     const struct {
         version         min_versions;
-        const wchar_t*  text;
+        const char16_t*  text;
     } delete_cases [] = {
-        { version::es1, L"delete x;" },// Delete of unqualified identifier
-        { version::es1, L"var x; delete x;"} ,
-        { version::es1, L"function f(){}; delete f;" },
-        { version::es1, L"function f() { delete x; }" },
-        { version::es1, L"function f(a) { delete a; }" },
-        { version::es3, L"function f() { if (0) { try { for (;;) { delete x; } } catch(e) {} } }" },
-        { version::es3, L"function f() { if (0) { try { for (var x;;) { delete x; } } catch(e) {} } }" },
-        { version::es5, L"o = { x:42, get a(){ delete x; return 12;} };" },
+        { version::es1, u"delete x;" },// Delete of unqualified identifier
+        { version::es1, u"var x; delete x;"} ,
+        { version::es1, u"function f(){}; delete f;" },
+        { version::es1, u"function f() { delete x; }" },
+        { version::es1, u"function f(a) { delete a; }" },
+        { version::es3, u"function f() { if (0) { try { for (;;) { delete x; } } catch(e) {} } }" },
+        { version::es3, u"function f() { if (0) { try { for (var x;;) { delete x; } } catch(e) {} } }" },
+        { version::es5, u"o = { x:42, get a(){ delete x; return 12;} };" },
     };
 
     for (const auto tc: delete_cases) {
@@ -977,7 +991,7 @@ void test_strict_mode() {
         }
         (void)parse_text(tc.text);
         if (v >= version::es5) {
-            auto ep = test_parse_fails(std::wstring(L"'use strict';")+tc.text);
+            auto ep = test_parse_fails(std::u16string(u"'use strict';")+tc.text);
             try {
                 std::rethrow_exception(ep);
             } catch (const std::exception& e) {
@@ -989,6 +1003,25 @@ void test_strict_mode() {
     }
 }
 
+void test_hoisted_declarations() {
+    // Declarations of function bodies are found when parsing (nested functions are scanned separately)
+    auto bs = parse_text("function f(a){var x; if (a) { var y; function g(){var z;} } function g(){} for (var x in a) {} }");
+    REQUIRE_EQ(bs->l().size(), 1U);
+    REQUIRE_EQ(bs->l()[0]->type(), statement_type::function_definition);
+    const auto& f = static_cast<const function_definition&>(*bs->l()[0]);
+    const auto& decls = f.shared_info()->declarations;
+    REQUIRE(decls.ids == (std::vector<std::u16string>{u"x", u"y", u"g", u"x"}));
+    REQUIRE_EQ(decls.functions.size(), 1U);
+    REQUIRE_EQ(decls.functions[0]->id(), u"g");
+    REQUIRE(decls.functions[0]->shared_info()->declarations.ids == std::vector<std::u16string>{u"z"});
+    REQUIRE_EQ(f.shared_info()->block.get(), &f.block());
+
+    // Programs are scanned on demand
+    const auto pd = hoisted_declarations::scan(*parse_text("var a; function h(){}"));
+    REQUIRE(pd.ids == (std::vector<std::u16string>{u"a", u"h"}));
+    REQUIRE_EQ(pd.functions.size(), 1U);
+}
+
 void test_main() {
     check_resered_words();
     test_semicolon_insertion();
@@ -1009,4 +1042,5 @@ void test_main() {
         test_fails_with_es5_constructors();
     }
     test_strict_mode();
+    test_hoisted_declarations();
 }
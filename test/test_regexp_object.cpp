@@ -6,7 +6,7 @@ using namespace mjs;
 
 void test_main() {
     if (tested_version() == version::es1) {
-        expect_eval_exception(L"new RegExp();");
+        expect_eval_exception(u"new RegExp();");
         // That RegExp literals aren't supported is tested elsewhere
         return;
     }
@@ -178,7 +178,7 @@ e('test'); //$string 'TypeError: Object is not a RegExp'
 
     // From ES5 RegExp.prototype is a RegExp object
     gc_heap h{8192};
-    RUN_TEST(L"RegExp.prototype.source", tested_version() >= version::es5 ? value{string{h,"(?:)"}} : value::undefined);
+    RUN_TEST(u"RegExp.prototype.source", tested_version() >= version::es5 ? value{string{h,"(?:)"}} : value::undefined);
 
     if (tested_version() >= version::es5) {
         RUN_TEST_SPEC(R"(
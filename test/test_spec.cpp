@@ -98,7 +98,7 @@ value parse_value(gc_heap& h, const std::string& s) {
             }
         }
         if (type == "string" && iss.get() == '\'') {
-            std::wstring res;
+            std::u16string res;
             bool escape = false;
             while (iss.rdbuf()->in_avail()) {
                 const auto ch = static_cast<uint16_t>(iss.get());
@@ -188,7 +188,7 @@ private:
 #if 0 // The stress test should be enabled, but this might still be relevant later on when debugging the GC
             h.garbage_collect(); // Run garbage collection after each statement to help catch bugs
 #endif
-        })
+        }, tested_engine())
 #ifdef TEST_SPEC_DEBUG
         , heap_(h)
 #endif
@@ -229,7 +229,7 @@ void run_test_spec(const std::string_view& source_text, const std::string_view&
 
     {
         std::vector<test_spec> specs;
-        auto file = std::make_shared<source_file>(std::wstring(name.begin(), name.end()), std::wstring(source_text.begin(), source_text.end()), tested_version());
+        auto file = std::make_shared<source_file>(std::u16string(name.begin(), name.end()), std::u16string(source_text.begin(), source_text.end()), tested_version());
 
         for (size_t pos = 0, next_pos; pos < source_text.length(); pos = next_pos + 1) {
             size_t delim_pos = source_text.find(delim, pos);
@@ -262,7 +262,7 @@ void run_test_spec(const std::string_view& source_text, const std::string_view&
     heap.garbage_collect();
     if (heap.use_percentage()) {
         std::wostringstream oss;
-        oss << "Leaks in test spec: " << heap.use_percentage() << "%\n" << std::wstring(source_text.begin(), source_text.end());
+        oss << "Leaks in test spec: " << heap.use_percentage() << "%\n" << std::u16string(source_text.begin(), source_text.end());
         THROW_RUNTIME_ERROR(oss.str());
     }
 
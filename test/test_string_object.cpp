@@ -7,15 +7,15 @@ void test_main() {
     gc_heap h{8192};
 
     // String
-    RUN_TEST(L"String()", value{string{h, ""}});
-    RUN_TEST(L"String('test')", value{string{h, "test"}});
-    RUN_TEST(L"String('test').length", value{4.0});
-    RUN_TEST(L"s = new String('test'); s.length = 42; s.length", value{4.0});
-    RUN_TEST(L"''+new String()", value{string{h, ""}});
-    RUN_TEST(L"''+new String('test')", value{string{h, "test"}});
-    RUN_TEST(L"Object('testXX').valueOf()", value{string{h, "testXX"}});
-    RUN_TEST(L"String.fromCharCode()", value{string{h, ""}});
-    RUN_TEST(L"String.fromCharCode(65,66,67+32)", value{string{h, "ABc"}});
+    RUN_TEST(u"String()", value{string{h, ""}});
+    RUN_TEST(u"String('test')", value{string{h, "test"}});
+    RUN_TEST(u"String('test').length", value{4.0});
+    RUN_TEST(u"s = new String('test'); s.length = 42; s.length", value{4.0});
+    RUN_TEST(u"''+new String()", value{string{h, ""}});
+    RUN_TEST(u"''+new String('test')", value{string{h, "test"}});
+    RUN_TEST(u"Object('testXX').valueOf()", value{string{h, "testXX"}});
+    RUN_TEST(u"String.fromCharCode()", value{string{h, ""}});
+    RUN_TEST(u"String.fromCharCode(65,66,67+32)", value{string{h, "ABc"}});
     RUN_TEST_SPEC(R"(
 'test'.charAt(0); //$string 't'
 'test'.charAt(2); //$string 's'
@@ -37,36 +37,43 @@ o = new Object();
 o.charCodeAt = String.prototype.charCodeAt;
 o.charCodeAt(0); //$number 91
 o.charCodeAt(-1); //$number NaN
+)");
+    // Substrings (long enough to share the characters) of a one-byte rope, which gets widened when flattened
+    RUN_TEST_SPEC(R"(
+var s = 'x'; for (var i = 0; i < 30; ++i) s += 'a';
+s.substring(10, 30); //$string 'aaaaaaaaaaaaaaaaaaaa'
+s.substring(0, 15).substring(1, 14); //$string 'aaaaaaaaaaaaa'
+s.substring(0, 15); //$string 'xaaaaaaaaaaaaaa'
 )");
 
-    RUN_TEST(L"''.indexOf()", value{-1.});
-    RUN_TEST(L"'11 undefined'.indexOf()", value{3.});
-    RUN_TEST(L"'testfesthest'.indexOf('XX')", value{-1.});
-    RUN_TEST(L"'testfesthest'.indexOf('est')", value{1.});
-    RUN_TEST(L"'testfesthest'.indexOf('est',3)", value{5.});
-    RUN_TEST(L"'testfesthest'.indexOf('est',7)", value{9.});
-    RUN_TEST(L"'testfesthest'.indexOf('est',11)", value{-1.});
-    RUN_TEST(L"'testfesthest'.lastIndexOf('estX')", value{-1.});
-    RUN_TEST(L"'testfesthest'.lastIndexOf('est')", value{9.});
-    RUN_TEST(L"'testfesthest'.lastIndexOf('est',1)", value{1.});
-    RUN_TEST(L"'testfesthest'.lastIndexOf('est',3)", value{1.});
-    RUN_TEST(L"'testfesthest'.lastIndexOf('est',7)", value{5.});
-    RUN_TEST(L"'testfesthest'.lastIndexOf('est', 22)", value{9.});
-    RUN_TEST(L"''.split()+''", value{string{h, ""}});
-    RUN_TEST(L"'1 2 3'.split()+''", value{string{h, "1 2 3"}});
-    RUN_TEST(L"'abcd'.split('')+''", value{string{h, "a,b,c,d"}});
-    RUN_TEST(L"'1 2 3'.split('not found')+''", value{string{h, "1 2 3"}});
-    RUN_TEST(L"'1 2 3'.split(' ')+''", value{string{h, "1,2,3"}});
-    RUN_TEST(L"'foo bar'.substring()", value{string{h, "foo bar"}});
-    RUN_TEST(L"'foo bar'.substring(-1)", value{string{h, "foo bar"}});
-    RUN_TEST(L"'foo bar'.substring(42)", value{string{h, ""}});
-    RUN_TEST(L"'foo bar'.substring(3)", value{string{h, " bar"}});
-    RUN_TEST(L"'foo bar'.substring(0, 1)", value{string{h, "f"}});
-    RUN_TEST(L"'foo bar'.substring(1, 0)", value{string{h, "f"}});
-    RUN_TEST(L"'foo bar'.substring(1000, -1)", value{string{h, "foo bar"}});
-    RUN_TEST(L"'foo bar'.substring(1, 4)", value{string{h, "oo "}});
-    RUN_TEST(L"'ABc'.toLowerCase()", value{string{h, "abc"}});
-    RUN_TEST(L"'ABc'.toUpperCase()", value{string{h, "ABC"}});
+    RUN_TEST(u"''.indexOf()", value{-1.});
+    RUN_TEST(u"'11 undefined'.indexOf()", value{3.});
+    RUN_TEST(u"'testfesthest'.indexOf('XX')", value{-1.});
+    RUN_TEST(u"'testfesthest'.indexOf('est')", value{1.});
+    RUN_TEST(u"'testfesthest'.indexOf('est',3)", value{5.});
+    RUN_TEST(u"'testfesthest'.indexOf('est',7)", value{9.});
+    RUN_TEST(u"'testfesthest'.indexOf('est',11)", value{-1.});
+    RUN_TEST(u"'testfesthest'.lastIndexOf('estX')", value{-1.});
+    RUN_TEST(u"'testfesthest'.lastIndexOf('est')", value{9.});
+    RUN_TEST(u"'testfesthest'.lastIndexOf('est',1)", value{1.});
+    RUN_TEST(u"'testfesthest'.lastIndexOf('est',3)", value{1.});
+    RUN_TEST(u"'testfesthest'.lastIndexOf('est',7)", value{5.});
+    RUN_TEST(u"'testfesthest'.lastIndexOf('est', 22)", value{9.});
+    RUN_TEST(u"''.split()+''", value{string{h, ""}});
+    RUN_TEST(u"'1 2 3'.split()+''", value{string{h, "1 2 3"}});
+    RUN_TEST(u"'abcd'.split('')+''", value{string{h, "a,b,c,d"}});
+    RUN_TEST(u"'1 2 3'.split('not found')+''", value{string{h, "1 2 3"}});
+    RUN_TEST(u"'1 2 3'.split(' ')+''", value{string{h, "1,2,3"}});
+    RUN_TEST(u"'foo bar'.substring()", value{string{h, "foo bar"}});
+    RUN_TEST(u"'foo bar'.substring(-1)", value{string{h, "foo bar"}});
+    RUN_TEST(u"'foo bar'.substring(42)", value{string{h, ""}});
+    RUN_TEST(u"'foo bar'.substring(3)", value{string{h, " bar"}});
+    RUN_TEST(u"'foo bar'.substring(0, 1)", value{string{h, "f"}});
+    RUN_TEST(u"'foo bar'.substring(1, 0)", value{string{h, "f"}});
+    RUN_TEST(u"'foo bar'.substring(1000, -1)", value{string{h, "foo bar"}});
+    RUN_TEST(u"'foo bar'.substring(1, 4)", value{string{h, "oo "}});
+    RUN_TEST(u"'ABc'.toLowerCase()", value{string{h, "abc"}});
+    RUN_TEST(u"'ABc'.toUpperCase()", value{string{h, "ABC"}});
 
     // Array like access came in ES5
     if (tested_version() < version::es5) {
@@ -210,7 +217,7 @@ try { String.prototype.valueOf.call({}); } catch (e) { e.toString(); } //$string
 
     // ES5.1, 15.5.4.20 String.prototype.trim
     if (tested_version() < version::es5) {
-        RUN_TEST(L"String.prototype.trim", value::undefined);
+        RUN_TEST(u"String.prototype.trim", value::undefined);
     } else {
 
         RUN_TEST_SPEC(R"(
@@ -66,7 +66,7 @@ void test_utf8_conversion() {
 void test_utf16_conversion() {
     const struct {
         uint32_t code_point;
-        wchar_t  chars[2];
+        char16_t  chars[2];
     } cases[] = {
         { 0x00000, { 0x0000, 0x0000 } },
         { 0x00024, { 0x0024, 0x0000 } },
@@ -75,7 +75,7 @@ void test_utf16_conversion() {
         { 0x24B62, { 0xD852, 0xDF62 } },
     };
 
-    wchar_t buffer[utf16_max_length];
+    char16_t buffer[utf16_max_length];
 
     for (const auto& c: cases) {
         const unsigned len = c.chars[1] != 0 ? 2 : 1;
@@ -95,8 +95,8 @@ void test_utf16_conversion() {
 
     REQUIRE_EQ(utf16_length_from_lead_code_unit(0xdc00), 0U);
     REQUIRE_EQ(utf16_length_from_lead_code_unit(0xd800), 2U);
-    REQUIRE_EQ(utf16_to_utf32(L"\xdc00", 2).length, 0U);
-    REQUIRE_EQ(utf16_to_utf32(L"\xd800", 1).length, 0U);
+    REQUIRE_EQ(utf16_to_utf32(u"\xdc00", 2).length, 0U);
+    REQUIRE_EQ(utf16_to_utf32(u"\xd800", 1).length, 0U);
 
     REQUIRE_EQ(utf32_to_utf16(max_code_point, buffer), 0U);
 
@@ -106,15 +106,15 @@ void test_utf16_conversion() {
 }
 
 void test_utf8_to_utf16() {
-    REQUIRE_EQ(utf8_to_utf16(""), L"");
-    REQUIRE_EQ(utf8_to_utf16("abc"), L"abc");
+    REQUIRE_EQ(utf8_to_utf16(""), u"");
+    REQUIRE_EQ(utf8_to_utf16("abc"), u"abc");
 
-    REQUIRE_EQ(utf8_to_utf16("$"                ) , L"\x0024" );
-    REQUIRE_EQ(utf8_to_utf16("\xC2\xA2"         ) , L"\x00A2" );
-    REQUIRE_EQ(utf8_to_utf16("\xE0\xA4\xB9"     ) , L"\x0939" );
-    REQUIRE_EQ(utf8_to_utf16("\xE2\x82\xAC"     ) , L"\x20AC" );
-    REQUIRE_EQ(utf8_to_utf16("\xF0\x90\x8D\x88" ) , L"\xD800\xDF48" );
-    REQUIRE_EQ(utf8_to_utf16("\xf4\x8f\xbf\xbf" ) , L"\xDBFF\xDFFF" );
+    REQUIRE_EQ(utf8_to_utf16("$"                ) , u"\x0024" );
+    REQUIRE_EQ(utf8_to_utf16("\xC2\xA2"         ) , u"\x00A2" );
+    REQUIRE_EQ(utf8_to_utf16("\xE0\xA4\xB9"     ) , u"\x0939" );
+    REQUIRE_EQ(utf8_to_utf16("\xE2\x82\xAC"     ) , u"\x20AC" );
+    REQUIRE_EQ(utf8_to_utf16("\xF0\x90\x8D\x88" ) , u"\xD800\xDF48" );
+    REQUIRE_EQ(utf8_to_utf16("\xf4\x8f\xbf\xbf" ) , u"\xDBFF\xDFFF" );
 
     try { 
         utf8_to_utf16("\xf8\x00\x00\x00\x00");
@@ -126,17 +126,17 @@ void test_utf8_to_utf16() {
 
 void test_utf16_to_utf8() {
 #define TC(s, d) REQUIRE_EQ(utf16_to_utf8(s), d)
-    TC( L""             , ""                 );
-    TC( L"xyz"          , "xyz"              );
-    TC( L"\x0024"       , "$"                );
-    TC( L"\x00A2"       , "\xC2\xA2"         );
-    TC( L"\x0939"       , "\xE0\xA4\xB9"     );
-    TC( L"\x20AC"       , "\xE2\x82\xAC"     );
-    TC( L"\xD800\xDF48" , "\xF0\x90\x8D\x88" );
-    TC( L"\xDBFF\xDFFF" , "\xf4\x8f\xbf\xbf" );
+    TC( u""             , ""                 );
+    TC( u"xyz"          , "xyz"              );
+    TC( u"\x0024"       , "$"                );
+    TC( u"\x00A2"       , "\xC2\xA2"         );
+    TC( u"\x0939"       , "\xE0\xA4\xB9"     );
+    TC( u"\x20AC"       , "\xE2\x82\xAC"     );
+    TC( u"\xD800\xDF48" , "\xF0\x90\x8D\x88" );
+    TC( u"\xDBFF\xDFFF" , "\xf4\x8f\xbf\xbf" );
 #undef TC
     try {
-        utf16_to_utf8(L"\xDC00\xDC00");
+        utf16_to_utf8(u"\xDC00\xDC00");
         REQUIRE(false);
     } catch (const std::exception& e) {
         REQUIRE_EQ(std::string(e.what()), "Unicode conversion failed");
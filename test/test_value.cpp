@@ -5,6 +5,8 @@
 
 #include <mjs/value.h>
 #include <mjs/object.h>
+#include <mjs/value_representation.h>
+#include <mjs/string.h>
 #include <mjs/gc_heap.h>
 #include "test.h"
 
@@ -32,20 +34,240 @@ void test_value() {
     REQUIRE_EQ(value{42.0}.number_value(), 42);
 }
 
+/*("value - int32 numbers") */{
+    gc_heap h{128};
+    const value i{int32_t{-42}};
+    REQUIRE_EQ(i.type(), value_type::number);
+    REQUIRE(i.is_int32());
+    REQUIRE_EQ(i.int32_value(), -42);
+    REQUIRE_EQ(i.number_value(), -42);
+    REQUIRE_EQ(i, value{-42.0});
+    REQUIRE(!value{-42.0}.is_int32());
+    REQUIRE(value_representation{i}.get_value(h).is_int32());
+    REQUIRE_EQ(value_representation{i}.get_value(h).int32_value(), -42);
+    REQUIRE(!value_representation{value{0.5}}.get_value(h).is_int32());
+
+    REQUIRE(make_number_value(INT32_MIN).is_int32());
+    REQUIRE(make_number_value(INT32_MAX).is_int32());
+    REQUIRE(make_number_value(0.0).is_int32());
+    REQUIRE(!make_number_value(-0.0).is_int32());
+    REQUIRE(!make_number_value(0.5).is_int32());
+    REQUIRE(!make_number_value(2147483648.0).is_int32());
+    REQUIRE(!make_number_value(NAN).is_int32());
+    REQUIRE(!make_number_value(INFINITY).is_int32());
+
+    REQUIRE_EQ(to_int32(value{int32_t{-1}}), -1);
+    REQUIRE_EQ(to_uint32(value{int32_t{-1}}), 0xffff'ffffU);
+    REQUIRE_EQ(to_string(h, value{int32_t{-123}}), (string{h, "-123"}));
+}
+
 /*("value - string") */{
     gc_heap h{128};
     REQUIRE_EQ((value{string{h,""}}.type()), value_type::string);
     REQUIRE_EQ((value{string{h,"Hello"}}.type()), value_type::string);
-    REQUIRE_EQ((value{string{h,std::wstring_view{L"test"}}}.type()), value_type::string);
+    REQUIRE_EQ((value{string{h,std::u16string_view{u"test"}}}.type()), value_type::string);
     REQUIRE_EQ((string{h,"test "} + string{h,"42"}), (string{h,"test 42"}));
 
     h.garbage_collect();
     assert(h.use_percentage() == 0);
 }
+
+/*("value - string ropes") */{
+    gc_heap h{1<<12};
+    {
+        string s{h, ""};
+        std::u16string expected;
+        for (int i = 0; i < 100; ++i) {
+            const auto piece = to_u16string(std::to_wstring(i)) + u",";
+            s = s + string{h, piece};
+            expected += piece;
+            if (i == 50) {
+                h.garbage_collect();
+            }
+        }
+        REQUIRE(s.unsafe_raw_get()->is_rope());
+        REQUIRE_EQ(s.length(), expected.length());
+        // Prepending makes the rope lean to the right
+        s = string{h, "prefix:"} + s;
+        expected = u"prefix:" + expected;
+        h.minor_garbage_collect();
+        REQUIRE(s.view() == expected);
+        h.garbage_collect();
+        REQUIRE(s.view() == expected);
+        // Short concatenations are flat
+        REQUIRE(!(string{h, "ab"} + string{h, "cd"}).unsafe_raw_get()->is_rope());
+        REQUIRE_EQ((string{h, "ab"} + string{h, ""}), (string{h, "ab"}));
+    }
+    h.garbage_collect();
+    assert(h.use_percentage() == 0);
+}
+
+/*("value - one-byte strings") */{
+    gc_heap h{1<<12};
+    {
+        const string ascii{h, "Hello world again!"};
+        const string latin1{h, std::u16string_view{u"Caf\xE9 au lait chaud"}};
+        const string wide{h, std::u16string_view{u"\x263A smile \x263A"}};
+        REQUIRE(ascii.unsafe_raw_get()->is_one_byte());
+        REQUIRE(latin1.unsafe_raw_get()->is_one_byte());
+        REQUIRE(!wide.unsafe_raw_get()->is_one_byte());
+        REQUIRE(latin1.unsafe_raw_get()->equals(u"Caf\xE9 au lait chaud"));
+        REQUIRE_EQ(latin1.visit([](auto v) { return char_code(v[3]); }), 0xE9U);
+
+        // Short strings are stored flat
+        const string short_ascii{h, "Hello"};
+        REQUIRE(!short_ascii.unsafe_raw_get()->is_one_byte());
+        REQUIRE(short_ascii.view() == u"Hello");
+        REQUIRE(short_ascii == (string{h, std::u16string_view{u"Hello"}}));
+
+        // Comparing and searching across widths
+        REQUIRE_EQ(ascii.unsafe_raw_get()->compare(*wide.unsafe_raw_get()), -1);
+        REQUIRE_EQ(wide.unsafe_raw_get()->compare(*ascii.unsafe_raw_get()), 1);
+        REQUIRE_EQ(ascii.unsafe_raw_get()->compare(*short_ascii.unsafe_raw_get()), 1);
+        REQUIRE_EQ(latin1.visit([](auto v) { return find_chars(v, std::u16string_view{u"au"}, 0); }), 5U);
+        REQUIRE_EQ(latin1.visit([](auto v) { return rfind_chars(v, std::u16string_view{u"a"}, 100); }), 15U);
+        REQUIRE_EQ(latin1.visit([](auto v) { return find_chars(v, std::u16string_view{u"au"}, 6); }), 15U);
+
+        // Mixing widths
+        const auto mixed = ascii + wide + latin1;
+        REQUIRE(mixed.view() == u"Hello world again!\x263A smile \x263A" u"Caf\xE9 au lait chaud");
+        const auto narrow = ascii + latin1;
+        REQUIRE(narrow == (string{h, std::u16string_view{u"Hello world again!Caf\xE9 au lait chaud"}}));
+        REQUIRE(narrow.substr(18, 18).visit([](auto v) { return sizeof(v[0]); }) == 1);
+        REQUIRE(narrow.substr(18, 18).view() == u"Caf\xE9 au lait chaud");
+
+        // Atoms stay one-byte
+        auto& atoms = atom_table::of(h);
+        const auto atom = atoms.intern(string{h, "one_byte_atom_name"});
+        REQUIRE(atom.unsafe_raw_get()->is_one_byte());
+        REQUIRE_EQ(atoms.find(u"one_byte_atom_name"), atom.unsafe_raw_get().get());
+
+        // view() widens the string in place (in a way that's invisible except for the memory used)
+        const auto before = ascii.view();
+        REQUIRE(before == u"Hello world again!");
+        REQUIRE(!ascii.unsafe_raw_get()->is_one_byte());
+        REQUIRE(ascii == (string{h, "Hello world again!"}));
+        h.garbage_collect();
+        REQUIRE(ascii.view() == u"Hello world again!");
+        REQUIRE(latin1.view() == u"Caf\xE9 au lait chaud");
+        REQUIRE(mixed.view() == u"Hello world again!\x263A smile \x263A" u"Caf\xE9 au lait chaud");
+    }
+    h.garbage_collect();
+    assert(h.use_percentage() == 0);
+}
+
+/*("value - string slices") */{
+    gc_heap h{1<<12};
+    {
+        const std::u16string text = u"The quick brown fox jumps over the lazy dog";
+        const string s{h, text};
+        const auto quick_jumps = s.substr(4, 26);
+        REQUIRE(quick_jumps.unsafe_raw_get()->is_slice());
+        REQUIRE(quick_jumps.view() == u"quick brown fox jumps over");
+        // Slices of slices refer to the original string
+        const auto brown_jumps = quick_jumps.substr(6);
+        REQUIRE(brown_jumps.unsafe_raw_get()->is_slice());
+        REQUIRE(brown_jumps.view() == u"brown fox jumps over");
+        // Short slices are copied
+        REQUIRE(!s.substr(4, 5).unsafe_raw_get()->is_slice());
+        REQUIRE(s.substr(4, 5).view() == u"quick");
+        REQUIRE_EQ(s.substr(0).unsafe_raw_get().get(), s.unsafe_raw_get().get());
+        REQUIRE(s.substr(text.length()).view().empty());
+        // Slices of ropes refer to the flattened string
+        const auto rope = s + string{h, "!!!!!!!!!!!!!!!!"};
+        REQUIRE(rope.substr(35, 10).view() == u"lazy dog!!");
+        h.minor_garbage_collect();
+        h.garbage_collect();
+        REQUIRE(quick_jumps.view() == u"quick brown fox jumps over");
+        REQUIRE(brown_jumps.view() == u"brown fox jumps over");
+    }
+    h.garbage_collect();
+    assert(h.use_percentage() == 0);
+}
+
+/*("value - string hashes") */{
+    gc_heap h{1<<12};
+    {
+        // The hash only depends on the characters, not on how the string is stored
+        const string one_byte{h, u"hash test string \xe6"};
+        const string wide{h, u"hash test string \xe6"};
+        (void)wide.view(); // Widen
+        const auto rope = string{h, u"hash test "} + string{h, u"string \xe6"};
+        const auto slice = string{h, u"The hash test string \xe6!"}.substr(4, 18);
+        REQUIRE(one_byte.unsafe_raw_get()->is_one_byte());
+        REQUIRE(!wide.unsafe_raw_get()->is_one_byte());
+        REQUIRE(rope.unsafe_raw_get()->is_rope());
+        REQUIRE(slice.unsafe_raw_get()->is_slice());
+        const auto hash = hash_chars(std::u16string_view{u"hash test string \xe6"});
+        REQUIRE_EQ(one_byte.unsafe_raw_get()->hash(), hash);
+        REQUIRE_EQ(wide.unsafe_raw_get()->hash(), hash);
+        REQUIRE_EQ(rope.unsafe_raw_get()->hash(), hash);
+        REQUIRE_EQ(slice.unsafe_raw_get()->hash(), hash);
+        REQUIRE(one_byte == wide && rope == slice);
+        REQUIRE((one_byte != string{h, u"hash test string \xe7"}));
+        // The hash is kept when the string is moved and when it's interned
+        h.minor_garbage_collect();
+        h.garbage_collect();
+        REQUIRE_EQ(rope.unsafe_raw_get()->hash(), hash);
+        REQUIRE_EQ(atom_table::of(h).intern(slice).unsafe_raw_get()->hash(), hash);
+        REQUIRE(hash_chars(std::string_view{""}) != 0);
+    }
+    h.garbage_collect();
+    assert(h.use_percentage() == 0);
+}
+
+/*("value - string builder") */{
+    gc_heap h{1<<12};
+    {
+        string_builder b{h};
+        std::u16string expected;
+        for (int i = 0; i < 100; ++i) {
+            b.append_number(i).append(u',');
+            expected += to_u16string(std::to_wstring(i)) + u",";
+            if (i == 50) {
+                // The partial result survives garbage collection
+                h.minor_garbage_collect();
+                h.garbage_collect();
+            }
+        }
+        b.append(string{h, "end"});
+        expected += u"end";
+        REQUIRE_EQ(b.length(), expected.length());
+        const auto s = b.release();
+        REQUIRE(s.unsafe_raw_get()->is_one_byte());
+        REQUIRE(s.view() == expected);
+        REQUIRE_EQ(b.length(), 0U);
+        REQUIRE(b.release().view().empty());
+
+        // Switches to char16_t when needed
+        string_builder wide{h, 4};
+        wide.append("Caf").append(u'\xE9').append(std::u16string_view{u" \x263A "}).append_number(-0.5).append(std::string_view{"!"});
+        const auto ws = wide.release();
+        REQUIRE(!ws.unsafe_raw_get()->is_one_byte());
+        REQUIRE(ws.view() == u"Caf\xE9 \x263A -0.5!");
+        REQUIRE(ws == (string{h, std::u16string_view{u"Caf\xE9 \x263A -0.5!"}}));
+
+        // The result doesn't use more memory than a string created the usual way
+        h.garbage_collect();
+        const auto used = h.used();
+        string_builder reserved{h, 1000};
+        reserved.append("short string");
+        const auto rs = reserved.release();
+        h.garbage_collect();
+        const auto builder_used = h.used() - used;
+        const string normal{h, "short string"};
+        h.garbage_collect();
+        REQUIRE(rs == normal);
+        REQUIRE(s.view() == expected);
+        REQUIRE_EQ(h.used() - used - builder_used, builder_used);
+    }
+    h.garbage_collect();
+    assert(h.use_percentage() == 0);
+}
 }
 
 void test_object() {
-    gc_heap h{1<<8};
+    gc_heap h{1<<9};
     {
         auto o = h.make<object>(string{h, "Object"}, nullptr);
         REQUIRE_EQ(o->enumerable_property_names(), (std::vector<string>{}));
@@ -78,6 +300,98 @@ void test_object() {
 
     h.garbage_collect();
     assert(h.use_percentage() == 0);
+
+/*("object - shapes") */{
+    auto proto = h.make<object>(string{h, "Object"}, nullptr);
+    auto o1 = h.make<object>(string{h, "Object"}, proto);
+    auto o2 = h.make<object>(string{h, "Object"}, proto);
+    const auto a = string{h, "a"}, b = string{h, "b"}, c = string{h, "c"};
+    REQUIRE_EQ(&o1->shape(), &o2->shape());
+    o1->put(a, value{1.0});
+    o1->put(b, value{2.0});
+    o1->put(c, value{3.0});
+    o2->put(a, value{4.0});
+    o2->put(b, value{5.0});
+    REQUIRE(&o1->shape() != &o2->shape());
+    o2->put(c, value{6.0});
+    REQUIRE_EQ(&o1->shape(), &o2->shape());
+    REQUIRE_EQ(o1->shape().find(u"c"), 2U);
+    REQUIRE_EQ(o1->shape().find(u"d"), object_shape::not_found);
+
+    // Deleting a property keeps the order of the remaining ones, and gives the object a shape of its own
+    REQUIRE(o1->delete_property(u"a"));
+    REQUIRE(o1->shape().is_dictionary());
+    REQUIRE_EQ(o1->enumerable_property_names(), (std::vector<string>{b, c}));
+    REQUIRE_EQ(o1->get(u"b"), value{2.0});
+    REQUIRE_EQ(o1->get(u"c"), value{3.0});
+    auto o3 = h.make<object>(string{h, "Object"}, proto);
+    o3->put(b, value{7.0});
+    o3->put(c, value{8.0});
+    REQUIRE(!o3->shape().is_dictionary());
+    REQUIRE(&o1->shape() != &o3->shape());
+    const auto id = o1->shape().id();
+    o1->put(a, value{10.0});
+    REQUIRE_EQ(o1->enumerable_property_names(), (std::vector<string>{b, c, a}));
+    REQUIRE_EQ(o1->shape().find(u"a"), 2U);
+    REQUIRE(o1->shape().id() != id);
+
+    // As does changing attributes
+    o2->redefine_own_property(b, value{9.0}, property_attribute::dont_enum);
+    REQUIRE(o2->shape().is_dictionary());
+    REQUIRE_EQ(o2->enumerable_property_names(), (std::vector<string>{a, c}));
+    REQUIRE_EQ(o2->get(u"b"), value{9.0});
+    REQUIRE_EQ(o2->get(u"c"), value{6.0});
+}
+    h.garbage_collect();
+    assert(h.use_percentage() == 0);
+
+/*("atom table") */{
+    auto& atoms = atom_table::of(h);
+    const auto size_before = atoms.size();
+    const auto a1 = atoms.intern(string{h, "atom_test"});
+    const auto a2 = atoms.intern(string{h, "atom_test"});
+    REQUIRE_EQ(a1.unsafe_raw_get().get(), a2.unsafe_raw_get().get());
+    REQUIRE_EQ(atoms.find(u"atom_test"), static_cast<const gc_string*>(a1.unsafe_raw_get().get()));
+    REQUIRE(!atoms.find(u"atom_test2"));
+    REQUIRE_EQ(atoms.size(), size_before + 1);
+}
+    // Atoms are weak
+    h.garbage_collect();
+    REQUIRE(!atom_table::of(h).find(u"atom_test"));
+    assert(h.use_percentage() == 0);
+}
+
+void test_object_many_properties() {
+    gc_heap h{1<<18};
+    {
+        auto o = h.make<object>(string{h, "Object"}, nullptr);
+        constexpr uint32_t n = 3000;
+        std::vector<string> names;
+        for (uint32_t i = 0; i < n; ++i) {
+            names.push_back(string{h, "p" + std::to_string(i)});
+            o->put(names.back(), value{static_cast<double>(i)});
+            REQUIRE_EQ(o->shape().is_dictionary(), i >= object_shape::max_shared_size);
+        }
+        REQUIRE_EQ(o->shape().size(), n);
+
+        // Delete every other property, and then the rest from the end
+        for (uint32_t i = 0; i < n; i += 2) {
+            REQUIRE(o->delete_property(names[i].view()));
+        }
+        REQUIRE_EQ(o->shape().size(), n / 2);
+        for (uint32_t i = 0; i < n; ++i) {
+            REQUIRE_EQ(o->get(names[i].view()), i % 2 ? value{static_cast<double>(i)} : value::undefined);
+        }
+        REQUIRE_EQ(o->enumerable_property_names().front(), names[1]);
+        REQUIRE_EQ(o->enumerable_property_names().back(), names[n - 1]);
+        for (uint32_t i = n - 1; i < n; i -= 2) {
+            REQUIRE(o->delete_property(names[i].view()));
+        }
+        REQUIRE_EQ(o->shape().size(), 0U);
+        REQUIRE_EQ(o->enumerable_property_names(), (std::vector<string>{}));
+    }
+    h.garbage_collect();
+    assert(h.use_percentage() == 0);
 }
 
 void test_type_conversion() {
@@ -163,6 +477,7 @@ void test_number_to_string() {
 void test_main() {
     test_value();
     test_object();
+    test_object_many_properties();
     test_type_conversion();
     test_number_to_string();
 }